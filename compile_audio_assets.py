@@ -0,0 +1,418 @@
+"""
+@file compile_audio_assets.py
+@author James Vollmer (jrvollmer@wisc.edu) - Team 01
+@brief Compile the sound effects listed in a manifest into the audio store for external flash
+
+Each clip is loaded (and resampled if the manifest asks for a rate), trimmed of leading and
+trailing silence, normalized to a target RMS loudness, and encoded. The clips are packed into
+one store image in the layout app_audio_store.c reads, along with a C header indexing it.
+
+Nothing depends on the time, the machine, or the order files are found in, so compiling the
+same inputs twice gives byte-identical outputs. Committing the index header is enough to
+review what changed in the store and how much flash it takes.
+"""
+import json
+import math
+import os
+import re
+import struct
+import sys
+import wave
+import zlib
+from argparse import ArgumentParser
+
+
+# IMA-ADPCM block layout. Must match app_audio_adpcm.h
+ADPCM_BLOCK_BYTES = 256
+ADPCM_BLOCK_HEADER_BYTES = 4
+ADPCM_BLOCK_SAMPLES = 1 + 2 * (ADPCM_BLOCK_BYTES - ADPCM_BLOCK_HEADER_BYTES)
+
+# Store layout. Must match app_audio_store.h
+STORE_MAGIC = 0x53444641
+STORE_VERSION = 1
+STORE_MAX_ENTRIES = 32
+STORE_ALIGN = 256                 # APP_AUDIO_STREAM_BLOCK_BYTES
+STORE_NO_SOUND_EFFECT = 0xFF
+STORE_HEADER = struct.Struct('<IHHI')
+STORE_ENTRY = struct.Struct('<IIIIBBHI')
+STORE_PAD = b'\xff'               # Erased flash
+FORMATS = {'pcm': 0, 'adpcm': 1}  # audio_asset_format_e
+
+# Highest rate the firmware plays at (APP_AUDIO_MIXER_SAMPLE_RATE_HZ). It upsamples anything lower
+MAX_SAMPLE_RATE = 44100
+MAX_DAC_SAMPLE = 4095
+
+SOUND_EFFECT_ENUM_FILE = 'source/data/audio_sample_luts.h'
+SOUND_EFFECT_REGEX = r'^\s*AUDIO_SOUND_EFFECT_(\w+)\s*=\s*(\d+)'
+
+DEFAULTS = {
+    'codec': 'adpcm',
+    'sample_rate': None,   # The source's own rate
+    'trim_db': -50.0,      # Samples quieter than this at either end are trimmed (dBFS)
+    'loudness_db': -16.0,  # Target RMS level (dBFS)
+    'peak_db': -1.0,       # Normalization never pushes the peak above this (dBFS)
+    'min_snr_db': 16.0,    # Round-trip SNR a clip must keep, or compiling fails (dB)
+}
+
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+]
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+class AssetError(Exception):
+    pass
+
+
+def db_to_linear(db):
+    return 10.0 ** (db / 20.0)
+
+
+def s16_to_dac(sample):
+    return min(MAX_DAC_SAMPLE, max(0, (sample >> 4) + 2048))
+
+
+def quantize(samples):
+    """Round float samples in [-1, 1] to signed 16-bit, half away from zero"""
+    out = []
+    for s in samples:
+        q = int(math.floor(abs(s) * 32767.0 + 0.5))
+        out.append(min(32767, q) if s >= 0 else -min(32768, q))
+    return out
+
+
+def adpcm_step(predictor, index, code):
+    step = IMA_STEP_TABLE[index]
+    diff = step >> 3
+    if code & 4:
+        diff += step
+    if code & 2:
+        diff += step >> 1
+    if code & 1:
+        diff += step >> 2
+    predictor = predictor - diff if code & 8 else predictor + diff
+    predictor = max(-32768, min(32767, predictor))
+    index = max(0, min(len(IMA_STEP_TABLE) - 1, index + IMA_INDEX_TABLE[code & 7]))
+    return predictor, index
+
+
+def adpcm_encode(samples):
+    """Encode signed 16-bit samples as IMA-ADPCM blocks"""
+    out = bytearray()
+    index = 0
+    for start in range(0, len(samples), ADPCM_BLOCK_SAMPLES):
+        block = samples[start:start + ADPCM_BLOCK_SAMPLES]
+        # Header holds the first sample and the current step index
+        predictor = block[0]
+        out += (predictor & 0xFFFF).to_bytes(2, 'little') + bytes([index, 0])
+        codes = bytearray(len(block) // 2)
+        for i, s in enumerate(block[1:]):
+            step = IMA_STEP_TABLE[index]
+            diff = s - predictor
+            code = 0
+            if diff < 0:
+                code = 8
+                diff = -diff
+            if diff >= step:
+                code |= 4
+                diff -= step
+            if diff >= (step >> 1):
+                code |= 2
+                diff -= step >> 1
+            if diff >= (step >> 2):
+                code |= 1
+            predictor, index = adpcm_step(predictor, index, code)
+            codes[i >> 1] |= code << (4 * (i & 1))
+        out += codes
+    return bytes(out)
+
+
+def adpcm_decode(data, n_samples):
+    """Decode IMA-ADPCM blocks back into signed 16-bit samples (same as the firmware)"""
+    out = []
+    for start in range(0, len(data), ADPCM_BLOCK_BYTES):
+        block = data[start:start + ADPCM_BLOCK_BYTES]
+        predictor = int.from_bytes(block[0:2], 'little', signed=True)
+        index = block[2]
+        out.append(predictor)
+        for byte in block[ADPCM_BLOCK_HEADER_BYTES:]:
+            for code in (byte & 0xF, byte >> 4):
+                if len(out) < n_samples:
+                    predictor, index = adpcm_step(predictor, index, code)
+                    out.append(predictor)
+    return out[:n_samples]
+
+
+def snr_db(reference, test):
+    mean = sum(reference) / len(reference)
+    signal = sum((r - mean) ** 2 for r in reference)
+    noise = sum((r - t) ** 2 for r, t in zip(reference, test))
+    return math.inf if noise == 0 else 10 * math.log10(signal / noise)
+
+
+def load_wav(path):
+    """Load a 16-bit PCM WAV file as mono floats, without any third party libraries"""
+    with wave.open(path, 'rb') as f:
+        if f.getsampwidth() != 2:
+            raise AssetError(f'{path}: only 16-bit WAV files are supported')
+        n_channels = f.getnchannels()
+        frames = f.readframes(f.getnframes())
+        sample_rate = f.getframerate()
+    raw = struct.unpack(f'<{len(frames) // 2}h', frames)
+    # Average the channels down to mono
+    samples = [sum(raw[i:i + n_channels]) / (n_channels * 32768.0) for i in range(0, len(raw), n_channels)]
+    return samples, sample_rate
+
+
+def load_clip(path, sample_rate):
+    """Load a clip as mono floats in [-1, 1], resampled to sample_rate if given"""
+    if path.lower().endswith('.wav'):
+        samples, source_rate = load_wav(path)
+        if sample_rate in (None, source_rate):
+            return samples, source_rate
+
+    # librosa is only needed for compressed sources and resampling. Its soxr resampler
+    # is deterministic, so outputs stay reproducible
+    import librosa
+    samples, source_rate = librosa.load(path, sr=sample_rate, mono=True, res_type='soxr_hq')
+    return [float(s) for s in samples], int(source_rate)
+
+
+def trim_silence(samples, trim_db):
+    """Drop samples quieter than trim_db from both ends (but never from the middle)"""
+    threshold = db_to_linear(trim_db)
+    loud = [i for i, s in enumerate(samples) if abs(s) > threshold]
+    if not loud:
+        return []
+    return samples[loud[0]:loud[-1] + 1]
+
+
+def normalize(samples, loudness_db, peak_db):
+    """Scale samples to an RMS of loudness_db, as far as the peak limit allows"""
+    rms = math.sqrt(sum(s * s for s in samples) / len(samples))
+    peak = max(abs(s) for s in samples)
+    if rms == 0:
+        return samples, 1.0
+    gain = min(db_to_linear(loudness_db) / rms, db_to_linear(peak_db) / peak)
+    return [s * gain for s in samples], gain
+
+
+def read_sound_effects(root):
+    """Map sound effect names to their audio_sound_effect_e values"""
+    with open(os.path.join(root, SOUND_EFFECT_ENUM_FILE)) as f:
+        matches = (re.match(SOUND_EFFECT_REGEX, line) for line in f)
+        return {m.group(1): int(m.group(2)) for m in matches if m and m.group(1) != 'MAX'}
+
+
+def compile_clip(clip, defaults, manifest_dir, sound_effects):
+    opts = {**defaults, **clip}
+    name = opts['name']
+    if opts['codec'] not in FORMATS:
+        raise AssetError(f'{name}: unknown codec "{opts["codec"]}"')
+    sound_effect = opts.get('sound_effect')
+    if sound_effect is not None and sound_effect not in sound_effects:
+        raise AssetError(f'{name}: unknown sound effect "{sound_effect}"')
+
+    samples, sample_rate = load_clip(os.path.join(manifest_dir, opts['source']), opts['sample_rate'])
+    if sample_rate > MAX_SAMPLE_RATE:
+        raise AssetError(f'{name}: {sample_rate}Hz is above the {MAX_SAMPLE_RATE}Hz output rate, set a sample_rate')
+    n_source = len(samples)
+
+    samples = trim_silence(samples, opts['trim_db'])
+    if not samples:
+        raise AssetError(f'{name}: clip is silent')
+    samples, gain = normalize(samples, opts['loudness_db'], opts['peak_db'])
+    pcm = quantize(samples)
+
+    if opts['codec'] == 'adpcm':
+        data = adpcm_encode(pcm)
+        snr = snr_db(pcm, adpcm_decode(data, len(pcm)))
+    else:
+        dac = [s16_to_dac(s) for s in pcm]
+        data = struct.pack(f'<{len(dac)}H', *dac)
+        snr = snr_db(pcm, [(s - 2048) * 16 for s in dac])
+
+    if snr < opts['min_snr_db']:
+        raise AssetError(f'{name}: SNR {snr:.1f}dB is below the {opts["min_snr_db"]:.1f}dB floor')
+
+    return {
+        'name': name,
+        'sound_effect': STORE_NO_SOUND_EFFECT if sound_effect is None else sound_effects[sound_effect],
+        'sound_effect_name': sound_effect,
+        'codec': opts['codec'],
+        'sample_rate': sample_rate,
+        'n_samples': len(pcm),
+        'n_trimmed': n_source - len(pcm),
+        'gain_db': 20 * math.log10(gain),
+        'snr_db': snr,
+        'min_snr_db': opts['min_snr_db'],
+        'pcm': pcm,
+        'data': data,
+    }
+
+
+def align(n):
+    return (n + STORE_ALIGN - 1) // STORE_ALIGN * STORE_ALIGN
+
+
+def pack_store(assets):
+    """Lay the assets out after the header and directory, each on a block boundary"""
+    offset = align(STORE_HEADER.size + STORE_ENTRY.size * len(assets))
+    directory = bytearray()
+    body = bytearray()
+    for asset in assets:
+        asset['offset'] = offset
+        asset['crc'] = zlib.crc32(asset['data'])
+        directory += STORE_ENTRY.pack(offset, len(asset['data']), asset['n_samples'], asset['sample_rate'],
+                                      FORMATS[asset['codec']], asset['sound_effect'], 0, asset['crc'])
+        padded = align(len(asset['data']))
+        body += asset['data'] + STORE_PAD * (padded - len(asset['data']))
+        offset += padded
+
+    header = STORE_HEADER.pack(STORE_MAGIC, STORE_VERSION, len(assets), zlib.crc32(directory))
+    head = header + directory
+    return head + STORE_PAD * (align(len(head)) - len(head)) + body
+
+
+def c_name(name):
+    return re.sub(r'\W', '_', name).upper()
+
+
+def generate_index(assets, store, manifest_path):
+    lines = [
+        '/**\n',
+        ' * @file audio_store_index.h\n',
+        ' * @brief\n',
+        f' * Index of the audio store compiled from {manifest_path}. Generated by\n',
+        ' * compile_audio_assets.py, do not edit\n',
+        ' */\n',
+        '\n',
+        '#ifndef __AUDIO_STORE_INDEX_H__\n',
+        '#define __AUDIO_STORE_INDEX_H__\n',
+        '\n',
+        '#include "app_audio_store.h"\n',
+        '\n',
+        f'#define AUDIO_STORE_N_ENTRIES    ({len(assets)}U)\n',
+        f'#define AUDIO_STORE_BYTES        ({len(store)}UL)\n',
+        f'#define AUDIO_STORE_CRC          (0x{zlib.crc32(store):08x}UL)\n',
+        '\n',
+        'typedef enum\n',
+        '{\n',
+    ]
+    for i, asset in enumerate(assets):
+        lines.append(f'    AUDIO_STORE_CLIP_{c_name(asset["name"])} = {i},\n')
+    lines += [
+        '} audio_store_clip_e;\n',
+        '\n',
+        '// Same as the directory at the start of the store\n',
+        'static const app_audio_store_entry_s audio_store_index[AUDIO_STORE_N_ENTRIES] = {\n',
+    ]
+    for asset in assets:
+        sound_effect = (f'AUDIO_SOUND_EFFECT_{asset["sound_effect_name"]}' if asset['sound_effect_name']
+                        else 'APP_AUDIO_STORE_NO_SOUND_EFFECT')
+        lines += [
+            f'    [AUDIO_STORE_CLIP_{c_name(asset["name"])}] = {{\n',
+            f'        .offset       = 0x{asset["offset"]:08x}UL,\n',
+            f'        .n_bytes      = {len(asset["data"])}UL,\n',
+            f'        .n_samples    = {asset["n_samples"]}UL,\n',
+            f'        .sample_rate  = {asset["sample_rate"]}UL,\n',
+            f'        .format       = AUDIO_ASSET_FORMAT_{asset["codec"].upper()},\n',
+            f'        .sound_effect = {sound_effect},\n',
+            f'        .crc          = 0x{asset["crc"]:08x}UL\n',
+            '    },\n',
+        ]
+    lines += [
+        '};\n',
+        '\n',
+        '#endif // __AUDIO_STORE_INDEX_H__\n',
+    ]
+    return ''.join(lines).encode()
+
+
+def compile_manifest(manifest_path, root):
+    with open(manifest_path) as f:
+        manifest = json.load(f)
+    defaults = {**DEFAULTS, **manifest.get('defaults', {})}
+    clips = manifest['clips']
+    if len(clips) > STORE_MAX_ENTRIES:
+        raise AssetError(f'{len(clips)} clips, the store holds at most {STORE_MAX_ENTRIES}')
+    names = [clip['name'] for clip in clips]
+    if len(set(names)) != len(names):
+        raise AssetError('clip names must be unique')
+
+    sound_effects = read_sound_effects(root)
+    manifest_dir = os.path.dirname(manifest_path)
+    assets = [compile_clip(clip, defaults, manifest_dir, sound_effects) for clip in clips]
+    store = pack_store(assets)
+    index = generate_index(assets, store, os.path.relpath(manifest_path, root).replace(os.sep, '/'))
+    return assets, store, index
+
+
+def dump_clips(assets, dump_dir):
+    """Write each ADPCM clip's source PCM and encoded data, for tools/adpcm_check to decode"""
+    os.makedirs(dump_dir, exist_ok=True)
+    lines = []
+    for asset in assets:
+        if asset['codec'] != 'adpcm':
+            continue
+        with wave.open(os.path.join(dump_dir, f"{asset['name']}.wav"), 'wb') as f:
+            f.setnchannels(1)
+            f.setsampwidth(2)
+            f.setframerate(asset['sample_rate'])
+            f.writeframes(struct.pack(f"<{len(asset['pcm'])}h", *asset['pcm']))
+        with open(os.path.join(dump_dir, f"{asset['name']}.adpcm"), 'wb') as f:
+            f.write(asset['data'])
+        lines.append(f"{asset['name']} {asset['min_snr_db']}\n")
+    with open(os.path.join(dump_dir, 'clips.txt'), 'w') as f:
+        f.writelines(lines)
+
+
+def write_if_changed(path, data, check):
+    """Write an output, or with check just report whether it is out of date"""
+    try:
+        with open(path, 'rb') as f:
+            if f.read() == data:
+                return False
+    except FileNotFoundError:
+        pass
+    if not check:
+        os.makedirs(os.path.dirname(path) or '.', exist_ok=True)
+        with open(path, 'wb') as f:
+            f.write(data)
+    return True
+
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description="Compile the audio manifest into the external flash audio store")
+    parser.add_argument("manifest", type=str, help="Path to the manifest of clips (JSON)")
+    parser.add_argument("-o", "--store-file", type=str, default="build/audio_store.bin", help="Path to the store image to write (programmed at APP_AUDIO_STORE_FLASH_ADDR)")
+    parser.add_argument("-i", "--index-file", type=str, default="source/data/audio_store_index.h", help="Path to the C index header to write")
+    parser.add_argument("--check", action="store_true", help="Don't write anything, just fail if the outputs are out of date")
+    parser.add_argument("--dump-dir", type=str, help="Also write each ADPCM clip's source and data here, for tools/adpcm_check")
+    args = parser.parse_args()
+
+    root = os.path.dirname(os.path.abspath(__file__))
+    try:
+        assets, store, index = compile_manifest(args.manifest, root)
+    except (AssetError, OSError, KeyError, ValueError) as e:
+        print(f"\033[1;31m{e}\033[0m")
+        sys.exit(1)
+
+    for asset in assets:
+        print(f"{asset['name']:<16} {asset['codec']:<5} {asset['sample_rate']:>5}Hz {asset['n_samples']:>7} samples "
+              f"({asset['n_trimmed']} trimmed) {len(asset['data']):>7} bytes, gain {asset['gain_db']:+.1f}dB, "
+              f"SNR {asset['snr_db']:.1f}dB")
+    print(f"Store: {len(assets)} clips, {len(store)} bytes, CRC 0x{zlib.crc32(store):08x}")
+    if args.dump_dir:
+        dump_clips(assets, args.dump_dir)
+
+    stale = [path for path, data in ((args.store_file, store), (args.index_file, index))
+             if write_if_changed(path, data, args.check)]
+    if args.check and stale:
+        print(f"\033[1;31mOut of date: {', '.join(stale)}\033[0m")
+        sys.exit(1)
@@ -19,8 +19,10 @@
 #include "task_audio.h"
 #include "data/audio_sample_luts.h"
 #include "task_car.h"
+#include "app_clock.h"
 #include <task.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 /****************************************************************************
@@ -40,9 +42,13 @@ typedef enum
 /******************************************************************************
  * Global Variables                                                           *
  ******************************************************************************/
-// Queues
-QueueHandle_t q_ble_car_joystick_x;
-QueueHandle_t q_ble_car_joystick_y;
+// Mailbox holding only the newest joystick sample. Writes overwrite it and reads peek at it,
+// so readers never act on stale positions, however long they take to get to it
+static QueueHandle_t q_ble_car_joystick;
+// Only touched by the GATT handler
+static car_joystick_sample_t ble_car_joystick_sample;
+// Per axis, written by the task that applies it
+static car_joystick_latency_t ble_car_joystick_latency[CAR_JOYSTICK_AXIS_MAX];
 // Race state
 volatile race_state_e race_state;
 
@@ -75,7 +81,7 @@ BaseType_t app_bt_car_get_new_item(void)
         app_rc_controller_get_item[0] = (car_item_t)item;
         app_bt_send_message(HDLC_RC_CONTROLLER_GET_ITEM_VALUE);
 
-        ret = xTaskNotify(xTaskAudioHandle, (uint32_t)AUDIO_SOUND_EFFECT_GET_ITEM, eSetValueWithOverwrite);
+        ret = xTaskNotify(xTaskAudioHandle, AUDIO_SOUND_EFFECT_NOTIFY_BIT(AUDIO_SOUND_EFFECT_GET_ITEM), eSetBits);
     }
 
     return ret;
@@ -107,13 +113,13 @@ BaseType_t app_bt_car_use_item(car_item_t item)
         switch (item)
         {
             case CAR_ITEM_SHOT:
-                xTaskNotify(xTaskAudioHandle, (uint32_t)AUDIO_SOUND_EFFECT_USE_SHOT, eSetValueWithOverwrite);
+                xTaskNotify(xTaskAudioHandle, AUDIO_SOUND_EFFECT_NOTIFY_BIT(AUDIO_SOUND_EFFECT_USE_SHOT), eSetBits);
                 break;
             case CAR_ITEM_SHIELD:
-                ret = xTaskNotify(xTaskAudioHandle, (uint32_t)AUDIO_SOUND_EFFECT_USE_SHIELD, eSetValueWithOverwrite);
+                ret = xTaskNotify(xTaskAudioHandle, AUDIO_SOUND_EFFECT_NOTIFY_BIT(AUDIO_SOUND_EFFECT_USE_SHIELD), eSetBits);
                 break;
             case CAR_ITEM_BOOST:
-                ret = xTaskNotify(xTaskAudioHandle, (uint32_t)AUDIO_SOUND_EFFECT_BOOST, eSetValueWithOverwrite);
+                ret = xTaskNotify(xTaskAudioHandle, AUDIO_SOUND_EFFECT_NOTIFY_BIT(AUDIO_SOUND_EFFECT_BOOST), eSetBits);
                 break;
             default:
                 goto item_used;
@@ -156,11 +162,118 @@ void app_bt_car_complete_lap(void)
 }
 
 
+/**
+ * @brief  Tell the RC controller app who hit the car, with what, and from
+ *         where
+ * 
+ * @param uint8_t
+ * Car ID of the shooter
+ * @param car_item_t
+ * Item they hit the car with
+ * @param uint8_t
+ * Where the hit came from (app_ir_hit_dir_e: 0 front, 1 side, 2 rear)
+ * @return void
+ */
+void app_bt_car_report_hit(uint8_t shooter_id, car_item_t item, uint8_t dir)
+{
+    if (ble_state.conn_id)
+    {
+        // Send if client is registered to receive notifications
+        app_rc_controller_hit[0] = shooter_id;
+        app_rc_controller_hit[1] = item;
+        app_rc_controller_hit[2] = dir;
+        app_bt_send_message(HDLC_RC_CONTROLLER_HIT_VALUE);
+    }
+}
+
+
+/**
+ * @brief  Publish a joystick write from the RC controller app, replacing the
+ *         last sample whether or not it was used
+ *
+ * @param car_joystick_axis_e
+ * Axis that was written
+ * @param car_joystick_t
+ * Its new position, from -1 to 1
+ */
+void app_bt_car_set_joystick(car_joystick_axis_e axis, car_joystick_t val)
+{
+    if (axis == CAR_JOYSTICK_AXIS_X)
+    {
+        ble_car_joystick_sample.x = val;
+    }
+    else
+    {
+        ble_car_joystick_sample.y = val;
+    }
+    ble_car_joystick_sample.seq[axis]++;
+    ble_car_joystick_sample.write_us[axis] = app_clock_us();
+
+    xQueueOverwrite(q_ble_car_joystick, &ble_car_joystick_sample);
+    // The link is alive
+    task_car_link_input(APP_FAILSAFE_INPUT_JOYSTICK);
+}
+
+
+/**
+ * @brief  Get the newest joystick sample without waiting. The sample stays in
+ *         the mailbox for other readers
+ *
+ * @param car_joystick_sample_t*
+ * Where to write the sample
+ * @return BaseType_t
+ * pdTRUE if there is a sample, pdFALSE if the joystick hasn't been written yet
+ */
+BaseType_t app_bt_car_get_joystick(car_joystick_sample_t* sample)
+{
+    return xQueuePeek(q_ble_car_joystick, sample, 0);
+}
+
+
+/**
+ * @brief  Record that a joystick sample has been applied to the car (e.g. its
+ *         PWM updated), for the latency stats. Call it straight afterwards
+ *
+ * @param car_joystick_axis_e
+ * Axis that was applied
+ * @param const car_joystick_sample_t*
+ * Sample that was applied
+ * @param uint32_t
+ * seq of the last sample of this axis the caller applied
+ */
+void app_bt_car_joystick_applied(car_joystick_axis_e axis, const car_joystick_sample_t* sample, uint32_t last_seq)
+{
+    const uint32_t latency_us = app_clock_us() - sample->write_us[axis];
+    car_joystick_latency_t* latency = &ble_car_joystick_latency[axis];
+
+    taskENTER_CRITICAL();
+    app_latency_record(&latency->hist, latency_us);
+    latency->n_skipped += sample->seq[axis] - last_seq - 1;
+    taskEXIT_CRITICAL();
+}
+
+
+/**
+ * @brief  Get the latency stats for an axis, and start measuring again
+ *
+ * @param car_joystick_axis_e
+ * Axis to get the stats for
+ * @param car_joystick_latency_t*
+ * Where to write the stats
+ */
+void app_bt_car_get_joystick_latency(car_joystick_axis_e axis, car_joystick_latency_t* latency)
+{
+    taskENTER_CRITICAL();
+    *latency = ble_car_joystick_latency[axis];
+    memset(&ble_car_joystick_latency[axis], 0, sizeof(ble_car_joystick_latency[axis]));
+    taskEXIT_CRITICAL();
+}
+
+
 void app_bt_car_init(void)
 {
-    // Create queues for BLE communication
-    q_ble_car_joystick_x = xQueueCreate(BLE_CAR_JOYSTICK_QUEUE_LEN, sizeof(car_joystick_t));
-    q_ble_car_joystick_y = xQueueCreate(BLE_CAR_JOYSTICK_QUEUE_LEN, sizeof(car_joystick_t));
+    // Create the joystick mailbox
+    q_ble_car_joystick = xQueueCreate(1, sizeof(car_joystick_sample_t));
 
     // Initial race state
     race_state = RACE_STATE_INACTIVE;
@@ -18,14 +18,13 @@
 // FreeRTOS Includes
 #include <FreeRTOS.h>
 #include <queue.h>
+// Project Includes
+#include "app_latency.h"
 
 
 /****************************************************************************
  * Typedefs and Defines
  ***************************************************************************/
-// Queue constants
-#define BLE_CAR_JOYSTICK_QUEUE_LEN    (3)
-
 #define BLE_CAR_MAX_LAP_COUNT    (3)
 
 typedef uint8_t car_item_t;
@@ -33,6 +32,31 @@ typedef uint8_t car_lap_t;
 typedef uint8_t car_event_t;
 typedef float32_t car_joystick_t;
 
+// Joystick axes. X steers and Y sets the speed
+typedef enum
+{
+    CAR_JOYSTICK_AXIS_X   = 0,
+    CAR_JOYSTICK_AXIS_Y   = 1,
+    CAR_JOYSTICK_AXIS_MAX = 2
+} car_joystick_axis_e;
+
+// Newest joystick position, and when each axis was written. The app writes the axes
+// separately, so each one keeps its own count
+typedef struct
+{
+    car_joystick_t x;
+    car_joystick_t y;
+    uint32_t seq[CAR_JOYSTICK_AXIS_MAX];      // Counts each axis's writes, so readers can tell new samples from ones they've used
+    uint32_t write_us[CAR_JOYSTICK_AXIS_MAX]; // app_clock time of each axis's last write
+} car_joystick_sample_t;
+
+// How long joystick samples took from being written to being applied to the car
+typedef struct
+{
+    app_latency_hist_s hist;
+    uint32_t n_skipped;     // Samples overwritten before they could be applied
+} car_joystick_latency_t;
+
 // Item types, for internal use
 typedef enum
 {
@@ -60,9 +84,6 @@ typedef enum
 /****************************************************************************
  * Extern Data Declarations
  ***************************************************************************/
-// Queues for incoming BLE messages
-extern QueueHandle_t q_ble_car_joystick_x;
-extern QueueHandle_t q_ble_car_joystick_y;
 // Race state
 extern volatile race_state_e race_state;
 
@@ -75,6 +96,11 @@ void app_bt_car_init(void);
 BaseType_t app_bt_car_get_new_item(void);
 BaseType_t app_bt_car_use_item(car_item_t item);
 void app_bt_car_complete_lap(void);
+void app_bt_car_report_hit(uint8_t shooter_id, car_item_t item, uint8_t dir);
+void app_bt_car_set_joystick(car_joystick_axis_e axis, car_joystick_t val);
+BaseType_t app_bt_car_get_joystick(car_joystick_sample_t* sample);
+void app_bt_car_joystick_applied(car_joystick_axis_e axis, const car_joystick_sample_t* sample, uint32_t last_seq);
+void app_bt_car_get_joystick_latency(car_joystick_axis_e axis, car_joystick_latency_t* latency);
 
 
 #endif      /*__APP_BT_CAR_H__ */
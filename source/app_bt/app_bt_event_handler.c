@@ -222,6 +222,7 @@ app_bt_management_callback(wiced_bt_management_evt_t event, wiced_bt_management_
                 /* Set CCCD value from the value that was previously saved in the NVRAM */
                 app_rc_controller_get_item_client_char_config[0] = peer_cccd_data[bondindex];
                 app_rc_controller_lap_client_char_config[0] = peer_cccd_data[bondindex];
+                app_rc_controller_hit_client_char_config[0] = peer_cccd_data[bondindex];
             }
             else
             {
@@ -59,6 +59,7 @@
 #include "app_bt_gatt_handler.h"
 #include "app_hw_device.h"
 #include "app_bt_car.h"
+#include "task_car.h"
 #ifdef ENABLE_BT_SPY_LOG
 #include "cybt_debug_uart.h"
 #endif
@@ -450,6 +451,8 @@ app_bt_gatt_connection_up( wiced_bt_gatt_connection_status_t *p_status )
         pairing_mode = FALSE;
     }
 #endif
+    /* Start tracking the link for the failsafe */
+    task_car_link_up();
     /* Update the adv/conn state */
     return WICED_BT_GATT_SUCCESS;
 }
@@ -474,6 +477,9 @@ app_bt_gatt_connection_down(wiced_bt_gatt_connection_status_t *p_status)
 
     UNUSED_VARIABLE(result);
 
+    /* Stop the car straight away rather than waiting for the failsafe's deadline */
+    task_car_link_down();
+
     /* Resetting the device info */
     memset(ble_state.remote_addr, 0, BD_ADDR_LEN);
     ble_state.conn_id = 0;
@@ -569,10 +575,10 @@ wiced_bt_gatt_status_t app_bt_set_value(uint16_t attr_handle,
                     app_rc_controller_joystick_x[2] = p_attr[2];
                     app_rc_controller_joystick_x[3] = p_attr[3];
 
-                    // Queue float for consumption
+                    // Publish float for consumption
                     car_joystick_t val_x;
                     memcpy(&val_x, &app_rc_controller_joystick_x, app_rc_controller_joystick_x_len);
-                    xQueueSendToBack(q_ble_car_joystick_x, &val_x, 0);
+                    app_bt_car_set_joystick(CAR_JOYSTICK_AXIS_X, val_x);
 
                     break;
 
@@ -586,10 +592,10 @@ wiced_bt_gatt_status_t app_bt_set_value(uint16_t attr_handle,
                     app_rc_controller_joystick_y[2] = p_attr[2];
                     app_rc_controller_joystick_y[3] = p_attr[3];
 
-                    // Queue float for consumption
+                    // Publish float for consumption
                     car_joystick_t val_y;
                     memcpy(&val_y, &app_rc_controller_joystick_y, app_rc_controller_joystick_y_len);
-                    xQueueSendToBack(q_ble_car_joystick_y, &val_y, 0);
+                    app_bt_car_set_joystick(CAR_JOYSTICK_AXIS_Y, val_y);
 
                     break;
 
@@ -625,6 +631,7 @@ wiced_bt_gatt_status_t app_bt_set_value(uint16_t attr_handle,
                     }
 
                     const car_event_t race_event = p_attr[0];
+                    task_car_link_input(APP_FAILSAFE_INPUT_GAME_EVENT);
                     switch (race_event)
                     {
                         case CAR_EVENT_RACE_START:
@@ -661,6 +668,19 @@ wiced_bt_gatt_status_t app_bt_set_value(uint16_t attr_handle,
                     UNUSED_VARIABLE(rslt);
                     break;
 
+                /* By writing into Characteristic Client Configuration descriptor
+                 * peer can enable or disable notification or indication */
+                case HDLD_RC_CONTROLLER_HIT_CLIENT_CHAR_CONFIG:
+                    if (len != 2)
+                    {
+                        return WICED_BT_GATT_INVALID_ATTR_LEN;
+                    }
+                    app_rc_controller_hit_client_char_config[0] = p_attr[0];
+                    peer_cccd_data[bondindex] = p_attr[0] | (p_attr[1] << 8);
+                    rslt = app_bt_update_cccd(peer_cccd_data[bondindex], bondindex);
+                    UNUSED_VARIABLE(rslt);
+                    break;
+
                 case HDLD_GATT_SERVICE_CHANGED_CLIENT_CHAR_CONFIG:
                     gatt_status = WICED_BT_GATT_SUCCESS;
                     break;
@@ -733,6 +753,14 @@ void app_bt_send_message(uint16_t handle)
                                                         app_rc_controller_lap,
                                                         NULL);
     }
+    else if((handle == HDLC_RC_CONTROLLER_HIT_VALUE) && (app_rc_controller_hit_client_char_config[0] & GATT_CLIENT_CONFIG_NOTIFICATION))
+    {
+        status = wiced_bt_gatt_server_send_notification(ble_state.conn_id,
+                                                        HDLC_RC_CONTROLLER_HIT_VALUE,
+                                                        app_rc_controller_hit_len,
+                                                        app_rc_controller_hit,
+                                                        NULL);
+    }
 }
 
 /**
@@ -17,14 +17,20 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "data/audio_sample_luts.h"
+#include "app_audio_mixer.h"
+#include "app_audio_scheduler.h"
+#include "app_audio_dds.h"
+#include "app_audio_stream.h"
+#include "app_audio_store.h"
+#include "app_audio_engine.h"
 
 
 // Defines
-// NOTE: While the speaker is capable of hitting 20kHz, the nominal max frequency for the
-//       CTDAC's clock is 500kHz; Sine the since wave LUT contains 100 samples, this gives
-//       a maximum frequency of 5kHz, limited by the MCU, which should be plenty for our
-//       needs anyway (~1kHz higher than a piano's highest note). In our project, we can
-//       reduce our sampling rate as needed to balance frequency requirements
+// NOTE: Tones are synthesized at the mixer's 44.1kHz sample rate (APP_AUDIO_MIXER_SAMPLE_RATE_HZ),
+//       so they could go up to the 22.05kHz Nyquist limit. Capping them at 5kHz keeps
+//       at least ~9 samples per period, so the DDS's images around the sample rate stay
+//       quiet, and 5kHz should be plenty for our needs anyway (~1kHz higher than a
+//       piano's highest note)
 #define MIN_FREQ_HZ          (200)
 #define MAX_FREQ_HZ          (5000)
 #define MIN_AMP_mDB          (0)
@@ -32,14 +38,48 @@
 #define TUNE_NAME_MAX_LEN    (25)
 #define N_TUNES              (2)
 #define MAX_DAC_SAMPLE       (4095UL)
-#define N_TONE_SAMPLES       (100)
-#define N_TUNE_SAMPLES       (2260) // From MP3 processing script
+
+// Q15 amplitude of the user interface cues
+#define AUDIO_CUE_GAIN       (APP_AUDIO_MIXER_GAIN_UNITY / 2)
+
+// Cost of filling each ping-pong buffer (everything the audio DMA interrupt does), in
+// CPU cycles. block_cycles is how long a buffer takes to play, so the CPU load is
+// total_cycles / (n_blocks * block_cycles)
+typedef struct
+{
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t n_blocks;
+    uint32_t block_cycles;
+    uint32_t n_engine_updates;   // Times the engine sound was set over the same blocks
+} app_audio_load_stats_s;
+
+// Tone sequences for user interface feedback
+typedef enum
+{
+    APP_AUDIO_CUE_CONFIRM    = 0,
+    APP_AUDIO_CUE_ERROR      = 1,
+    APP_AUDIO_CUE_CONNECT    = 2,
+    APP_AUDIO_CUE_DISCONNECT = 3,
+    APP_AUDIO_CUE_MAX
+} app_audio_cue_e;
 
 
 // Function declarations
 void app_audio_init(void);
 void app_audio_play_tone(uint32_t amplitude, uint32_t frequency);
-void app_audio_play_sound_effect(audio_sound_effect_e sound_effect);
+void app_audio_play_tone_sequence(const app_audio_dds_segment_s* segments, uint8_t n_segments);
+void app_audio_stop_tone(void);
+void app_audio_play_cue(app_audio_cue_e cue);
+app_audio_handle_t app_audio_play_sound_effect(audio_sound_effect_e sound_effect);
+app_audio_handle_t app_audio_play_sound_effect_pitched(audio_sound_effect_e sound_effect, uint16_t pitch);
+app_audio_status_e app_audio_get_sound_effect_status(app_audio_handle_t handle);
+void app_audio_set_completion_callback(app_audio_completion_cb_t completion_cb);
+void app_audio_get_mixer_stats(app_audio_mixer_stats_s* stats);
+void app_audio_set_stream_refill_callback(app_audio_stream_refill_cb_t refill_cb);
+void app_audio_get_stream_stats(app_audio_stream_stats_s* stats);
+void app_audio_get_load_stats(app_audio_load_stats_s* stats);
 
 
 #endif // __APP_AUDIO_H__
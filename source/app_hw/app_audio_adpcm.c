@@ -0,0 +1,176 @@
+/**
+ * @file app_audio_adpcm.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the IMA-ADPCM sound effect decoder. Decodes 4-bit
+ * codes from flash into signed 16-bit samples for the mixer
+ *
+ * @version 0.1
+ * @date 2024-12-8
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_adpcm.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define ADPCM_MAX_STEP_INDEX    (88)
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static const int16_t adpcm_step_table[ADPCM_MAX_STEP_INDEX + 1] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t adpcm_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Apply a single 4-bit code to the decoder state
+ *
+ * @param app_audio_adpcm_decoder_s*
+ * Decoder to update
+ * @param uint8_t
+ * 4-bit ADPCM code
+ */
+static inline void app_audio_adpcm_step(app_audio_adpcm_decoder_s* dec, uint8_t code)
+{
+    const int32_t step = adpcm_step_table[dec->step_index];
+    int32_t diff = step >> 3;
+
+    if (code & 4) { diff += step; }
+    if (code & 2) { diff += step >> 1; }
+    if (code & 1) { diff += step >> 2; }
+
+    int32_t predictor = (code & 8) ? (dec->predictor - diff) : (dec->predictor + diff);
+    if (predictor > INT16_MAX)
+    {
+        predictor = INT16_MAX;
+    }
+    else if (predictor < INT16_MIN)
+    {
+        predictor = INT16_MIN;
+    }
+    dec->predictor = predictor;
+
+    int32_t step_index = dec->step_index + adpcm_index_table[code];
+    if (step_index < 0)
+    {
+        step_index = 0;
+    }
+    else if (step_index > ADPCM_MAX_STEP_INDEX)
+    {
+        step_index = ADPCM_MAX_STEP_INDEX;
+    }
+    dec->step_index = step_index;
+}
+
+
+/**
+ * @brief  Prepare a decoder to play a clip from the start
+ *
+ * @param app_audio_adpcm_decoder_s*
+ * Decoder to initialize
+ * @param const uint8_t*
+ * Start of the clip's ADPCM blocks
+ * @param uint32_t
+ * Number of samples in the clip
+ */
+void app_audio_adpcm_init(app_audio_adpcm_decoder_s* dec, const uint8_t* data, uint32_t n_samples)
+{
+    dec->data = data;
+    dec->n_samples = n_samples;
+    dec->pos = 0;
+    dec->predictor = 0;
+    dec->step_index = 0;
+}
+
+
+/**
+ * @brief  Decode the next samples of a clip
+ *
+ * @param app_audio_adpcm_decoder_s*
+ * Decoder to read from
+ * @param int16_t*
+ * Buffer to write signed 16-bit samples to
+ * @param uint32_t
+ * Maximum number of samples to decode
+ * @return uint32_t
+ * Number of samples written. Less than n_out once the end of the clip is reached
+ */
+uint32_t app_audio_adpcm_decode(app_audio_adpcm_decoder_s* dec, int16_t* out, uint32_t n_out)
+{
+    uint32_t n_decoded = 0;
+    const uint32_t n_remaining = app_audio_adpcm_remaining(dec);
+
+    if (n_out > n_remaining)
+    {
+        n_out = n_remaining;
+    }
+
+    while (n_decoded < n_out)
+    {
+        const uint32_t block = dec->pos / APP_AUDIO_ADPCM_BLOCK_SAMPLES;
+        uint32_t offset = dec->pos % APP_AUDIO_ADPCM_BLOCK_SAMPLES;
+        const uint8_t* p_block = dec->data + (block * APP_AUDIO_ADPCM_BLOCK_BYTES);
+
+        if (offset == 0)
+        {
+            // Block header resets the decoder state and holds the first sample
+            dec->predictor = (int16_t)(p_block[0] | (p_block[1] << 8));
+            dec->step_index = (p_block[2] > ADPCM_MAX_STEP_INDEX) ? ADPCM_MAX_STEP_INDEX : p_block[2];
+            out[n_decoded++] = (int16_t)dec->predictor;
+            offset++;
+        }
+
+        // Decode the rest of this block, or as many samples as requested
+        uint32_t n_block = APP_AUDIO_ADPCM_BLOCK_SAMPLES - offset;
+        if (n_block > (n_out - n_decoded))
+        {
+            n_block = n_out - n_decoded;
+        }
+
+        const uint8_t* p_codes = p_block + APP_AUDIO_ADPCM_BLOCK_HEADER_BYTES;
+        for (uint32_t i = offset - 1; i < (offset - 1 + n_block); i++)
+        {
+            const uint8_t code = (i & 1) ? (p_codes[i >> 1] >> 4) : (p_codes[i >> 1] & 0xF);
+            app_audio_adpcm_step(dec, code);
+            out[n_decoded++] = (int16_t)dec->predictor;
+        }
+
+        dec->pos = (block * APP_AUDIO_ADPCM_BLOCK_SAMPLES) + offset + n_block;
+    }
+
+    return n_decoded;
+}
+
+
+/**
+ * @brief  Get the number of samples left to decode
+ *
+ * @param const app_audio_adpcm_decoder_s*
+ * Decoder to check
+ * @return uint32_t
+ * Number of samples that have not been decoded yet
+ */
+uint32_t app_audio_adpcm_remaining(const app_audio_adpcm_decoder_s* dec)
+{
+    return dec->n_samples - dec->pos;
+}
+
+/* [] END OF FILE */
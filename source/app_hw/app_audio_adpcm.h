@@ -0,0 +1,48 @@
+/**
+ * @file app_audio_adpcm.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the IMA-ADPCM sound effect decoder
+ *
+ * @version 0.1
+ * @date 2024-12-8
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_ADPCM_H__
+#define __APP_AUDIO_ADPCM_H__
+
+// Include Standard C Libraries
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: Samples are stored in fixed-size mono IMA-ADPCM blocks (same layout as a WAV
+//       file's IMA-ADPCM data chunk). Each block starts with a 4 byte header holding the
+//       first sample (int16, little endian) and the step index, followed by 4-bit codes
+//       for the rest of the block's samples, low nibble first. The final block of a clip
+//       may be truncated, so the decoder also needs the clip's sample count
+#define APP_AUDIO_ADPCM_BLOCK_BYTES            (256U)
+#define APP_AUDIO_ADPCM_BLOCK_HEADER_BYTES     (4U)
+#define APP_AUDIO_ADPCM_BLOCK_SAMPLES          (1U + (2U * (APP_AUDIO_ADPCM_BLOCK_BYTES - APP_AUDIO_ADPCM_BLOCK_HEADER_BYTES)))
+
+// Decoder state for a single clip
+typedef struct
+{
+    const uint8_t* data;  // Start of the clip's ADPCM blocks
+    uint32_t n_samples;   // Total number of samples in the clip
+    uint32_t pos;         // Index of the next sample to decode
+    int32_t predictor;    // Last decoded sample (signed 16-bit)
+    int32_t step_index;   // Index into the step size table
+} app_audio_adpcm_decoder_s;
+
+
+// Function declarations
+void app_audio_adpcm_init(app_audio_adpcm_decoder_s* dec, const uint8_t* data, uint32_t n_samples);
+uint32_t app_audio_adpcm_decode(app_audio_adpcm_decoder_s* dec, int16_t* out, uint32_t n_out);
+uint32_t app_audio_adpcm_remaining(const app_audio_adpcm_decoder_s* dec);
+
+
+#endif // __APP_AUDIO_ADPCM_H__
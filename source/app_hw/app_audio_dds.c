@@ -0,0 +1,325 @@
+/**
+ * @file app_audio_dds.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the DDS tone generator. A 32-bit phase accumulator is
+ * advanced by a tuning word every output sample, and the top bits of the
+ * phase index a sine table (with linear interpolation between entries).
+ * Sweeping the tuning word gives chirps, and since the phase is never reset
+ * between segments, pitch changes are free of discontinuities.
+ *
+ * Tones are added to the mixer's output block, so they play alongside sound
+ * effects at the same fixed sample rate. None of these functions are
+ * reentrant; callers must keep app_audio_dds_render (which runs from the
+ * audio DMA interrupt) out while changing what is played
+ *
+ * @version 0.1
+ * @date 2024-12-12
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_dds.h"
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define DDS_LUT_BITS        (8U)
+#define DDS_LUT_SIZE        (1U << DDS_LUT_BITS)
+#define DDS_MS_TO_SAMPLES(MS)    (((uint32_t)(MS) * APP_AUDIO_MIXER_SAMPLE_RATE_HZ) / 1000UL)
+#define DDS_RAMP_SAMPLES    (DDS_MS_TO_SAMPLES(APP_AUDIO_DDS_RAMP_MS))
+
+typedef struct
+{
+    app_audio_dds_segment_s segments[APP_AUDIO_DDS_MAX_SEGMENTS];
+    uint8_t n_segments;
+    uint8_t segment_idx;         // n_segments while fading out after the last segment
+    bool active;
+    bool hold;                   // Current segment plays until replaced
+    uint32_t segment_left;       // Samples left in the current segment
+    uint32_t phase;
+    uint32_t tuning_word;
+    int32_t tuning_step;         // Added to the tuning word every sample while sweeping
+    int32_t amp;                 // Q15 amplitude << 16, so ramps can take fractional steps
+    int32_t amp_target;
+    int32_t amp_step;
+    uint32_t ramp_left;
+} app_audio_dds_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// One period of a sine wave in Q15, with the first entry repeated at the end so
+// that interpolation never has to wrap
+static const int16_t app_audio_dds_sine_lut[DDS_LUT_SIZE + 1] = {
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+      6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+     12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+     18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+     23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+     27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+     32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+     32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+     32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+     30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+     27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+     18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+     12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+      6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+         0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+     -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+    -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+    -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+    -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+    -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+     -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804,
+         0
+};
+
+static app_audio_dds_s app_audio_dds;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Look up the sine of a phase, interpolating between the two table
+ *         entries it falls between
+ *
+ * @param uint32_t
+ * Phase, where 2^32 is a full period
+ * @return int16_t
+ * Q15 sine of the phase
+ */
+int16_t app_audio_dds_sine(uint32_t phase)
+{
+    const uint32_t idx = phase >> (32U - DDS_LUT_BITS);
+    const int32_t frac = (int32_t)((phase >> (16U - DDS_LUT_BITS)) & 0xFFFF);
+    const int32_t a = app_audio_dds_sine_lut[idx];
+    const int32_t b = app_audio_dds_sine_lut[idx + 1];
+
+    return (int16_t)(a + (((b - a) * frac) >> 16));
+}
+
+
+/**
+ * @brief  Ramp the amplitude to a new value
+ *
+ * @param int16_t
+ * Q15 amplitude to ramp to
+ * @param uint32_t
+ * Number of samples to ramp over (at least 1)
+ */
+static void app_audio_dds_ramp_to(int16_t gain, uint32_t n_samples)
+{
+    app_audio_dds.amp_target = (int32_t)gain << 16;
+    app_audio_dds.amp_step = (app_audio_dds.amp_target - app_audio_dds.amp) / (int32_t)n_samples;
+    app_audio_dds.ramp_left = n_samples;
+}
+
+
+/**
+ * @brief  Start the segment at app_audio_dds.segment_idx, or fade out if there
+ *         are no segments left
+ *
+ * @return void
+ */
+static void app_audio_dds_start_segment(void)
+{
+    if (app_audio_dds.segment_idx >= app_audio_dds.n_segments)
+    {
+        // Keep the last pitch while fading out
+        app_audio_dds.hold = false;
+        app_audio_dds.segment_left = DDS_RAMP_SAMPLES;
+        app_audio_dds.tuning_step = 0;
+        app_audio_dds_ramp_to(0, DDS_RAMP_SAMPLES);
+        return;
+    }
+
+    const app_audio_dds_segment_s* segment = &app_audio_dds.segments[app_audio_dds.segment_idx];
+    const uint32_t tuning_start = APP_AUDIO_DDS_TUNING_WORD(segment->freq_start_hz);
+    const uint32_t tuning_end = APP_AUDIO_DDS_TUNING_WORD(segment->freq_end_hz);
+
+    app_audio_dds.tuning_word = tuning_start;
+    if (APP_AUDIO_DDS_HOLD == segment->duration_ms)
+    {
+        app_audio_dds.hold = true;
+        app_audio_dds.segment_left = 0;
+        app_audio_dds.tuning_step = 0;
+        app_audio_dds_ramp_to(segment->gain, DDS_RAMP_SAMPLES);
+    }
+    else
+    {
+        const uint32_t n_samples = (DDS_MS_TO_SAMPLES(segment->duration_ms) > 0) ? DDS_MS_TO_SAMPLES(segment->duration_ms) : 1;
+
+        app_audio_dds.hold = false;
+        app_audio_dds.segment_left = n_samples;
+        app_audio_dds.tuning_step = (int32_t)(((int64_t)tuning_end - (int64_t)tuning_start) / (int64_t)n_samples);
+        app_audio_dds_ramp_to(segment->gain, (n_samples < DDS_RAMP_SAMPLES) ? n_samples : DDS_RAMP_SAMPLES);
+    }
+}
+
+
+/**
+ * @brief  Synthesize samples and add them to the output, all within one segment
+ *
+ * @param int16_t*
+ * Samples to add to
+ * @param uint32_t
+ * Number of samples
+ */
+static void app_audio_dds_render_run(int16_t* out, uint32_t n_samples)
+{
+    uint32_t phase = app_audio_dds.phase;
+    uint32_t tuning_word = app_audio_dds.tuning_word;
+    const int32_t tuning_step = app_audio_dds.tuning_step;
+    int32_t amp = app_audio_dds.amp;
+
+    for (uint32_t i = 0; i < n_samples; i++)
+    {
+        if (app_audio_dds.ramp_left > 0)
+        {
+            amp = (--app_audio_dds.ramp_left == 0) ? app_audio_dds.amp_target : (amp + app_audio_dds.amp_step);
+        }
+
+        const int32_t sine = app_audio_dds_sine(phase);
+        int32_t sample = out[i] + ((sine * (amp >> 16)) >> 15);
+        out[i] = (int16_t)((sample > INT16_MAX) ? INT16_MAX : ((sample < INT16_MIN) ? INT16_MIN : sample));
+
+        phase += tuning_word;
+        tuning_word += (uint32_t)tuning_step;
+    }
+
+    app_audio_dds.phase = phase;
+    app_audio_dds.tuning_word = tuning_word;
+    app_audio_dds.amp = amp;
+}
+
+
+/**
+ * @brief  Initialize the tone generator (silent)
+ *
+ * @return void
+ */
+void app_audio_dds_init(void)
+{
+    memset(&app_audio_dds, 0, sizeof(app_audio_dds));
+}
+
+
+/**
+ * @brief  Play a sequence of tones, replacing whatever is playing. The phase
+ *         carries over and the amplitude ramps from its current value, so
+ *         switching is click-free
+ *
+ * @param const app_audio_dds_segment_s*
+ * Segments to play in order (copied)
+ * @param uint8_t
+ * Number of segments (up to APP_AUDIO_DDS_MAX_SEGMENTS)
+ */
+void app_audio_dds_play(const app_audio_dds_segment_s* segments, uint8_t n_segments)
+{
+    if (n_segments > APP_AUDIO_DDS_MAX_SEGMENTS)
+    {
+        n_segments = APP_AUDIO_DDS_MAX_SEGMENTS;
+    }
+
+    if (!app_audio_dds.active)
+    {
+        // Start from silence at a zero crossing
+        app_audio_dds.phase = 0;
+        app_audio_dds.amp = 0;
+    }
+
+    memcpy(app_audio_dds.segments, segments, n_segments * sizeof(app_audio_dds_segment_s));
+    app_audio_dds.n_segments = n_segments;
+    app_audio_dds.segment_idx = 0;
+    app_audio_dds_start_segment();
+    app_audio_dds.active = true;
+}
+
+
+/**
+ * @brief  Fade out whatever is playing
+ *
+ * @return void
+ */
+void app_audio_dds_stop(void)
+{
+    if (app_audio_dds.active)
+    {
+        app_audio_dds.segment_idx = app_audio_dds.n_segments;
+        app_audio_dds_start_segment();
+    }
+}
+
+
+/**
+ * @brief  Check whether a tone is playing (including fading out)
+ *
+ * @return bool
+ * true if tones are still being synthesized
+ */
+bool app_audio_dds_active(void)
+{
+    return app_audio_dds.active;
+}
+
+
+/**
+ * @brief  Add the next block of tones to the mixer's output
+ *
+ * @param int16_t*
+ * Block of APP_AUDIO_MIXER_BLOCK_SAMPLES mixed samples to add to
+ */
+void app_audio_dds_render(int16_t* out)
+{
+    uint32_t n_left = APP_AUDIO_MIXER_BLOCK_SAMPLES;
+
+    while (app_audio_dds.active && (n_left > 0))
+    {
+        uint32_t n_samples = n_left;
+
+        if (!app_audio_dds.hold && (app_audio_dds.segment_left < n_samples))
+        {
+            n_samples = app_audio_dds.segment_left;
+        }
+
+        app_audio_dds_render_run(out, n_samples);
+        out += n_samples;
+        n_left -= n_samples;
+
+        if (!app_audio_dds.hold)
+        {
+            app_audio_dds.segment_left -= n_samples;
+            if (app_audio_dds.segment_left == 0)
+            {
+                if (app_audio_dds.segment_idx >= app_audio_dds.n_segments)
+                {
+                    // Finished fading out
+                    app_audio_dds.active = false;
+                }
+                else
+                {
+                    app_audio_dds.segment_idx++;
+                    app_audio_dds_start_segment();
+                }
+            }
+        }
+    }
+}
+
+/* [] END OF FILE */
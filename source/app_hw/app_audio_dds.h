@@ -0,0 +1,57 @@
+/**
+ * @file app_audio_dds.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the direct digital synthesis (DDS) tone generator, which
+ * synthesizes tones, chirps, and tone sequences into the mixer output
+ *
+ * @version 0.1
+ * @date 2024-12-12
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_DDS_H__
+#define __APP_AUDIO_DDS_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "app_audio_mixer.h"
+
+
+// Defines
+// NOTE: Tones are synthesized at the mixer's fixed output rate, so the frequency
+//       resolution is APP_AUDIO_MIXER_SAMPLE_RATE_HZ / 2^32 (~5uHz) and changing
+//       pitch never touches the CTDAC clock
+#define APP_AUDIO_DDS_MAX_SEGMENTS     (8U)
+// Amplitude changes are ramped over this long to avoid clicks
+#define APP_AUDIO_DDS_RAMP_MS          (5U)
+// Segment duration that holds the segment until another tone is played
+#define APP_AUDIO_DDS_HOLD             (0U)
+
+// Convert a frequency to a 32-bit phase increment per output sample
+#define APP_AUDIO_DDS_TUNING_WORD(HZ)  ((uint32_t)(((uint64_t)(HZ) << 32) / APP_AUDIO_MIXER_SAMPLE_RATE_HZ))
+
+// One step of a tone sequence. The frequency sweeps linearly from freq_start_hz
+// to freq_end_hz over the segment (a chirp), or stays put if they are equal
+typedef struct
+{
+    uint16_t freq_start_hz;
+    uint16_t freq_end_hz;
+    int16_t gain;          // Q15 amplitude, ramped to from the previous segment
+    uint16_t duration_ms;  // APP_AUDIO_DDS_HOLD to play until replaced
+} app_audio_dds_segment_s;
+
+
+// Function declarations
+void app_audio_dds_init(void);
+void app_audio_dds_play(const app_audio_dds_segment_s* segments, uint8_t n_segments);
+void app_audio_dds_stop(void);
+bool app_audio_dds_active(void);
+void app_audio_dds_render(int16_t* out);
+int16_t app_audio_dds_sine(uint32_t phase);
+
+
+#endif // __APP_AUDIO_DDS_H__
@@ -0,0 +1,201 @@
+/**
+ * @file app_audio_engine.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the engine sound. The car task sets the engine's speed
+ * with a single word store and never waits on the audio driver. The audio
+ * DMA interrupt reads that word once per block, glides towards it, and works
+ * out the pitch, filter, and level for the block, so the per-sample loop is
+ * one oscillator, one filter, and a saturating add into the mixer output.
+ *
+ * The engine is added after the mixer has rendered its voices, so it can be
+ * ducked whenever a sound effect is playing
+ *
+ * @version 0.1
+ * @date 2024-12-16
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_engine.h"
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+// The target is packed into one word so a single store updates it
+#define ENGINE_TARGET_RUNNING     (1UL << 8)
+#define ENGINE_TARGET_SPEED(T)    ((T) & 0xFFUL)
+
+#define ENGINE_TUNING_WORD(HZ)    ((uint32_t)(((uint64_t)(HZ) << 32) / APP_AUDIO_MIXER_SAMPLE_RATE_HZ))
+// One-pole low-pass coefficient w / (1 + w) in Q15, where w = 2 * pi * HZ / sample rate
+#define ENGINE_W_Q15(HZ)          ((205887ULL * (HZ)) / APP_AUDIO_MIXER_SAMPLE_RATE_HZ)
+#define ENGINE_LP_COEF(HZ)        ((int32_t)((ENGINE_W_Q15(HZ) << 15) / (32768ULL + ENGINE_W_Q15(HZ))))
+#define ENGINE_FILTER_SHIFT       (8U)
+
+// Interpolate between the idle and full speed values of a parameter
+#define ENGINE_LERP(IDLE, MAX, SPEED_Q8) \
+    ((int32_t)(IDLE) + (int32_t)((((int64_t)(MAX) - (int64_t)(IDLE)) * (SPEED_Q8)) / (APP_AUDIO_ENGINE_MAX_SPEED << 8)))
+
+typedef struct
+{
+    uint32_t phase;
+    int32_t sub;                 // Square wave an octave down, flipped every period
+    int32_t speed;               // Speed after gliding, << 16
+    int32_t gain;                // Q15 level << 16, ramped across each block
+    int32_t filter_state;        // Q15 output of the low-pass << ENGINE_FILTER_SHIFT
+} app_audio_engine_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static app_audio_engine_s app_audio_engine;
+// Only written by the car task, and only read by the audio DMA interrupt
+static volatile uint32_t app_audio_engine_target = 0;
+static volatile uint32_t app_audio_engine_updates = 0;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Initialize the engine sound (stopped)
+ *
+ * @return void
+ */
+void app_audio_engine_init(void)
+{
+    memset(&app_audio_engine, 0, sizeof(app_audio_engine));
+    app_audio_engine.sub = INT16_MAX / 2;
+    app_audio_engine_target = 0;
+}
+
+
+/**
+ * @brief  Set what the engine should sound like. Lock-free, so the car's
+ *         control loop can call it on every step without blocking. Only one
+ *         task may call it
+ *
+ * @param bool
+ * true while the engine should be heard (idling when the speed is 0)
+ * @param uint8_t
+ * Speed, from 0 to APP_AUDIO_ENGINE_MAX_SPEED
+ */
+void app_audio_engine_set(bool running, uint8_t speed)
+{
+    if (speed > APP_AUDIO_ENGINE_MAX_SPEED)
+    {
+        speed = APP_AUDIO_ENGINE_MAX_SPEED;
+    }
+
+    // A single aligned word store, which the interrupt can't see half of
+    app_audio_engine_target = (running ? ENGINE_TARGET_RUNNING : 0UL) | speed;
+    app_audio_engine_updates++;
+}
+
+
+/**
+ * @brief  Get the speed the engine was last set to
+ *
+ * @return uint8_t
+ * Speed, from 0 to APP_AUDIO_ENGINE_MAX_SPEED
+ */
+uint8_t app_audio_engine_get_speed(void)
+{
+    return (uint8_t)ENGINE_TARGET_SPEED(app_audio_engine_target);
+}
+
+
+/**
+ * @brief  Get how many times the engine has been set, to measure how often the
+ *         car updates it
+ *
+ * @return uint32_t
+ * Number of calls to app_audio_engine_set (wraps)
+ */
+uint32_t app_audio_engine_n_updates(void)
+{
+    return app_audio_engine_updates;
+}
+
+
+/**
+ * @brief  Check whether the engine is being heard (including fading out)
+ *
+ * @return bool
+ * true if the engine is adding to the output
+ */
+bool app_audio_engine_active(void)
+{
+    return ((app_audio_engine_target & ENGINE_TARGET_RUNNING) != 0) || (app_audio_engine.gain != 0);
+}
+
+
+/**
+ * @brief  Add the next block of the engine sound to the mixer's output
+ *
+ * @param int16_t*
+ * Block of APP_AUDIO_MIXER_BLOCK_SAMPLES mixed samples to add to
+ * @param bool
+ * true to duck the engine under sound effects that are playing
+ */
+void app_audio_engine_render(int16_t* out, bool duck)
+{
+    const uint32_t target = app_audio_engine_target;
+    const bool running = (target & ENGINE_TARGET_RUNNING) != 0;
+
+    if (!running && (0 == app_audio_engine.gain))
+    {
+        // Stopped and faded out, so there is nothing to add
+        return;
+    }
+
+    // Glide towards the target speed, then work out the block's parameters from it
+    app_audio_engine.speed += (((int32_t)ENGINE_TARGET_SPEED(target) << 16) - app_audio_engine.speed) >>
+                              APP_AUDIO_ENGINE_GLIDE_SHIFT;
+    const int32_t speed_q8 = app_audio_engine.speed >> 8;
+    const uint32_t tuning_word = (uint32_t)ENGINE_LERP(ENGINE_TUNING_WORD(APP_AUDIO_ENGINE_IDLE_HZ),
+                                                       ENGINE_TUNING_WORD(APP_AUDIO_ENGINE_MAX_HZ),
+                                                       speed_q8);
+    const int32_t filter_coef = ENGINE_LERP(ENGINE_LP_COEF(APP_AUDIO_ENGINE_IDLE_CUTOFF_HZ),
+                                            ENGINE_LP_COEF(APP_AUDIO_ENGINE_MAX_CUTOFF_HZ),
+                                            speed_q8);
+    int32_t gain_target = running ? ENGINE_LERP(APP_AUDIO_ENGINE_IDLE_GAIN, APP_AUDIO_ENGINE_MAX_GAIN, speed_q8) : 0;
+    if (duck)
+    {
+        gain_target = (gain_target * APP_AUDIO_ENGINE_DUCK_GAIN) >> 15;
+    }
+
+    // Ramp the level across the block rather than step it
+    const int32_t gain_step = ((gain_target << 16) - app_audio_engine.gain) / (int32_t)APP_AUDIO_MIXER_BLOCK_SAMPLES;
+    uint32_t phase = app_audio_engine.phase;
+    int32_t sub = app_audio_engine.sub;
+    int32_t gain = app_audio_engine.gain;
+    int32_t filter_state = app_audio_engine.filter_state;
+
+    for (uint32_t i = 0; i < APP_AUDIO_MIXER_BLOCK_SAMPLES; i++)
+    {
+        const int32_t saw = ((int32_t)(phase >> 16) - 32768) / 2;
+
+        filter_state += (int32_t)(((int64_t)(((saw + sub) << ENGINE_FILTER_SHIFT) - filter_state) * filter_coef) >> 15);
+        const int32_t sample = out[i] + (((filter_state >> ENGINE_FILTER_SHIFT) * (gain >> 16)) >> 15);
+        out[i] = (int16_t)((sample > INT16_MAX) ? INT16_MAX : ((sample < INT16_MIN) ? INT16_MIN : sample));
+
+        const uint32_t next_phase = phase + tuning_word;
+        if (next_phase < phase)
+        {
+            sub = -sub;
+        }
+        phase = next_phase;
+        gain += gain_step;
+    }
+
+    app_audio_engine.phase = phase;
+    app_audio_engine.sub = sub;
+    // Land exactly on the target so a stopped engine reaches silence
+    app_audio_engine.gain = gain_target << 16;
+    app_audio_engine.filter_state = filter_state;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,51 @@
+/**
+ * @file app_audio_engine.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the engine sound, a continuous voice whose pitch, tone, and
+ * level follow the car's speed, mixed under sound effects
+ *
+ * @version 0.1
+ * @date 2024-12-16
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_ENGINE_H__
+#define __APP_AUDIO_ENGINE_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "app_audio_mixer.h"
+
+
+// Defines
+// NOTE: The engine is a saw wave at the firing rate plus a square wave an octave below it,
+//       through a one-pole low-pass that opens up with speed. Speed changes glide over
+//       roughly APP_AUDIO_ENGINE_GLIDE_BLOCKS mixer blocks, so steps from the car's motor
+//       ramp don't zipper
+#define APP_AUDIO_ENGINE_IDLE_HZ          (45U)
+#define APP_AUDIO_ENGINE_MAX_HZ           (180U)
+#define APP_AUDIO_ENGINE_IDLE_CUTOFF_HZ   (400U)
+#define APP_AUDIO_ENGINE_MAX_CUTOFF_HZ    (3000U)
+#define APP_AUDIO_ENGINE_IDLE_GAIN        (2500)  // Q15
+#define APP_AUDIO_ENGINE_MAX_GAIN         (9000)  // Q15
+// Scale applied to the engine while any sound effect is playing
+#define APP_AUDIO_ENGINE_DUCK_GAIN        (9830)  // Q15 (-10.5dB)
+#define APP_AUDIO_ENGINE_GLIDE_SHIFT      (4U)
+#define APP_AUDIO_ENGINE_GLIDE_BLOCKS     (1U << APP_AUDIO_ENGINE_GLIDE_SHIFT)
+#define APP_AUDIO_ENGINE_MAX_SPEED        (100U)
+
+
+// Function declarations
+void app_audio_engine_init(void);
+void app_audio_engine_set(bool running, uint8_t speed);
+uint8_t app_audio_engine_get_speed(void);
+uint32_t app_audio_engine_n_updates(void);
+bool app_audio_engine_active(void);
+void app_audio_engine_render(int16_t* out, bool duck);
+
+
+#endif // __APP_AUDIO_ENGINE_H__
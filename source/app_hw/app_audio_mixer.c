@@ -0,0 +1,602 @@
+/**
+ * @file app_audio_mixer.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the software audio mixer. Each active voice is decoded
+ * (and resampled from its asset's native rate) or synthesized into a scratch
+ * block, scaled by its gain, and summed into the output block with saturating
+ * adds so that overlapping sound effects clip instead of wrapping around.
+ *
+ * Only the cycle counter and the DSP intrinsics depend on the target, so
+ * this file can also be built on a host to benchmark the mixer
+ *
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_mixer.h"
+#include <string.h>
+
+#if defined(__ARM_ARCH)
+#include "cy_pdl.h"
+#else
+#include <time.h>
+#endif
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#if defined(__ARM_ARCH)
+// DWT cycle counter of the CM4
+#define MIXER_CYCLE_COUNT()    (DWT->CYCCNT)
+#else
+// Host builds count nanoseconds instead of cycles
+#define MIXER_CYCLE_COUNT()    (app_audio_mixer_host_cycle_count())
+#endif
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+// Saturating add of two pairs of int16 samples in one instruction
+#define MIXER_QADD16(A, B)    (__QADD16((A), (B)))
+#else
+#define MIXER_QADD16(A, B)    (app_audio_mixer_qadd16((A), (B)))
+#endif
+
+// Convert 12-bit DAC samples to the signed 16-bit mixing domain
+#define MIXER_DAC_TO_S16(U)    ((int16_t)(((int32_t)(U) - 2048) * 16))
+
+// Samples held by one stream block
+#define MIXER_STREAM_BLOCK_SAMPLES(FORMAT)    ((AUDIO_ASSET_FORMAT_ADPCM == (FORMAT)) ? \
+                                               APP_AUDIO_ADPCM_BLOCK_SAMPLES : \
+                                               (APP_AUDIO_STREAM_BLOCK_BYTES / sizeof(uint16_t)))
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static app_audio_voice_s app_audio_mixer_voices[APP_AUDIO_MIXER_N_VOICES];
+// Scratch block each voice is rendered into before being mixed
+static int16_t app_audio_mixer_voice_buf[APP_AUDIO_MIXER_BLOCK_SAMPLES];
+// Input to the resampler. Upsampling never needs more input than output samples
+static int16_t app_audio_mixer_resampler_buf[APP_AUDIO_RESAMPLER_TAPS + APP_AUDIO_MIXER_BLOCK_SAMPLES];
+static app_audio_mixer_stats_s app_audio_mixer_stats;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+#if !defined(__ARM_ARCH)
+/**
+ * @brief  Stand-in for the cycle counter on host builds
+ *
+ * @return uint32_t
+ * Monotonic time in nanoseconds (wraps like the cycle counter)
+ */
+static inline uint32_t app_audio_mixer_host_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+}
+#endif
+
+
+#if !(defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1))
+/**
+ * @brief  Portable equivalent of the QADD16 instruction
+ *
+ * @param uint32_t
+ * Two packed int16 values
+ * @param uint32_t
+ * Two packed int16 values
+ * @return uint32_t
+ * Saturated sums of the low and high halves, packed the same way
+ */
+static inline uint32_t app_audio_mixer_qadd16(uint32_t a, uint32_t b)
+{
+    int32_t lo = (int32_t)(int16_t)(a & 0xFFFF) + (int32_t)(int16_t)(b & 0xFFFF);
+    int32_t hi = (int32_t)(int16_t)(a >> 16) + (int32_t)(int16_t)(b >> 16);
+
+    lo = (lo > INT16_MAX) ? INT16_MAX : ((lo < INT16_MIN) ? INT16_MIN : lo);
+    hi = (hi > INT16_MAX) ? INT16_MAX : ((hi < INT16_MIN) ? INT16_MIN : hi);
+
+    return ((uint32_t)(uint16_t)hi << 16) | (uint16_t)lo;
+}
+#endif
+
+
+/**
+ * @brief  Read the next samples of a voice's asset from its stream, a block at
+ *         a time. Blocks are released back to the stream as soon as they have
+ *         been played
+ *
+ * @param uint8_t
+ * Index of the voice (and its stream)
+ * @param int16_t*
+ * Where to write the samples
+ * @param uint32_t
+ * Number of samples to read (no more than are left in the asset)
+ * @return uint32_t
+ * Number of samples read. Less than requested if the stream underran
+ */
+static uint32_t app_audio_mixer_read_stream(uint8_t voice_idx, int16_t* out, uint32_t n_samples)
+{
+    app_audio_voice_s* voice = &app_audio_mixer_voices[voice_idx];
+    const audio_asset_s* asset = voice->asset;
+    const uint32_t block_samples = MIXER_STREAM_BLOCK_SAMPLES(asset->format);
+    uint32_t n_read = 0;
+
+    while (n_read < n_samples)
+    {
+        if (0 == voice->block_left)
+        {
+            voice->block = app_audio_stream_peek(voice_idx);
+            if (NULL == voice->block)
+            {
+                // Underrun. Pick up where it left off on the next block
+                break;
+            }
+            const uint32_t asset_left = voice->n_samples - (voice->pos + n_read);
+            voice->block_left = (asset_left < block_samples) ? asset_left : block_samples;
+            if (AUDIO_ASSET_FORMAT_ADPCM == asset->format)
+            {
+                // Each ADPCM block carries its own predictor, so blocks decode independently
+                app_audio_adpcm_init(&voice->decoder, voice->block, voice->block_left);
+            }
+        }
+
+        uint32_t n = ((n_samples - n_read) < voice->block_left) ? (n_samples - n_read) : voice->block_left;
+        if (AUDIO_ASSET_FORMAT_ADPCM == asset->format)
+        {
+            n = app_audio_adpcm_decode(&voice->decoder, &out[n_read], n);
+        }
+        else
+        {
+            // Blocks start on a multiple of block_samples, and the last one is cut short
+            const uint16_t* src = &((const uint16_t*)voice->block)[(voice->pos + n_read) % block_samples];
+            for (uint32_t i = 0; i < n; i++)
+            {
+                out[n_read + i] = MIXER_DAC_TO_S16(src[i]);
+            }
+        }
+        n_read += n;
+        voice->block_left -= n;
+
+        if (0 == voice->block_left)
+        {
+            app_audio_stream_release(voice_idx);
+        }
+    }
+
+    return n_read;
+}
+
+
+/**
+ * @brief  Read the next samples of a voice's asset, at the asset's sample rate
+ *
+ * @param uint8_t
+ * Index of the voice to read from
+ * @param int16_t*
+ * Where to write the samples
+ * @param uint32_t
+ * Most samples to read
+ * @return uint32_t
+ * Number of samples read. Less than requested once the asset ends, or if its
+ * stream underran
+ */
+static uint32_t app_audio_mixer_read_voice(uint8_t voice_idx, int16_t* out, uint32_t n_samples)
+{
+    app_audio_voice_s* voice = &app_audio_mixer_voices[voice_idx];
+    const audio_asset_s* asset = voice->asset;
+
+    if (n_samples > (voice->n_samples - voice->pos))
+    {
+        n_samples = voice->n_samples - voice->pos;
+    }
+
+    if (voice->streamed)
+    {
+        n_samples = app_audio_mixer_read_stream(voice_idx, out, n_samples);
+    }
+    else if (AUDIO_ASSET_FORMAT_ADPCM == asset->format)
+    {
+        n_samples = app_audio_adpcm_decode(&voice->decoder, out, n_samples);
+    }
+    else
+    {
+        const uint16_t* src = &((const uint16_t*)asset->data)[voice->pos];
+        for (uint32_t i = 0; i < n_samples; i++)
+        {
+            out[i] = MIXER_DAC_TO_S16(src[i]);
+        }
+    }
+    voice->pos += n_samples;
+
+    return n_samples;
+}
+
+
+/**
+ * @brief  Render the next block of a voice into the scratch buffer
+ *
+ * @param uint8_t
+ * Index of the voice to render
+ * @return uint32_t
+ * Number of samples rendered. Less than a full block once the voice ends
+ */
+static uint32_t app_audio_mixer_render_voice(uint8_t voice_idx)
+{
+    app_audio_voice_s* voice = &app_audio_mixer_voices[voice_idx];
+    uint32_t n_samples;
+
+    if (AUDIO_ASSET_FORMAT_SYNTH == voice->asset->format)
+    {
+        // Synthesized straight at the output rate
+        n_samples = app_audio_synth_render(&voice->synth, app_audio_mixer_voice_buf, APP_AUDIO_MIXER_BLOCK_SAMPLES);
+        voice->pos += n_samples;
+    }
+    else if (voice->resample)
+    {
+        // Read just enough input for a full block of output, padding the end of
+        // the asset (or an underrun) with silence
+        int16_t* in = &app_audio_mixer_resampler_buf[APP_AUDIO_RESAMPLER_TAPS];
+        const uint32_t n_in = app_audio_resampler_n_in(&voice->resampler, APP_AUDIO_MIXER_BLOCK_SAMPLES);
+        const uint32_t n_read = app_audio_mixer_read_voice(voice_idx, in, n_in);
+
+        memset(&in[n_read], 0, (n_in - n_read) * sizeof(in[0]));
+        app_audio_resampler_process(&voice->resampler,
+                                    app_audio_mixer_resampler_buf,
+                                    app_audio_mixer_voice_buf,
+                                    APP_AUDIO_MIXER_BLOCK_SAMPLES);
+        n_samples = APP_AUDIO_MIXER_BLOCK_SAMPLES;
+    }
+    else
+    {
+        n_samples = app_audio_mixer_read_voice(voice_idx, app_audio_mixer_voice_buf, APP_AUDIO_MIXER_BLOCK_SAMPLES);
+    }
+
+    if (voice->gain != APP_AUDIO_MIXER_GAIN_UNITY)
+    {
+        for (uint32_t i = 0; i < n_samples; i++)
+        {
+            app_audio_mixer_voice_buf[i] = (int16_t)(((int32_t)app_audio_mixer_voice_buf[i] * voice->gain) >> 15);
+        }
+    }
+
+    return n_samples;
+}
+
+
+/**
+ * @brief  Add the cost of rendering one block of a voice to the per-rate stats
+ *
+ * @param const audio_asset_s*
+ * Asset the voice is playing
+ * @param uint32_t
+ * CPU cycles spent rendering and mixing the block
+ */
+static void app_audio_mixer_update_rate_stats(const audio_asset_s* asset, uint32_t cycles)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_MIXER_N_RATE_STATS; i++)
+    {
+        app_audio_mixer_rate_stats_s* rate_stats = &app_audio_mixer_stats.rates[i];
+
+        // Formats and rates get an entry the first time they are played
+        if (((rate_stats->sample_rate == asset->sample_rate) && (rate_stats->format == asset->format)) ||
+            (rate_stats->sample_rate == 0))
+        {
+            rate_stats->sample_rate = asset->sample_rate;
+            rate_stats->format = (uint8_t)asset->format;
+            rate_stats->n_blocks++;
+            rate_stats->total_cycles += cycles;
+            if (cycles > rate_stats->max_cycles)
+            {
+                rate_stats->max_cycles = cycles;
+            }
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief  Add the scratch buffer into the output block, two samples at a time
+ *
+ * @param int16_t*
+ * Output block
+ * @param uint32_t
+ * Number of samples in the scratch buffer
+ */
+static void app_audio_mixer_accumulate(int16_t* out, uint32_t n_samples)
+{
+    uint32_t i = 0;
+
+    // memcpy keeps the packed loads legal C, and compiles to single LDR/STR
+    for (; (i + 1) < n_samples; i += 2)
+    {
+        uint32_t acc;
+        uint32_t voice;
+        memcpy(&acc, &out[i], sizeof(acc));
+        memcpy(&voice, &app_audio_mixer_voice_buf[i], sizeof(voice));
+        acc = MIXER_QADD16(acc, voice);
+        memcpy(&out[i], &acc, sizeof(acc));
+    }
+
+    if (i < n_samples)
+    {
+        // Odd sample at the end of a voice. The high half is zero, so it can't saturate
+        const uint32_t acc = MIXER_QADD16((uint16_t)out[i], (uint16_t)app_audio_mixer_voice_buf[i]);
+        out[i] = (int16_t)(acc & 0xFFFF);
+    }
+}
+
+
+/**
+ * @brief  Reset the mixer, stopping all voices
+ *
+ * @param uint32_t
+ * Most CPU cycles a single block is allowed to take. Once exceeded, the rest of
+ * the voices are held back until the next block
+ */
+void app_audio_mixer_init(uint32_t budget_cycles)
+{
+#if defined(__ARM_ARCH)
+    // Start the DWT cycle counter used to measure the cost of each block
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    memset(app_audio_mixer_voices, 0, sizeof(app_audio_mixer_voices));
+    app_audio_mixer_reset_stats();
+    app_audio_mixer_stats.budget_cycles = budget_cycles;
+}
+
+
+/**
+ * @brief  Start playing an asset on a free voice. Assets that aren't stored at
+ *         APP_AUDIO_MIXER_SAMPLE_RATE_HZ are upsampled to it, assets in external
+ *         flash are streamed, and synthesized assets are rendered as they play.
+ *         Must not run while a block is being rendered
+ *
+ * @param const audio_asset_s*
+ * Asset to play
+ * @param int16_t
+ * Q15 gain for the asset (APP_AUDIO_MIXER_GAIN_UNITY to play it as is)
+ * @param uint16_t
+ * Q12 pitch scale (APP_AUDIO_MIXER_PITCH_UNITY to play it as is). Synthesized
+ * assets keep their length, while sampled ones play faster or slower, and can't
+ * be raised past the output rate
+ * @return uint8_t
+ * Index of the voice playing the asset, or APP_AUDIO_MIXER_INVALID_VOICE if
+ * every voice is busy
+ */
+uint8_t app_audio_mixer_start_voice(const audio_asset_s* asset, int16_t gain, uint16_t pitch)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_MIXER_N_VOICES; i++)
+    {
+        app_audio_voice_s* voice = &app_audio_mixer_voices[i];
+
+        if (!voice->active)
+        {
+            voice->asset = asset;
+            voice->pos = 0;
+            voice->gain = gain;
+            voice->block_left = 0;
+            if (AUDIO_ASSET_FORMAT_SYNTH == asset->format)
+            {
+                voice->resample = false;
+                voice->streamed = false;
+                voice->n_samples = app_audio_synth_start(&voice->synth,
+                                                         (const app_audio_synth_patch_s*)asset->data,
+                                                         (uint8_t)asset->n_samples,
+                                                         APP_AUDIO_MIXER_SAMPLE_RATE_HZ,
+                                                         pitch);
+                voice->active = (voice->n_samples > 0);
+                return i;
+            }
+
+            // Sampled assets change pitch by changing the rate they are played at
+            uint32_t sample_rate = (asset->sample_rate * pitch) >> APP_AUDIO_SYNTH_PITCH_SHIFT;
+            if (sample_rate > APP_AUDIO_MIXER_SAMPLE_RATE_HZ)
+            {
+                sample_rate = APP_AUDIO_MIXER_SAMPLE_RATE_HZ;
+            }
+            voice->n_samples = asset->n_samples;
+            voice->resample = (sample_rate != APP_AUDIO_MIXER_SAMPLE_RATE_HZ);
+            if (voice->resample)
+            {
+                app_audio_resampler_init(&voice->resampler, sample_rate, APP_AUDIO_MIXER_SAMPLE_RATE_HZ);
+            }
+            voice->streamed = (NULL == asset->data);
+            if (voice->streamed)
+            {
+                const uint32_t block_samples = MIXER_STREAM_BLOCK_SAMPLES(asset->format);
+                const uint32_t n_blocks = (asset->n_samples + block_samples - 1) / block_samples;
+                app_audio_stream_open(i, asset->ext_addr, n_blocks * APP_AUDIO_STREAM_BLOCK_BYTES);
+            }
+            else if (AUDIO_ASSET_FORMAT_ADPCM == asset->format)
+            {
+                app_audio_adpcm_init(&voice->decoder, (const uint8_t*)asset->data, asset->n_samples);
+            }
+            voice->active = (asset->n_samples > 0);
+
+            return i;
+        }
+    }
+
+    return APP_AUDIO_MIXER_INVALID_VOICE;
+}
+
+
+/**
+ * @brief  Stop a single voice. Must not run while a block is being rendered
+ *
+ * @param uint8_t
+ * Index of the voice to stop
+ */
+void app_audio_mixer_stop_voice(uint8_t voice_idx)
+{
+    if (voice_idx < APP_AUDIO_MIXER_N_VOICES)
+    {
+        app_audio_voice_s* voice = &app_audio_mixer_voices[voice_idx];
+
+        if (voice->active && voice->streamed)
+        {
+            app_audio_stream_close(voice_idx);
+        }
+        voice->active = false;
+    }
+}
+
+
+/**
+ * @brief  Stop all voices. Must not run while a block is being rendered
+ *
+ * @return void
+ */
+void app_audio_mixer_stop_all(void)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_MIXER_N_VOICES; i++)
+    {
+        app_audio_mixer_stop_voice(i);
+    }
+}
+
+
+/**
+ * @brief  Check whether a voice is still playing
+ *
+ * @param uint8_t
+ * Index of the voice to check
+ * @return bool
+ * true if the voice has samples left to mix
+ */
+bool app_audio_mixer_voice_active(uint8_t voice_idx)
+{
+    return (voice_idx < APP_AUDIO_MIXER_N_VOICES) && app_audio_mixer_voices[voice_idx].active;
+}
+
+
+/**
+ * @brief  Get the number of voices that are playing
+ *
+ * @return uint8_t
+ * Number of active voices
+ */
+uint8_t app_audio_mixer_n_active(void)
+{
+    uint8_t n_active = 0;
+
+    for (uint8_t i = 0; i < APP_AUDIO_MIXER_N_VOICES; i++)
+    {
+        n_active += app_audio_mixer_voices[i].active ? 1 : 0;
+    }
+
+    return n_active;
+}
+
+
+/**
+ * @brief  Mix the next block of every active voice. Voices that end partway through
+ *         the block are padded with silence and freed
+ *
+ * @param int16_t*
+ * Buffer to write APP_AUDIO_MIXER_BLOCK_SAMPLES mixed samples to
+ */
+void app_audio_mixer_render(int16_t* out)
+{
+    const uint32_t start_cycles = MIXER_CYCLE_COUNT();
+    uint8_t n_active = 0;
+    bool over_budget = false;
+
+    memset(out, 0, APP_AUDIO_MIXER_BLOCK_SAMPLES * sizeof(out[0]));
+
+    for (uint8_t i = 0; i < APP_AUDIO_MIXER_N_VOICES; i++)
+    {
+        app_audio_voice_s* voice = &app_audio_mixer_voices[i];
+
+        if (!voice->active)
+        {
+            continue;
+        }
+        n_active++;
+
+        // Hold the voice back for a block rather than starve the rest of the system
+        if ((MIXER_CYCLE_COUNT() - start_cycles) > app_audio_mixer_stats.budget_cycles)
+        {
+            over_budget = true;
+            continue;
+        }
+
+        const uint32_t voice_start_cycles = MIXER_CYCLE_COUNT();
+        const uint32_t n_samples = app_audio_mixer_render_voice(i);
+        app_audio_mixer_accumulate(out, n_samples);
+        app_audio_mixer_update_rate_stats(voice->asset, MIXER_CYCLE_COUNT() - voice_start_cycles);
+
+        if (voice->pos >= voice->n_samples)
+        {
+            app_audio_mixer_stop_voice(i);
+        }
+    }
+
+    // Update the benchmark
+    const uint32_t cycles = MIXER_CYCLE_COUNT() - start_cycles;
+    app_audio_mixer_stats.last_cycles = cycles;
+    app_audio_mixer_stats.total_cycles += cycles;
+    app_audio_mixer_stats.n_blocks++;
+    if (cycles > app_audio_mixer_stats.max_cycles)
+    {
+        app_audio_mixer_stats.max_cycles = cycles;
+    }
+    if (n_active > app_audio_mixer_stats.max_active_voices)
+    {
+        app_audio_mixer_stats.max_active_voices = n_active;
+    }
+    if (over_budget)
+    {
+        app_audio_mixer_stats.n_budget_overruns++;
+    }
+}
+
+
+/**
+ * @brief  Read the cycle counter the mixer's benchmark uses, so the rest of the
+ *         audio driver can be measured the same way
+ *
+ * @return uint32_t
+ * CPU cycles (nanoseconds on host builds), wrapping
+ */
+uint32_t app_audio_mixer_cycle_count(void)
+{
+    return MIXER_CYCLE_COUNT();
+}
+
+
+/**
+ * @brief  Get the cost of the blocks rendered so far
+ *
+ * @param app_audio_mixer_stats_s*
+ * Where to copy the stats to
+ */
+void app_audio_mixer_get_stats(app_audio_mixer_stats_s* stats)
+{
+    *stats = app_audio_mixer_stats;
+}
+
+
+/**
+ * @brief  Clear the benchmark, keeping the per-block budget
+ *
+ * @return void
+ */
+void app_audio_mixer_reset_stats(void)
+{
+    const uint32_t budget_cycles = app_audio_mixer_stats.budget_cycles;
+
+    memset(&app_audio_mixer_stats, 0, sizeof(app_audio_mixer_stats));
+    app_audio_mixer_stats.budget_cycles = budget_cycles;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,100 @@
+/**
+ * @file app_audio_mixer.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the software audio mixer, which sums all playing sound
+ * effects into a single block of samples for the CTDAC
+ *
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_MIXER_H__
+#define __APP_AUDIO_MIXER_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "data/audio_sample_luts.h"
+#include "app_audio_adpcm.h"
+#include "app_audio_resampler.h"
+#include "app_audio_stream.h"
+#include "app_audio_synth.h"
+
+
+// Defines
+// NOTE: All voices are mixed at the same rate. Assets stored at a lower rate are upsampled
+//       as they play, so the output rate is the highest rate any asset is stored at. A block
+//       of 128 samples is 2.9ms of audio, which bounds how long a newly started sound effect
+//       waits before it is heard
+#define APP_AUDIO_MIXER_N_VOICES          (4U)
+#define APP_AUDIO_MIXER_BLOCK_SAMPLES     (128U)
+#define APP_AUDIO_MIXER_SAMPLE_RATE_HZ    (44100UL)
+#define APP_AUDIO_MIXER_N_RATE_STATS      (4U)
+#define APP_AUDIO_MIXER_GAIN_UNITY        (INT16_MAX) // Q15
+#define APP_AUDIO_MIXER_PITCH_UNITY       (APP_AUDIO_SYNTH_PITCH_UNITY) // Q12
+#define APP_AUDIO_MIXER_INVALID_VOICE     (0xFF)
+
+// Assets in external flash are streamed through one stream per voice
+#if (APP_AUDIO_STREAM_N_STREAMS < APP_AUDIO_MIXER_N_VOICES)
+#error "Every mixer voice needs its own stream"
+#endif
+
+// A single sound effect being mixed
+typedef struct
+{
+    const audio_asset_s* asset;
+    uint32_t pos;                          // Index of the next sample to mix
+    uint32_t n_samples;                    // Length of the asset (at the output rate if synthesized)
+    app_audio_adpcm_decoder_s decoder;     // Only used for IMA-ADPCM assets
+    app_audio_synth_s synth;               // Only used for synthesized assets
+    bool streamed;                         // Asset is read from external flash
+    const uint8_t* block;                  // Stream block being played (streamed only)
+    uint32_t block_left;                   // Samples left in the stream block
+    int16_t gain;                          // Q15 gain applied before mixing
+    bool resample;                         // Asset isn't stored at the output rate
+    app_audio_resampler_s resampler;
+    volatile bool active;
+} app_audio_voice_s;
+
+// Cost of rendering a single voice for one block, by the format and sample rate of its asset
+typedef struct
+{
+    uint32_t sample_rate;        // 0 if unused
+    uint8_t format;              // audio_asset_format_e
+    uint32_t n_blocks;
+    uint64_t total_cycles;
+    uint32_t max_cycles;
+} app_audio_mixer_rate_stats_s;
+
+// Cost of rendering output blocks, in CPU cycles
+typedef struct
+{
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t n_blocks;
+    uint32_t budget_cycles;      // Limit on the cost of a single block
+    uint32_t n_budget_overruns;  // Blocks where a voice was held back to stay within budget
+    uint8_t max_active_voices;
+    app_audio_mixer_rate_stats_s rates[APP_AUDIO_MIXER_N_RATE_STATS];
+} app_audio_mixer_stats_s;
+
+
+// Function declarations
+void app_audio_mixer_init(uint32_t budget_cycles);
+uint8_t app_audio_mixer_start_voice(const audio_asset_s* asset, int16_t gain, uint16_t pitch);
+void app_audio_mixer_stop_voice(uint8_t voice_idx);
+void app_audio_mixer_stop_all(void);
+bool app_audio_mixer_voice_active(uint8_t voice_idx);
+uint8_t app_audio_mixer_n_active(void);
+void app_audio_mixer_render(int16_t* out);
+uint32_t app_audio_mixer_cycle_count(void);
+void app_audio_mixer_get_stats(app_audio_mixer_stats_s* stats);
+void app_audio_mixer_reset_stats(void);
+
+
+#endif // __APP_AUDIO_MIXER_H__
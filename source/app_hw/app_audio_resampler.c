@@ -0,0 +1,164 @@
+/**
+ * @file app_audio_resampler.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the polyphase FIR resampler. The output position advances
+ * through the input by a Q32 step per output sample. The integer part picks
+ * the input samples under the filter, and the top bits of the fractional part
+ * pick one of APP_AUDIO_RESAMPLER_PHASES sets of interpolation coefficients.
+ *
+ * The coefficients are a Kaiser windowed sinc (beta = 5) with its cutoff at
+ * 0.45x the input rate: flat to 0.3x, -3dB at 0.4x, and images of content
+ * below 0.4x are at least 29dB down
+ *
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_resampler.h"
+#include <string.h>
+
+#if defined(__ARM_ARCH)
+#include "cy_pdl.h"
+#endif
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define RESAMPLER_PHASE_SHIFT    (27U) // log2(2^32 / APP_AUDIO_RESAMPLER_PHASES)
+
+#if (APP_AUDIO_RESAMPLER_PHASES != (1UL << (32U - RESAMPLER_PHASE_SHIFT)))
+#error "RESAMPLER_PHASE_SHIFT must match APP_AUDIO_RESAMPLER_PHASES"
+#endif
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// Q15 coefficients for each phase. Every row sums to 32768 so DC passes unchanged
+static const int16_t app_audio_resampler_coefs[APP_AUDIO_RESAMPLER_PHASES][APP_AUDIO_RESAMPLER_TAPS] = {
+    {   646,  -1688,   2786,  29371,   2786,  -1688,    646,    -91},
+    {   574,  -1425,   1940,  29339,   3680,  -1955,    718,   -103},
+    {   503,  -1168,   1142,  29224,   4617,  -2223,    789,   -116},
+    {   433,   -918,    394,  29025,   5593,  -2489,    858,   -128},
+    {   366,   -677,   -303,  28741,   6607,  -2751,    925,   -140},
+    {   301,   -446,   -947,  28379,   7653,  -3007,    987,   -152},
+    {   238,   -227,  -1537,  27936,   8727,  -3252,   1045,   -162},
+    {   180,    -22,  -2072,  27418,   9824,  -3485,   1097,   -172},
+    {   125,    169,  -2552,  26824,  10941,  -3701,   1142,   -180},
+    {    75,    345,  -2976,  26160,  12071,  -3899,   1179,   -187},
+    {    28,    506,  -3346,  25429,  13209,  -4074,   1207,   -191},
+    {   -13,    650,  -3662,  24635,  14349,  -4223,   1225,   -193},
+    {   -51,    778,  -3925,  23784,  15487,  -4344,   1231,   -192},
+    {   -83,    889,  -4136,  22877,  16616,  -4433,   1225,   -187},
+    {  -111,    984,  -4297,  21923,  17730,  -4487,   1206,   -180},
+    {  -135,   1063,  -4411,  20927,  18823,  -4503,   1173,   -169},
+    {  -154,   1126,  -4479,  19891,  19891,  -4479,   1126,   -154},
+    {  -169,   1173,  -4503,  18823,  20927,  -4411,   1063,   -135},
+    {  -180,   1206,  -4487,  17730,  21923,  -4297,    984,   -111},
+    {  -187,   1225,  -4433,  16616,  22877,  -4136,    889,    -83},
+    {  -192,   1231,  -4344,  15487,  23784,  -3925,    778,    -51},
+    {  -193,   1225,  -4223,  14349,  24635,  -3662,    650,    -13},
+    {  -191,   1207,  -4074,  13209,  25429,  -3346,    506,     28},
+    {  -187,   1179,  -3899,  12071,  26160,  -2976,    345,     75},
+    {  -180,   1142,  -3701,  10941,  26824,  -2552,    169,    125},
+    {  -172,   1097,  -3485,   9824,  27418,  -2072,    -22,    180},
+    {  -162,   1045,  -3252,   8727,  27936,  -1537,   -227,    238},
+    {  -152,    987,  -3007,   7653,  28379,   -947,   -446,    301},
+    {  -140,    925,  -2751,   6607,  28741,   -303,   -677,    366},
+    {  -128,    858,  -2489,   5593,  29025,    394,   -918,    433},
+    {  -116,    789,  -2223,   4617,  29224,   1142,  -1168,    503},
+    {  -103,    718,  -1955,   3680,  29339,   1940,  -1425,    574}
+};
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Reset a resampler
+ *
+ * @param app_audio_resampler_s*
+ * Resampler to initialize
+ * @param uint32_t
+ * Sample rate of the input
+ * @param uint32_t
+ * Sample rate of the output (at least in_rate)
+ */
+void app_audio_resampler_init(app_audio_resampler_s* rs, uint32_t in_rate, uint32_t out_rate)
+{
+#if defined(__ARM_ARCH)
+    CY_ASSERT(in_rate <= out_rate);
+#endif
+
+    rs->step = (in_rate >= out_rate) ? UINT32_MAX : (uint32_t)(((uint64_t)in_rate << 32) / out_rate);
+    rs->frac = 0;
+    memset(rs->history, 0, sizeof(rs->history));
+}
+
+
+/**
+ * @brief  Get how many new input samples the next block of output needs
+ *
+ * @param const app_audio_resampler_s*
+ * Resampler
+ * @param uint32_t
+ * Number of output samples in the next block
+ * @return uint32_t
+ * Number of input samples to pass to app_audio_resampler_process (at most n_out)
+ */
+uint32_t app_audio_resampler_n_in(const app_audio_resampler_s* rs, uint32_t n_out)
+{
+    return (uint32_t)(((uint64_t)rs->frac + ((uint64_t)rs->step * n_out)) >> 32);
+}
+
+
+/**
+ * @brief  Resample a block
+ *
+ * @param app_audio_resampler_s*
+ * Resampler
+ * @param int16_t*
+ * Work buffer holding APP_AUDIO_RESAMPLER_TAPS free samples followed by the
+ * app_audio_resampler_n_in(rs, n_out) new input samples. The free samples are
+ * filled with the end of the previous block
+ * @param int16_t*
+ * Where to write the output samples
+ * @param uint32_t
+ * Number of output samples to produce
+ */
+void app_audio_resampler_process(app_audio_resampler_s* rs, int16_t* buf, int16_t* out, uint32_t n_out)
+{
+    const uint32_t n_in = app_audio_resampler_n_in(rs, n_out);
+    const uint32_t step = rs->step;
+    uint32_t frac = rs->frac;
+    const int16_t* x = buf;
+
+    memcpy(buf, rs->history, sizeof(rs->history));
+
+    for (uint32_t i = 0; i < n_out; i++)
+    {
+        const int16_t* h = app_audio_resampler_coefs[frac >> RESAMPLER_PHASE_SHIFT];
+        int32_t acc = 0;
+
+        for (uint32_t k = 0; k < APP_AUDIO_RESAMPLER_TAPS; k++)
+        {
+            acc += (int32_t)x[k] * h[k];
+        }
+        // Rows sum to unity, but overshoot on full scale input can still clip
+        acc >>= 15;
+        out[i] = (int16_t)((acc > INT16_MAX) ? INT16_MAX : ((acc < INT16_MIN) ? INT16_MIN : acc));
+
+        // Step through the input, moving the filter forward on each carry
+        const uint32_t next = frac + step;
+        x += (next < frac) ? 1 : 0;
+        frac = next;
+    }
+
+    rs->frac = frac;
+    memcpy(rs->history, &buf[n_in], sizeof(rs->history));
+}
+
+/* [] END OF FILE */
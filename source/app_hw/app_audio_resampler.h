@@ -0,0 +1,45 @@
+/**
+ * @file app_audio_resampler.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the polyphase FIR resampler, which upsamples assets from
+ * their native sample rate to the mixer's output rate
+ *
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_RESAMPLER_H__
+#define __APP_AUDIO_RESAMPLER_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: Every output sample costs APP_AUDIO_RESAMPLER_TAPS multiply-accumulates,
+//       regardless of the ratio. The filter only band-limits to the input rate,
+//       so it can upsample but not downsample
+#define APP_AUDIO_RESAMPLER_TAPS      (8U)
+#define APP_AUDIO_RESAMPLER_PHASES    (32U)
+
+// State of a single resampled stream
+typedef struct
+{
+    uint32_t step;                                // Input samples per output sample (Q32)
+    uint32_t frac;                                // Position between input samples (Q32)
+    int16_t history[APP_AUDIO_RESAMPLER_TAPS];    // Last input samples of the previous block
+} app_audio_resampler_s;
+
+
+// Function declarations
+void app_audio_resampler_init(app_audio_resampler_s* rs, uint32_t in_rate, uint32_t out_rate);
+uint32_t app_audio_resampler_n_in(const app_audio_resampler_s* rs, uint32_t n_out);
+void app_audio_resampler_process(app_audio_resampler_s* rs, int16_t* buf, int16_t* out, uint32_t n_out);
+
+
+#endif // __APP_AUDIO_RESAMPLER_H__
@@ -0,0 +1,389 @@
+/**
+ * @file app_audio_scheduler.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the sound effect scheduler. Requests are started on a free
+ * mixer voice right away. When all voices are busy, the sound effect's policy
+ * decides whether it replaces a lower priority voice, waits in a small
+ * priority queue, or is dropped. The scheduler is serviced after every mixed
+ * block, which is when finished voices are reported and queued requests start
+ *
+ * @version 0.1
+ * @date 2024-12-11
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_scheduler.h"
+#include "app_audio_store.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#if ((APP_AUDIO_SCHED_N_SLOTS & (APP_AUDIO_SCHED_N_SLOTS - 1)) != 0)
+#error "APP_AUDIO_SCHED_N_SLOTS must be a power of 2"
+#endif
+
+// Handles hold the request's slot in their low bits and a generation count above
+// that, so a stale handle can be told apart from a newer request in the same slot
+#define SCHED_HANDLE_SLOT_MASK    (APP_AUDIO_SCHED_N_SLOTS - 1UL)
+#define SCHED_HANDLE_GEN_SHIFT    (3U)
+#define SCHED_HANDLE_SLOT(H)      ((uint8_t)((H) & SCHED_HANDLE_SLOT_MASK))
+
+#define SCHED_MS_TO_BLOCKS(MS) \
+    ((((uint32_t)(MS) * APP_AUDIO_MIXER_SAMPLE_RATE_HZ) / 1000UL) / APP_AUDIO_MIXER_BLOCK_SAMPLES)
+
+#define SCHED_STATUS_IS_PENDING(S)    ((APP_AUDIO_STATUS_QUEUED == (S)) || (APP_AUDIO_STATUS_PLAYING == (S)))
+
+// A single accepted request
+typedef struct
+{
+    app_audio_handle_t handle;
+    audio_sound_effect_e sound_effect;
+    uint16_t pitch;              // Q12 pitch scale to play the sound effect at
+    app_audio_status_e status;
+    uint8_t voice_idx;           // Mixer voice, while playing
+    uint32_t seq;                // Order the request was accepted in, to break priority ties
+    uint32_t queued_block;       // Block count when the request was queued
+} app_audio_sched_slot_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// Scheduling of each sound effect. Being hit matters most, while the item pickup
+// jingle is the first thing to give way when the mixer is full
+static const app_audio_sched_policy_s app_audio_sched_policies[AUDIO_SOUND_EFFECT_MAX] = {
+    [AUDIO_SOUND_EFFECT_GET_ITEM]   = { .priority = 0, .policy = APP_AUDIO_POLICY_QUEUE,   .max_queue_ms = 300 },
+    [AUDIO_SOUND_EFFECT_USE_SHIELD] = { .priority = 2, .policy = APP_AUDIO_POLICY_PREEMPT, .max_queue_ms = 100 },
+    [AUDIO_SOUND_EFFECT_USE_SHOT]   = { .priority = 2, .policy = APP_AUDIO_POLICY_PREEMPT, .max_queue_ms = 100 },
+    [AUDIO_SOUND_EFFECT_BOOST]      = { .priority = 1, .policy = APP_AUDIO_POLICY_QUEUE,   .max_queue_ms = 200 },
+    [AUDIO_SOUND_EFFECT_HIT]        = { .priority = 3, .policy = APP_AUDIO_POLICY_PREEMPT, .max_queue_ms = 100 }
+};
+
+static app_audio_sched_slot_s app_audio_sched_slots[APP_AUDIO_SCHED_N_SLOTS];
+static app_audio_completion_cb_t app_audio_sched_completion_cb = NULL;
+static uint32_t app_audio_sched_generation = 1;
+static uint32_t app_audio_sched_seq = 0;
+// Number of times the scheduler has been serviced, i.e. mixed blocks
+static uint32_t app_audio_sched_block_count = 0;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Finish a request, freeing its slot and reporting how it ended
+ *
+ * @param app_audio_sched_slot_s*
+ * Request to finish
+ * @param app_audio_status_e
+ * How the request ended
+ */
+static void app_audio_scheduler_finish(app_audio_sched_slot_s* slot, app_audio_status_e status)
+{
+    slot->status = status;
+    slot->voice_idx = APP_AUDIO_MIXER_INVALID_VOICE;
+
+    if (NULL != app_audio_sched_completion_cb)
+    {
+        app_audio_sched_completion_cb(slot->handle, status);
+    }
+}
+
+
+/**
+ * @brief  Try to start a request on a free mixer voice
+ *
+ * @param app_audio_sched_slot_s*
+ * Request to start
+ * @return bool
+ * true if the request is now playing
+ */
+static bool app_audio_scheduler_start(app_audio_sched_slot_s* slot)
+{
+    const uint8_t voice_idx = app_audio_mixer_start_voice(app_audio_store_sound_effect(slot->sound_effect),
+                                                          APP_AUDIO_MIXER_GAIN_UNITY,
+                                                          slot->pitch);
+
+    if (APP_AUDIO_MIXER_INVALID_VOICE != voice_idx)
+    {
+        slot->voice_idx = voice_idx;
+        slot->status = APP_AUDIO_STATUS_PLAYING;
+    }
+
+    return (APP_AUDIO_MIXER_INVALID_VOICE != voice_idx);
+}
+
+
+/**
+ * @brief  Find the least important request in a given state. Among requests with
+ *         the same priority, the oldest is picked
+ *
+ * @param app_audio_status_e
+ * State the request must be in
+ * @return app_audio_sched_slot_s*
+ * Least important request, or NULL if none are in that state
+ */
+static app_audio_sched_slot_s* app_audio_scheduler_find_lowest(app_audio_status_e status)
+{
+    app_audio_sched_slot_s* lowest = NULL;
+
+    for (uint8_t i = 0; i < APP_AUDIO_SCHED_N_SLOTS; i++)
+    {
+        app_audio_sched_slot_s* slot = &app_audio_sched_slots[i];
+
+        if (status != slot->status)
+        {
+            continue;
+        }
+
+        if ((NULL == lowest) ||
+            (app_audio_sched_policies[slot->sound_effect].priority < app_audio_sched_policies[lowest->sound_effect].priority) ||
+            ((app_audio_sched_policies[slot->sound_effect].priority == app_audio_sched_policies[lowest->sound_effect].priority) &&
+             (slot->seq < lowest->seq)))
+        {
+            lowest = slot;
+        }
+    }
+
+    return lowest;
+}
+
+
+/**
+ * @brief  Find the queued request to start next. This is the highest priority one,
+ *         and the oldest among requests with the same priority
+ *
+ * @return app_audio_sched_slot_s*
+ * Next request to start, or NULL if the queue is empty
+ */
+static app_audio_sched_slot_s* app_audio_scheduler_find_next_queued(void)
+{
+    app_audio_sched_slot_s* next = NULL;
+
+    for (uint8_t i = 0; i < APP_AUDIO_SCHED_N_SLOTS; i++)
+    {
+        app_audio_sched_slot_s* slot = &app_audio_sched_slots[i];
+
+        if (APP_AUDIO_STATUS_QUEUED != slot->status)
+        {
+            continue;
+        }
+
+        if ((NULL == next) ||
+            (app_audio_sched_policies[slot->sound_effect].priority > app_audio_sched_policies[next->sound_effect].priority) ||
+            ((app_audio_sched_policies[slot->sound_effect].priority == app_audio_sched_policies[next->sound_effect].priority) &&
+             (slot->seq < next->seq)))
+        {
+            next = slot;
+        }
+    }
+
+    return next;
+}
+
+
+/**
+ * @brief  Reset the scheduler, forgetting all requests
+ *
+ * @return void
+ */
+void app_audio_scheduler_init(void)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_SCHED_N_SLOTS; i++)
+    {
+        app_audio_sched_slots[i].handle = APP_AUDIO_SCHED_INVALID_HANDLE;
+        app_audio_sched_slots[i].status = APP_AUDIO_STATUS_DONE;
+        app_audio_sched_slots[i].voice_idx = APP_AUDIO_MIXER_INVALID_VOICE;
+    }
+}
+
+
+/**
+ * @brief  Set the function to call whenever an accepted request ends
+ *
+ * @param app_audio_completion_cb_t
+ * Completion callback. May be NULL
+ */
+void app_audio_scheduler_set_completion_cb(app_audio_completion_cb_t completion_cb)
+{
+    app_audio_sched_completion_cb = completion_cb;
+}
+
+
+/**
+ * @brief  Request a sound effect. Must not run while the scheduler is being serviced
+ *
+ * @param audio_sound_effect_e
+ * Sound effect to play
+ * @param uint16_t
+ * Q12 pitch scale (APP_AUDIO_MIXER_PITCH_UNITY to play it as is)
+ * @return app_audio_handle_t
+ * Handle to check on the request with, or APP_AUDIO_SCHED_INVALID_HANDLE if the
+ * request was dropped straight away
+ */
+app_audio_handle_t app_audio_scheduler_request(audio_sound_effect_e sound_effect, uint16_t pitch)
+{
+    const app_audio_sched_policy_s* policy = &app_audio_sched_policies[sound_effect];
+    app_audio_sched_slot_s* slot = NULL;
+
+    // Find a free slot for the request
+    for (uint8_t i = 0; i < APP_AUDIO_SCHED_N_SLOTS; i++)
+    {
+        if (!SCHED_STATUS_IS_PENDING(app_audio_sched_slots[i].status))
+        {
+            slot = &app_audio_sched_slots[i];
+            break;
+        }
+    }
+
+    if ((NULL == slot) && (APP_AUDIO_POLICY_DROP != policy->policy))
+    {
+        // Queue is full. Make room if something less important is waiting
+        app_audio_sched_slot_s* lowest = app_audio_scheduler_find_lowest(APP_AUDIO_STATUS_QUEUED);
+        if ((NULL != lowest) && (app_audio_sched_policies[lowest->sound_effect].priority < policy->priority))
+        {
+            app_audio_scheduler_finish(lowest, APP_AUDIO_STATUS_DROPPED);
+            slot = lowest;
+        }
+    }
+
+    if (NULL == slot)
+    {
+        return APP_AUDIO_SCHED_INVALID_HANDLE;
+    }
+
+    const uint8_t slot_idx = (uint8_t)(slot - app_audio_sched_slots);
+    slot->handle = (app_audio_sched_generation++ << SCHED_HANDLE_GEN_SHIFT) | slot_idx;
+    slot->sound_effect = sound_effect;
+    slot->pitch = pitch;
+    slot->seq = app_audio_sched_seq++;
+    slot->voice_idx = APP_AUDIO_MIXER_INVALID_VOICE;
+
+    if (app_audio_scheduler_start(slot))
+    {
+        return slot->handle;
+    }
+
+    // Every voice is busy
+    if (APP_AUDIO_POLICY_PREEMPT == policy->policy)
+    {
+        app_audio_sched_slot_s* lowest = app_audio_scheduler_find_lowest(APP_AUDIO_STATUS_PLAYING);
+        if ((NULL != lowest) && (app_audio_sched_policies[lowest->sound_effect].priority < policy->priority))
+        {
+            app_audio_mixer_stop_voice(lowest->voice_idx);
+            app_audio_scheduler_finish(lowest, APP_AUDIO_STATUS_PREEMPTED);
+            (void)app_audio_scheduler_start(slot);
+            return slot->handle;
+        }
+    }
+
+    if (APP_AUDIO_POLICY_DROP == policy->policy)
+    {
+        slot->status = APP_AUDIO_STATUS_DROPPED;
+        return APP_AUDIO_SCHED_INVALID_HANDLE;
+    }
+
+    slot->status = APP_AUDIO_STATUS_QUEUED;
+    slot->queued_block = app_audio_sched_block_count;
+    return slot->handle;
+}
+
+
+/**
+ * @brief  Report finished sound effects and start queued ones on the freed voices.
+ *         Called after each block is mixed
+ *
+ * @return void
+ */
+void app_audio_scheduler_service(void)
+{
+    app_audio_sched_block_count++;
+
+    for (uint8_t i = 0; i < APP_AUDIO_SCHED_N_SLOTS; i++)
+    {
+        app_audio_sched_slot_s* slot = &app_audio_sched_slots[i];
+
+        if ((APP_AUDIO_STATUS_PLAYING == slot->status) && !app_audio_mixer_voice_active(slot->voice_idx))
+        {
+            app_audio_scheduler_finish(slot, APP_AUDIO_STATUS_DONE);
+        }
+        else if ((APP_AUDIO_STATUS_QUEUED == slot->status) &&
+                 ((app_audio_sched_block_count - slot->queued_block) >
+                  SCHED_MS_TO_BLOCKS(app_audio_sched_policies[slot->sound_effect].max_queue_ms)))
+        {
+            // Waited too long to still make sense to play
+            app_audio_scheduler_finish(slot, APP_AUDIO_STATUS_DROPPED);
+        }
+    }
+
+    app_audio_sched_slot_s* next = app_audio_scheduler_find_next_queued();
+    while ((NULL != next) && app_audio_scheduler_start(next))
+    {
+        next = app_audio_scheduler_find_next_queued();
+    }
+}
+
+
+/**
+ * @brief  Stop every playing sound effect and empty the queue.
+ *         Must not run while the scheduler is being serviced
+ *
+ * @return void
+ */
+void app_audio_scheduler_stop_all(void)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_SCHED_N_SLOTS; i++)
+    {
+        app_audio_sched_slot_s* slot = &app_audio_sched_slots[i];
+
+        if (APP_AUDIO_STATUS_PLAYING == slot->status)
+        {
+            app_audio_mixer_stop_voice(slot->voice_idx);
+            app_audio_scheduler_finish(slot, APP_AUDIO_STATUS_PREEMPTED);
+        }
+        else if (APP_AUDIO_STATUS_QUEUED == slot->status)
+        {
+            app_audio_scheduler_finish(slot, APP_AUDIO_STATUS_DROPPED);
+        }
+    }
+}
+
+
+/**
+ * @brief  Get the state of a request
+ *
+ * @param app_audio_handle_t
+ * Handle returned when the sound effect was requested
+ * @return app_audio_status_e
+ * State of the request. Requests whose slot has since been reused report
+ * APP_AUDIO_STATUS_DONE, and APP_AUDIO_SCHED_INVALID_HANDLE reports
+ * APP_AUDIO_STATUS_DROPPED
+ */
+app_audio_status_e app_audio_scheduler_get_status(app_audio_handle_t handle)
+{
+    if (APP_AUDIO_SCHED_INVALID_HANDLE == handle)
+    {
+        return APP_AUDIO_STATUS_DROPPED;
+    }
+
+    const app_audio_sched_slot_s* slot = &app_audio_sched_slots[SCHED_HANDLE_SLOT(handle)];
+    return (slot->handle == handle) ? slot->status : APP_AUDIO_STATUS_DONE;
+}
+
+
+/**
+ * @brief  Get the slot a request is held in, e.g. to map requests to event bits
+ *
+ * @param app_audio_handle_t
+ * Handle returned when the sound effect was requested
+ * @return uint8_t
+ * Slot index, less than APP_AUDIO_SCHED_N_SLOTS
+ */
+uint8_t app_audio_scheduler_handle_slot(app_audio_handle_t handle)
+{
+    return SCHED_HANDLE_SLOT(handle);
+}
+
+/* [] END OF FILE */
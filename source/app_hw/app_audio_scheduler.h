@@ -0,0 +1,75 @@
+/**
+ * @file app_audio_scheduler.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the sound effect scheduler, which decides which requested
+ * sound effects get a mixer voice based on their priority and policy
+ *
+ * @version 0.1
+ * @date 2024-12-11
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_SCHEDULER_H__
+#define __APP_AUDIO_SCHEDULER_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "data/audio_sample_luts.h"
+#include "app_audio_mixer.h"
+
+
+// Defines
+// NOTE: Each accepted request holds a slot until it finishes, so at most
+//       (APP_AUDIO_SCHED_N_SLOTS - APP_AUDIO_MIXER_N_VOICES) requests can be queued
+#define APP_AUDIO_SCHED_N_SLOTS           (8U)
+#define APP_AUDIO_SCHED_INVALID_HANDLE    (0UL)
+
+// Identifies a single request to play a sound effect
+typedef uint32_t app_audio_handle_t;
+
+// What to do with a request when every mixer voice is busy
+typedef enum
+{
+    APP_AUDIO_POLICY_PREEMPT = 0, // Replace a lower priority sound effect, otherwise queue
+    APP_AUDIO_POLICY_QUEUE   = 1, // Wait for a free voice
+    APP_AUDIO_POLICY_DROP    = 2  // Don't play
+} app_audio_policy_e;
+
+typedef enum
+{
+    APP_AUDIO_STATUS_QUEUED    = 0,
+    APP_AUDIO_STATUS_PLAYING   = 1,
+    APP_AUDIO_STATUS_DONE      = 2, // Played to the end
+    APP_AUDIO_STATUS_PREEMPTED = 3, // Stopped partway through for something else
+    APP_AUDIO_STATUS_DROPPED   = 4  // Never played
+} app_audio_status_e;
+
+// How a sound effect is scheduled
+typedef struct
+{
+    uint8_t priority;            // Higher values are more important
+    app_audio_policy_e policy;
+    uint16_t max_queue_ms;       // Queued requests are dropped after waiting this long
+} app_audio_sched_policy_s;
+
+// Called when an accepted request finishes, is preempted, or expires in the queue.
+// Runs from the audio DMA interrupt, or from the caller of app_audio_scheduler_request
+// or app_audio_scheduler_stop_all
+typedef void (*app_audio_completion_cb_t)(app_audio_handle_t handle, app_audio_status_e status);
+
+
+// Function declarations
+void app_audio_scheduler_init(void);
+void app_audio_scheduler_set_completion_cb(app_audio_completion_cb_t completion_cb);
+app_audio_handle_t app_audio_scheduler_request(audio_sound_effect_e sound_effect, uint16_t pitch);
+void app_audio_scheduler_service(void);
+void app_audio_scheduler_stop_all(void);
+app_audio_status_e app_audio_scheduler_get_status(app_audio_handle_t handle);
+uint8_t app_audio_scheduler_handle_slot(app_audio_handle_t handle);
+
+
+#endif // __APP_AUDIO_SCHEDULER_H__
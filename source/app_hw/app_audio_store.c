@@ -0,0 +1,226 @@
+/**
+ * @file app_audio_store.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the audio asset store. The directory is read from external
+ * flash once at startup, and every asset it lists is checked against its CRC
+ * before being used. Sound effects found in the store are streamed from
+ * external flash, and the rest keep playing from the tables in internal
+ * flash, so a missing or partly written store never silences anything
+ *
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_store.h"
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define CRC32_POLY    (0xEDB88320UL) // Reflected IEEE 802.3, same as zlib
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// Sound effects found in the store. Entries with n_samples of 0 weren't found
+static audio_asset_s app_audio_store_assets[AUDIO_SOUND_EFFECT_MAX];
+// Scratch space for reading the directory and checking assets
+static app_audio_store_entry_s app_audio_store_dir[APP_AUDIO_STORE_MAX_ENTRIES];
+static uint8_t app_audio_store_buf[APP_AUDIO_STREAM_BLOCK_BYTES];
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Update a CRC-32 with more data. Bitwise, since it is only used while
+ *         loading the store
+ *
+ * @param uint32_t
+ * CRC of the data so far (0 to start)
+ * @param const uint8_t*
+ * Data to add
+ * @param uint32_t
+ * Length of the data in bytes
+ * @return uint32_t
+ * CRC including the new data
+ */
+uint32_t app_audio_crc32(uint32_t crc, const uint8_t* data, uint32_t length)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (CRC32_POLY & (0UL - (crc & 1UL)));
+        }
+    }
+    return ~crc;
+}
+
+
+/**
+ * @brief  Check an asset in the store against its CRC
+ *
+ * @param app_audio_stream_read_fn_t
+ * Function to read from external flash with
+ * @param const app_audio_store_entry_s*
+ * Directory entry of the asset
+ * @return bool
+ * true if the asset could be read and matches its CRC
+ */
+static bool app_audio_store_check_asset(app_audio_stream_read_fn_t read_fn, const app_audio_store_entry_s* entry)
+{
+    uint32_t crc = 0;
+
+    for (uint32_t done = 0; done < entry->n_bytes; done += sizeof(app_audio_store_buf))
+    {
+        const uint32_t length = ((entry->n_bytes - done) < sizeof(app_audio_store_buf)) ?
+                                (entry->n_bytes - done) : sizeof(app_audio_store_buf);
+
+        if (!read_fn(APP_AUDIO_STORE_FLASH_ADDR + entry->offset + done, length, app_audio_store_buf))
+        {
+            return false;
+        }
+        crc = app_audio_crc32(crc, app_audio_store_buf, length);
+    }
+
+    return crc == entry->crc;
+}
+
+
+/**
+ * @brief  Check whether an asset can be streamed as described by its entry
+ *
+ * @param const app_audio_store_entry_s*
+ * Directory entry of the asset
+ * @return bool
+ * true if the entry is usable
+ */
+static bool app_audio_store_entry_valid(const app_audio_store_entry_s* entry)
+{
+    uint32_t min_bytes;
+
+    if (AUDIO_ASSET_FORMAT_ADPCM == entry->format)
+    {
+        // Every block but the last is complete
+        min_bytes = ((entry->n_samples - 1) / APP_AUDIO_ADPCM_BLOCK_SAMPLES) * APP_AUDIO_ADPCM_BLOCK_BYTES;
+    }
+    else if (AUDIO_ASSET_FORMAT_PCM == entry->format)
+    {
+        min_bytes = entry->n_samples * sizeof(uint16_t);
+    }
+    else
+    {
+        return false;
+    }
+
+    return (entry->sound_effect < AUDIO_SOUND_EFFECT_MAX) &&
+           (entry->n_samples > 0) &&
+           (entry->n_bytes >= min_bytes) &&
+           ((entry->offset % APP_AUDIO_STREAM_BLOCK_BYTES) == 0);
+}
+
+
+/**
+ * @brief  Load the store's directory from external flash. Sound effects in the
+ *         store are streamed from then on
+ *
+ * @param app_audio_stream_read_fn_t
+ * Function to read from external flash with
+ * @return app_audio_store_result_e
+ * Whether the directory could be loaded. Individual assets that fail their CRC
+ * are skipped
+ */
+app_audio_store_result_e app_audio_store_init(app_audio_stream_read_fn_t read_fn)
+{
+    app_audio_store_header_s header;
+
+    memset(app_audio_store_assets, 0, sizeof(app_audio_store_assets));
+
+    if (!read_fn(APP_AUDIO_STORE_FLASH_ADDR, sizeof(header), (uint8_t*)&header))
+    {
+        return APP_AUDIO_STORE_READ_ERROR;
+    }
+    if (header.magic != APP_AUDIO_STORE_MAGIC)
+    {
+        return APP_AUDIO_STORE_NOT_PRESENT;
+    }
+    if ((header.version != APP_AUDIO_STORE_VERSION) || (header.n_entries > APP_AUDIO_STORE_MAX_ENTRIES))
+    {
+        return APP_AUDIO_STORE_BAD_DIR;
+    }
+
+    const uint32_t dir_bytes = header.n_entries * sizeof(app_audio_store_entry_s);
+    if (!read_fn(APP_AUDIO_STORE_FLASH_ADDR + sizeof(header), dir_bytes, (uint8_t*)app_audio_store_dir))
+    {
+        return APP_AUDIO_STORE_READ_ERROR;
+    }
+    if (app_audio_crc32(0, (const uint8_t*)app_audio_store_dir, dir_bytes) != header.dir_crc)
+    {
+        return APP_AUDIO_STORE_BAD_DIR;
+    }
+
+    for (uint16_t i = 0; i < header.n_entries; i++)
+    {
+        const app_audio_store_entry_s* entry = &app_audio_store_dir[i];
+
+        if (app_audio_store_entry_valid(entry) && app_audio_store_check_asset(read_fn, entry))
+        {
+            audio_asset_s* asset = &app_audio_store_assets[entry->sound_effect];
+
+            asset->data = NULL;
+            asset->ext_addr = APP_AUDIO_STORE_FLASH_ADDR + entry->offset;
+            asset->n_samples = entry->n_samples;
+            asset->sample_rate = entry->sample_rate;
+            asset->format = (audio_asset_format_e)entry->format;
+        }
+    }
+
+    return APP_AUDIO_STORE_OK;
+}
+
+
+/**
+ * @brief  Get the asset to play for a sound effect
+ *
+ * @param audio_sound_effect_e
+ * Sound effect to look up
+ * @return const audio_asset_s*
+ * The sound effect's asset in external flash if the store has it, otherwise
+ * the one in internal flash
+ */
+const audio_asset_s* app_audio_store_sound_effect(audio_sound_effect_e sound_effect)
+{
+    if (app_audio_store_assets[sound_effect].n_samples > 0)
+    {
+        return &app_audio_store_assets[sound_effect];
+    }
+    return &audio_assets[sound_effect];
+}
+
+
+/**
+ * @brief  Get how many sound effects are streamed from the store
+ *
+ * @return uint8_t
+ * Number of sound effects found in the store
+ */
+uint8_t app_audio_store_n_streamed(void)
+{
+    uint8_t n_streamed = 0;
+
+    for (uint8_t i = 0; i < AUDIO_SOUND_EFFECT_MAX; i++)
+    {
+        n_streamed += (app_audio_store_assets[i].n_samples > 0) ? 1 : 0;
+    }
+
+    return n_streamed;
+}
+
+/* [] END OF FILE */
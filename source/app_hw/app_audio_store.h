@@ -0,0 +1,74 @@
+/**
+ * @file app_audio_store.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the audio asset store, a directory of sound effects kept in
+ * external flash and streamed from there instead of internal flash
+ *
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_STORE_H__
+#define __APP_AUDIO_STORE_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "data/audio_sample_luts.h"
+#include "app_audio_stream.h"
+
+
+// Defines
+// NOTE: The store is a header, a directory of entries, then the assets themselves, all
+//       little endian. Offsets are from the start of the store. Every asset starts on a
+//       APP_AUDIO_STREAM_BLOCK_BYTES boundary so that stream blocks line up with ADPCM
+//       blocks. The store sits well clear of the kv-store, which uses the last sectors
+//       of the first half of the flash
+#define APP_AUDIO_STORE_FLASH_ADDR       (0x00100000UL)
+#define APP_AUDIO_STORE_MAGIC            (0x53444641UL) // "AFDS"
+#define APP_AUDIO_STORE_VERSION          (1U)
+#define APP_AUDIO_STORE_MAX_ENTRIES      (32U)
+// Entries that aren't one of the sound effects
+#define APP_AUDIO_STORE_NO_SOUND_EFFECT  (0xFFU)
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t n_entries;
+    uint32_t dir_crc;       // CRC-32 of the directory entries
+} app_audio_store_header_s;
+
+typedef struct
+{
+    uint32_t offset;        // Start of the asset, from the start of the store
+    uint32_t n_bytes;
+    uint32_t n_samples;
+    uint32_t sample_rate;
+    uint8_t format;         // audio_asset_format_e
+    uint8_t sound_effect;   // audio_sound_effect_e it replaces, or APP_AUDIO_STORE_NO_SOUND_EFFECT
+    uint16_t reserved;
+    uint32_t crc;           // CRC-32 of the asset's n_bytes
+} app_audio_store_entry_s;
+
+typedef enum
+{
+    APP_AUDIO_STORE_OK          = 0,
+    APP_AUDIO_STORE_NOT_PRESENT = 1, // Nothing has been written to the store
+    APP_AUDIO_STORE_READ_ERROR  = 2,
+    APP_AUDIO_STORE_BAD_DIR     = 3  // Unsupported version or corrupt directory
+} app_audio_store_result_e;
+
+
+// Function declarations
+app_audio_store_result_e app_audio_store_init(app_audio_stream_read_fn_t read_fn);
+const audio_asset_s* app_audio_store_sound_effect(audio_sound_effect_e sound_effect);
+uint8_t app_audio_store_n_streamed(void);
+uint32_t app_audio_crc32(uint32_t crc, const uint8_t* data, uint32_t length);
+
+
+#endif // __APP_AUDIO_STORE_H__
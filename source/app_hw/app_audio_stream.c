@@ -0,0 +1,289 @@
+/**
+ * @file app_audio_stream.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for audio streaming. Each stream is a single producer, single
+ * consumer ring of blocks: the refill task reads blocks from external flash
+ * and publishes them by advancing head, and the mixer (in the audio DMA
+ * interrupt) consumes them by advancing tail. External flash can't be read
+ * from the interrupt, so the mixer never waits on it. If a block isn't ready
+ * in time the voice plays silence for the rest of the mixer block and the
+ * underrun is counted
+ *
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_stream.h"
+#include <string.h>
+
+#if defined(__ARM_ARCH)
+#include "cy_pdl.h"
+#endif
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#if defined(__ARM_ARCH)
+// Keep the audio DMA interrupt out while stream state is checked
+#define STREAM_ENTER_CRITICAL()    Cy_SysLib_EnterCriticalSection()
+#define STREAM_EXIT_CRITICAL(S)    Cy_SysLib_ExitCriticalSection(S)
+// Make sure a block's data is written before the mixer can see it
+#define STREAM_DMB()               __DMB()
+#else
+#define STREAM_ENTER_CRITICAL()    (0UL)
+#define STREAM_EXIT_CRITICAL(S)    ((void)(S))
+#define STREAM_DMB()               __sync_synchronize()
+#endif
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static app_audio_stream_s app_audio_streams[APP_AUDIO_STREAM_N_STREAMS];
+static app_audio_stream_stats_s app_audio_stream_stats;
+static app_audio_stream_read_fn_t app_audio_stream_read_fn = NULL;
+static app_audio_stream_refill_cb_t app_audio_stream_refill_cb = NULL;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Check whether a stream has room for blocks it hasn't read yet
+ *
+ * @param const app_audio_stream_s*
+ * Stream to check
+ * @return bool
+ * true if the refill task has work to do for the stream
+ */
+static inline bool app_audio_stream_needs_refill(const app_audio_stream_s* stream)
+{
+    return stream->open &&
+           (stream->n_fetched < stream->n_blocks) &&
+           ((stream->head - stream->tail) < APP_AUDIO_STREAM_RING_BLOCKS);
+}
+
+
+/**
+ * @brief  Close all streams
+ *
+ * @param app_audio_stream_read_fn_t
+ * Function to read from external flash with
+ */
+void app_audio_stream_init(app_audio_stream_read_fn_t read_fn)
+{
+    memset(app_audio_streams, 0, sizeof(app_audio_streams));
+    app_audio_stream_read_fn = read_fn;
+    app_audio_stream_reset_stats();
+}
+
+
+/**
+ * @brief  Set the function to call when a stream needs refilling
+ *
+ * @param app_audio_stream_refill_cb_t
+ * Function to wake the refill task with
+ */
+void app_audio_stream_set_refill_cb(app_audio_stream_refill_cb_t refill_cb)
+{
+    app_audio_stream_refill_cb = refill_cb;
+}
+
+
+/**
+ * @brief  Start streaming an asset, dropping anything buffered for the stream's
+ *         previous asset. Must not run while a block is being rendered
+ *
+ * @param uint8_t
+ * Stream to use (one per mixer voice)
+ * @param uint32_t
+ * Start of the asset in external flash
+ * @param uint32_t
+ * Length of the asset in bytes
+ */
+void app_audio_stream_open(uint8_t stream_idx, uint32_t addr, uint32_t n_bytes)
+{
+    app_audio_stream_s* stream = &app_audio_streams[stream_idx];
+
+    stream->generation++;
+    stream->addr = addr;
+    stream->n_blocks = (n_bytes + APP_AUDIO_STREAM_BLOCK_BYTES - 1) / APP_AUDIO_STREAM_BLOCK_BYTES;
+    stream->n_fetched = 0;
+    stream->head = 0;
+    stream->tail = 0;
+    stream->started = false;
+    stream->open = true;
+
+    if (app_audio_stream_refill_cb != NULL)
+    {
+        app_audio_stream_refill_cb();
+    }
+}
+
+
+/**
+ * @brief  Stop streaming. Must not run while a block is being rendered
+ *
+ * @param uint8_t
+ * Stream to close
+ */
+void app_audio_stream_close(uint8_t stream_idx)
+{
+    app_audio_streams[stream_idx].open = false;
+}
+
+
+/**
+ * @brief  Get the next block of a stream without consuming it
+ *
+ * @param uint8_t
+ * Stream to read
+ * @return const uint8_t*
+ * APP_AUDIO_STREAM_BLOCK_BYTES of the asset, or NULL if the block hasn't been
+ * read from flash yet
+ */
+const uint8_t* app_audio_stream_peek(uint8_t stream_idx)
+{
+    app_audio_stream_s* stream = &app_audio_streams[stream_idx];
+    const uint32_t fill = stream->head - stream->tail;
+
+    // Only blocks the refill task could still be working on count towards the margin
+    if (stream->started && (stream->head < stream->n_blocks) && (fill < app_audio_stream_stats.min_fill))
+    {
+        app_audio_stream_stats.min_fill = fill;
+    }
+
+    if (fill == 0)
+    {
+        // Waiting for the first block only delays the start of the asset
+        if (stream->started && (stream->tail < stream->n_blocks))
+        {
+            app_audio_stream_stats.n_underruns++;
+        }
+        return NULL;
+    }
+
+    return stream->ring[stream->tail % APP_AUDIO_STREAM_RING_BLOCKS];
+}
+
+
+/**
+ * @brief  Consume the block returned by app_audio_stream_peek, making room for
+ *         the refill task to read another
+ *
+ * @param uint8_t
+ * Stream to advance
+ */
+void app_audio_stream_release(uint8_t stream_idx)
+{
+    app_audio_stream_s* stream = &app_audio_streams[stream_idx];
+
+    stream->tail++;
+    stream->started = true;
+}
+
+
+/**
+ * @brief  Wake the refill task if any stream has room for more blocks. Called
+ *         after each mixer block
+ *
+ * @return void
+ */
+void app_audio_stream_service(void)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_STREAM_N_STREAMS; i++)
+    {
+        if (app_audio_stream_needs_refill(&app_audio_streams[i]))
+        {
+            if (app_audio_stream_refill_cb != NULL)
+            {
+                app_audio_stream_refill_cb();
+            }
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief  Read blocks from external flash until every stream's ring is full or
+ *         its asset has been read. Runs from the refill task, since reads block
+ *
+ * @return void
+ */
+void app_audio_stream_refill(void)
+{
+    for (uint8_t i = 0; i < APP_AUDIO_STREAM_N_STREAMS; i++)
+    {
+        app_audio_stream_s* stream = &app_audio_streams[i];
+
+        for (;;)
+        {
+            uint32_t intr_state = STREAM_ENTER_CRITICAL();
+            if (!app_audio_stream_needs_refill(stream))
+            {
+                STREAM_EXIT_CRITICAL(intr_state);
+                break;
+            }
+            const uint32_t generation = stream->generation;
+            const uint32_t addr = stream->addr + (stream->n_fetched * APP_AUDIO_STREAM_BLOCK_BYTES);
+            uint8_t* block = stream->ring[stream->head % APP_AUDIO_STREAM_RING_BLOCKS];
+            STREAM_EXIT_CRITICAL(intr_state);
+
+            // The slot past head is never read by the mixer, so it can be filled
+            // without holding it off
+            const bool ok = app_audio_stream_read_fn(addr, APP_AUDIO_STREAM_BLOCK_BYTES, block);
+
+            intr_state = STREAM_ENTER_CRITICAL();
+            // Drop the block if the stream was reopened for another asset meanwhile
+            const bool current = stream->open && (stream->generation == generation);
+            if (current && ok)
+            {
+                STREAM_DMB();
+                stream->head++;
+                stream->n_fetched++;
+                app_audio_stream_stats.n_blocks_read++;
+            }
+            else if (!ok)
+            {
+                app_audio_stream_stats.n_read_errors++;
+            }
+            STREAM_EXIT_CRITICAL(intr_state);
+
+            if (!ok)
+            {
+                // Try again on the next mixer block rather than spin on a bad read
+                break;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief  Get the streaming stats
+ *
+ * @param app_audio_stream_stats_s*
+ * Where to copy the stats to
+ */
+void app_audio_stream_get_stats(app_audio_stream_stats_s* stats)
+{
+    *stats = app_audio_stream_stats;
+}
+
+
+/**
+ * @brief  Clear the streaming stats
+ *
+ * @return void
+ */
+void app_audio_stream_reset_stats(void)
+{
+    memset(&app_audio_stream_stats, 0, sizeof(app_audio_stream_stats));
+    app_audio_stream_stats.min_fill = APP_AUDIO_STREAM_RING_BLOCKS;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,76 @@
+/**
+ * @file app_audio_stream.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for audio streaming, which prefetches assets stored in external
+ * flash into per-voice SRAM ring buffers ahead of the mixer
+ *
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_STREAM_H__
+#define __APP_AUDIO_STREAM_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "app_audio_adpcm.h"
+
+
+// Defines
+// NOTE: Assets are streamed in blocks of one IMA-ADPCM block (505 samples, 11.5ms at
+//       44.1kHz) or 128 PCM samples (2.9ms at 44.1kHz). Each stream buffers up to
+//       APP_AUDIO_STREAM_RING_BLOCKS blocks, which is how long the refill task can be
+//       held off before a voice underruns
+#define APP_AUDIO_STREAM_N_STREAMS       (4U)
+#define APP_AUDIO_STREAM_BLOCK_BYTES     (APP_AUDIO_ADPCM_BLOCK_BYTES)
+#define APP_AUDIO_STREAM_RING_BLOCKS     (8U)
+
+// Read from external flash. Returns true on success
+typedef bool (*app_audio_stream_read_fn_t)(uint32_t addr, uint32_t length, uint8_t* buf);
+// Called when a stream has room for more blocks, to wake whatever calls
+// app_audio_stream_refill. Usually runs from the audio DMA interrupt
+typedef void (*app_audio_stream_refill_cb_t)(void);
+
+// A single asset being streamed
+typedef struct
+{
+    // First, so that PCM blocks are aligned for 16-bit reads
+    uint8_t ring[APP_AUDIO_STREAM_RING_BLOCKS][APP_AUDIO_STREAM_BLOCK_BYTES];
+    uint32_t addr;                   // Start of the asset in external flash
+    uint32_t n_blocks;               // Length of the asset in blocks
+    uint32_t n_fetched;              // Blocks read so far (refill task only)
+    volatile uint32_t head;          // Blocks made available to the mixer (refill task only)
+    volatile uint32_t tail;          // Blocks consumed by the mixer (mixer only)
+    volatile uint32_t generation;    // Changes whenever the stream is reopened
+    volatile bool open;
+    bool started;                    // First block has been consumed
+} app_audio_stream_s;
+
+typedef struct
+{
+    uint32_t n_underruns;    // Blocks where a voice ran out of data partway through its asset
+    uint32_t n_blocks_read;
+    uint32_t n_read_errors;
+    uint32_t min_fill;       // Fewest blocks buffered ahead of a playing voice
+} app_audio_stream_stats_s;
+
+
+// Function declarations
+void app_audio_stream_init(app_audio_stream_read_fn_t read_fn);
+void app_audio_stream_set_refill_cb(app_audio_stream_refill_cb_t refill_cb);
+void app_audio_stream_open(uint8_t stream_idx, uint32_t addr, uint32_t n_bytes);
+void app_audio_stream_close(uint8_t stream_idx);
+const uint8_t* app_audio_stream_peek(uint8_t stream_idx);
+void app_audio_stream_release(uint8_t stream_idx);
+void app_audio_stream_service(void);
+void app_audio_stream_refill(void);
+void app_audio_stream_get_stats(app_audio_stream_stats_s* stats);
+void app_audio_stream_reset_stats(void);
+
+
+#endif // __APP_AUDIO_STREAM_H__
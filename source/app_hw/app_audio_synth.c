@@ -0,0 +1,392 @@
+/**
+ * @file app_audio_synth.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the procedural sound effect synthesizer. Each note runs a
+ * 32-bit phase accumulator like the DDS tone generator, and the phase is
+ * turned into a square, saw, noise, or sine wave. A piecewise linear ADSR
+ * envelope scales the oscillator, and a one-pole low-pass filter (whose
+ * coefficient is updated once per block) softens it. Samples are rendered in
+ * runs that never cross an envelope stage or the end of a pitch sweep, so the
+ * per-sample loop has no bookkeeping beyond a few adds
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_synth.h"
+#include "app_audio_dds.h"
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define SYNTH_MS_TO_SAMPLES(SYNTH, MS)    (((uint32_t)(MS) * (SYNTH)->sample_rate) / 1000UL)
+// 2 * pi in Q15
+#define SYNTH_TWO_PI_Q15                  (205887ULL)
+#define SYNTH_FILTER_SHIFT                (8U)
+// Taps 32, 22, 2, 1 (maximal length)
+#define SYNTH_LFSR_TAPS                   (0x80200003UL)
+#define SYNTH_LFSR_SEED                   (0xACE1ACE1UL)
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Get the current note's patch
+ *
+ * @param const app_audio_synth_s*
+ * Synthesizer to check
+ * @return const app_audio_synth_patch_s*
+ * Patch of the note being played
+ */
+static inline const app_audio_synth_patch_s* app_audio_synth_patch(const app_audio_synth_s* synth)
+{
+    return &synth->notes[synth->note_idx];
+}
+
+
+/**
+ * @brief  Convert a frequency to a phase increment per sample, after scaling
+ *         it by the synthesizer's pitch
+ *
+ * @param const app_audio_synth_s*
+ * Synthesizer to tune for
+ * @param uint16_t
+ * Frequency in Hz, before the pitch is applied
+ * @return uint32_t
+ * Phase increment per sample
+ */
+static uint32_t app_audio_synth_tuning_word(const app_audio_synth_s* synth, uint16_t freq_hz)
+{
+    const uint64_t scaled = (uint64_t)freq_hz * synth->pitch;
+    const uint64_t tuning_word = (scaled << (32U - APP_AUDIO_SYNTH_PITCH_SHIFT)) / synth->sample_rate;
+
+    // Anything at or above the sample rate would just alias
+    return (tuning_word > UINT32_MAX) ? UINT32_MAX : (uint32_t)tuning_word;
+}
+
+
+/**
+ * @brief  Get the length of a note
+ *
+ * @param const app_audio_synth_s*
+ * Synthesizer the note is played by
+ * @param const app_audio_synth_patch_s*
+ * Patch of the note
+ * @return uint32_t
+ * Length of the note in samples
+ */
+static uint32_t app_audio_synth_note_samples(const app_audio_synth_s* synth, const app_audio_synth_patch_s* patch)
+{
+    return SYNTH_MS_TO_SAMPLES(synth, patch->attack_ms) +
+           SYNTH_MS_TO_SAMPLES(synth, patch->decay_ms) +
+           SYNTH_MS_TO_SAMPLES(synth, patch->sustain_ms) +
+           SYNTH_MS_TO_SAMPLES(synth, patch->release_ms);
+}
+
+
+/**
+ * @brief  Update the low-pass coefficient for the current point in the note.
+ *         The coefficient is w / (1 + w), close enough to 1 - e^-w for the
+ *         cutoffs used by sound effects and cheap enough to do every block
+ *
+ * @param app_audio_synth_s*
+ * Synthesizer to update
+ */
+static void app_audio_synth_update_filter(app_audio_synth_s* synth)
+{
+    const app_audio_synth_patch_s* patch = app_audio_synth_patch(synth);
+
+    if (APP_AUDIO_SYNTH_NO_FILTER == patch->cutoff_start_hz)
+    {
+        synth->filter_coef = 0;
+        return;
+    }
+
+    int32_t cutoff_hz = patch->cutoff_start_hz;
+    if (synth->note_samples > 0)
+    {
+        cutoff_hz += (int32_t)(((int64_t)((int32_t)patch->cutoff_end_hz - (int32_t)patch->cutoff_start_hz) *
+                                synth->note_pos) / synth->note_samples);
+    }
+
+    // The filter follows the pitch, so transposed notes keep their tone
+    const uint64_t scaled_hz = ((uint64_t)cutoff_hz * synth->pitch) >> APP_AUDIO_SYNTH_PITCH_SHIFT;
+    const uint64_t w = (SYNTH_TWO_PI_Q15 * scaled_hz) / synth->sample_rate;
+    const uint64_t coef = (w << 15) / (32768ULL + w);
+
+    synth->filter_coef = (coef >= INT16_MAX) ? INT16_MAX : ((coef == 0) ? 1 : (int16_t)coef);
+}
+
+
+/**
+ * @brief  Start an envelope stage, skipping any with no length. Moves on to
+ *         the next note after the release
+ *
+ * @param app_audio_synth_s*
+ * Synthesizer to update
+ * @param app_audio_synth_stage_e
+ * Stage to start
+ */
+static void app_audio_synth_start_stage(app_audio_synth_s* synth, app_audio_synth_stage_e stage);
+
+
+/**
+ * @brief  Start the note at synth->note_idx, or finish if there are none left
+ *
+ * @param app_audio_synth_s*
+ * Synthesizer to update
+ */
+static void app_audio_synth_start_note(app_audio_synth_s* synth)
+{
+    if (synth->note_idx >= synth->n_notes)
+    {
+        synth->stage = APP_AUDIO_SYNTH_STAGE_DONE;
+        synth->stage_left = 0;
+        return;
+    }
+
+    const app_audio_synth_patch_s* patch = app_audio_synth_patch(synth);
+    const uint32_t tuning_start = app_audio_synth_tuning_word(synth, patch->freq_start_hz);
+    const uint32_t tuning_end = app_audio_synth_tuning_word(synth, patch->freq_end_hz);
+
+    synth->tuning_word = tuning_start;
+    synth->sweep_left = SYNTH_MS_TO_SAMPLES(synth, patch->sweep_ms);
+    synth->tuning_step = (synth->sweep_left > 0) ?
+                         (int32_t)(((int64_t)tuning_end - (int64_t)tuning_start) / (int64_t)synth->sweep_left) : 0;
+    synth->note_samples = app_audio_synth_note_samples(synth, patch);
+    synth->note_pos = 0;
+    // Every note starts from silence
+    synth->env_target = 0;
+    app_audio_synth_update_filter(synth);
+    app_audio_synth_start_stage(synth, APP_AUDIO_SYNTH_STAGE_ATTACK);
+}
+
+
+static void app_audio_synth_start_stage(app_audio_synth_s* synth, app_audio_synth_stage_e stage)
+{
+    const app_audio_synth_patch_s* patch = app_audio_synth_patch(synth);
+    const int32_t peak = (int32_t)patch->gain << 16;
+    const int32_t sustain = (((int32_t)patch->gain * patch->sustain) >> 15) << 16;
+
+    // The end of the last stage lands exactly on its target
+    synth->env = synth->env_target;
+
+    for (; stage < APP_AUDIO_SYNTH_STAGE_DONE; stage++)
+    {
+        uint16_t length_ms;
+
+        switch (stage)
+        {
+            case APP_AUDIO_SYNTH_STAGE_ATTACK:
+                length_ms = patch->attack_ms;
+                synth->env_target = peak;
+                break;
+            case APP_AUDIO_SYNTH_STAGE_DECAY:
+                length_ms = patch->decay_ms;
+                synth->env_target = sustain;
+                break;
+            case APP_AUDIO_SYNTH_STAGE_SUSTAIN:
+                length_ms = patch->sustain_ms;
+                synth->env_target = sustain;
+                break;
+            default:
+                length_ms = patch->release_ms;
+                synth->env_target = 0;
+                break;
+        }
+
+        synth->stage_left = SYNTH_MS_TO_SAMPLES(synth, length_ms);
+        if (synth->stage_left > 0)
+        {
+            synth->stage = (uint8_t)stage;
+            synth->env_step = (synth->env_target - synth->env) / (int32_t)synth->stage_left;
+            return;
+        }
+
+        // Zero length stages jump straight to their level
+        synth->env = synth->env_target;
+    }
+
+    synth->note_idx++;
+    app_audio_synth_start_note(synth);
+}
+
+
+/**
+ * @brief  Render samples that all fall within one envelope stage and one side
+ *         of the end of the pitch sweep
+ *
+ * @param app_audio_synth_s*
+ * Synthesizer to render
+ * @param int16_t*
+ * Where to write the samples
+ * @param uint32_t
+ * Number of samples
+ */
+static void app_audio_synth_render_run(app_audio_synth_s* synth, int16_t* out, uint32_t n_samples)
+{
+    const app_audio_synth_patch_s* patch = app_audio_synth_patch(synth);
+    const uint8_t wave = patch->wave;
+    const uint32_t duty_phase = (uint32_t)patch->duty << 24;
+    const int32_t tuning_step = synth->tuning_step;
+    const int32_t env_step = synth->env_step;
+    const int32_t filter_coef = synth->filter_coef;
+    uint32_t phase = synth->phase;
+    uint32_t tuning_word = synth->tuning_word;
+    int32_t env = synth->env;
+    int32_t filter_state = synth->filter_state;
+
+    for (uint32_t i = 0; i < n_samples; i++)
+    {
+        int32_t osc;
+
+        switch (wave)
+        {
+            case APP_AUDIO_SYNTH_WAVE_SQUARE:
+                osc = (phase < duty_phase) ? INT16_MAX : -INT16_MAX;
+                break;
+            case APP_AUDIO_SYNTH_WAVE_SAW:
+                osc = (int32_t)(phase >> 16) - 32768;
+                break;
+            case APP_AUDIO_SYNTH_WAVE_NOISE:
+                osc = synth->noise;
+                break;
+            default:
+                osc = app_audio_dds_sine(phase);
+                break;
+        }
+
+        int32_t sample = (osc * (env >> 16)) >> 15;
+        if (filter_coef != 0)
+        {
+            filter_state += (int32_t)(((int64_t)((sample << SYNTH_FILTER_SHIFT) - filter_state) * filter_coef) >> 15);
+            sample = filter_state >> SYNTH_FILTER_SHIFT;
+        }
+        out[i] = (int16_t)sample;
+
+        const uint32_t next_phase = phase + tuning_word;
+        if (next_phase < phase)
+        {
+            // Clock the noise generator once per period
+            synth->lfsr = (synth->lfsr >> 1) ^ (SYNTH_LFSR_TAPS & (0UL - (synth->lfsr & 1UL)));
+            synth->noise = (int16_t)(synth->lfsr & 0xFFFF);
+        }
+        phase = next_phase;
+        tuning_word += (uint32_t)tuning_step;
+        env += env_step;
+    }
+
+    synth->phase = phase;
+    synth->tuning_word = tuning_word;
+    synth->env = env;
+    synth->filter_state = filter_state;
+}
+
+
+/**
+ * @brief  Start synthesizing a sound effect
+ *
+ * @param app_audio_synth_s*
+ * Synthesizer to start
+ * @param const app_audio_synth_patch_s*
+ * Notes to play in order (not copied)
+ * @param uint8_t
+ * Number of notes
+ * @param uint32_t
+ * Rate to render at (Hz)
+ * @param uint16_t
+ * Q12 scale applied to every frequency (APP_AUDIO_SYNTH_PITCH_UNITY to play the
+ * notes as written)
+ * @return uint32_t
+ * Length of the sound effect in samples
+ */
+uint32_t app_audio_synth_start(app_audio_synth_s* synth,
+                               const app_audio_synth_patch_s* notes,
+                               uint8_t n_notes,
+                               uint32_t sample_rate,
+                               uint16_t pitch)
+{
+    uint32_t n_samples = 0;
+
+    memset(synth, 0, sizeof(*synth));
+    synth->notes = notes;
+    synth->n_notes = n_notes;
+    synth->sample_rate = sample_rate;
+    synth->pitch = pitch;
+    synth->lfsr = SYNTH_LFSR_SEED;
+
+    for (uint8_t i = 0; i < n_notes; i++)
+    {
+        n_samples += app_audio_synth_note_samples(synth, &notes[i]);
+    }
+
+    app_audio_synth_start_note(synth);
+
+    return n_samples;
+}
+
+
+/**
+ * @brief  Render the next samples of a sound effect
+ *
+ * @param app_audio_synth_s*
+ * Synthesizer to render
+ * @param int16_t*
+ * Where to write the samples
+ * @param uint32_t
+ * Most samples to render
+ * @return uint32_t
+ * Number of samples rendered. Less than requested once the last note ends
+ */
+uint32_t app_audio_synth_render(app_audio_synth_s* synth, int16_t* out, uint32_t n_samples)
+{
+    uint32_t n_done = 0;
+
+    if (synth->stage != APP_AUDIO_SYNTH_STAGE_DONE)
+    {
+        app_audio_synth_update_filter(synth);
+    }
+
+    while ((n_done < n_samples) && (synth->stage != APP_AUDIO_SYNTH_STAGE_DONE))
+    {
+        uint32_t n_run = n_samples - n_done;
+
+        if (synth->stage_left < n_run)
+        {
+            n_run = synth->stage_left;
+        }
+        if ((synth->sweep_left > 0) && (synth->sweep_left < n_run))
+        {
+            n_run = synth->sweep_left;
+        }
+
+        app_audio_synth_render_run(synth, &out[n_done], n_run);
+        n_done += n_run;
+        synth->note_pos += n_run;
+        synth->stage_left -= n_run;
+
+        if (synth->sweep_left > 0)
+        {
+            synth->sweep_left -= n_run;
+            if (0 == synth->sweep_left)
+            {
+                // Hold the end frequency
+                synth->tuning_step = 0;
+            }
+        }
+
+        if (0 == synth->stage_left)
+        {
+            app_audio_synth_start_stage(synth, (app_audio_synth_stage_e)(synth->stage + 1));
+        }
+    }
+
+    return n_done;
+}
+
+/* [] END OF FILE */
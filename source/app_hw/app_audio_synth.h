@@ -0,0 +1,105 @@
+/**
+ * @file app_audio_synth.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the procedural sound effect synthesizer, which renders
+ * sound effects from small parameter records (patches) instead of playing
+ * recorded samples
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_AUDIO_SYNTH_H__
+#define __APP_AUDIO_SYNTH_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: Patches are rendered at the rate passed to app_audio_synth_start (the mixer's
+//       output rate), so there is nothing to resample. A sound effect is a sequence of
+//       notes, each with its own patch, played back to back
+#define APP_AUDIO_SYNTH_PITCH_SHIFT    (12U)
+#define APP_AUDIO_SYNTH_PITCH_UNITY    (1U << APP_AUDIO_SYNTH_PITCH_SHIFT) // Q12
+// Cutoff of 0 leaves the low-pass filter out
+#define APP_AUDIO_SYNTH_NO_FILTER      (0U)
+
+typedef enum
+{
+    APP_AUDIO_SYNTH_WAVE_SQUARE = 0,
+    APP_AUDIO_SYNTH_WAVE_SAW    = 1,
+    APP_AUDIO_SYNTH_WAVE_NOISE  = 2, // New random value every period, so pitch sets its color
+    APP_AUDIO_SYNTH_WAVE_SINE   = 3
+} app_audio_synth_wave_e;
+
+// A single note. The oscillator sweeps linearly from freq_start_hz to freq_end_hz over
+// sweep_ms and then holds, while a linear ADSR envelope shapes its amplitude. The note
+// lasts attack_ms + decay_ms + sustain_ms + release_ms
+typedef struct
+{
+    uint8_t wave;                // app_audio_synth_wave_e
+    uint8_t duty;                // Square wave duty cycle (/256, so 128 is a square)
+    uint16_t freq_start_hz;
+    uint16_t freq_end_hz;
+    uint16_t sweep_ms;           // 0 to stay at freq_start_hz
+    uint16_t attack_ms;
+    uint16_t decay_ms;
+    uint16_t sustain_ms;
+    uint16_t release_ms;
+    int16_t sustain;             // Q15 level held after the decay, relative to gain
+    int16_t gain;                // Q15 peak level
+    uint16_t cutoff_start_hz;    // One-pole low-pass, swept like the pitch (APP_AUDIO_SYNTH_NO_FILTER to bypass)
+    uint16_t cutoff_end_hz;
+} app_audio_synth_patch_s;
+
+typedef enum
+{
+    APP_AUDIO_SYNTH_STAGE_ATTACK  = 0,
+    APP_AUDIO_SYNTH_STAGE_DECAY   = 1,
+    APP_AUDIO_SYNTH_STAGE_SUSTAIN = 2,
+    APP_AUDIO_SYNTH_STAGE_RELEASE = 3,
+    APP_AUDIO_SYNTH_STAGE_DONE    = 4
+} app_audio_synth_stage_e;
+
+// State of a single synthesized sound effect
+typedef struct
+{
+    const app_audio_synth_patch_s* notes;
+    uint8_t n_notes;
+    uint8_t note_idx;
+    uint16_t pitch;              // Q12 scale applied to every frequency
+    uint32_t sample_rate;
+    uint32_t phase;
+    uint32_t tuning_word;        // Phase increment per sample
+    int32_t tuning_step;         // Added to the tuning word every sample while sweeping
+    uint32_t sweep_left;         // Samples left in the pitch sweep
+    uint8_t stage;               // app_audio_synth_stage_e
+    uint32_t stage_left;         // Samples left in the envelope stage
+    int32_t env;                 // Q15 envelope << 16, so ramps can take fractional steps
+    int32_t env_step;
+    int32_t env_target;          // Envelope at the end of the stage
+    uint32_t note_samples;       // Length of the note, for sweeping the cutoff
+    uint32_t note_pos;
+    uint32_t lfsr;               // Noise generator
+    int16_t noise;               // Noise value held for the current period
+    int16_t filter_coef;         // Q15 low-pass coefficient, 0 when bypassed
+    int32_t filter_state;        // Q15 output of the low-pass << 8
+} app_audio_synth_s;
+
+
+// Function declarations
+uint32_t app_audio_synth_start(app_audio_synth_s* synth,
+                               const app_audio_synth_patch_s* notes,
+                               uint8_t n_notes,
+                               uint32_t sample_rate,
+                               uint16_t pitch);
+uint32_t app_audio_synth_render(app_audio_synth_s* synth, int16_t* out, uint32_t n_samples);
+
+
+#endif // __APP_AUDIO_SYNTH_H__
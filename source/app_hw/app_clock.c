@@ -0,0 +1,91 @@
+#include "app_clock.h"
+
+// Every timestamp relies on the clock only wrapping every ~71 minutes, so it needs a 32-bit
+// counter. Only TCPWM0's are 32-bit (TCPWM1's would wrap every 65 ms), and a counter the HAL
+// picks for itself could be either, depending on what was set up first. So the clock takes a
+// counter of its own, which no pin the car uses is wired to
+#define APP_CLOCK_TCPWM_BLOCK   (0U)
+#define APP_CLOCK_TCPWM_CNT     (7U)
+
+static cyhal_timer_t app_clock_timer;
+static cyhal_clock_t app_clock_divider;
+
+/**
+ * @brief
+ * Stops everything if the clock couldn't be started. Nothing is timed right
+ * without it, so this holds in release builds too, unlike CY_ASSERT
+ *
+ * @param rslt
+ * Result of a step of starting the clock
+ */
+static void app_clock_check(cy_rslt_t rslt) {
+    if (CY_RSLT_SUCCESS != rslt) {
+        __disable_irq();
+        CY_HALT();
+        while (1) {
+        }
+    }
+}
+
+/**
+ * @brief
+ * Starts the clock. Must run before anything reads it
+ */
+void app_clock_init(void) {
+    const cyhal_resource_inst_t resource = {
+        .type = CYHAL_RSC_TCPWM,
+        .block_num = APP_CLOCK_TCPWM_BLOCK,
+        .channel_num = APP_CLOCK_TCPWM_CNT
+    };
+    const cy_stc_tcpwm_counter_config_t counter_cfg = {
+        .period = UINT32_MAX,
+        .clockPrescaler = CY_TCPWM_COUNTER_PRESCALER_DIVBY_1,
+        .runMode = CY_TCPWM_COUNTER_CONTINUOUS,
+        .countDirection = CY_TCPWM_COUNTER_COUNT_UP,
+        .compareOrCapture = CY_TCPWM_COUNTER_MODE_CAPTURE,
+        .compare0 = 0,
+        .compare1 = 0,
+        .enableCompareSwap = false,
+        .interruptSources = CY_TCPWM_INT_NONE,
+        .captureInputMode = CY_TCPWM_INPUT_RISINGEDGE,
+        .captureInput = CY_TCPWM_INPUT_0,
+        .reloadInputMode = CY_TCPWM_INPUT_RISINGEDGE,
+        .reloadInput = CY_TCPWM_INPUT_0,
+        .startInputMode = CY_TCPWM_INPUT_RISINGEDGE,
+        .startInput = CY_TCPWM_INPUT_0,
+        .stopInputMode = CY_TCPWM_INPUT_RISINGEDGE,
+        .stopInput = CY_TCPWM_INPUT_0,
+        .countInputMode = CY_TCPWM_INPUT_LEVEL,
+        .countInput = CY_TCPWM_INPUT_1
+    };
+    const cyhal_timer_configurator_t timer_cfg = {
+        .resource = &resource,
+        .config = &counter_cfg,
+        .clock = &app_clock_divider
+    };
+
+    // Fails if anything else already has the counter
+    app_clock_check(cyhal_hwmgr_reserve(&resource));
+    app_clock_check(cyhal_clock_allocate(&app_clock_divider, CYHAL_CLOCK_BLOCK_PERIPHERAL_16BIT));
+    app_clock_check(cyhal_clock_set_frequency(&app_clock_divider, APP_CLOCK_HZ, NULL));
+    app_clock_check(cyhal_clock_set_enabled(&app_clock_divider, true, true));
+    app_clock_check(cyhal_timer_init_cfg(&app_clock_timer, &timer_cfg));
+    // The period register of a 16-bit counter only keeps the low 16 bits
+    app_clock_check((Cy_TCPWM_Counter_GetPeriod(app_clock_timer.tcpwm.base,
+                                                app_clock_timer.tcpwm.resource.channel_num) == UINT32_MAX)
+                    ? CY_RSLT_SUCCESS : CYHAL_TIMER_RSLT_ERR_INIT);
+    app_clock_check(cyhal_timer_start(&app_clock_timer));
+}
+
+/**
+ * @brief
+ * Reads the clock. Safe to call from interrupts
+ *
+ * @return
+ * Microseconds since app_clock_init (wraps every ~71 minutes)
+ */
+uint32_t app_clock_us(void) {
+    return cyhal_timer_read(&app_clock_timer);
+}
+
+/* [] END OF FILE */
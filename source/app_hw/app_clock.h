@@ -0,0 +1,24 @@
+/**
+ * @file app_clock.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief Header file for the free-running microsecond clock that events are
+ * timestamped with (wheel sensor pulses, joystick writes, ...)
+ * @version 0.1
+ * @date 2024-12-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __APP_CLOCK_H__
+#define __APP_CLOCK_H__
+
+#include <stdint.h>
+#include "cy_result.h"
+#include "cyhal.h"
+
+#define APP_CLOCK_HZ    (1000000)
+
+void app_clock_init(void);
+uint32_t app_clock_us(void);
+
+#endif
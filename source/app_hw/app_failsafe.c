@@ -0,0 +1,207 @@
+/**
+ * @file app_failsafe.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the link-loss failsafe. A BLE link that goes quiet isn't
+ * reported as down until the supervision timeout, seconds later, and until
+ * then the car would carry on at the last joystick position it was given
+ *
+ * @version 0.1
+ * @date 2024-12-23
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_failsafe.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define FAILSAFE_US_PER_MS      (1000U)
+#define FAILSAFE_MS_PER_S       (1000.0f)
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Initialize the failsafe. The inputs are left as they are, so it can
+ *         be initialized after the link has come up
+ *
+ * @param app_failsafe_s*
+ * Failsafe to initialize
+ * @param const app_failsafe_cfg_s*
+ * Deadline and deceleration
+ * @param uint32_t
+ * Current time (us, wraps)
+ */
+void app_failsafe_init(app_failsafe_s* failsafe, const app_failsafe_cfg_s* cfg, uint32_t now_us)
+{
+    failsafe->cfg = *cfg;
+    // Starts tripped until there's a link, without counting it as a trip
+    failsafe->state = failsafe->connected ? APP_FAILSAFE_STATE_OK : APP_FAILSAFE_STATE_LINK_DOWN;
+    failsafe->n_link_downs_seen = failsafe->n_link_downs;
+    failsafe->n_joystick_seen = failsafe->n_inputs[APP_FAILSAFE_INPUT_JOYSTICK];
+    failsafe->trip_us = now_us;
+    failsafe->n_trips = 0;
+}
+
+
+/**
+ * @brief  Change the failsafe's deadline and deceleration
+ *
+ * @param app_failsafe_s*
+ * Failsafe to update
+ * @param const app_failsafe_cfg_s*
+ * New deadline and deceleration
+ */
+void app_failsafe_set_cfg(app_failsafe_s* failsafe, const app_failsafe_cfg_s* cfg)
+{
+    failsafe->cfg = *cfg;
+}
+
+
+/**
+ * @brief  Note that an input has just been received. Called by the BLE side
+ *
+ * @param app_failsafe_s*
+ * Failsafe to update
+ * @param app_failsafe_input_e
+ * Input that was received
+ * @param uint32_t
+ * Current time (us, wraps)
+ */
+void app_failsafe_input(app_failsafe_s* failsafe, app_failsafe_input_e input, uint32_t now_us)
+{
+    failsafe->input_us[input] = now_us;
+    failsafe->n_inputs[input]++;
+}
+
+
+/**
+ * @brief  Note that the connection has come up. Called by the BLE side
+ *
+ * @param app_failsafe_s*
+ * Failsafe to update
+ * @param uint32_t
+ * Current time (us, wraps)
+ */
+void app_failsafe_link_up(app_failsafe_s* failsafe, uint32_t now_us)
+{
+    app_failsafe_input(failsafe, APP_FAILSAFE_INPUT_CONNECTION, now_us);
+    failsafe->connected = true;
+}
+
+
+/**
+ * @brief  Note that the connection has dropped. Called by the BLE side. The
+ *         next update trips the failsafe, even if the link is back by then
+ *
+ * @param app_failsafe_s*
+ * Failsafe to update
+ */
+void app_failsafe_link_down(app_failsafe_s* failsafe)
+{
+    failsafe->connected = false;
+    failsafe->n_link_downs++;
+}
+
+
+/**
+ * @brief  Get how long it has been since any input was received
+ *
+ * @param const app_failsafe_s*
+ * Failsafe to check
+ * @param uint32_t
+ * Current time (us, wraps)
+ * @return uint32_t
+ * Age of the newest input (us)
+ */
+uint32_t app_failsafe_age_us(const app_failsafe_s* failsafe, uint32_t now_us)
+{
+    uint32_t age_us = UINT32_MAX;
+
+    for (uint32_t i = 0; i < APP_FAILSAFE_INPUT_MAX; i++)
+    {
+        const uint32_t input_age_us = now_us - failsafe->input_us[i];
+        if (input_age_us < age_us)
+        {
+            age_us = input_age_us;
+        }
+    }
+    return age_us;
+}
+
+
+/**
+ * @brief  Check the link, and trip or clear the failsafe. Run it on every
+ *         control loop tick
+ *
+ * @param app_failsafe_s*
+ * Failsafe to run
+ * @param uint32_t
+ * Current time (us, wraps)
+ * @return app_failsafe_state_e
+ * APP_FAILSAFE_STATE_OK if the car may be driven, otherwise why it must stop
+ */
+app_failsafe_state_e app_failsafe_update(app_failsafe_s* failsafe, uint32_t now_us)
+{
+    const uint32_t n_link_downs = failsafe->n_link_downs;
+    const uint32_t n_joystick = failsafe->n_inputs[APP_FAILSAFE_INPUT_JOYSTICK];
+    app_failsafe_state_e trip = APP_FAILSAFE_STATE_OK;
+
+    if ((n_link_downs != failsafe->n_link_downs_seen) || !failsafe->connected)
+    {
+        trip = APP_FAILSAFE_STATE_LINK_DOWN;
+    }
+    else if ((failsafe->cfg.deadline_ms > 0) &&
+             (app_failsafe_age_us(failsafe, now_us) > ((uint32_t)failsafe->cfg.deadline_ms * FAILSAFE_US_PER_MS)))
+    {
+        trip = APP_FAILSAFE_STATE_STALE;
+    }
+    failsafe->n_link_downs_seen = n_link_downs;
+
+    if (trip != APP_FAILSAFE_STATE_OK)
+    {
+        if (failsafe->state == APP_FAILSAFE_STATE_OK)
+        {
+            failsafe->trip_us = now_us;
+            failsafe->n_trips++;
+        }
+        failsafe->state = trip;
+        // Only joystick samples from after the link is back can clear it
+        failsafe->n_joystick_seen = n_joystick;
+    }
+    else if ((failsafe->state != APP_FAILSAFE_STATE_OK) && (n_joystick != failsafe->n_joystick_seen))
+    {
+        failsafe->state = APP_FAILSAFE_STATE_OK;
+    }
+
+    return failsafe->state;
+}
+
+
+/**
+ * @brief  Bring a speed setpoint towards 0 at the failsafe's deceleration
+ *
+ * @param const app_failsafe_s*
+ * Failsafe to decelerate with
+ * @param float
+ * Signed speed setpoint (duty cycle, %)
+ * @param uint32_t
+ * Time since the last call (ms)
+ * @return float
+ * New speed setpoint, with the same sign, or 0
+ */
+float app_failsafe_decel(const app_failsafe_s* failsafe, float speed, uint32_t elapsed_ms)
+{
+    const float step = (float)failsafe->cfg.decel * (float)elapsed_ms / FAILSAFE_MS_PER_S;
+
+    if ((speed <= step) && (speed >= -step))
+    {
+        return 0.0f;
+    }
+    return (speed > 0.0f) ? (speed - step) : (speed + step);
+}
+
+/* [] END OF FILE */
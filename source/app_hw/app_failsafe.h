@@ -0,0 +1,90 @@
+/**
+ * @file app_failsafe.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the link-loss failsafe, which tracks how fresh the car's
+ * BLE inputs are and stops the car on a fixed deceleration profile once they
+ * go stale or the connection drops
+ *
+ * @version 0.1
+ * @date 2024-12-23
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_FAILSAFE_H__
+#define __APP_FAILSAFE_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: The RC controller app writes the joystick every frame while it is connected, so the
+//       link counts as alive while any input (joystick write, game event, or the connection
+//       coming up) is newer than the deadline. The connection dropping trips the failsafe on
+//       the next update, without waiting for the deadline. Once tripped, it stays tripped until
+//       the link is back and a new joystick sample has come in, so the car doesn't lurch off at
+//       whatever the stick was before the link was lost.
+//       The inputs are written by the BLE side and everything else by the control loop, so each
+//       field has a single writer and no locking is needed
+// Defaults, tuned with tools/link_loss_sim. The deadline rides out a 150 ms burst of
+// interference, and the deceleration takes the car from full speed to stopped in 250 ms
+#define APP_FAILSAFE_DEFAULT_DEADLINE_MS    (300U)
+#define APP_FAILSAFE_DEFAULT_DECEL          (400U)
+
+// Inputs whose freshness is tracked
+typedef enum
+{
+    APP_FAILSAFE_INPUT_JOYSTICK   = 0,
+    APP_FAILSAFE_INPUT_GAME_EVENT = 1,
+    APP_FAILSAFE_INPUT_CONNECTION = 2,      // The connection coming up
+    APP_FAILSAFE_INPUT_MAX        = 3
+} app_failsafe_input_e;
+
+typedef enum
+{
+    APP_FAILSAFE_STATE_OK        = 0,
+    APP_FAILSAFE_STATE_STALE     = 1,       // No input within the deadline
+    APP_FAILSAFE_STATE_LINK_DOWN = 2,       // The connection dropped
+    APP_FAILSAFE_STATE_MAX
+} app_failsafe_state_e;
+
+typedef struct
+{
+    uint16_t deadline_ms;   // Longest the link may go without any input. 0 only stops on disconnects
+    uint16_t decel;         // How fast the speed setpoint falls once tripped (duty cycle % per second)
+} app_failsafe_cfg_s;
+
+// State of the failsafe
+typedef struct
+{
+    // Written by the BLE side
+    volatile uint32_t input_us[APP_FAILSAFE_INPUT_MAX];     // app_clock time of each input's last update
+    volatile uint32_t n_inputs[APP_FAILSAFE_INPUT_MAX];     // Counts every update of each input
+    volatile uint32_t n_link_downs;
+    volatile bool connected;
+    // Written by the control loop
+    app_failsafe_cfg_s cfg;
+    volatile app_failsafe_state_e state;
+    uint32_t n_link_downs_seen;
+    uint32_t n_joystick_seen;                               // Joystick updates while tripped
+    uint32_t trip_us;                                       // When it last tripped
+    uint32_t n_trips;
+} app_failsafe_s;
+
+
+// Function declarations
+void app_failsafe_init(app_failsafe_s* failsafe, const app_failsafe_cfg_s* cfg, uint32_t now_us);
+void app_failsafe_set_cfg(app_failsafe_s* failsafe, const app_failsafe_cfg_s* cfg);
+void app_failsafe_input(app_failsafe_s* failsafe, app_failsafe_input_e input, uint32_t now_us);
+void app_failsafe_link_up(app_failsafe_s* failsafe, uint32_t now_us);
+void app_failsafe_link_down(app_failsafe_s* failsafe);
+uint32_t app_failsafe_age_us(const app_failsafe_s* failsafe, uint32_t now_us);
+app_failsafe_state_e app_failsafe_update(app_failsafe_s* failsafe, uint32_t now_us);
+float app_failsafe_decel(const app_failsafe_s* failsafe, float speed, uint32_t elapsed_ms);
+
+
+#endif // __APP_FAILSAFE_H__
@@ -62,6 +62,9 @@
 #include "task_ir_led.h"
 #include "task_car.h"
 #include "dc_motor.h"
+#include "app_clock.h"
+#include "wheel_speed.h"
+#include "task_ir_receiver.h"
 #include "i2c.h"
 #include "servo_motor.h"
 #include "task_hall_sensor.h"
@@ -347,6 +350,7 @@ void app_bt_hw_init()
                 &button_handle);
 
     // Initialize hardware resources for the car
+    app_clock_init();
     app_audio_init();
     app_ir_led_init();
 
@@ -357,9 +361,11 @@ void app_bt_hw_init()
     i2c_init();
     task_color_sensor_init();
     dc_motor_init();
+    wheel_speed_init();
     task_servo_init();
     task_hall_sensor_init();
     task_car_init();
+    task_ir_receiver_init();
 }
 
 /**
@@ -0,0 +1,254 @@
+/**
+ * @file app_ir_code.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the coded IR shot protocol. Each shot carries the shooter's
+ * car ID, so a car can tell who hit it and ignore its own shots, and a stray
+ * 38 kHz source, which can't produce a valid frame, isn't taken as a hit
+ *
+ * @version 0.1
+ * @date 2024-12-26
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_ir_code.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define IR_CODE_UNITS_US(units)     ((uint32_t)(units) * APP_IR_CODE_UNIT_US)
+#define IR_CODE_HALF_UNIT_US        (APP_IR_CODE_UNIT_US / 2U)
+#define IR_CODE_PAYLOAD_BITS        (APP_IR_CODE_CAR_ID_BITS + APP_IR_CODE_SHOT_TYPE_BITS)
+#define IR_CODE_CHECK_MASK          ((1UL << APP_IR_CODE_CHECK_BITS) - 1UL)
+
+// From one mark starting to the next
+#define IR_CODE_HEADER_PERIOD_US    IR_CODE_UNITS_US(APP_IR_CODE_HEADER_MARK_UNITS + APP_IR_CODE_HEADER_SPACE_UNITS)
+#define IR_CODE_ZERO_PERIOD_US      IR_CODE_UNITS_US(APP_IR_CODE_BIT_MARK_UNITS + APP_IR_CODE_ZERO_SPACE_UNITS)
+#define IR_CODE_ONE_PERIOD_US       IR_CODE_UNITS_US(APP_IR_CODE_BIT_MARK_UNITS + APP_IR_CODE_ONE_SPACE_UNITS)
+// Marks come out of the receivers up to about 150 us longer or shorter than they were sent
+#define IR_CODE_HEADER_MARK_MIN_US  (IR_CODE_UNITS_US(APP_IR_CODE_HEADER_MARK_UNITS) - IR_CODE_UNITS_US(1))
+#define IR_CODE_HEADER_MARK_MAX_US  (IR_CODE_UNITS_US(APP_IR_CODE_HEADER_MARK_UNITS) + IR_CODE_UNITS_US(1) + IR_CODE_HALF_UNIT_US)
+#define IR_CODE_BIT_MARK_MAX_US     IR_CODE_UNITS_US(2U * APP_IR_CODE_BIT_MARK_UNITS)
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Get the check bits for a frame's car ID and shot type
+ *
+ * @param uint32_t
+ * Car ID and shot type, as sent
+ * @return uint32_t
+ * Check bits. Never 0 for an all-0 payload, so a stuck receiver can't decode
+ */
+static uint32_t app_ir_code_check(uint32_t payload)
+{
+    return ~(payload ^ (payload >> APP_IR_CODE_CHECK_BITS)) & IR_CODE_CHECK_MASK;
+}
+
+
+/**
+ * @brief  Add a run of carrier or space to a frame
+ *
+ * @param uint8_t*
+ * Frame being built, 1 per unit of carrier and 0 per unit of space
+ * @param uint32_t
+ * Units in the frame so far
+ * @param uint8_t
+ * 1 for carrier, 0 for space
+ * @param uint32_t
+ * Length of the run (units)
+ * @return uint32_t
+ * Units in the frame now
+ */
+static uint32_t app_ir_code_run(uint8_t* units, uint32_t n_units, uint8_t level, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        units[n_units++] = level;
+    }
+    return n_units;
+}
+
+
+/**
+ * @brief  Build the frame for a shot, and the gap after it
+ *
+ * @param const app_ir_code_frame_s*
+ * Car ID and shot type to send
+ * @param uint8_t*
+ * Where to write the frame, 1 per unit of carrier and 0 per unit of space
+ * @param uint32_t
+ * Units there is room for. APP_IR_CODE_MAX_FRAME_UNITS is always enough
+ * @return uint32_t
+ * Units in the frame, 0 if the car ID or shot type is out of range or there
+ * wasn't room
+ */
+uint32_t app_ir_code_encode(const app_ir_code_frame_s* frame, uint8_t* units, uint32_t max_units)
+{
+    uint32_t n_units = 0;
+
+    if ((frame->car_id >= APP_IR_CODE_N_CAR_IDS) ||
+        (frame->shot_type >= APP_IR_CODE_N_SHOT_TYPES) ||
+        (max_units < APP_IR_CODE_MAX_FRAME_UNITS))
+    {
+        return 0;
+    }
+
+    const uint32_t payload = ((uint32_t)frame->car_id << APP_IR_CODE_SHOT_TYPE_BITS) | frame->shot_type;
+    const uint32_t bits = (payload << APP_IR_CODE_CHECK_BITS) | app_ir_code_check(payload);
+
+    n_units = app_ir_code_run(units, n_units, 1, APP_IR_CODE_HEADER_MARK_UNITS);
+    n_units = app_ir_code_run(units, n_units, 0, APP_IR_CODE_HEADER_SPACE_UNITS);
+    for (uint32_t i = APP_IR_CODE_N_BITS; i > 0; i--)
+    {
+        const bool one = ((bits >> (i - 1)) & 1UL) != 0;
+        n_units = app_ir_code_run(units, n_units, 1, APP_IR_CODE_BIT_MARK_UNITS);
+        n_units = app_ir_code_run(units, n_units, 0, one ? APP_IR_CODE_ONE_SPACE_UNITS : APP_IR_CODE_ZERO_SPACE_UNITS);
+    }
+    n_units = app_ir_code_run(units, n_units, 1, APP_IR_CODE_STOP_MARK_UNITS);
+    n_units = app_ir_code_run(units, n_units, 0, APP_IR_CODE_GAP_UNITS);
+
+    return n_units;
+}
+
+
+/**
+ * @brief  Initialize a decoder, waiting for a header
+ *
+ * @param app_ir_code_decoder_s*
+ * Decoder to initialize
+ */
+void app_ir_code_decoder_init(app_ir_code_decoder_s* dec)
+{
+    dec->state = APP_IR_CODE_STATE_IDLE;
+    dec->mark_start_us = 0;
+    dec->frame_start_us = 0;
+    dec->bits = 0;
+    dec->n_bits = 0;
+    dec->n_errors = 0;
+}
+
+
+/**
+ * @brief  Give up on the frame being read, if there is one
+ *
+ * @param app_ir_code_decoder_s*
+ * Decoder to reset
+ */
+static void app_ir_code_abandon(app_ir_code_decoder_s* dec)
+{
+    if (dec->state != APP_IR_CODE_STATE_IDLE)
+    {
+        dec->n_errors++;
+        dec->state = APP_IR_CODE_STATE_IDLE;
+    }
+}
+
+
+/**
+ * @brief  Read the bit ended by a mark starting, and the frame if it was the
+ *         last one. Marks must be given in the order they happened
+ *
+ * @param app_ir_code_decoder_s*
+ * Receiver's decoder
+ * @param uint32_t
+ * app_clock time the mark started
+ * @param app_ir_code_frame_s*
+ * Where to write the frame
+ * @return bool
+ * true if a whole, valid frame was read. It is complete as soon as its stop
+ * mark starts
+ */
+bool app_ir_code_mark_start(app_ir_code_decoder_s* dec, uint32_t us, app_ir_code_frame_s* frame)
+{
+    const uint32_t period_us = us - dec->mark_start_us;
+    bool done = false;
+
+    dec->mark_start_us = us;
+
+    switch (dec->state)
+    {
+        case APP_IR_CODE_STATE_HEADER:
+            if ((period_us >= (IR_CODE_HEADER_PERIOD_US - APP_IR_CODE_UNIT_US)) &&
+                (period_us <= (IR_CODE_HEADER_PERIOD_US + APP_IR_CODE_UNIT_US)))
+            {
+                dec->state = APP_IR_CODE_STATE_BITS;
+                dec->bits = 0;
+                dec->n_bits = 0;
+            }
+            else
+            {
+                app_ir_code_abandon(dec);
+            }
+            break;
+
+        case APP_IR_CODE_STATE_BITS:
+            if ((period_us >= (IR_CODE_ZERO_PERIOD_US - IR_CODE_HALF_UNIT_US)) &&
+                (period_us <= (IR_CODE_ONE_PERIOD_US + IR_CODE_HALF_UNIT_US)))
+            {
+                const uint32_t one = (period_us >= (IR_CODE_ZERO_PERIOD_US + IR_CODE_HALF_UNIT_US)) ? 1UL : 0UL;
+                dec->bits = (dec->bits << 1) | one;
+                dec->n_bits++;
+            }
+            else
+            {
+                app_ir_code_abandon(dec);
+                break;
+            }
+
+            if (dec->n_bits == APP_IR_CODE_N_BITS)
+            {
+                // This is the stop mark
+                const uint32_t payload = dec->bits >> APP_IR_CODE_CHECK_BITS;
+
+                dec->state = APP_IR_CODE_STATE_IDLE;
+                if ((dec->bits & IR_CODE_CHECK_MASK) == app_ir_code_check(payload))
+                {
+                    frame->car_id = (uint8_t)(payload >> APP_IR_CODE_SHOT_TYPE_BITS);
+                    frame->shot_type = (uint8_t)(payload & (APP_IR_CODE_N_SHOT_TYPES - 1U));
+                    done = true;
+                }
+                else
+                {
+                    dec->n_errors++;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return done;
+}
+
+
+/**
+ * @brief  Check the length of the mark that has just ended. A header mark
+ *         starts a new frame, even part way through another
+ *
+ * @param app_ir_code_decoder_s*
+ * Receiver's decoder
+ * @param uint32_t
+ * app_clock time the mark ended
+ */
+void app_ir_code_mark_end(app_ir_code_decoder_s* dec, uint32_t us)
+{
+    const uint32_t mark_us = us - dec->mark_start_us;
+
+    if ((mark_us >= IR_CODE_HEADER_MARK_MIN_US) && (mark_us <= IR_CODE_HEADER_MARK_MAX_US))
+    {
+        app_ir_code_abandon(dec);
+        dec->state = APP_IR_CODE_STATE_HEADER;
+        dec->frame_start_us = dec->mark_start_us;
+    }
+    else if ((dec->state == APP_IR_CODE_STATE_BITS) && (mark_us > IR_CODE_BIT_MARK_MAX_US))
+    {
+        app_ir_code_abandon(dec);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,93 @@
+/**
+ * @file app_ir_code.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the coded IR shot protocol: the frames a car's IR LED sends
+ * when it fires, and the decoder that reads them back out of a receiver's
+ * marks
+ *
+ * @version 0.1
+ * @date 2024-12-26
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_IR_CODE_H__
+#define __APP_IR_CODE_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: A frame is pulse-distance coded on the 38 kHz carrier, in units of APP_IR_CODE_UNIT_US:
+//         header: 4 units of carrier, 2 units of space
+//         12 bits, MSB first: 1 unit of carrier, then 1 unit of space for a 0 or 2 for a 1
+//         stop: 1 unit of carrier, then a gap of quiet before the next frame
+//       The bits are the shooter's car ID (6 bits), the shot type (2 bits), and a 4-bit check.
+//       Receivers stretch or shrink their marks depending on signal strength, so bits are told
+//       apart by the time from one mark starting to the next, which doesn't change. A unit is
+//       long enough for the receivers to lock on to each mark (at least 10 carrier cycles), and
+//       a frame takes 12.4 ms (all 0s) to 17.2 ms (all 1s), not counting the gap.
+//       A hit can't be taken until a whole frame has been read, so this costs hit latency: a
+//       bare carrier mark was taken about 2 ms after it started, a frame about 15 ms after
+//       (in tools/ir_rx_bench: 15.3 ms mean on clean shots, 18.0-19.4 ms mean under lamp or
+//       sunlight noise, which loses some first frames). Shorter units would leave the receivers
+//       too few cycles to lock on, and fewer bits would leave too few car IDs or no check, so
+//       the latency is the price of knowing who fired and ignoring stray 38 kHz light
+#define APP_IR_CODE_UNIT_US             (400U)
+#define APP_IR_CODE_HEADER_MARK_UNITS   (4U)
+#define APP_IR_CODE_HEADER_SPACE_UNITS  (2U)
+#define APP_IR_CODE_BIT_MARK_UNITS      (1U)
+#define APP_IR_CODE_ZERO_SPACE_UNITS    (1U)
+#define APP_IR_CODE_ONE_SPACE_UNITS     (2U)
+#define APP_IR_CODE_STOP_MARK_UNITS     (1U)
+#define APP_IR_CODE_GAP_UNITS           (8U)
+#define APP_IR_CODE_CAR_ID_BITS         (6U)
+#define APP_IR_CODE_SHOT_TYPE_BITS      (2U)
+#define APP_IR_CODE_CHECK_BITS          (4U)
+#define APP_IR_CODE_N_BITS              (APP_IR_CODE_CAR_ID_BITS + APP_IR_CODE_SHOT_TYPE_BITS + APP_IR_CODE_CHECK_BITS)
+#define APP_IR_CODE_N_CAR_IDS           (1U << APP_IR_CODE_CAR_ID_BITS)
+#define APP_IR_CODE_N_SHOT_TYPES        (1U << APP_IR_CODE_SHOT_TYPE_BITS)
+// Longest frame, every bit a 1, including the gap after it
+#define APP_IR_CODE_MAX_FRAME_UNITS     (APP_IR_CODE_HEADER_MARK_UNITS + APP_IR_CODE_HEADER_SPACE_UNITS + \
+                                         (APP_IR_CODE_N_BITS * (APP_IR_CODE_BIT_MARK_UNITS + APP_IR_CODE_ONE_SPACE_UNITS)) + \
+                                         APP_IR_CODE_STOP_MARK_UNITS + APP_IR_CODE_GAP_UNITS)
+
+// What a frame carries
+typedef struct
+{
+    uint8_t car_id;         // Shooter, below APP_IR_CODE_N_CAR_IDS
+    uint8_t shot_type;      // Below APP_IR_CODE_N_SHOT_TYPES
+} app_ir_code_frame_s;
+
+typedef enum
+{
+    APP_IR_CODE_STATE_IDLE   = 0,   // Waiting for a header mark
+    APP_IR_CODE_STATE_HEADER = 1,   // Had a header mark, waiting for the first bit's
+    APP_IR_CODE_STATE_BITS   = 2,   // Reading bits
+    APP_IR_CODE_STATE_MAX
+} app_ir_code_state_e;
+
+// State of one receiver's decoder
+typedef struct
+{
+    app_ir_code_state_e state;
+    uint32_t mark_start_us;     // When the last mark started
+    uint32_t frame_start_us;    // When the header mark started
+    uint32_t bits;
+    uint8_t n_bits;
+    uint32_t n_errors;          // Frames abandoned part way, or with a bad check
+} app_ir_code_decoder_s;
+
+
+// Function declarations
+uint32_t app_ir_code_encode(const app_ir_code_frame_s* frame, uint8_t* units, uint32_t max_units);
+void app_ir_code_decoder_init(app_ir_code_decoder_s* dec);
+bool app_ir_code_mark_start(app_ir_code_decoder_s* dec, uint32_t us, app_ir_code_frame_s* frame);
+void app_ir_code_mark_end(app_ir_code_decoder_s* dec, uint32_t us);
+
+
+#endif // __APP_IR_CODE_H__
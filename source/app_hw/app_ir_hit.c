@@ -0,0 +1,123 @@
+/**
+ * @file app_ir_hit.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for hit analysis. The three receivers face different ways, so
+ * the ones nearest a shot see more of it and lock on to it sooner, which is
+ * enough to tell a hit from the front, side or rear
+ *
+ * @version 0.1
+ * @date 2024-12-27
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_ir_hit.h"
+#include <math.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define IR_HIT_PI               (3.14159265f)
+#define IR_HIT_RAD_PER_DEG      (IR_HIT_PI / 180.0f)
+
+
+/******************************************************************************
+ * Global Variables                                                           *
+ ******************************************************************************/
+static const int16_t ir_hit_bearings_deg[APP_IR_RX_N_RECEIVERS] = {
+    APP_IR_HIT_BEARING_A_DEG,
+    APP_IR_HIT_BEARING_B_DEG,
+    APP_IR_HIT_BEARING_C_DEG
+};
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Get the direction a shot from a bearing counts as
+ *
+ * @param int32_t
+ * Bearing of the shot (degrees, from -180 to 180)
+ * @return app_ir_hit_dir_e
+ * Front, side or rear
+ */
+app_ir_hit_dir_e app_ir_hit_dir(int32_t bearing_deg)
+{
+    const int32_t off_deg = abs(bearing_deg);
+
+    if (off_deg <= APP_IR_HIT_FRONT_DEG)
+    {
+        return APP_IR_HIT_DIR_FRONT;
+    }
+    if (off_deg >= APP_IR_HIT_REAR_DEG)
+    {
+        return APP_IR_HIT_DIR_REAR;
+    }
+    return APP_IR_HIT_DIR_SIDE;
+}
+
+
+/**
+ * @brief  Work out which way a shot came from
+ *
+ * @param const app_ir_rx_hit_s*
+ * Shot, with how much of it each receiver saw and when
+ * @param app_ir_hit_s*
+ * Where to write the direction
+ */
+void app_ir_hit_analyze(const app_ir_rx_hit_s* hit, app_ir_hit_s* result)
+{
+    uint32_t first_us = hit->detect_us;
+    float x = 0.0f;
+    float y = 0.0f;
+    float total = 0.0f;
+    float strongest = 0.0f;
+    uint32_t bearing_rx = hit->receiver;
+
+    result->receivers = 0;
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        if (hit->carrier_us[i] > 0)
+        {
+            result->receivers |= (uint8_t)(1U << i);
+            if ((hit->detect_us - hit->arrival_us[i]) > (hit->detect_us - first_us))
+            {
+                first_us = hit->arrival_us[i];
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        if (hit->carrier_us[i] == 0)
+        {
+            continue;
+        }
+        const float lag_us = (float)(hit->arrival_us[i] - first_us);
+        const float pull = (float)hit->carrier_us[i] * (float)APP_IR_HIT_LAG_US / ((float)APP_IR_HIT_LAG_US + lag_us);
+        const float bearing_rad = (float)ir_hit_bearings_deg[i] * IR_HIT_RAD_PER_DEG;
+
+        x += pull * cosf(bearing_rad);
+        y += pull * sinf(bearing_rad);
+        total += pull;
+        if (pull > strongest)
+        {
+            strongest = pull;
+            bearing_rx = i;
+        }
+    }
+
+    if ((total > 0.0f) && (sqrtf((x * x) + (y * y)) >= (APP_IR_HIT_MIN_SPREAD * total)))
+    {
+        result->bearing_deg = (int16_t)lroundf(atan2f(y, x) / IR_HIT_RAD_PER_DEG);
+    }
+    else
+    {
+        result->bearing_deg = ir_hit_bearings_deg[bearing_rx];
+    }
+    result->dir = app_ir_hit_dir(result->bearing_deg);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,64 @@
+/**
+ * @file app_ir_hit.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for hit analysis, which works out which way a shot came from
+ * out of how much of it each IR receiver saw, and when
+ *
+ * @version 0.1
+ * @date 2024-12-27
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_IR_HIT_H__
+#define __APP_IR_HIT_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Include Project Specific Files
+#include "app_ir_rx.h"
+
+
+// Defines
+// NOTE: Bearings are in degrees, counterclockwise from dead ahead, so left is positive. Each
+//       receiver points out from the car at its bearing, and sees most of a shot from there.
+//       Every receiver that saw the shot pulls the estimate towards its bearing, by how much
+//       carrier it saw. A receiver that locked on later than the first one saw a weaker signal,
+//       so its pull is cut, to half once it is APP_IR_HIT_LAG_US behind. If the pulls
+//       nearly cancel out, the shot came from everywhere at once (a reflection, or point blank),
+//       and the strongest receiver's bearing is used
+#define APP_IR_HIT_BEARING_A_DEG    (0)         // Front
+#define APP_IR_HIT_BEARING_B_DEG    (120)       // Rear left
+#define APP_IR_HIT_BEARING_C_DEG    (-120)      // Rear right
+#define APP_IR_HIT_FRONT_DEG        (45)        // Up to this far from dead ahead is a front hit
+#define APP_IR_HIT_REAR_DEG         (135)       // At least this far from dead ahead is a rear hit
+#define APP_IR_HIT_LAG_US           (200U)
+#define APP_IR_HIT_MIN_SPREAD       (0.2f)      // Pull left over, over the total, to trust the estimate
+
+typedef enum
+{
+    APP_IR_HIT_DIR_FRONT = 0,
+    APP_IR_HIT_DIR_SIDE  = 1,
+    APP_IR_HIT_DIR_REAR  = 2,
+    APP_IR_HIT_DIR_MAX
+} app_ir_hit_dir_e;
+
+// Where a shot came from
+typedef struct
+{
+    app_ir_hit_dir_e dir;
+    int16_t bearing_deg;    // From -180 to 180
+    uint8_t receivers;      // Mask of the receivers that saw it
+} app_ir_hit_s;
+
+
+// Function declarations
+void app_ir_hit_analyze(const app_ir_rx_hit_s* hit, app_ir_hit_s* result);
+app_ir_hit_dir_e app_ir_hit_dir(int32_t bearing_deg);
+
+
+#endif // __APP_IR_HIT_H__
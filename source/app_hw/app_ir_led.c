@@ -2,7 +2,9 @@
  * @file app_ir_led.c
  * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
  * @brief 
- * Source file for IR LED interface
+ * Source file for IR LED interface. A shot is sent as coded frames on the
+ * 38 kHz carrier, built up front and then played out by a timer interrupt
+ * that starts and stops the carrier at each unit of the frame
  * 
  * @version 0.1
  * @date 2024-11-16
@@ -10,106 +12,160 @@
  * @copyright Copyright (c) 2024
  */
 #include "app_ir_led.h"
-#include <timers.h>
 #include "cy_pdl.h"
+#include "cyhal.h"
 #include "cybsp.h"
 #include "app_bt_car.h"
+#include "app_ir_code.h"
 
 
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define IR_LED_TIMER_HZ             (1000000)
+#define IR_LED_INTR_PRIORITY        (3)
+// A shot is sent more than once, so it still gets through if a frame is blocked part way
+#define IR_LED_SHOT_FRAMES          (3U)
+#define IR_LED_MAX_UNITS            (IR_LED_SHOT_FRAMES * APP_IR_CODE_MAX_FRAME_UNITS)
+
 /*******************************************************************************
  * Function Prototypes
  ********************************************************************************/
-static void app_ir_led_timers_init(void);
+static void app_ir_led_timer_init(void);
 static void app_ir_led_tcpwm_init(void);
 
 
 /******************************************************************************
  * Global Variables                                                           *
  ******************************************************************************/
-static uint8_t n_active_timers = 0;
-static TimerHandle_t ir_led_timers[CAR_ITEM_MAX];
-static const uint32_t item_delays_ms[CAR_ITEM_MAX] = {
-    [CAR_ITEM_SHOT]   = 1000,
-    [CAR_ITEM_SHIELD] = 0,
-    [CAR_ITEM_BOOST]  = 0,
-};
+static cyhal_timer_t ir_led_timer;
+// Frames being sent, 1 per unit of carrier and 0 per unit of space. Written while idle
+static uint8_t ir_led_units[IR_LED_MAX_UNITS];
+// Units to send, set to start sending and cleared by the interrupt once they have all gone
+static volatile uint32_t ir_led_n_units = 0;
+// Only used by the interrupt
+static uint32_t ir_led_unit_idx = 0;
+static bool ir_led_carrier_on = false;
 
 
 /*******************************************************************************
  * Function Definitions
  *******************************************************************************/
 /**
- * @brief Stop IR LED after all active timers expire
+ * @brief Step the frames being sent on by one unit, switching the carrier
+ *        on or off where it changes
  * 
- * @param TimerHandle_t
- * (Unused) Timer that has expired
+ * @param void*
+ * (Unused) Callback argument
+ * @param cyhal_timer_event_t
+ * (Unused) Timer event
  * @return void
  */
-static void app_ir_led_stop_ir_led(TimerHandle_t xTimer)
+static void app_ir_led_timer_isr(void *callback_arg, cyhal_timer_event_t event)
 {
-    // Suppress unused parameter warning
-    (void)xTimer;
+    // Suppress unused parameter warnings
+    (void)callback_arg;
+    (void)event;
+
+    if (ir_led_unit_idx < ir_led_n_units)
+    {
+        const bool carrier_on = (ir_led_units[ir_led_unit_idx++] != 0);
 
-    Cy_TCPWM_TriggerStopOrKill(TCPWM0, tcpwm_0_cnt_5_MASK);
+        if (carrier_on != ir_led_carrier_on)
+        {
+            if (carrier_on)
+            {
+                Cy_TCPWM_TriggerStart(TCPWM0, tcpwm_0_cnt_5_MASK);
+            }
+            else
+            {
+                Cy_TCPWM_TriggerStopOrKill(TCPWM0, tcpwm_0_cnt_5_MASK);
+            }
+            ir_led_carrier_on = carrier_on;
+        }
+    }
+    else
+    {
+        // Everything has gone, so stop until the next shot
+        Cy_TCPWM_TriggerStopOrKill(TCPWM0, tcpwm_0_cnt_5_MASK);
+        ir_led_carrier_on = false;
+        cyhal_timer_stop(&ir_led_timer);
+        ir_led_n_units = 0;
+    }
 }
 
 
 /**
- * @brief Pulse IR LED based on the specified item
+ * @brief Fire the IR LED for the specified item, sending a coded shot
  * 
  * @param car_item_t
- * Item to use. Controls the time for which the IR LED is pulsed
+ * Item to use. Only shots use the IR LED
+ * @param uint8_t
+ * This car's ID, sent with the shot
  * 
  * @return BaseType_t
- * pdTRUE if IR LED started successfully, pdFALSE otherwise
+ * pdTRUE if the shot started sending, pdFALSE if the item doesn't use the IR
+ * LED or the last shot is still being sent
  */
-BaseType_t app_ir_led_use_item(car_item_t item)
+BaseType_t app_ir_led_use_item(car_item_t item, uint8_t car_id)
 {
-    BaseType_t ret = pdFALSE;
+    const app_ir_code_frame_s frame = {
+        .car_id = car_id,
+        .shot_type = item,
+    };
+    uint32_t n_units = 0;
 
-    if ((item > CAR_ITEM_MIN) && (item < CAR_ITEM_MAX) && (item_delays_ms[item] > 0))
+    if ((item != CAR_ITEM_SHOT) || (ir_led_n_units != 0))
     {
-        if (!xTimerIsTimerActive(ir_led_timers[item]))
-        {
-            // Pulse the IR LED at 38kHz
-            Cy_TCPWM_TriggerStart(TCPWM0, tcpwm_0_cnt_5_MASK);
-
-            // TODO TODO Just use vTaskDelay(pdMS_TO_TICKS(item_delays_ms[item])); in task_ir_led and then call app_ir_led_start/stop_ir_led
+        return pdFALSE;
+    }
 
-            xTimerStart(ir_led_timers[item], 0);
-            n_active_timers++;
-        }
-        else
+    for (uint32_t i = 0; i < IR_LED_SHOT_FRAMES; i++)
+    {
+        const uint32_t n = app_ir_code_encode(&frame, &ir_led_units[n_units], IR_LED_MAX_UNITS - n_units);
+        if (n == 0)
         {
-            xTimerReset(ir_led_timers[item], 0);
+            return pdFALSE;
         }
-
-        ret = pdTRUE;
+        n_units += n;
     }
 
-    return ret;
+    // The interrupt takes the first unit one period after the timer starts
+    ir_led_unit_idx = 0;
+    ir_led_n_units = n_units;
+    cyhal_timer_reset(&ir_led_timer);
+    cyhal_timer_start(&ir_led_timer);
+
+    return pdTRUE;
 }
 
 
 /**
- * @brief Initialize timers for IR LED stop conditions
+ * @brief Initialize the timer that steps through the frames being sent
  * 
  * @param void
  * @return void
  */
-static void app_ir_led_timers_init(void)
+static void app_ir_led_timer_init(void)
 {
-    for (int i=(CAR_ITEM_MIN+1); i < CAR_ITEM_MAX; i++)
-    {
-        if (item_delays_ms[i] > 0)
-        {
-            ir_led_timers[i] = xTimerCreate("IR_LED_Stop_Timer",
-                                            pdMS_TO_TICKS(item_delays_ms[i]),
-                                            pdFALSE,
-                                            (void*)0,
-                                            app_ir_led_stop_ir_led);
-        }
-    }
+    cy_rslt_t rslt;
+    const cyhal_timer_cfg_t timer_cfg = {
+        .compare_value = 0,
+        .period = APP_IR_CODE_UNIT_US - 1,
+        .direction = CYHAL_TIMER_DIR_UP,
+        .is_compare = false,
+        .is_continuous = true,
+        .value = 0
+    };
+
+    rslt = cyhal_timer_init(&ir_led_timer, NC, NULL);
+    CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+    rslt = cyhal_timer_configure(&ir_led_timer, &timer_cfg);
+    CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+    rslt = cyhal_timer_set_frequency(&ir_led_timer, IR_LED_TIMER_HZ);
+    CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+    cyhal_timer_register_callback(&ir_led_timer, app_ir_led_timer_isr, NULL);
+    cyhal_timer_enable_event(&ir_led_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, IR_LED_INTR_PRIORITY, true);
 }
 
 
@@ -129,7 +185,7 @@ static void app_ir_led_tcpwm_init(void)
 
 void app_ir_led_init(void)
 {
-    app_ir_led_timers_init();
+    app_ir_led_timer_init();
     app_ir_led_tcpwm_init();
 }
 
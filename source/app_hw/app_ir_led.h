@@ -20,7 +20,7 @@
 
 
 void app_ir_led_init(void);
-BaseType_t app_ir_led_use_item(car_item_t item);
+BaseType_t app_ir_led_use_item(car_item_t item, uint8_t car_id);
 
 
 #endif // __APP_IR_LED_H__
@@ -0,0 +1,597 @@
+/**
+ * @file app_ir_rx.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for IR hit detection. The receivers' pin interrupt only
+ * timestamps each edge and pushes it onto a ring, so it is short enough to
+ * keep up with every pulse, and the detector task works through the edges
+ * as soon as it is woken. The edges' timestamps are all the decoder needs,
+ * so a shot is seen as soon as enough of its frames have ended. Glitches are
+ * filtered out of each receiver's marks before they are decoded
+ *
+ * @version 0.1
+ * @date 2024-12-24
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_ir_rx.h"
+
+#if defined(__ARM_ARCH)
+#include "cy_pdl.h"
+#endif
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define IR_RX_RING_MASK         (APP_IR_RX_RING_LEN - 1U)
+#if defined(__ARM_ARCH)
+// Make sure an edge is written before the detector can see it, and read before its slot is reused
+#define IR_RX_DMB()             __DMB()
+#else
+#define IR_RX_DMB()             __sync_synchronize()
+#endif
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Empty a ring of edges
+ *
+ * @param app_ir_rx_ring_s*
+ * Ring to initialize
+ */
+void app_ir_rx_ring_init(app_ir_rx_ring_s* ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->n_dropped = 0;
+}
+
+
+/**
+ * @brief  Add an edge to the ring. Only one context (the pin interrupt) may
+ *         push
+ *
+ * @param app_ir_rx_ring_s*
+ * Ring to add to
+ * @param uint8_t
+ * Receiver the edge is from
+ * @param bool
+ * true if the carrier started, false if it stopped
+ * @param uint32_t
+ * app_clock time of the edge
+ * @return bool
+ * true if it was added, false if the ring was full and it was dropped
+ */
+bool app_ir_rx_push(app_ir_rx_ring_s* ring, uint8_t receiver, bool mark, uint32_t us)
+{
+    const uint32_t head = ring->head;
+
+    if ((head - ring->tail) >= APP_IR_RX_RING_LEN)
+    {
+        ring->n_dropped++;
+        return false;
+    }
+    app_ir_rx_edge_s* edge = &ring->edges[head & IR_RX_RING_MASK];
+    edge->us = us;
+    edge->receiver = receiver;
+    edge->mark = mark;
+    IR_RX_DMB();
+    ring->head = head + 1;
+
+    return true;
+}
+
+
+/**
+ * @brief  Take the oldest edge off the ring. Only one task may pop
+ *
+ * @param app_ir_rx_ring_s*
+ * Ring to take from
+ * @param app_ir_rx_edge_s*
+ * Where to write the edge
+ * @return bool
+ * true if there was an edge, false if the ring was empty
+ */
+bool app_ir_rx_pop(app_ir_rx_ring_s* ring, app_ir_rx_edge_s* edge)
+{
+    const uint32_t tail = ring->tail;
+
+    if (tail == ring->head)
+    {
+        return false;
+    }
+    IR_RX_DMB();
+    *edge = ring->edges[tail & IR_RX_RING_MASK];
+    IR_RX_DMB();
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+
+/**
+ * @brief  Get the detector's default sensitivity
+ *
+ * @param app_ir_rx_cfg_s*
+ * Where to write the settings
+ */
+void app_ir_rx_cfg_default(app_ir_rx_cfg_s* cfg)
+{
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        cfg->min_mark_us[i] = APP_IR_RX_DEFAULT_MIN_MARK_US;
+    }
+    cfg->min_frames = APP_IR_RX_DEFAULT_MIN_FRAMES;
+}
+
+
+/**
+ * @brief  Check the detector's settings are in range, such as after loading
+ *         them
+ *
+ * @param const app_ir_rx_cfg_s*
+ * Settings to check
+ * @return bool
+ * true if they can be used
+ */
+bool app_ir_rx_cfg_valid(const app_ir_rx_cfg_s* cfg)
+{
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        if (cfg->min_mark_us[i] > APP_IR_RX_MAX_MIN_MARK_US)
+        {
+            return false;
+        }
+    }
+    return (cfg->min_frames >= 1U) && (cfg->min_frames <= APP_IR_RX_MAX_MIN_FRAMES);
+}
+
+
+/**
+ * @brief  Forget what a receiver is in the middle of
+ *
+ * @param app_ir_rx_receiver_s*
+ * Receiver to reset
+ */
+static void app_ir_rx_receiver_clear(app_ir_rx_receiver_s* rx)
+{
+    rx->in_mark = false;
+    rx->in_burst = false;
+    rx->decoding = false;
+    rx->end_pending = false;
+}
+
+
+/**
+ * @brief  Initialize the detector, with every receiver quiet and the default
+ *         sensitivity
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to initialize
+ * @param uint8_t
+ * This car's ID, whose frames are ignored
+ */
+void app_ir_rx_detector_init(app_ir_rx_detector_s* det, uint8_t own_id)
+{
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        app_ir_rx_receiver_s* rx = &det->receivers[i];
+        app_ir_rx_receiver_clear(rx);
+        rx->mark_start_us = 0;
+        rx->mark_end_us = 0;
+        rx->burst_start_us = 0;
+        rx->last_edge_us = 0;
+        rx->carrier_us = 0;
+        rx->n_glitches = 0;
+        app_ir_code_decoder_init(&rx->decoder);
+    }
+    for (uint32_t i = 0; i < APP_IR_CODE_N_CAR_IDS; i++)
+    {
+        det->frame_us[i] = 0;
+        det->shot_us[i] = 0;
+        det->shot_frames[i] = 0;
+    }
+    app_ir_rx_cfg_default(&det->cfg);
+    det->own_id = own_id;
+    det->shooting = 0;
+    det->reported = 0;
+    det->n_frames = 0;
+    det->n_own = 0;
+    det->n_rejected = 0;
+}
+
+
+/**
+ * @brief  Change how sensitive the detector is. Takes effect from the next
+ *         mark and shot
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to update
+ * @param const app_ir_rx_cfg_s*
+ * New settings, which must be valid
+ */
+void app_ir_rx_set_cfg(app_ir_rx_detector_s* det, const app_ir_rx_cfg_s* cfg)
+{
+    det->cfg = *cfg;
+}
+
+
+/**
+ * @brief  End a shooter's shot, counting it as rejected if it came from
+ *         another car and never got enough frames
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to update
+ * @param uint8_t
+ * Shooter whose shot has ended
+ */
+static void app_ir_rx_shot_end(app_ir_rx_detector_s* det, uint8_t car_id)
+{
+    const uint64_t shooter = 1ULL << car_id;
+
+    if (((det->reported & shooter) == 0) && (car_id != det->own_id))
+    {
+        det->n_rejected++;
+    }
+    det->shooting &= ~shooter;
+    det->reported &= ~shooter;
+}
+
+
+/**
+ * @brief  Add a decoded frame to its shooter's shot, and decide whether the
+ *         shot has now got enough frames to be taken
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to update
+ * @param const app_ir_code_frame_s*
+ * Frame that was decoded
+ * @param uint32_t
+ * app_clock time the frame started
+ * @param uint32_t
+ * app_clock time it was decoded
+ * @return bool
+ * true if it completes a new shot from another car
+ */
+static bool app_ir_rx_frame(app_ir_rx_detector_s* det, const app_ir_code_frame_s* frame, uint32_t start_us, uint32_t us)
+{
+    const uint8_t car_id = frame->car_id;
+    const uint64_t shooter = 1ULL << car_id;
+    const uint32_t since_us = us - det->frame_us[car_id];
+
+    det->n_frames++;
+
+    if (((det->shooting & shooter) != 0) && (since_us > APP_IR_RX_SHOT_GAP_US))
+    {
+        app_ir_rx_shot_end(det, car_id);
+    }
+    if ((det->shooting & shooter) == 0)
+    {
+        det->shooting |= shooter;
+        det->shot_us[car_id] = start_us;
+        det->shot_frames[car_id] = 1;
+    }
+    else if ((since_us >= APP_IR_RX_SAME_FRAME_US) && (det->shot_frames[car_id] < UINT8_MAX))
+    {
+        det->shot_frames[car_id]++;
+    }
+    det->frame_us[car_id] = us;
+
+    if (car_id == det->own_id)
+    {
+        det->n_own++;
+        return false;
+    }
+    if (((det->reported & shooter) != 0) || (det->shot_frames[car_id] < det->cfg.min_frames))
+    {
+        return false;
+    }
+    det->reported |= shooter;
+    return true;
+}
+
+
+/**
+ * @brief  End the shots that have stopped coming in. Only needed to count the
+ *         rejected shots, so it can be called whenever is convenient
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to update
+ * @param uint32_t
+ * app_clock time now
+ */
+void app_ir_rx_expire(app_ir_rx_detector_s* det, uint32_t now_us)
+{
+    uint64_t shooting = det->shooting;
+
+    while (shooting != 0)
+    {
+        const uint8_t car_id = (uint8_t)__builtin_ctzll(shooting);
+
+        shooting &= shooting - 1U;
+        if ((now_us - det->frame_us[car_id]) > APP_IR_RX_SHOT_GAP_US)
+        {
+            app_ir_rx_shot_end(det, car_id);
+        }
+    }
+}
+
+
+/**
+ * @brief  Fill in how much of a shot each receiver has seen, from the bursts
+ *         they are in now
+ *
+ * @param const app_ir_rx_detector_s*
+ * Detector the shot was decoded by
+ * @param uint32_t
+ * app_clock time the shot was decoded
+ * @param app_ir_rx_hit_s*
+ * Shot to fill in
+ */
+static void app_ir_rx_hit_bursts(const app_ir_rx_detector_s* det, uint32_t us, app_ir_rx_hit_s* hit)
+{
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        const app_ir_rx_receiver_s* rx = &det->receivers[i];
+        // A mark that's still going counts once it is long enough not to be a glitch
+        const uint32_t mark_us = rx->in_mark ? (us - rx->mark_start_us) : 0U;
+        const bool mark = rx->decoding || (mark_us >= det->cfg.min_mark_us[i]);
+        const bool burst = rx->in_burst && ((us - rx->last_edge_us) <= APP_IR_RX_BURST_GAP_US);
+
+        hit->carrier_us[i] = 0;
+        hit->arrival_us[i] = 0;
+        if (burst || (rx->in_mark && mark))
+        {
+            hit->carrier_us[i] = (burst ? rx->carrier_us : 0U) + (mark ? mark_us : 0U);
+            hit->arrival_us[i] = burst ? rx->burst_start_us : rx->mark_start_us;
+        }
+    }
+}
+
+
+/**
+ * @brief  Start a receiver's mark, or carry on with its last one if it only
+ *         dropped out for a glitch
+ *
+ * @param app_ir_rx_receiver_s*
+ * Receiver whose mark started
+ * @param uint16_t
+ * Receiver's min_mark_us
+ * @param uint32_t
+ * app_clock time the mark started
+ */
+static void app_ir_rx_mark(app_ir_rx_receiver_s* rx, uint16_t min_mark_us, uint32_t us)
+{
+    rx->in_mark = true;
+
+    if (rx->end_pending && ((us - rx->mark_end_us) < min_mark_us))
+    {
+        // The last mark's carrier is counted again, in full, when it ends
+        rx->n_glitches++;
+        rx->carrier_us -= rx->mark_end_us - rx->mark_start_us;
+        rx->end_pending = false;
+        return;
+    }
+    if (rx->end_pending)
+    {
+        app_ir_code_mark_end(&rx->decoder, rx->mark_end_us);
+        rx->end_pending = false;
+    }
+    rx->decoding = false;
+    rx->mark_start_us = us;
+}
+
+
+/**
+ * @brief  End a receiver's mark, and decode it unless it was a glitch
+ *
+ * @param app_ir_rx_receiver_s*
+ * Receiver whose mark ended
+ * @param uint16_t
+ * Receiver's min_mark_us
+ * @param uint32_t
+ * app_clock time the mark ended
+ * @param app_ir_code_frame_s*
+ * Where to write the frame
+ * @return bool
+ * true if the mark completed a valid frame
+ */
+static bool app_ir_rx_space(app_ir_rx_receiver_s* rx, uint16_t min_mark_us, uint32_t us, app_ir_code_frame_s* frame)
+{
+    const uint32_t mark_us = us - rx->mark_start_us;
+    bool done = false;
+
+    rx->in_mark = false;
+
+    if (!rx->decoding && (mark_us < min_mark_us))
+    {
+        rx->n_glitches++;
+        return false;
+    }
+    if (!rx->decoding)
+    {
+        if (!rx->in_burst || ((rx->mark_start_us - rx->last_edge_us) > APP_IR_RX_BURST_GAP_US))
+        {
+            rx->in_burst = true;
+            rx->burst_start_us = rx->mark_start_us;
+            rx->carrier_us = 0;
+        }
+        rx->decoding = true;
+        done = app_ir_code_mark_start(&rx->decoder, rx->mark_start_us, frame);
+    }
+    // Given to the decoder once the next mark is known not to be part of this one
+    rx->carrier_us += mark_us;
+    rx->last_edge_us = us;
+    rx->end_pending = true;
+    rx->mark_end_us = us;
+
+    return done;
+}
+
+
+/**
+ * @brief  Add an edge to its receiver's decoder and burst. Edges must be given
+ *         in the order they happened
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to update
+ * @param const app_ir_rx_edge_s*
+ * Edge from the ring
+ * @param app_ir_rx_hit_s*
+ * Where to write the shot
+ * @return bool
+ * true if the edge completed a new shot
+ */
+bool app_ir_rx_edge(app_ir_rx_detector_s* det, const app_ir_rx_edge_s* edge, app_ir_rx_hit_s* hit)
+{
+    app_ir_code_frame_s frame;
+
+    if (edge->receiver >= APP_IR_RX_N_RECEIVERS)
+    {
+        return false;
+    }
+    app_ir_rx_receiver_s* rx = &det->receivers[edge->receiver];
+    const uint16_t min_mark_us = det->cfg.min_mark_us[edge->receiver];
+
+    // An edge can repeat its receiver's last one if the level changed back before the
+    // interrupt read it, so only changes count
+    if (edge->mark && !rx->in_mark)
+    {
+        app_ir_rx_mark(rx, min_mark_us, edge->us);
+    }
+    else if (!edge->mark && rx->in_mark)
+    {
+        if (app_ir_rx_space(rx, min_mark_us, edge->us, &frame) &&
+            app_ir_rx_frame(det, &frame, rx->decoder.frame_start_us, edge->us))
+        {
+            hit->receiver = edge->receiver;
+            hit->shooter_id = frame.car_id;
+            hit->shot_type = frame.shot_type;
+            hit->start_us = det->shot_us[frame.car_id];
+            hit->detect_us = edge->us;
+            app_ir_rx_hit_bursts(det, edge->us, hit);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief  Get how many frames the receivers have had to abandon, from noise,
+ *         interference or a shot being blocked part way
+ *
+ * @param const app_ir_rx_detector_s*
+ * Detector to check
+ * @return uint32_t
+ * Frames abandoned by all the receivers
+ */
+uint32_t app_ir_rx_n_errors(const app_ir_rx_detector_s* det)
+{
+    uint32_t n_errors = 0;
+
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        n_errors += det->receivers[i].decoder.n_errors;
+    }
+    return n_errors;
+}
+
+
+/**
+ * @brief  Get how many marks and dropouts the receivers have filtered out as
+ *         too short
+ *
+ * @param const app_ir_rx_detector_s*
+ * Detector to check
+ * @return uint32_t
+ * Glitches filtered out by all the receivers
+ */
+uint32_t app_ir_rx_n_glitches(const app_ir_rx_detector_s* det)
+{
+    uint32_t n_glitches = 0;
+
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        n_glitches += det->receivers[i].n_glitches;
+    }
+    return n_glitches;
+}
+
+
+/**
+ * @brief  Forget a receiver's current mark and frame, for when its edges have
+ *         been missed
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector to update
+ * @param uint8_t
+ * Receiver to reset
+ */
+void app_ir_rx_receiver_reset(app_ir_rx_detector_s* det, uint8_t receiver)
+{
+    if (receiver >= APP_IR_RX_N_RECEIVERS)
+    {
+        return;
+    }
+    app_ir_rx_receiver_s* rx = &det->receivers[receiver];
+    const uint32_t n_errors = rx->decoder.n_errors;
+
+    app_ir_rx_receiver_clear(rx);
+    app_ir_code_decoder_init(&rx->decoder);
+    rx->decoder.n_errors = n_errors;
+}
+
+
+/**
+ * @brief  Start watching a receiver's hardware mark count
+ *
+ * @param app_ir_rx_counter_s*
+ * Count to initialize
+ * @param uint16_t
+ * Counter reading now
+ */
+void app_ir_rx_counter_init(app_ir_rx_counter_s* counter, uint16_t count)
+{
+    counter->count = count;
+    counter->marks = 0;
+    counter->flooded = false;
+    counter->n_marks = 0;
+    counter->n_floods = 0;
+}
+
+
+/**
+ * @brief  End a window of a receiver's hardware mark count, and check whether
+ *         it is flooded with noise. Call it every APP_IR_RX_WINDOW_US
+ *
+ * @param app_ir_rx_counter_s*
+ * Count to update
+ * @param uint16_t
+ * Counter reading now. Only the low 16 bits are used, so any counter width works
+ * @return bool
+ * true if the receiver's edge interrupt should be off
+ */
+bool app_ir_rx_counter_window(app_ir_rx_counter_s* counter, uint16_t count)
+{
+    counter->marks = (uint16_t)(count - counter->count);
+    counter->count = count;
+    counter->n_marks += counter->marks;
+
+    if (!counter->flooded && (counter->marks > APP_IR_RX_FLOOD_MARKS))
+    {
+        counter->flooded = true;
+        counter->n_floods++;
+    }
+    else if (counter->flooded && (counter->marks <= APP_IR_RX_CALM_MARKS))
+    {
+        counter->flooded = false;
+    }
+    return counter->flooded;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,161 @@
+/**
+ * @file app_ir_rx.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for IR hit detection: a lock-free ring of timestamped edges
+ * from the IR receivers, and the detector that filters and decodes shots out
+ * of them
+ *
+ * @version 0.1
+ * @date 2024-12-24
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_IR_RX_H__
+#define __APP_IR_RX_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Include Project Specific Files
+#include "app_ir_code.h"
+
+// Defines
+// NOTE: The receivers demodulate the 38 kHz carrier, so their output is a mark (low) while
+//       they see it. Edges are pushed by the receivers' pin interrupt and popped by the
+//       detector task. Each receiver's marks are decoded on their own, and a shot is a valid
+//       frame from another car. A car sends each shot as several frames, and more than one
+//       receiver may decode them, so a shooter's frames are only reported again once they have
+//       stopped for APP_IR_RX_SHOT_GAP_US
+#define APP_IR_RX_N_RECEIVERS       (3U)
+#define APP_IR_RX_RING_LEN          (256U)      // Must be a power of 2
+#define APP_IR_RX_SHOT_GAP_US       (100000U)
+// NOTE: How sensitive the detector is can be tuned, and is saved by the receiver task. Each
+//       receiver drops marks shorter than its min_mark_us as glitches, and bridges dropouts
+//       shorter than it inside a mark, so a mark is only decoded once it has ended. Weak shots
+//       come out of the receivers with marks as short as 250 us, so raising it much past the
+//       default trades range for immunity to noise. A shot is only taken once min_frames of its
+//       frames have been decoded, each within APP_IR_RX_SHOT_GAP_US of the last. Decodes closer
+//       together than APP_IR_RX_SAME_FRAME_US are the same frame seen by several receivers. A
+//       shot that ends without enough frames is counted as rejected. Defaults were tuned with
+//       tools/ir_rx_bench
+#define APP_IR_RX_SAME_FRAME_US         (4000U)
+#define APP_IR_RX_DEFAULT_MIN_MARK_US   (120U)
+#define APP_IR_RX_MAX_MIN_MARK_US       (240U)
+#define APP_IR_RX_DEFAULT_MIN_FRAMES    (1U)
+#define APP_IR_RX_MAX_MIN_FRAMES        (3U)        // A shot is sent as 3 frames
+// NOTE: Each receiver's marks are also grouped into bursts, which end once it has been quiet for
+//       APP_IR_RX_BURST_GAP_US, longer than any space inside a frame. How much carrier each
+//       receiver's burst holds, and when it started, go with a shot so where it came from can be
+//       worked out. The receivers' edges are handled in the order they happened, so by the time
+//       one receiver decodes a frame the others' share of it has already been counted
+#define APP_IR_RX_BURST_GAP_US      (2000U)
+// NOTE: Each receiver's marks are also counted in hardware, and the count is checked once per
+//       window. A frame has at most 14 marks in 17.2 ms, so a receiver with many more than that
+//       in a window is seeing noise (sunlight, lighting, a failing receiver), and its edge
+//       interrupt is turned off so it can't swamp the CPU or fill the ring. The counter keeps
+//       counting, so the receiver is turned back on once it has calmed down
+#define APP_IR_RX_WINDOW_US         (10000U)
+#define APP_IR_RX_FLOOD_MARKS       (40U)       // More marks than this in a window is noise
+#define APP_IR_RX_CALM_MARKS        (10U)       // A flooded receiver is turned back on at or below this
+
+// An edge of one receiver's output
+typedef struct
+{
+    uint32_t us;            // app_clock time of the edge
+    uint8_t receiver;
+    bool mark;              // true if the carrier started, false if it stopped
+} app_ir_rx_edge_s;
+
+// Single producer, single consumer ring of edges
+typedef struct
+{
+    app_ir_rx_edge_s edges[APP_IR_RX_RING_LEN];
+    volatile uint32_t head;         // Only written by the producer
+    volatile uint32_t tail;         // Only written by the consumer
+    volatile uint32_t n_dropped;    // Edges lost to a full ring
+} app_ir_rx_ring_s;
+
+// How sensitive the detector is
+typedef struct
+{
+    uint16_t min_mark_us[APP_IR_RX_N_RECEIVERS];    // Up to APP_IR_RX_MAX_MIN_MARK_US. 0 keeps every mark
+    uint8_t min_frames;                             // From 1 to APP_IR_RX_MAX_MIN_FRAMES
+} app_ir_rx_cfg_s;
+
+// One receiver's output
+typedef struct
+{
+    bool in_mark;
+    bool in_burst;
+    bool decoding;          // Whether the current mark has been given to the decoder
+    bool end_pending;       // Whether the last mark's end is still to be given to the decoder
+    uint32_t mark_start_us;
+    uint32_t mark_end_us;
+    uint32_t burst_start_us;
+    uint32_t last_edge_us;
+    uint32_t carrier_us;    // Carrier in the burst, not counting a mark that's still going
+    uint32_t n_glitches;    // Marks and dropouts too short to keep
+    app_ir_code_decoder_s decoder;
+} app_ir_rx_receiver_s;
+
+// One receiver's hardware mark count
+typedef struct
+{
+    uint16_t count;         // Counter reading at the end of the last window
+    uint16_t marks;         // Marks in the last window
+    bool flooded;           // Whether its edge interrupt should be off
+    uint32_t n_marks;       // Counts every mark
+    uint32_t n_floods;
+} app_ir_rx_counter_s;
+
+// State of the detector
+typedef struct
+{
+    app_ir_rx_receiver_s receivers[APP_IR_RX_N_RECEIVERS];
+    app_ir_rx_cfg_s cfg;
+    uint8_t own_id;                                 // Frames from this car are reflections of its own shots
+    uint32_t frame_us[APP_IR_CODE_N_CAR_IDS];       // When each shooter's last frame was decoded
+    uint32_t shot_us[APP_IR_CODE_N_CAR_IDS];        // When each shooter's shot's first frame started
+    uint8_t shot_frames[APP_IR_CODE_N_CAR_IDS];     // Frames of each shooter's shot so far
+    uint64_t shooting;                              // Mask of the shooters whose shot is still coming in
+    uint64_t reported;                              // Mask of the shooters whose shot has been reported
+    uint32_t n_frames;                              // Valid frames, including repeats and reflections
+    uint32_t n_own;                                 // Frames from this car
+    uint32_t n_rejected;                            // Shots from other cars that ended short of min_frames
+} app_ir_rx_detector_s;
+
+// A detected shot
+typedef struct
+{
+    uint8_t receiver;       // Receiver that decoded it first
+    uint8_t shooter_id;
+    uint8_t shot_type;
+    uint32_t start_us;      // When its first frame started
+    uint32_t detect_us;     // When it was taken
+    uint32_t carrier_us[APP_IR_RX_N_RECEIVERS];     // Carrier each receiver has seen of it, 0 if none
+    uint32_t arrival_us[APP_IR_RX_N_RECEIVERS];     // When each receiver that saw it started to
+} app_ir_rx_hit_s;
+
+
+// Function declarations
+void app_ir_rx_ring_init(app_ir_rx_ring_s* ring);
+bool app_ir_rx_push(app_ir_rx_ring_s* ring, uint8_t receiver, bool mark, uint32_t us);
+bool app_ir_rx_pop(app_ir_rx_ring_s* ring, app_ir_rx_edge_s* edge);
+void app_ir_rx_cfg_default(app_ir_rx_cfg_s* cfg);
+bool app_ir_rx_cfg_valid(const app_ir_rx_cfg_s* cfg);
+void app_ir_rx_detector_init(app_ir_rx_detector_s* det, uint8_t own_id);
+void app_ir_rx_set_cfg(app_ir_rx_detector_s* det, const app_ir_rx_cfg_s* cfg);
+bool app_ir_rx_edge(app_ir_rx_detector_s* det, const app_ir_rx_edge_s* edge, app_ir_rx_hit_s* hit);
+void app_ir_rx_expire(app_ir_rx_detector_s* det, uint32_t now_us);
+uint32_t app_ir_rx_n_errors(const app_ir_rx_detector_s* det);
+uint32_t app_ir_rx_n_glitches(const app_ir_rx_detector_s* det);
+void app_ir_rx_receiver_reset(app_ir_rx_detector_s* det, uint8_t receiver);
+void app_ir_rx_counter_init(app_ir_rx_counter_s* counter, uint16_t count);
+bool app_ir_rx_counter_window(app_ir_rx_counter_s* counter, uint16_t count);
+
+
+#endif // __APP_IR_RX_H__
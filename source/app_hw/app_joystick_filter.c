@@ -0,0 +1,195 @@
+/**
+ * @file app_joystick_filter.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for joystick input conditioning. The RC controller app writes
+ * the joystick once per connection event at best, so left alone the car's
+ * setpoints move in steps, and stall whenever a packet is late or dropped
+ *
+ * @version 0.1
+ * @date 2024-12-21
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_joystick_filter.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define JOYSTICK_FILTER_US_PER_S    (1000000.0f)
+#define JOYSTICK_FILTER_MS_PER_S    (1000.0f)
+#define JOYSTICK_FILTER_CLAMP(V, LO, HI)   (((V) < (LO)) ? (LO) : (((V) > (HI)) ? (HI) : (V)))
+// Samples closer together than this are taken to be this far apart, so a burst of late
+// packets doesn't look like a fast stick
+#define JOYSTICK_FILTER_MIN_PERIOD_S    (0.005f)
+// Once the stick is released, the output drops to neutral from this close (or the deadband)
+#define JOYSTICK_FILTER_MIN_SNAP        (0.01f)
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Initialize a joystick axis's filter
+ *
+ * @param app_joystick_filter_s*
+ * Filter to initialize
+ * @param const app_joystick_filter_cfg_s*
+ * Conditioning settings
+ */
+void app_joystick_filter_init(app_joystick_filter_s* filter, const app_joystick_filter_cfg_s* cfg)
+{
+    filter->cfg = *cfg;
+    app_joystick_filter_reset(filter);
+}
+
+
+/**
+ * @brief  Change a filter's settings. Its state is kept, so the output
+ *         doesn't jump
+ *
+ * @param app_joystick_filter_s*
+ * Filter to update
+ * @param const app_joystick_filter_cfg_s*
+ * New conditioning settings
+ */
+void app_joystick_filter_set_cfg(app_joystick_filter_s* filter, const app_joystick_filter_cfg_s* cfg)
+{
+    filter->cfg = *cfg;
+}
+
+
+/**
+ * @brief  Forget the filter's history, so it starts again from neutral
+ *
+ * @param app_joystick_filter_s*
+ * Filter to reset
+ */
+void app_joystick_filter_reset(app_joystick_filter_s* filter)
+{
+    filter->position = 0.0f;
+    filter->velocity = 0.0f;
+    filter->last_shaped = 0.0f;
+    filter->sample_us = 0;
+    filter->tick_us = 0;
+    filter->started = false;
+}
+
+
+/**
+ * @brief  Apply the deadband and expo curve to a joystick value. Outside the
+ *         deadband the value is rescaled so it still reaches full deflection
+ *
+ * @param const app_joystick_filter_cfg_s*
+ * Conditioning settings
+ * @param float
+ * Raw joystick value, from -1 to 1
+ * @return float
+ * Shaped value, from -1 to 1
+ */
+float app_joystick_filter_shape(const app_joystick_filter_cfg_s* cfg, float raw)
+{
+    const float deadband = (float)cfg->deadband / APP_JOYSTICK_FILTER_ONE;
+    const float expo = (float)cfg->expo / APP_JOYSTICK_FILTER_ONE;
+    const float magnitude = JOYSTICK_FILTER_CLAMP((raw < 0.0f) ? -raw : raw, 0.0f, 1.0f);
+
+    if ((magnitude <= deadband) || (deadband >= 1.0f))
+    {
+        return 0.0f;
+    }
+
+    const float scaled = (magnitude - deadband) / (1.0f - deadband);
+    const float shaped = ((1.0f - expo) * scaled) + (expo * scaled * scaled * scaled);
+    return (raw < 0.0f) ? -shaped : shaped;
+}
+
+
+/**
+ * @brief  Run the filter for one control loop tick
+ *
+ * @param app_joystick_filter_s*
+ * Filter to run
+ * @param bool
+ * true if a new sample came in since the last tick
+ * @param float
+ * The new sample, from -1 to 1 (ignored without one)
+ * @param uint32_t
+ * Current time (us, wraps)
+ * @return float
+ * Conditioned joystick value, from -1 to 1
+ */
+float app_joystick_filter_update(app_joystick_filter_s* filter, bool new_sample, float raw, uint32_t now_us)
+{
+    const app_joystick_filter_cfg_s* cfg = &filter->cfg;
+    const float dt_s = (float)(now_us - filter->tick_us) / JOYSTICK_FILTER_US_PER_S;
+    const float since_sample_s = (float)(now_us - filter->sample_us) / JOYSTICK_FILTER_US_PER_S;
+    const float predict_s = (float)cfg->predict_ms / JOYSTICK_FILTER_MS_PER_S;
+
+    filter->tick_us = now_us;
+    if (!filter->started)
+    {
+        if (!new_sample)
+        {
+            return 0.0f;
+        }
+        // Nothing to filter against, so start at the first sample
+        filter->started = true;
+        filter->last_shaped = app_joystick_filter_shape(cfg, raw);
+        filter->position = filter->last_shaped;
+        filter->velocity = 0.0f;
+        filter->sample_us = now_us;
+        return filter->position;
+    }
+
+    const float prev_position = filter->position;
+
+    // Carry the stick's motion forward, but not past the prediction horizon
+    if (since_sample_s <= predict_s)
+    {
+        filter->position += filter->velocity * dt_s;
+    }
+    else if ((since_sample_s - dt_s) < predict_s)
+    {
+        filter->position += filter->velocity * (predict_s - (since_sample_s - dt_s));
+    }
+
+    if (new_sample)
+    {
+        const float alpha = (float)cfg->alpha / APP_JOYSTICK_FILTER_ONE;
+        const float beta = (float)cfg->beta / APP_JOYSTICK_FILTER_ONE;
+        const float period_s = (since_sample_s > JOYSTICK_FILTER_MIN_PERIOD_S) ? since_sample_s : JOYSTICK_FILTER_MIN_PERIOD_S;
+        const float shaped = app_joystick_filter_shape(cfg, raw);
+        const float residual = shaped - filter->position;
+
+        filter->position += alpha * residual;
+        filter->velocity += (beta * residual) / period_s;
+        filter->last_shaped = shaped;
+        filter->sample_us = now_us;
+    }
+
+    // Stay on the side of neutral the stick is on, so the motor never blips the wrong way.
+    // Once it's released, the position can only fall back to neutral
+    const float side = (0.0f != filter->last_shaped) ? filter->last_shaped : prev_position;
+    const float lo = (side > 0.0f) ? 0.0f : -1.0f;
+    const float hi = (side < 0.0f) ? 0.0f : 1.0f;
+    filter->position = JOYSTICK_FILTER_CLAMP(filter->position, lo, hi);
+    if (0.0f == filter->last_shaped)
+    {
+        // Settle on neutral, so the motor stops and brakes
+        const float deadband = (float)cfg->deadband / APP_JOYSTICK_FILTER_ONE;
+        const float snap = (deadband > JOYSTICK_FILTER_MIN_SNAP) ? deadband : JOYSTICK_FILTER_MIN_SNAP;
+        if ((filter->position < snap) && (filter->position > -snap))
+        {
+            filter->position = 0.0f;
+        }
+    }
+    if (0.0f == filter->position)
+    {
+        filter->velocity = 0.0f;
+    }
+
+    return filter->position;
+}
+
+/* [] END OF FILE */
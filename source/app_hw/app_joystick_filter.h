@@ -0,0 +1,66 @@
+/**
+ * @file app_joystick_filter.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for joystick input conditioning: a deadband, an expo curve,
+ * an alpha-beta filter, and prediction across missed BLE connection events
+ *
+ * @version 0.1
+ * @date 2024-12-21
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_JOYSTICK_FILTER_H__
+#define __APP_JOYSTICK_FILTER_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: The filter runs on every control loop tick, whether or not a new sample came in.
+//       Samples are shaped (deadband, then expo) and fed to an alpha-beta filter, which
+//       tracks the stick's position and velocity. Between samples the position is carried
+//       forward at that velocity for up to predict_ms, so a late or dropped packet doesn't
+//       stall a moving stick, then held. Prediction never crosses neutral or goes past full
+//       deflection. alpha 1000, beta 0 and predict_ms 0 pass samples straight through, and
+//       with no deadband or expo as well, the output is the raw joystick value
+#define APP_JOYSTICK_FILTER_ONE         (1000U)     // Settings are in thousandths
+// Defaults, tuned with tools/joystick_replay. Steering has no expo, as app_steering has its own curve
+#define APP_JOYSTICK_FILTER_DEFAULT_THROTTLE    { .deadband = 50, .expo = 250, .alpha = 400, .beta = 300, .predict_ms = 60 }
+#define APP_JOYSTICK_FILTER_DEFAULT_STEERING    { .deadband = 20, .expo = 0, .alpha = 400, .beta = 200, .predict_ms = 40 }
+
+typedef struct
+{
+    uint16_t deadband;      // Values this close to neutral are 0 (thousandths of full deflection)
+    uint16_t expo;          // How much of the curve is cubic rather than linear (thousandths)
+    uint16_t alpha;         // Alpha-beta filter position gain (thousandths)
+    uint16_t beta;          // Alpha-beta filter velocity gain (thousandths)
+    uint16_t predict_ms;    // Longest the stick's motion is carried past its last sample
+} app_joystick_filter_cfg_s;
+
+// State of one joystick axis
+typedef struct
+{
+    app_joystick_filter_cfg_s cfg;
+    float position;         // Filtered, shaped position (-1 to 1)
+    float velocity;         // Filtered velocity (full deflections per second)
+    float last_shaped;      // Last sample after the deadband and expo
+    uint32_t sample_us;     // When the last sample came in
+    uint32_t tick_us;       // When the filter last ran
+    bool started;           // Whether a sample has come in yet
+} app_joystick_filter_s;
+
+
+// Function declarations
+void app_joystick_filter_init(app_joystick_filter_s* filter, const app_joystick_filter_cfg_s* cfg);
+void app_joystick_filter_set_cfg(app_joystick_filter_s* filter, const app_joystick_filter_cfg_s* cfg);
+void app_joystick_filter_reset(app_joystick_filter_s* filter);
+float app_joystick_filter_shape(const app_joystick_filter_cfg_s* cfg, float raw);
+float app_joystick_filter_update(app_joystick_filter_s* filter, bool new_sample, float raw, uint32_t now_us);
+
+
+#endif // __APP_JOYSTICK_FILTER_H__
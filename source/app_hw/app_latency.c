@@ -0,0 +1,150 @@
+/**
+ * @file app_latency.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for latency histograms. Recording is a count leading zeros and
+ * an increment, so it's cheap enough to do on every control loop tick
+ *
+ * @version 0.1
+ * @date 2024-12-19
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_latency.h"
+#include <string.h>
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Bucket a latency falls into
+ *
+ * @param uint32_t
+ * Latency (us)
+ * @return uint32_t
+ * Index into the histogram's counts
+ */
+static uint32_t latency_bucket(uint32_t latency_us)
+{
+    if (latency_us < APP_LATENCY_LINEAR_US)
+    {
+        return latency_us;
+    }
+    if (latency_us >= APP_LATENCY_MAX_US)
+    {
+        return APP_LATENCY_N_BUCKETS - 1;
+    }
+
+    // The leading one picks the power of two, and the bits after it the sub-bucket
+    const uint32_t msb = 31U - (uint32_t)__builtin_clz(latency_us);
+    const uint32_t sub = (latency_us >> (msb - APP_LATENCY_SUB_BITS)) & (APP_LATENCY_SUB_BUCKETS - 1U);
+    return APP_LATENCY_LINEAR_US + ((msb - APP_LATENCY_LINEAR_BITS) * APP_LATENCY_SUB_BUCKETS) + sub;
+}
+
+
+/**
+ * @brief  Longest latency that falls into a bucket
+ *
+ * @param uint32_t
+ * Index into the histogram's counts
+ * @return uint32_t
+ * Latency (us)
+ */
+static uint32_t latency_bucket_max(uint32_t bucket)
+{
+    if (bucket < APP_LATENCY_LINEAR_US)
+    {
+        return bucket;
+    }
+
+    const uint32_t msb = ((bucket - APP_LATENCY_LINEAR_US) / APP_LATENCY_SUB_BUCKETS) + APP_LATENCY_LINEAR_BITS;
+    const uint32_t sub = (bucket - APP_LATENCY_LINEAR_US) % APP_LATENCY_SUB_BUCKETS;
+    const uint32_t shift = msb - APP_LATENCY_SUB_BITS;
+    return ((APP_LATENCY_SUB_BUCKETS + sub + 1U) << shift) - 1U;
+}
+
+
+/**
+ * @brief  Empty a histogram
+ *
+ * @param app_latency_hist_s*
+ * Histogram to reset
+ */
+void app_latency_reset(app_latency_hist_s* hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+
+/**
+ * @brief  Record a latency
+ *
+ * @param app_latency_hist_s*
+ * Histogram to record it in
+ * @param uint32_t
+ * Latency (us)
+ */
+void app_latency_record(app_latency_hist_s* hist, uint32_t latency_us)
+{
+    hist->counts[latency_bucket(latency_us)]++;
+    hist->n++;
+    hist->total_us += latency_us;
+    if (latency_us > hist->max_us)
+    {
+        hist->max_us = latency_us;
+    }
+}
+
+
+/**
+ * @brief  Find a percentile of the recorded latencies
+ *
+ * @param const app_latency_hist_s*
+ * Histogram to read
+ * @param uint32_t
+ * Percentile in tenths of a percent, e.g. 500 for the median or 990 for p99
+ * @return uint32_t
+ * Latency (us) that at least that share of the recorded latencies are no
+ * longer than, rounded up to the end of its bucket (but never more than the
+ * maximum). 0 if nothing has been recorded
+ */
+uint32_t app_latency_percentile(const app_latency_hist_s* hist, uint32_t permille)
+{
+    // Rank of the latency we're after, counting from 1
+    const uint64_t rank = (((uint64_t)hist->n * permille) + 999U) / 1000U;
+    uint64_t seen = 0;
+
+    if (0 == hist->n)
+    {
+        return 0;
+    }
+
+    for (uint32_t bucket = 0; bucket < APP_LATENCY_N_BUCKETS; bucket++)
+    {
+        seen += hist->counts[bucket];
+        if ((seen > 0) && (seen >= rank))
+        {
+            // The last bucket has no end
+            const uint32_t bucket_max = (bucket < (APP_LATENCY_N_BUCKETS - 1)) ? latency_bucket_max(bucket) : UINT32_MAX;
+            return (bucket_max < hist->max_us) ? bucket_max : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+
+/**
+ * @brief  Mean of the recorded latencies
+ *
+ * @param const app_latency_hist_s*
+ * Histogram to read
+ * @return uint32_t
+ * Mean latency (us), 0 if nothing has been recorded
+ */
+uint32_t app_latency_mean(const app_latency_hist_s* hist)
+{
+    return (hist->n > 0) ? (uint32_t)(hist->total_us / hist->n) : 0;
+}
+
+/* [] END OF FILE */
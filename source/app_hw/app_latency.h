@@ -0,0 +1,52 @@
+/**
+ * @file app_latency.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for latency histograms, which record how long something took
+ * in constant time and memory, and report its percentiles
+ *
+ * @version 0.1
+ * @date 2024-12-19
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_LATENCY_H__
+#define __APP_LATENCY_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: Latencies under APP_LATENCY_LINEAR_US get a bucket per microsecond. Above that, every
+//       power of two is split into APP_LATENCY_SUB_BUCKETS buckets, so a bucket is never wider
+//       than 1/8 of its value (12.5% error). Anything from APP_LATENCY_MAX_US up is counted in
+//       the last bucket. The maximum is kept exactly
+#define APP_LATENCY_SUB_BITS        (3U)
+#define APP_LATENCY_SUB_BUCKETS     (1U << APP_LATENCY_SUB_BITS)
+#define APP_LATENCY_LINEAR_BITS     (APP_LATENCY_SUB_BITS + 1U)
+#define APP_LATENCY_LINEAR_US       (1U << APP_LATENCY_LINEAR_BITS)
+#define APP_LATENCY_MAX_BITS        (24U)                           // ~16.8 s
+#define APP_LATENCY_MAX_US          (1UL << APP_LATENCY_MAX_BITS)
+#define APP_LATENCY_N_BUCKETS       (APP_LATENCY_LINEAR_US + ((APP_LATENCY_MAX_BITS - APP_LATENCY_LINEAR_BITS) * APP_LATENCY_SUB_BUCKETS))
+
+typedef struct
+{
+    uint32_t counts[APP_LATENCY_N_BUCKETS];
+    uint32_t n;             // Number of latencies recorded
+    uint32_t max_us;        // Longest latency recorded
+    uint64_t total_us;      // Sum of every latency recorded, for the mean
+} app_latency_hist_s;
+
+
+// Function declarations
+void app_latency_reset(app_latency_hist_s* hist);
+void app_latency_record(app_latency_hist_s* hist, uint32_t latency_us);
+uint32_t app_latency_percentile(const app_latency_hist_s* hist, uint32_t permille);
+uint32_t app_latency_mean(const app_latency_hist_s* hist);
+
+
+#endif // __APP_LATENCY_H__
@@ -0,0 +1,130 @@
+/**
+ * @file app_motor_drive.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the drive motor's state machine. It runs on every control
+ * loop tick, and turns the signed duty cycle the car wants (and whether it
+ * wants to brake when stopping) into the signed duty cycle to drive
+ *
+ * @version 0.1
+ * @date 2024-12-20
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_motor_drive.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define MOTOR_DRIVE_SIGN(V)      (((V) > 0) ? 1 : (((V) < 0) ? -1 : 0))
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Initialize the drive motor's state machine (coasting, stopped)
+ *
+ * @param app_motor_drive_s*
+ * State machine to initialize
+ * @param const app_motor_drive_cfg_s*
+ * Braking and dead time settings
+ */
+void app_motor_drive_init(app_motor_drive_s* drive, const app_motor_drive_cfg_s* cfg)
+{
+    drive->cfg = *cfg;
+    drive->state = APP_MOTOR_DRIVE_COAST;
+    drive->output = 0;
+    drive->dir = 0;
+    drive->off_ms = UINT16_MAX;
+    drive->speed = 0;
+}
+
+
+/**
+ * @brief  Step the state machine
+ *
+ * @param app_motor_drive_s*
+ * State machine to step
+ * @param int32_t
+ * Signed duty cycle the car wants, from -APP_MOTOR_DRIVE_MAX_DUTY to
+ * APP_MOTOR_DRIVE_MAX_DUTY
+ * @param bool
+ * true to brake if the car wants to stop, false to coast
+ * @param uint32_t
+ * Time since the last step (ms)
+ * @return int32_t
+ * Signed duty cycle to drive the motor at, 0 to turn it off
+ */
+int32_t app_motor_drive_update(app_motor_drive_s* drive, int32_t duty, bool brake, uint32_t elapsed_ms)
+{
+    const app_motor_drive_cfg_s* cfg = &drive->cfg;
+    const int32_t release = (int32_t)cfg->brake_release << 16;
+    const int32_t want = (abs(duty) > APP_MOTOR_DRIVE_MIN_DUTY) ? MOTOR_DRIVE_SIGN(duty) : 0;
+    app_motor_drive_state_e state;
+    int32_t output;
+
+    // Follow the wheel speed from what the motor was driven at since the last step
+    if (elapsed_ms >= cfg->tau_ms)
+    {
+        drive->speed = drive->output << 16;
+    }
+    else
+    {
+        drive->speed += (int32_t)((((int64_t)drive->output << 16) - drive->speed) * elapsed_ms / cfg->tau_ms);
+    }
+    if (drive->output != 0)
+    {
+        drive->off_ms = 0;
+    }
+    else if (drive->off_ms < UINT16_MAX)
+    {
+        drive->off_ms += elapsed_ms;
+    }
+    const int32_t moving = (abs(drive->speed) > release) ? MOTOR_DRIVE_SIGN(drive->speed) : 0;
+
+    if (want == 0)
+    {
+        if (brake && (moving != 0) && (cfg->brake_duty > 0))
+        {
+            state = APP_MOTOR_DRIVE_BRAKE;
+            output = -moving * cfg->brake_duty;
+        }
+        else
+        {
+            state = APP_MOTOR_DRIVE_COAST;
+            output = 0;
+        }
+    }
+    else if ((moving == -want) && (cfg->brake_duty > 0))
+    {
+        // Still turning the other way, so brake before driving this way at full duty cycle
+        state = APP_MOTOR_DRIVE_BRAKE;
+        output = want * ((abs(duty) < cfg->brake_duty) ? abs(duty) : cfg->brake_duty);
+    }
+    else
+    {
+        state = (want > 0) ? APP_MOTOR_DRIVE_FORWARD : APP_MOTOR_DRIVE_REVERSE;
+        output = duty;
+    }
+
+    // Never drive against the last direction until the motor has been off for the dead time
+    if ((output != 0) && (drive->dir != 0) && (MOTOR_DRIVE_SIGN(output) != drive->dir) &&
+        (drive->off_ms < cfg->dead_time_ms))
+    {
+        state = APP_MOTOR_DRIVE_DEAD_TIME;
+        output = 0;
+    }
+    if (output != 0)
+    {
+        drive->dir = MOTOR_DRIVE_SIGN(output);
+    }
+
+    drive->state = state;
+    drive->output = output;
+
+    return output;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+/**
+ * @file app_motor_drive.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the drive motor's state machine, which decides how to
+ * stop (coast or brake) and enforces dead time when the motor changes
+ * direction
+ *
+ * @version 0.1
+ * @date 2024-12-20
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_MOTOR_DRIVE_H__
+#define __APP_MOTOR_DRIVE_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: The motor driver only has a PWM and a direction input, so it can't short the motor's
+//       windings. Braking drives the motor against the way it is turning instead, at a limited
+//       duty cycle, until it has nearly stopped. The wheel speed is estimated from what the
+//       motor has been driven at, so braking works without the wheel sensor. Changing direction
+//       while the wheel is still turning brakes first, so the motor doesn't see its full
+//       back-EMF plus the full reverse duty cycle at once
+#define APP_MOTOR_DRIVE_MIN_DUTY    (5)     // Duty cycles (%) at or below this stop the motor
+#define APP_MOTOR_DRIVE_MAX_DUTY    (100)
+// Defaults, tuned with tools/speed_sim
+#define APP_MOTOR_DRIVE_DEFAULT_BRAKE_DUTY      (40)
+#define APP_MOTOR_DRIVE_DEFAULT_BRAKE_RELEASE   (10)
+#define APP_MOTOR_DRIVE_DEFAULT_DEAD_TIME_MS    (10)
+#define APP_MOTOR_DRIVE_DEFAULT_TAU_MS          (150)
+
+typedef enum
+{
+    APP_MOTOR_DRIVE_COAST     = 0,          // Off, free to turn
+    APP_MOTOR_DRIVE_FORWARD   = 1,
+    APP_MOTOR_DRIVE_REVERSE   = 2,
+    APP_MOTOR_DRIVE_BRAKE     = 3,          // Driven against the way it is turning
+    APP_MOTOR_DRIVE_DEAD_TIME = 4,          // Off before being driven the other way
+    APP_MOTOR_DRIVE_STATE_MAX
+} app_motor_drive_state_e;
+
+typedef struct
+{
+    uint8_t brake_duty;                     // Duty cycle (%) to brake at. 0 never brakes
+    uint8_t brake_release;                  // Estimated speed (% of full) to stop braking at
+    uint16_t dead_time_ms;                  // Least time off before driving the other way
+    uint16_t tau_ms;                        // Motor's time constant, for the speed estimate
+} app_motor_drive_cfg_s;
+
+// State of the drive motor
+typedef struct
+{
+    app_motor_drive_cfg_s cfg;
+    app_motor_drive_state_e state;
+    int32_t output;                         // Signed duty cycle being driven (0 = off)
+    int32_t dir;                            // Direction last driven (1 or -1), 0 if never
+    uint32_t off_ms;                        // How long the motor has been off
+    int32_t speed;                          // Estimated speed (signed duty cycle, Q16)
+} app_motor_drive_s;
+
+
+// Function declarations
+void app_motor_drive_init(app_motor_drive_s* drive, const app_motor_drive_cfg_s* cfg);
+int32_t app_motor_drive_update(app_motor_drive_s* drive, int32_t duty, bool brake, uint32_t elapsed_ms);
+
+
+#endif // __APP_MOTOR_DRIVE_H__
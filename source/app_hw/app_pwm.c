@@ -0,0 +1,101 @@
+/**
+ * @file app_pwm.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the PWM fast path. cyhal_pwm_set_duty_cycle works out the
+ * period and compare counts in floating point and reprograms the counter on
+ * every call, which is fine once but not on every step of a control loop.
+ * Here the HAL sets the period once, and the counts it picked are read back
+ * so later updates can skip it
+ *
+ * @version 0.1
+ * @date 2024-12-19
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_pwm.h"
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Set up a PWM on a pin at a fixed frequency, and start it
+ *
+ * @param app_pwm_s*
+ * PWM to initialize
+ * @param cyhal_gpio_t
+ * Pin to drive
+ * @param uint32_t
+ * Counter clock (Hz)
+ * @param uint32_t
+ * PWM frequency (Hz). Can't be changed later
+ * @param float
+ * Duty cycle (%) to start at
+ * @return cy_rslt_t
+ * CY_RSLT_SUCCESS if the PWM is running
+ */
+cy_rslt_t app_pwm_init(app_pwm_s* pwm, cyhal_gpio_t pin, uint32_t clock_hz, uint32_t frequency_hz, float duty_cycle)
+{
+    cy_rslt_t rslt;
+
+    // Give the counter its own clock, so the HAL doesn't pick a coarser one for the frequency
+    rslt = cyhal_clock_allocate(&pwm->clock, CYHAL_CLOCK_BLOCK_PERIPHERAL_16BIT);
+    if (CY_RSLT_SUCCESS == rslt)
+    {
+        rslt = cyhal_clock_set_frequency(&pwm->clock, clock_hz, NULL);
+    }
+    if (CY_RSLT_SUCCESS == rslt)
+    {
+        rslt = cyhal_clock_set_enabled(&pwm->clock, true, true);
+    }
+    if (CY_RSLT_SUCCESS == rslt)
+    {
+        rslt = cyhal_pwm_init(&pwm->hal, pin, &pwm->clock);
+    }
+    if (CY_RSLT_SUCCESS == rslt)
+    {
+        rslt = cyhal_pwm_set_duty_cycle(&pwm->hal, duty_cycle, frequency_hz);
+    }
+    if (CY_RSLT_SUCCESS == rslt)
+    {
+        rslt = cyhal_pwm_start(&pwm->hal);
+    }
+
+    if (CY_RSLT_SUCCESS == rslt)
+    {
+        pwm->base = pwm->hal.tcpwm.base;
+        pwm->cnt_num = pwm->hal.tcpwm.resource.channel_num;
+        // The counter counts from 0 to its period register, inclusive
+        pwm->period_counts = Cy_TCPWM_PWM_GetPeriod0(pwm->base, pwm->cnt_num) + 1U;
+    }
+
+    return rslt;
+}
+
+
+/**
+ * @brief  Convert a duty cycle to the counts that give it. Meant for working
+ *         out counts ahead of time, rather than on every update
+ *
+ * @param const app_pwm_s*
+ * PWM the counts are for
+ * @param float
+ * Duty cycle (%), from 0 to APP_PWM_MAX_DUTY
+ * @return uint32_t
+ * Pulse width, in counts
+ */
+uint32_t app_pwm_duty_to_counts(const app_pwm_s* pwm, float duty_cycle)
+{
+    if (duty_cycle <= 0.0f)
+    {
+        return 0;
+    }
+    if (duty_cycle >= (float)APP_PWM_MAX_DUTY)
+    {
+        return pwm->period_counts;
+    }
+    return (uint32_t)(((duty_cycle * (float)pwm->period_counts) / (float)APP_PWM_MAX_DUTY) + 0.5f);
+}
+
+/* [] END OF FILE */
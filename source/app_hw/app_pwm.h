@@ -0,0 +1,61 @@
+/**
+ * @file app_pwm.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the PWM fast path. The HAL sets a PWM's pin, clock, and
+ * frequency up once, and every update after that is a single write of a
+ * precomputed count to the TCPWM's compare register
+ *
+ * @version 0.1
+ * @date 2024-12-19
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_PWM_H__
+#define __APP_PWM_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include "cyhal.h"
+#include "cy_pdl.h"
+
+
+// Defines
+// NOTE: The counters are 16-bit, so the clock must be at most 65536 times the PWM frequency.
+//       The clock sets the resolution of the duty cycle.
+//       A new compare value takes effect immediately rather than at the end of the period,
+//       so at most one period after an update has a pulse width between the old and new ones
+#define APP_PWM_MAX_DUTY      (100U)
+
+typedef struct
+{
+    cyhal_pwm_t hal;          // Owns the pin and counter
+    cyhal_clock_t clock;
+    TCPWM_Type* base;
+    uint32_t cnt_num;
+    uint32_t period_counts;   // Counts per PWM period
+} app_pwm_s;
+
+
+// Function declarations
+cy_rslt_t app_pwm_init(app_pwm_s* pwm, cyhal_gpio_t pin, uint32_t clock_hz, uint32_t frequency_hz, float duty_cycle);
+uint32_t app_pwm_duty_to_counts(const app_pwm_s* pwm, float duty_cycle);
+
+
+/**
+ * @brief  Change a PWM's pulse width. Safe to call from an interrupt
+ *
+ * @param const app_pwm_s*
+ * PWM to update
+ * @param uint32_t
+ * Pulse width, in counts (see app_pwm_duty_to_counts)
+ */
+static inline void app_pwm_write(const app_pwm_s* pwm, uint32_t counts)
+{
+    Cy_TCPWM_PWM_SetCompare0(pwm->base, pwm->cnt_num, counts);
+}
+
+
+#endif // __APP_PWM_H__
@@ -0,0 +1,195 @@
+/**
+ * @file app_speed_ctrl.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the car's closed-loop speed controller. The wheel speed is
+ * measured from the times of the wheel sensor's edges rather than by counting
+ * them over a fixed window, so it is accurate to a fraction of a pulse per
+ * second even though only a few pulses arrive per update. The PID is all
+ * integer math, and stops integrating while its output is saturated, so it
+ * doesn't overshoot after the car is held back (e.g. on grass or after a hit)
+ *
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_speed_ctrl.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define SPEED_CTRL_US_PER_S       (1000000ULL)
+#define SPEED_CTRL_OUTPUT_LIMIT   ((int64_t)APP_SPEED_CTRL_MAX_OUTPUT << APP_SPEED_CTRL_GAIN_SHIFT)
+#define SPEED_CTRL_CLAMP(V, LO, HI)   (((V) < (LO)) ? (LO) : (((V) > (HI)) ? (HI) : (V)))
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Initialize a speed controller
+ *
+ * @param app_speed_ctrl_s*
+ * Controller to initialize
+ * @param const app_speed_ctrl_gains_s*
+ * PID gains
+ * @param uint32_t
+ * Wheel speed (pulses/s) to aim for at a setpoint of APP_SPEED_CTRL_MAX_OUTPUT
+ */
+void app_speed_ctrl_init(app_speed_ctrl_s* ctrl, const app_speed_ctrl_gains_s* gains, uint32_t max_speed)
+{
+    ctrl->gains = *gains;
+    ctrl->max_speed = (int32_t)(max_speed << APP_SPEED_CTRL_SPEED_SHIFT);
+    ctrl->speed = 0;
+    ctrl->n_edges = 0;
+    ctrl->last_edge_us = 0;
+    ctrl->synced = false;
+    app_speed_ctrl_reset(ctrl);
+}
+
+
+/**
+ * @brief  Change a speed controller's gains. The integral term is kept, so the
+ *         output doesn't jump
+ *
+ * @param app_speed_ctrl_s*
+ * Controller to update
+ * @param const app_speed_ctrl_gains_s*
+ * New PID gains
+ */
+void app_speed_ctrl_set_gains(app_speed_ctrl_s* ctrl, const app_speed_ctrl_gains_s* gains)
+{
+    ctrl->gains = *gains;
+}
+
+
+/**
+ * @brief  Forget the PID's history, e.g. when the motor is stopped. The speed
+ *         measurement is kept
+ *
+ * @param app_speed_ctrl_s*
+ * Controller to reset
+ */
+void app_speed_ctrl_reset(app_speed_ctrl_s* ctrl)
+{
+    ctrl->integral = 0;
+    ctrl->prev_speed = 0;
+    ctrl->target = 0;
+    ctrl->output = 0;
+}
+
+
+/**
+ * @brief  Measure the wheel speed from the wheel sensor's edges. Call it once
+ *         before each update
+ *
+ * @param app_speed_ctrl_s*
+ * Controller to measure the speed for
+ * @param uint32_t
+ * Number of edges the sensor has seen (wraps)
+ * @param uint32_t
+ * Time of the last edge (us, wraps)
+ * @param uint32_t
+ * Current time (us, wraps)
+ * @return int32_t
+ * Wheel speed (pulses/s, Q8), without a direction
+ */
+int32_t app_speed_ctrl_measure(app_speed_ctrl_s* ctrl, uint32_t n_edges, uint32_t last_edge_us, uint32_t now_us)
+{
+    const uint32_t n_new = n_edges - ctrl->n_edges;
+
+    if (!ctrl->synced)
+    {
+        // Nothing to measure against until the second call
+        ctrl->synced = true;
+        ctrl->n_edges = n_edges;
+        ctrl->last_edge_us = last_edge_us;
+        ctrl->speed = 0;
+    }
+    else if (n_new > 0)
+    {
+        // Average over every edge period that ended since the last measurement
+        const uint32_t dt_us = last_edge_us - ctrl->last_edge_us;
+        if (dt_us > 0)
+        {
+            const uint64_t speed = (((uint64_t)n_new << APP_SPEED_CTRL_SPEED_SHIFT) * SPEED_CTRL_US_PER_S) / dt_us;
+            ctrl->speed = (speed > INT32_MAX) ? INT32_MAX : (int32_t)speed;
+        }
+        ctrl->n_edges = n_edges;
+        ctrl->last_edge_us = last_edge_us;
+    }
+    else
+    {
+        // No edges, so the wheel is turning no faster than one pulse since the last edge
+        const uint32_t since_us = now_us - ctrl->last_edge_us;
+        if (since_us >= APP_SPEED_CTRL_STOPPED_US)
+        {
+            ctrl->speed = 0;
+        }
+        else if (since_us > 0)
+        {
+            const int32_t bound = (int32_t)((SPEED_CTRL_US_PER_S << APP_SPEED_CTRL_SPEED_SHIFT) / since_us);
+            if (ctrl->speed > bound)
+            {
+                ctrl->speed = bound;
+            }
+        }
+    }
+
+    return ctrl->speed;
+}
+
+
+/**
+ * @brief  Run the PID once. Must be called at APP_SPEED_CTRL_HZ, after
+ *         app_speed_ctrl_measure
+ *
+ * @param app_speed_ctrl_s*
+ * Controller to run
+ * @param int32_t
+ * Setpoint, from -APP_SPEED_CTRL_MAX_OUTPUT to APP_SPEED_CTRL_MAX_OUTPUT
+ * @return int32_t
+ * Duty cycle to drive the motor at, with the same sign as the setpoint. The
+ * motor is never reversed to slow the car down
+ */
+int32_t app_speed_ctrl_update(app_speed_ctrl_s* ctrl, int32_t setpoint)
+{
+    const app_speed_ctrl_gains_s* gains = &ctrl->gains;
+    const int64_t out_min = (setpoint < 0) ? -SPEED_CTRL_OUTPUT_LIMIT : 0;
+    const int64_t out_max = (setpoint < 0) ? 0 : SPEED_CTRL_OUTPUT_LIMIT;
+
+    // The sensor can't tell which way the wheel turns, so it's taken to turn the way it's driven
+    const int32_t speed = (ctrl->output < 0) ? -ctrl->speed : ctrl->speed;
+    const int32_t target = (int32_t)(((int64_t)setpoint * ctrl->max_speed) / APP_SPEED_CTRL_MAX_OUTPUT);
+    const int64_t error = (int64_t)target - speed;
+
+    const int64_t feedforward = (int64_t)setpoint << APP_SPEED_CTRL_GAIN_SHIFT;
+    const int64_t p = (gains->kp * error) >> APP_SPEED_CTRL_SPEED_SHIFT;
+    // Differentiate the speed rather than the error, so setpoint steps don't kick the output
+    const int64_t d = -((gains->kd * ((int64_t)speed - ctrl->prev_speed) * APP_SPEED_CTRL_HZ) >>
+                        APP_SPEED_CTRL_SPEED_SHIFT);
+    const int64_t i_step = ((gains->ki * error) >> APP_SPEED_CTRL_SPEED_SHIFT) / APP_SPEED_CTRL_HZ;
+
+    int64_t integral = SPEED_CTRL_CLAMP(ctrl->integral + i_step, -SPEED_CTRL_OUTPUT_LIMIT, SPEED_CTRL_OUTPUT_LIMIT);
+    int64_t output = feedforward + p + integral + d;
+    if (((output > out_max) && (i_step > 0)) || ((output < out_min) && (i_step < 0)))
+    {
+        // Anti-windup: hold the integral while it would only push a saturated output further
+        integral = ctrl->integral;
+        output = feedforward + p + integral + d;
+    }
+    output = SPEED_CTRL_CLAMP(output, out_min, out_max);
+
+    ctrl->integral = (int32_t)integral;
+    ctrl->prev_speed = speed;
+    ctrl->target = target;
+    // Round to the nearest whole duty cycle
+    ctrl->output = (int32_t)((output >= 0) ? ((output + (1 << (APP_SPEED_CTRL_GAIN_SHIFT - 1))) >> APP_SPEED_CTRL_GAIN_SHIFT)
+                                          : -((-output + (1 << (APP_SPEED_CTRL_GAIN_SHIFT - 1))) >> APP_SPEED_CTRL_GAIN_SHIFT));
+
+    return ctrl->output;
+}
+
+/* [] END OF FILE */
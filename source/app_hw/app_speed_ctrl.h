@@ -0,0 +1,77 @@
+/**
+ * @file app_speed_ctrl.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the car's closed-loop speed controller, a fixed-point PID
+ * that turns a speed setpoint and the measured wheel speed into a duty cycle
+ *
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_SPEED_CTRL_H__
+#define __APP_SPEED_CTRL_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: Setpoints and outputs are signed duty cycles (%), so the open-loop duty cycle for a
+//       setpoint is the setpoint itself. It is used as a feedforward term, and the PID only
+//       corrects for load, friction, and battery voltage around it. With all gains 0 the
+//       controller is open-loop. Speeds are wheel sensor pulses per second
+#define APP_SPEED_CTRL_HZ               (100U)      // How often app_speed_ctrl_update runs
+#define APP_SPEED_CTRL_GAIN_SHIFT       (16U)       // Gains are Q16
+#define APP_SPEED_CTRL_SPEED_SHIFT      (8U)        // Speeds are Q8
+#define APP_SPEED_CTRL_MAX_OUTPUT       (100)
+// Wheel speed (pulses/s) at full throttle, unloaded on a charged battery, so closed-loop
+// setpoints drive the car about as fast as the same open-loop duty cycles
+#define APP_SPEED_CTRL_MAX_PPS          (400U)
+// Default gains in thousandths, tuned with tools/speed_sim
+#define APP_SPEED_CTRL_DEFAULT_KP       (350)
+#define APP_SPEED_CTRL_DEFAULT_KI       (2500)
+#define APP_SPEED_CTRL_DEFAULT_KD       (0)
+// No pulse for this long means the wheel has stopped
+#define APP_SPEED_CTRL_STOPPED_US       (250000U)
+
+// Convert gains in thousandths to Q16
+#define APP_SPEED_CTRL_GAIN_FROM_MILLI(G)   ((int32_t)(((int64_t)(G) << APP_SPEED_CTRL_GAIN_SHIFT) / 1000))
+#define APP_SPEED_CTRL_GAIN_TO_MILLI(G)     ((int32_t)((((int64_t)(G) * 1000) + (1 << (APP_SPEED_CTRL_GAIN_SHIFT - 1))) >> APP_SPEED_CTRL_GAIN_SHIFT))
+
+typedef struct
+{
+    int32_t kp;    // Duty cycle (%) per pulse/s of error (Q16)
+    int32_t ki;    // Duty cycle (%) per pulse of accumulated error (Q16)
+    int32_t kd;    // Duty cycle (%) per pulse/s^2 of acceleration (Q16)
+} app_speed_ctrl_gains_s;
+
+// State of a speed controller
+typedef struct
+{
+    app_speed_ctrl_gains_s gains;
+    int32_t max_speed;        // Speed at a setpoint of APP_SPEED_CTRL_MAX_OUTPUT (Q8)
+    int32_t integral;         // Integral term (duty cycle Q16)
+    int32_t speed;            // Last measured speed, unsigned (Q8)
+    int32_t prev_speed;       // Signed speed at the last update (Q8)
+    int32_t target;           // Signed target speed at the last update (Q8)
+    int32_t output;           // Last duty cycle
+    uint32_t n_edges;         // Sensor edge count at the last measurement
+    uint32_t last_edge_us;    // Time of the last sensor edge seen
+    bool synced;              // Whether n_edges and last_edge_us have been read yet
+} app_speed_ctrl_s;
+
+
+// Function declarations
+void app_speed_ctrl_init(app_speed_ctrl_s* ctrl, const app_speed_ctrl_gains_s* gains, uint32_t max_speed);
+void app_speed_ctrl_set_gains(app_speed_ctrl_s* ctrl, const app_speed_ctrl_gains_s* gains);
+void app_speed_ctrl_reset(app_speed_ctrl_s* ctrl);
+int32_t app_speed_ctrl_measure(app_speed_ctrl_s* ctrl, uint32_t n_edges, uint32_t last_edge_us, uint32_t now_us);
+int32_t app_speed_ctrl_update(app_speed_ctrl_s* ctrl, int32_t setpoint);
+
+
+#endif // __APP_SPEED_CTRL_H__
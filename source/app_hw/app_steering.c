@@ -0,0 +1,164 @@
+/**
+ * @file app_steering.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the steering response. The curve and the high speed
+ * reduction are worked out by the compiler, so a tick is two table lookups,
+ * a multiply, and the slew rate limit
+ *
+ * @version 0.1
+ * @date 2024-12-22
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_steering.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define STEERING_CLAMP(V, LO, HI)   (((V) < (LO)) ? (LO) : (((V) > (HI)) ? (HI) : (V)))
+#define STEERING_CURVE_SHIFT        (10U)   // log2(APP_STEERING_ONE / APP_STEERING_CURVE_SEGMENTS)
+#define STEERING_SPEED_STEP         (APP_STEERING_MAX_SPEED / APP_STEERING_SPEED_SEGMENTS)
+
+// Point I of the curve, at stick I / N: ((1000 - expo) * x + expo * x^3) / 1000, rounded
+#define STEERING_N3                 ((int64_t)APP_STEERING_CURVE_SEGMENTS * APP_STEERING_CURVE_SEGMENTS * APP_STEERING_CURVE_SEGMENTS)
+#define STEERING_CURVE(I)           ((uint16_t)((((((int64_t)(1000 - APP_STEERING_EXPO) * (I) * APP_STEERING_CURVE_SEGMENTS * APP_STEERING_CURVE_SEGMENTS) + \
+                                                   ((int64_t)APP_STEERING_EXPO * (I) * (I) * (I))) * APP_STEERING_ONE) +                               \
+                                                 ((1000 * STEERING_N3) / 2)) / (1000 * STEERING_N3)))
+#define STEERING_CURVE_8(I)         STEERING_CURVE((I)),     STEERING_CURVE((I) + 1), STEERING_CURVE((I) + 2), STEERING_CURVE((I) + 3), \
+                                    STEERING_CURVE((I) + 4), STEERING_CURVE((I) + 5), STEERING_CURVE((I) + 6), STEERING_CURVE((I) + 7)
+
+// Gain at speed I / N of full: 1 - high_speed * s^2 / 1000, rounded
+#define STEERING_N2                 ((int64_t)APP_STEERING_SPEED_SEGMENTS * APP_STEERING_SPEED_SEGMENTS)
+#define STEERING_GAIN(I)            ((uint16_t)(((((1000 * STEERING_N2) - ((int64_t)APP_STEERING_HIGH_SPEED * (I) * (I))) * APP_STEERING_ONE) + \
+                                                 ((1000 * STEERING_N2) / 2)) / (1000 * STEERING_N2)))
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// Steering angle (Q15) at every 1/32 of the stick's travel, and one past the end
+static const uint16_t app_steering_curve[APP_STEERING_CURVE_SEGMENTS + 1] = {
+    STEERING_CURVE_8(0), STEERING_CURVE_8(8), STEERING_CURVE_8(16), STEERING_CURVE_8(24),
+    STEERING_CURVE(32)
+};
+
+// Share of the angle kept (Q15) at every 1/10 of full speed
+static const uint16_t app_steering_gain[APP_STEERING_SPEED_SEGMENTS + 1] = {
+    STEERING_GAIN(0), STEERING_GAIN(1), STEERING_GAIN(2), STEERING_GAIN(3), STEERING_GAIN(4), STEERING_GAIN(5),
+    STEERING_GAIN(6), STEERING_GAIN(7), STEERING_GAIN(8), STEERING_GAIN(9), STEERING_GAIN(10)
+};
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Initialize the steering, pointing straight ahead
+ *
+ * @param app_steering_s*
+ * Steering to initialize
+ * @param const app_steering_cfg_s*
+ * Slew rate limit
+ */
+void app_steering_init(app_steering_s* steering, const app_steering_cfg_s* cfg)
+{
+    steering->cfg = *cfg;
+    app_steering_reset(steering);
+}
+
+
+/**
+ * @brief  Change the steering's slew rate limit
+ *
+ * @param app_steering_s*
+ * Steering to update
+ * @param const app_steering_cfg_s*
+ * New slew rate limit
+ */
+void app_steering_set_cfg(app_steering_s* steering, const app_steering_cfg_s* cfg)
+{
+    steering->cfg = *cfg;
+}
+
+
+/**
+ * @brief  Point the steering straight ahead at once, e.g. between races
+ *
+ * @param app_steering_s*
+ * Steering to reset
+ */
+void app_steering_reset(app_steering_s* steering)
+{
+    steering->angle = 0;
+}
+
+
+/**
+ * @brief  Look up the steering angle for a stick position and speed, with no
+ *         slew rate limit
+ *
+ * @param int32_t
+ * Stick position (Q15, from -APP_STEERING_ONE to APP_STEERING_ONE)
+ * @param int32_t
+ * Car's speed, either direction (duty cycle, %)
+ * @return int32_t
+ * Steering angle (Q15)
+ */
+int32_t app_steering_target(int32_t stick, int32_t speed)
+{
+    const int32_t magnitude = STEERING_CLAMP(abs(stick), 0, APP_STEERING_ONE);
+    const int32_t speed_mag = STEERING_CLAMP(abs(speed), 0, APP_STEERING_MAX_SPEED);
+    const uint32_t idx = (uint32_t)magnitude >> STEERING_CURVE_SHIFT;
+    const uint32_t speed_idx = (uint32_t)speed_mag / STEERING_SPEED_STEP;
+    int32_t curve = app_steering_curve[idx];
+    int32_t gain = app_steering_gain[speed_idx];
+
+    if (idx < APP_STEERING_CURVE_SEGMENTS)
+    {
+        const int32_t frac = magnitude & ((1 << STEERING_CURVE_SHIFT) - 1);
+        curve += ((app_steering_curve[idx + 1] - curve) * frac) >> STEERING_CURVE_SHIFT;
+    }
+    if (speed_idx < APP_STEERING_SPEED_SEGMENTS)
+    {
+        const int32_t frac = speed_mag % STEERING_SPEED_STEP;
+        gain += ((app_steering_gain[speed_idx + 1] - gain) * frac) / (int32_t)STEERING_SPEED_STEP;
+    }
+
+    const int32_t angle = (int32_t)(((int64_t)curve * gain) >> 15);
+    return (stick < 0) ? -angle : angle;
+}
+
+
+/**
+ * @brief  Run the steering for one tick. Must be called at
+ *         APP_STEERING_TICK_HZ
+ *
+ * @param app_steering_s*
+ * Steering to run
+ * @param int32_t
+ * Stick position (Q15, from -APP_STEERING_ONE to APP_STEERING_ONE)
+ * @param int32_t
+ * Car's speed, either direction (duty cycle, %)
+ * @return int32_t
+ * Steering angle to point the servo at (Q15)
+ */
+int32_t app_steering_update(app_steering_s* steering, int32_t stick, int32_t speed)
+{
+    const int32_t target = app_steering_target(stick, speed);
+    const int32_t max_step = (int32_t)(((int64_t)steering->cfg.max_rate * APP_STEERING_ONE) / (1000 * APP_STEERING_TICK_HZ));
+
+    if ((0 == steering->cfg.max_rate) || (abs(target - steering->angle) <= max_step))
+    {
+        steering->angle = target;
+    }
+    else
+    {
+        steering->angle += (target > steering->angle) ? max_step : -max_step;
+    }
+
+    return steering->angle;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+/**
+ * @file app_steering.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the steering response: a table-driven curve from the
+ * conditioned joystick to the steering angle, less steering at high speed,
+ * and a slew rate limit, run on a fixed tick
+ *
+ * @version 0.1
+ * @date 2024-12-22
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __APP_STEERING_H__
+#define __APP_STEERING_H__
+
+// Include Standard C Libraries
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Defines
+// NOTE: Stick positions and steering angles are Q15, so APP_STEERING_ONE is full deflection
+//       (full lock). The response is (1 - expo) * stick + expo * stick^3, scaled down by
+//       high_speed * (speed / 100)^2, so the car turns as sharply as ever when slow but doesn't
+//       spin out at full speed. Both are tables built by the preprocessor from the settings
+//       below, and interpolated linearly
+#define APP_STEERING_ONE                (32768)
+#define APP_STEERING_TICK_HZ            (50U)       // Once per servo PWM period
+#define APP_STEERING_EXPO               (300)       // Thousandths
+#define APP_STEERING_HIGH_SPEED         (400)       // Steering taken away at full speed (thousandths)
+#define APP_STEERING_CURVE_SEGMENTS     (32U)
+#define APP_STEERING_SPEED_SEGMENTS     (10U)
+#define APP_STEERING_MAX_SPEED          (100)       // Speeds are duty cycles (%)
+// Default slew rate limit, in thousandths of full lock per second, so 8 s^-1 is lock to lock
+// in 250 ms. 0 turns the limit off
+#define APP_STEERING_DEFAULT_MAX_RATE   (8000U)
+
+typedef struct
+{
+    uint32_t max_rate;      // Fastest the steering may move (thousandths of full lock per second)
+} app_steering_cfg_s;
+
+// State of the steering
+typedef struct
+{
+    app_steering_cfg_s cfg;
+    int32_t angle;          // Steering angle last output (Q15)
+} app_steering_s;
+
+
+// Function declarations
+void app_steering_init(app_steering_s* steering, const app_steering_cfg_s* cfg);
+void app_steering_set_cfg(app_steering_s* steering, const app_steering_cfg_s* cfg);
+void app_steering_reset(app_steering_s* steering);
+int32_t app_steering_target(int32_t stick, int32_t speed);
+int32_t app_steering_update(app_steering_s* steering, int32_t stick, int32_t speed);
+
+
+#endif // __APP_STEERING_H__
@@ -1,6 +1,12 @@
 #include "dc_motor.h"
+#include <stdlib.h>
 
-cyhal_pwm_t dc_pwm_obj;
+static app_pwm_s dc_pwm;
+// Compare counts for every duty cycle, worked out once at init
+static uint32_t dc_motor_duty_counts[APP_PWM_MAX_DUTY + 1];
+// Decides how to stop and when the motor may change direction
+static app_motor_drive_s dc_motor_drive_sm;
+static int32_t dc_motor_output = 0;
 
 /**
  * @brief
@@ -10,13 +16,26 @@ cyhal_pwm_t dc_pwm_obj;
 void dc_motor_init(void) {
 	cy_rslt_t rslt;
     
-    /* Initialize PWM on the supplied pin and assign a new clock */
-    rslt = cyhal_pwm_init(&dc_pwm_obj, DC_MOTOR_PWM_PIN, NULL);
+    /* Initialize PWM on the supplied pin and assign a new clock, stopped (inverted, so 100 is actually 0) */
+    rslt = app_pwm_init(&dc_pwm, DC_MOTOR_PWM_PIN, DC_MOTOR_PWM_CLOCK_HZ, DC_MOTOR_PWM_FREQ_HZ, APP_PWM_MAX_DUTY);
     CY_ASSERT(CY_RSLT_SUCCESS == rslt);
 
+    // The PWM is inverted, so each duty cycle's counts are for 100 minus it
+    for (uint32_t duty = 0; duty <= APP_PWM_MAX_DUTY; duty++) {
+        dc_motor_duty_counts[duty] = app_pwm_duty_to_counts(&dc_pwm, (float)(APP_PWM_MAX_DUTY - duty));
+    }
+
     // Initialize the pin that controls the direction
     rslt = cyhal_gpio_configure(DC_MOTOR_DIR_PIN, CYHAL_GPIO_DIR_OUTPUT, CYHAL_GPIO_DRIVE_STRONG);
     CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+
+    const app_motor_drive_cfg_s drive_cfg = {
+        .brake_duty = DC_MOTOR_BRAKE_DUTY,
+        .brake_release = DC_MOTOR_BRAKE_RELEASE,
+        .dead_time_ms = DC_MOTOR_DEAD_TIME_MS,
+        .tau_ms = DC_MOTOR_TAU_MS
+    };
+    app_motor_drive_init(&dc_motor_drive_sm, &drive_cfg);
 }
 
 void set_dc_motor_direction(uint8_t dir) {
@@ -24,18 +43,46 @@ void set_dc_motor_direction(uint8_t dir) {
 }
 
 void set_dc_motor_duty_cycle(uint8_t duty_cycle) {
-	cy_rslt_t rslt;
-	rslt = cyhal_pwm_set_duty_cycle(&dc_pwm_obj, 100-duty_cycle, 50);
-	rslt = cyhal_pwm_start(&dc_pwm_obj);
-	CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+	if (duty_cycle > APP_PWM_MAX_DUTY) {
+		duty_cycle = APP_PWM_MAX_DUTY;
+	}
+	app_pwm_write(&dc_pwm, dc_motor_duty_counts[duty_cycle]);
 }
 
 void turn_dc_motor_off() {
-	cy_rslt_t rslt;
 	/* To turn off, must use PWM duty cycle of 100 (inverted so actually 0)*/
-	rslt = cyhal_pwm_set_duty_cycle(&dc_pwm_obj, 100, 50);
-	rslt = cyhal_pwm_start(&dc_pwm_obj);
-	CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+	app_pwm_write(&dc_pwm, dc_motor_duty_counts[0]);
 }
 
+/**
+ * @brief
+ * Runs the motor's drive state machine for one control loop tick, and only
+ * touches the hardware when its output changes.
+ *
+ * @param duty
+ * Signed duty cycle the car wants, 0 (or at most DC_MOTOR_MIN_DUTY) to stop
+ * @param brake
+ * true to brake if stopping, false to coast
+ * @param elapsed_ms
+ * Time since the last call
+ */
+void dc_motor_drive(int32_t duty, bool brake, uint32_t elapsed_ms) {
+	const int32_t output = app_motor_drive_update(&dc_motor_drive_sm, duty, brake, elapsed_ms);
+
+	if (output == dc_motor_output) {
+		return;
+	}
+	if (output == 0) {
+		turn_dc_motor_off();
+	} else {
+		if ((dc_motor_output == 0) || ((output > 0) != (dc_motor_output > 0))) {
+			set_dc_motor_direction((output > 0) ? FORWARD : REVERSE);
+		}
+		set_dc_motor_duty_cycle((uint8_t)abs(output));
+	}
+	dc_motor_output = output;
+}
 
+app_motor_drive_state_e dc_motor_get_state(void) {
+	return dc_motor_drive_sm.state;
+}
@@ -19,22 +19,36 @@
 #include "cyhal_gpio.h"
 #include "cy_result.h"
 #include "cyhal.h"
+#include "app_pwm.h"
+#include "app_motor_drive.h"
 
 // Pin controlling PWM signal
 #define DC_MOTOR_PWM_PIN P9_0
 // Pin controlling direction signal
 #define DC_MOTOR_DIR_PIN P9_1
+// Above hearing, so the motor doesn't whine, and fast enough that the current doesn't ripple
+#define DC_MOTOR_PWM_FREQ_HZ      (20000)
+#define DC_MOTOR_PWM_CLOCK_HZ     (10000000) // 500 counts per period
 
 #define REVERSE 0
 #define FORWARD 1
 #define STOPPED 2
-#define DC_MOTOR_MIN_DUTY         (5)
-#define DC_MOTOR_RAMP_STEP_VAL    (5)
-#define DC_MOTOR_RAMP_STEP_MS     (1) // TODO Tune
+#define DC_MOTOR_MIN_DUTY         APP_MOTOR_DRIVE_MIN_DUTY
+// Whether to brake (rather than coast) when the joystick returns to neutral, and when hit
+#define DC_MOTOR_BRAKE_ON_NEUTRAL (true)
+#define DC_MOTOR_BRAKE_ON_HIT     (true)
+// How hard to brake, and how long to wait before driving the other way
+#define DC_MOTOR_BRAKE_DUTY       APP_MOTOR_DRIVE_DEFAULT_BRAKE_DUTY
+#define DC_MOTOR_BRAKE_RELEASE    APP_MOTOR_DRIVE_DEFAULT_BRAKE_RELEASE
+#define DC_MOTOR_DEAD_TIME_MS     APP_MOTOR_DRIVE_DEFAULT_DEAD_TIME_MS
+#define DC_MOTOR_TAU_MS           APP_MOTOR_DRIVE_DEFAULT_TAU_MS
+#define DC_MOTOR_RAMP_STEP_VAL    (5) // Most the duty cycle changes per control loop tick
 
 void dc_motor_init(void);
 void set_dc_motor_direction(uint8_t dir);
 void set_dc_motor_duty_cycle(uint8_t duty_cycle);
 void turn_dc_motor_off();
+void dc_motor_drive(int32_t duty, bool brake, uint32_t elapsed_ms);
+app_motor_drive_state_e dc_motor_get_state(void);
 
 #endif
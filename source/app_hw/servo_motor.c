@@ -1,41 +1,142 @@
 #include "servo_motor.h"
-#include <math.h>
+#include "task_car.h"
+#include "app_clock.h"
+#include "app_steering.h"
+#include "app_bt_bonding.h"
+#include <stdlib.h>
+#include <string.h>
 
-cyhal_pwm_t servo_pwm_obj;
-#define RACE_INACTIVE_DELAY_MS    (50)
+// Steer once per servo PWM period, as the servo can't see changes any faster
+#define SERVO_TICK_MS             (1000 / APP_STEERING_TICK_HZ)
+#define SERVO_STEERING_KV_KEY     "steering"
+#define SERVO_MAX_RATE_LIMIT      (100000)
+
+static app_pwm_s servo_pwm;
+static uint32_t servo_counts;
+
+// Set by the CLI, and picked up by the servo task on its next tick
+static app_steering_cfg_s servo_steering_cfg;
+static volatile bool servo_steering_cfg_changed = false;
+
+static BaseType_t cli_handler_steering_rate(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+// The CLI command definition for the steering rate limit command
+static const CLI_Command_Definition_t xSteeringRate =
+{
+    "steering_rate",                                                     // Command text
+    "\r\nsteering_rate < max_rate >\r\n\tThousandths of full lock per second, 0 for no limit (saved)\r\n",  // Command help text
+    cli_handler_steering_rate,                                           // The function to run
+    1                                                                    // The user can enter 1 parameter
+};
 
 
 void set_servo_motor_duty_cycle(float duty_cycle) {
-    cy_rslt_t rslt;
-    rslt = cyhal_pwm_set_duty_cycle(&servo_pwm_obj, duty_cycle, 50);
-    rslt = cyhal_pwm_start(&servo_pwm_obj);
-    CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+    servo_counts = app_pwm_duty_to_counts(&servo_pwm, duty_cycle);
+    app_pwm_write(&servo_pwm, servo_counts);
+}
+
+// point the servo at a steering angle (Q15). The PWM is only written when the pulse width changes
+static void servo_set_angle(int32_t angle) {
+    // Servo is upside down, so left and right are reversed
+    const uint32_t counts = app_pwm_duty_to_counts(&servo_pwm, STRAIGHT + (TURN_DUTY_RANGE * angle) / APP_STEERING_ONE);
+    if (counts != servo_counts) {
+        servo_counts = counts;
+        app_pwm_write(&servo_pwm, counts);
+    }
+}
+
+// set how fast the steering may move
+static BaseType_t cli_handler_steering_rate(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    BaseType_t xParameterStringLength;
+    char param[16] = {0};
+    char *end_ptr;
+    configASSERT(pcWriteBuffer);
+
+    const char *pcParameter = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameterStringLength);
+    configASSERT(pcParameter);
+    strncat(param, pcParameter, (xParameterStringLength < (BaseType_t)sizeof(param)) ? (size_t)xParameterStringLength : sizeof(param) - 1);
+
+    const long max_rate = strtol(param, &end_ptr, 10);
+    if ((*end_ptr != '\0') || (max_rate < 0) || (max_rate > SERVO_MAX_RATE_LIMIT)) {
+        task_print_error("Invalid parameter %s. Must be between 0 and %li", param, (long)SERVO_MAX_RATE_LIMIT);
+    } else {
+        app_steering_cfg_s cfg = { .max_rate = (uint32_t)max_rate };
+        taskENTER_CRITICAL();
+        servo_steering_cfg = cfg;
+        servo_steering_cfg_changed = true;
+        taskEXIT_CRITICAL();
+
+        if (CY_RSLT_SUCCESS != mtb_kvstore_write(&kvstore_obj, SERVO_STEERING_KV_KEY, (uint8_t *)&cfg, sizeof(cfg))) {
+            task_print_error("Couldn't save the steering settings");
+        }
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
 }
 
 void task_servo() {
-    bool race_transition = true;
-    car_joystick_t x = 0;
-    car_joystick_t prev_x = x;
+    car_joystick_sample_t joystick = {0};
+    uint32_t last_seq = 0;
+    const app_joystick_filter_cfg_s default_filter_cfg = APP_JOYSTICK_FILTER_DEFAULT_STEERING;
+    app_joystick_filter_cfg_s filter_cfg;
+    uint32_t filter_cfg_gen = 0;
+    app_joystick_filter_s filter;
+    app_steering_cfg_s steering_cfg;
+    app_steering_s steering;
+    app_joystick_filter_init(&filter, &default_filter_cfg);
+    taskENTER_CRITICAL();
+    steering_cfg = servo_steering_cfg;
+    servo_steering_cfg_changed = false;
+    taskEXIT_CRITICAL();
+    app_steering_init(&steering, &steering_cfg);
+
+    TickType_t wake_time = xTaskGetTickCount();
     while (1) {
-        if (race_state == RACE_STATE_ACTIVE) {
-            xQueueReceive(q_ble_car_joystick_x, &x, portMAX_DELAY);
-            if (fabs(x - prev_x) > 0.01) {
-                // Clamp to 0 to make sure we don't get stuck in a near-straight position
-                if (x > -0.01 && x < 0.01) {
-                    x = 0;
-                }
-                // Servo is upside down, so left and right are reversed
-                set_servo_motor_duty_cycle(STRAIGHT + TURN_DUTY_RANGE * x);
-                prev_x = x;
+        // Run on a fixed tick rather than when samples come in, so the steering moves at the
+        // same rate however the BLE packets are spaced
+        vTaskDelayUntil(&wake_time, pdMS_TO_TICKS(SERVO_TICK_MS));
+
+        // Only an X write is a new sample, so a Y write never feeds the filter a stale repeat
+        const bool new_sample = (pdTRUE == app_bt_car_get_joystick(&joystick)) && (joystick.seq[CAR_JOYSTICK_AXIS_X] != last_seq);
+        if (task_car_get_joystick_filter_cfg(CAR_JOYSTICK_AXIS_X, &filter_cfg_gen, &filter_cfg)) {
+            app_joystick_filter_set_cfg(&filter, &filter_cfg);
+        }
+        if (servo_steering_cfg_changed) {
+            taskENTER_CRITICAL();
+            steering_cfg = servo_steering_cfg;
+            servo_steering_cfg_changed = false;
+            taskEXIT_CRITICAL();
+            app_steering_set_cfg(&steering, &steering_cfg);
+        }
+
+        if ((race_state == RACE_STATE_ACTIVE) && !task_car_link_ok()) {
+            // Lost the RC controller app, so straighten up at the usual rate while the car stops
+            if (new_sample) {
+                last_seq = joystick.seq[CAR_JOYSTICK_AXIS_X];
+            }
+            app_joystick_filter_reset(&filter);
+            servo_set_angle(app_steering_update(&steering, 0, task_car_get_speed()));
+        } else if (race_state == RACE_STATE_ACTIVE) {
+            // Only the newest sample matters, so peek rather than queue them up. The filter
+            // carries on between samples, so steering keeps moving if a packet is late
+            const float x = app_joystick_filter_update(&filter, new_sample, joystick.x, app_clock_us());
+            servo_set_angle(app_steering_update(&steering, (int32_t)(x * APP_STEERING_ONE), task_car_get_speed()));
+            if (new_sample) {
+                app_bt_car_joystick_applied(CAR_JOYSTICK_AXIS_X, &joystick, last_seq);
+                last_seq = joystick.seq[CAR_JOYSTICK_AXIS_X];
             }
-            race_transition = true;
         } else {
-            // Hold straight while we're waiting for the race to start
-            if (race_transition) {
-                race_transition = false;
-                set_servo_motor_duty_cycle(STRAIGHT);
+            // Samples from before the race don't count as skipped
+            if (new_sample) {
+                last_seq = joystick.seq[CAR_JOYSTICK_AXIS_X];
             }
-            vTaskDelay(pdMS_TO_TICKS(RACE_INACTIVE_DELAY_MS));
+            app_joystick_filter_reset(&filter);
+            app_steering_reset(&steering);
+            // Hold straight while we're waiting for the race to start
+            servo_set_angle(0);
         }
     }
 }
@@ -43,14 +144,24 @@ void task_servo() {
 void task_servo_init() {
     cy_rslt_t rslt1;
     
-    /* Initialize PWM on the supplied pin and assign a new clock */
-    rslt1 = cyhal_pwm_init(&servo_pwm_obj, SERVO_PIN, NULL);
+    /* Initialize PWM on the supplied pin and assign a new clock, pointing straight ahead */
+    rslt1 = app_pwm_init(&servo_pwm, SERVO_PIN, SERVO_PWM_CLOCK_HZ, SERVO_PWM_FREQ_HZ, STRAIGHT);
     CY_ASSERT(CY_RSLT_SUCCESS == rslt1);
+    servo_counts = app_pwm_duty_to_counts(&servo_pwm, STRAIGHT);
+
+    // load this car's steering rate limit
+    uint32_t cfg_size = sizeof(servo_steering_cfg);
+    if ((CY_RSLT_SUCCESS != mtb_kvstore_read(&kvstore_obj, SERVO_STEERING_KV_KEY, (uint8_t *)&servo_steering_cfg, &cfg_size)) ||
+        (cfg_size != sizeof(servo_steering_cfg))) {
+        servo_steering_cfg.max_rate = APP_STEERING_DEFAULT_MAX_RATE;
+    }
+
+    FreeRTOS_CLIRegisterCommand(&xSteeringRate);
 
     // create the task
     BaseType_t rslt = xTaskCreate(task_servo,
                                   "servo",
-                                  configMINIMAL_STACK_SIZE,
+                                  configMINIMAL_STACK_SIZE * 2,
                                   NULL,
                                   configMAX_PRIORITIES - 5,
                                   NULL);
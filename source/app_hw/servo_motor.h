@@ -3,12 +3,15 @@
 
 #include "cyhal.h"
 #include "cyhal_pwm.h"
+#include "app_pwm.h"
 #include <FreeRTOS.h>
 #include "queue.h"
 #include "app_bt_car.h"
 #include "task_console.h"
 
 #define SERVO_PIN P10_6
+#define SERVO_PWM_FREQ_HZ (50)
+#define SERVO_PWM_CLOCK_HZ (1000000) // 1 us steps
 
 #define LEFT45 10
 #define LEFT30 8.75
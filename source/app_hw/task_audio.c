@@ -22,6 +22,9 @@
  ******************************************************************************/
 static void task_audio_car(void *param);
 static void task_audio_cli(void *param);
+static void task_audio_stream(void *param);
+static void task_audio_sound_effect_complete(app_audio_handle_t handle, app_audio_status_e status);
+static void task_audio_stream_refill(void);
 
 static BaseType_t cli_handler_audio_play_tone(
     char *pcWriteBuffer,
@@ -33,6 +36,26 @@ static BaseType_t cli_handler_audio_play_sound_effect(
     size_t xWriteBufferLen,
     const char *pcCommandString
 );
+static BaseType_t cli_handler_audio_play_sound_effect_pitched(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
+static BaseType_t cli_handler_audio_play_chirp(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
+static BaseType_t cli_handler_audio_play_cue(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
+static BaseType_t cli_handler_audio_stats(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
 
 
 /******************************************************************************
@@ -43,6 +66,35 @@ QueueHandle_t q_audio_cli_req;
 QueueHandle_t q_audio_cli_resp;
 
 TaskHandle_t xTaskAudioHandle;
+// Reads blocks of sound effects streamed from external flash
+static TaskHandle_t xTaskAudioStreamHandle;
+
+// Where the last hit came from, set before the hit sound effect is requested
+static volatile app_ir_hit_dir_e audio_hit_dir = APP_IR_HIT_DIR_FRONT;
+static const uint16_t audio_hit_pitch_pct[APP_IR_HIT_DIR_MAX] = {
+    [APP_IR_HIT_DIR_FRONT] = AUDIO_HIT_FRONT_PITCH_PCT,
+    [APP_IR_HIT_DIR_SIDE]  = AUDIO_HIT_SIDE_PITCH_PCT,
+    [APP_IR_HIT_DIR_REAR]  = AUDIO_HIT_REAR_PITCH_PCT,
+};
+
+// One bit per scheduler slot, set when the sound effect in that slot ends
+static EventGroupHandle_t ev_audio_sound_effects;
+
+// Names for sound effect states, for printing
+static const char* audio_status_names[] = {
+    [APP_AUDIO_STATUS_QUEUED]    = "queued",
+    [APP_AUDIO_STATUS_PLAYING]   = "playing",
+    [APP_AUDIO_STATUS_DONE]      = "done",
+    [APP_AUDIO_STATUS_PREEMPTED] = "preempted",
+    [APP_AUDIO_STATUS_DROPPED]   = "dropped"
+};
+
+// Names for asset formats, for printing
+static const char* audio_format_names[] = {
+    [AUDIO_ASSET_FORMAT_PCM]   = "PCM",
+    [AUDIO_ASSET_FORMAT_ADPCM] = "ADPCM",
+    [AUDIO_ASSET_FORMAT_SYNTH] = "synth"
+};
 
 // The CLI command definition for the audio play tone command
 static const CLI_Command_Definition_t xAudioPlayTone =
@@ -62,43 +114,158 @@ static const CLI_Command_Definition_t xAudioPlaySoundEffect =
     1                                          // The user can enter 1 parameter
 };
 
+// The CLI command definition for the audio play pitched sound effect command
+static const CLI_Command_Definition_t xAudioPlaySoundEffectPitched =
+{
+    "play_sound_effect_pitched",                                           // Command text
+    "\r\nplay_sound_effect_pitched < idx > < pitch >\r\n\t25 <= pitch (%) <= 400\r\n",  // Command help text
+    cli_handler_audio_play_sound_effect_pitched,                           // The function to run
+    2                                                                      // The user can enter 2 parameters
+};
+
+// The CLI command definition for the audio play chirp command
+static const CLI_Command_Definition_t xAudioPlayChirp =
+{
+    "play_chirp",                                          // Command text
+    "\r\nplay_chirp < start freq > < end freq > < duration > < amplitude >\r\n\t200 <= freq (Hz) <= 5000\r\n\t1 <= duration (ms) <= 5000\r\n\t0 <= amp (mdB) <= 94000\r\n",  // Command help text
+    cli_handler_audio_play_chirp,                          // The function to run
+    4                                                      // The user can enter 4 parameters
+};
+
+// The CLI command definition for the audio play cue command
+static const CLI_Command_Definition_t xAudioPlayCue =
+{
+    "play_cue",                                // Command text
+    "\r\nplay_cue < idx >\r\n",                // Command help text
+    cli_handler_audio_play_cue,                // The function to run
+    1                                          // The user can enter 1 parameter
+};
+
+// The CLI command definition for the audio mixer stats command
+static const CLI_Command_Definition_t xAudioStats =
+{
+    "audio_stats",                             // Command text
+    "\r\naudio_stats\r\n",                     // Command help text
+    cli_handler_audio_stats,                   // The function to run
+    0                                          // The user can enter 0 parameters
+};
+
 
 /******************************************************************************
  * Static Function Definitions                                                *
  ******************************************************************************/
 /**
- * @brief  Play tunes when notified
+ * @brief  Audio completion callback. Wakes anything waiting on the sound effect
+ * 
+ * @param app_audio_handle_t
+ * Sound effect that ended
+ * @param app_audio_status_e
+ * How it ended
+ */
+static void task_audio_sound_effect_complete(app_audio_handle_t handle, app_audio_status_e status)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    (void)status;
+
+    // Usually called from the audio DMA interrupt, but the FromISR variant is
+    // also safe from the critical sections the audio driver calls this from
+    xEventGroupSetBitsFromISR(ev_audio_sound_effects,
+                              (EventBits_t)1 << app_audio_scheduler_handle_slot(handle),
+                              &xHigherPriorityTaskWoken);
+    if (xPortIsInsideInterrupt())
+    {
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+}
+
+
+/**
+ * @brief  Stream refill callback. Wakes the stream task to read more blocks
+ *         from external flash
+ * 
+ * @return void
+ */
+static void task_audio_stream_refill(void)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    // Usually called from the audio DMA interrupt, but also from the critical
+    // section a sound effect is started from
+    vTaskNotifyGiveFromISR(xTaskAudioStreamHandle, &xHigherPriorityTaskWoken);
+    if (xPortIsInsideInterrupt())
+    {
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+}
+
+
+/**
+ * @brief  Keep the streams of sound effects in external flash topped up
  * 
  * @param param
  * Unused
  */
-static void task_audio_car(void *param)
+static void task_audio_stream(void *param)
 {
     // Suppress warning for unused parameter
     (void)param;
 
-    uint16_t task_delay_ms = 0;
-
-    for (audio_sound_effect_e i = 0; i < AUDIO_SOUND_EFFECT_MAX; i++)
+    for (;;)
     {
-        const uint16_t delay_ms = (audio_sample_sizes[i] * 1000) / audio_sample_rates[i];
-        if (delay_ms > task_delay_ms)
-        {
-            task_delay_ms = delay_ms;
-        }
+        // Any number of wakeups are handled by a single pass over every stream
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        app_audio_stream_refill();
     }
+}
+
+
+/**
+ * @brief  Play tunes when notified
+ * 
+ * @param param
+ * Unused
+ */
+static void task_audio_car(void *param)
+{
+    // Suppress warning for unused parameter
+    (void)param;
+
+    uint32_t sound_effects = 0;
 
     // Repeatedly running part of the task
     for (;;)
     {
-        // Wait to be notified, getting the sound effect to play
-        const audio_sound_effect_e sound_effect = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-
-        task_print_info("Playing sound effect %u", sound_effect); // TODO REMOVE
-        app_audio_play_sound_effect(sound_effect);
+        // Wait to be notified, getting the bit for each sound effect to play
+        xTaskNotifyWait(0, UINT32_MAX, &sound_effects, portMAX_DELAY);
 
-        // Delay while we're playing the tone
-        vTaskDelay(pdMS_TO_TICKS(task_delay_ms));
+        // The scheduler mixes, queues, or drops each sound effect right away,
+        // so there is no need to wait for them to finish
+        for (audio_sound_effect_e i = 0; i < AUDIO_SOUND_EFFECT_MAX; i++)
+        {
+            if (!(sound_effects & AUDIO_SOUND_EFFECT_NOTIFY_BIT(i)))
+            {
+                continue;
+            }
+
+            // Boosting from a higher speed sounds higher
+            uint16_t pitch = APP_AUDIO_MIXER_PITCH_UNITY;
+            if (AUDIO_SOUND_EFFECT_BOOST == i)
+            {
+                pitch += (uint16_t)((APP_AUDIO_MIXER_PITCH_UNITY * AUDIO_BOOST_MAX_PITCH_UP_PCT * app_audio_engine_get_speed()) /
+                                    (100UL * APP_AUDIO_ENGINE_MAX_SPEED));
+            }
+            // Hits sound different depending on where they came from
+            else if (AUDIO_SOUND_EFFECT_HIT == i)
+            {
+                pitch = (uint16_t)((APP_AUDIO_MIXER_PITCH_UNITY * audio_hit_pitch_pct[audio_hit_dir]) / 100UL);
+            }
+
+            if (APP_AUDIO_SCHED_INVALID_HANDLE == app_audio_play_sound_effect_pitched(i, pitch))
+            {
+                task_print_warning("Dropped sound effect %u", i);
+            }
+        }
     }
 }
 
@@ -129,10 +296,89 @@ static void task_audio_cli(void *param)
                 app_audio_play_tone(audio_pkt.amplitude, audio_pkt.frequency);
                 break;
 
+            case AUDIO_PLAY_CHIRP:
+            {
+                const app_audio_dds_segment_s chirp =
+                {
+                    .freq_start_hz = (uint16_t)audio_pkt.frequency,
+                    .freq_end_hz   = (uint16_t)audio_pkt.frequency_end,
+                    .gain          = (int16_t)((audio_pkt.amplitude * APP_AUDIO_MIXER_GAIN_UNITY) / (MAX_AMP_mDB - MIN_AMP_mDB)),
+                    .duration_ms   = (uint16_t)audio_pkt.duration_ms
+                };
+                task_print_info("Playing chirp from %u Hz to %u Hz over %u ms...", audio_pkt.frequency, audio_pkt.frequency_end, audio_pkt.duration_ms);
+                app_audio_play_tone_sequence(&chirp, 1);
+                break;
+            }
+
+            case AUDIO_PLAY_CUE:
+                task_print_info("Playing cue %u", audio_pkt.cue_idx);
+                app_audio_play_cue((app_audio_cue_e)audio_pkt.cue_idx);
+                break;
+
             case AUDIO_PLAY_SOUND_EFFECT:
-                task_print_info("Playing sound effect %u", audio_pkt.sound_effect_idx);
-                app_audio_play_sound_effect(audio_pkt.sound_effect_idx);
+            {
+                const uint32_t pitch_pct = (audio_pkt.pitch_pct > 0) ? audio_pkt.pitch_pct : 100;
+                task_print_info("Playing sound effect %u at %u%% pitch", audio_pkt.sound_effect_idx, pitch_pct);
+                const app_audio_handle_t handle = app_audio_play_sound_effect_pitched(
+                    audio_pkt.sound_effect_idx,
+                    (uint16_t)((pitch_pct * APP_AUDIO_MIXER_PITCH_UNITY) / 100));
+                const app_audio_status_e status = task_audio_wait_sound_effect(handle, pdMS_TO_TICKS(AUDIO_CLI_WAIT_MS));
+                task_print_info("Sound effect %u %s", audio_pkt.sound_effect_idx, audio_status_names[status]);
                 break;
+            }
+
+            case AUDIO_PRINT_STATS:
+            {
+                app_audio_mixer_stats_s stats;
+                app_audio_get_mixer_stats(&stats);
+                task_print_info("Mixer: %lu blocks of %u samples, %u voices max",
+                                stats.n_blocks, APP_AUDIO_MIXER_BLOCK_SAMPLES, stats.max_active_voices);
+                task_print_info("Mixer cycles/block: last %lu, avg %lu, max %lu, budget %lu (%lu over)",
+                                stats.last_cycles,
+                                (stats.n_blocks > 0) ? (uint32_t)(stats.total_cycles / stats.n_blocks) : 0,
+                                stats.max_cycles,
+                                stats.budget_cycles,
+                                stats.n_budget_overruns);
+                for (uint8_t i = 0; (i < APP_AUDIO_MIXER_N_RATE_STATS) && (stats.rates[i].sample_rate != 0); i++)
+                {
+                    task_print_info("Voice cycles/block for %s at %lu Hz: avg %lu, max %lu (%lu blocks)",
+                                    audio_format_names[stats.rates[i].format],
+                                    stats.rates[i].sample_rate,
+                                    (uint32_t)(stats.rates[i].total_cycles / stats.rates[i].n_blocks),
+                                    stats.rates[i].max_cycles,
+                                    stats.rates[i].n_blocks);
+                }
+
+                app_audio_load_stats_s load_stats;
+                app_audio_get_load_stats(&load_stats);
+                if ((load_stats.n_blocks > 0) && (load_stats.block_cycles > 0))
+                {
+                    // Load in hundredths of a percent
+                    const uint32_t avg_load = (uint32_t)((load_stats.total_cycles * 10000ULL) /
+                                                         ((uint64_t)load_stats.n_blocks * load_stats.block_cycles));
+                    const uint32_t max_load = (uint32_t)(((uint64_t)load_stats.max_cycles * 10000ULL) / load_stats.block_cycles);
+                    const uint32_t elapsed_ms = (uint32_t)(((uint64_t)load_stats.n_blocks * APP_AUDIO_MIXER_BLOCK_SAMPLES * 1000ULL) /
+                                                           APP_AUDIO_MIXER_SAMPLE_RATE_HZ);
+                    task_print_info("Audio CPU load: avg %lu.%02lu%%, max %lu.%02lu%% over %lu ms",
+                                    avg_load / 100, avg_load % 100, max_load / 100, max_load % 100, elapsed_ms);
+                    task_print_info("Engine: speed %u, %lu updates (%lu/s)",
+                                    app_audio_engine_get_speed(),
+                                    load_stats.n_engine_updates,
+                                    (elapsed_ms > 0) ? (uint32_t)(((uint64_t)load_stats.n_engine_updates * 1000ULL) / elapsed_ms) : 0);
+                }
+
+                app_audio_stream_stats_s stream_stats;
+                app_audio_get_stream_stats(&stream_stats);
+                task_print_info("Streaming: %u of %u sound effects from external flash",
+                                app_audio_store_n_streamed(), AUDIO_SOUND_EFFECT_MAX);
+                task_print_info("Stream blocks: %lu read, %lu read errors, %lu underruns, min %lu of %u buffered",
+                                stream_stats.n_blocks_read,
+                                stream_stats.n_read_errors,
+                                stream_stats.n_underruns,
+                                stream_stats.min_fill,
+                                APP_AUDIO_STREAM_RING_BLOCKS);
+                break;
+            }
 
             default:
                 // Only commands above are supported
@@ -354,18 +600,370 @@ static BaseType_t cli_handler_audio_play_sound_effect(
 }
 
 
+/**
+ * @brief  FreeRTOS CLI Handler for the 'play_sound_effect_pitched' command
+ * 
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_audio_play_sound_effect_pitched(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    audio_packet_t audio_pkt = {0};
+    BaseType_t xReturn;
+
+    audio_pkt.cmd = AUDIO_PLAY_SOUND_EFFECT;
+
+    // Remove compile time warnings about unused parameters, and check the
+    // write buffer is not NULL.
+    // NOTE - for simplicity, this example assumes the write buffer length
+    // is adequate, so does not check for buffer overflows
+    (void)pcCommandString;
+    (void)xWriteBufferLen;
+    configASSERT(pcWriteBuffer);
+
+    // Get sound effect index, with validation
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "sound effect index",
+        1,
+        0,
+        AUDIO_SOUND_EFFECT_MAX - 1,
+        &audio_pkt.sound_effect_idx
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+
+    // Get pitch, with validation
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "pitch",
+        2,
+        AUDIO_MIN_PITCH_PCT,
+        AUDIO_MAX_PITCH_PCT,
+        &audio_pkt.pitch_pct
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+
+    // Send the message to the audio task
+    audio_pkt.return_queue = q_audio_cli_resp;
+    xQueueSendToBack(q_audio_cli_req, &audio_pkt, portMAX_DELAY);
+
+    // Wait for task to complete
+    xQueueReceive(q_audio_cli_resp, &audio_pkt, portMAX_DELAY);
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    xReturn = pdFALSE;
+    return xReturn;
+}
+
+
+/**
+ * @brief  FreeRTOS CLI Handler for the 'play_chirp' command
+ * 
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_audio_play_chirp(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    audio_packet_t audio_pkt = {0};
+    BaseType_t xReturn;
+
+    audio_pkt.cmd = AUDIO_PLAY_CHIRP;
+
+    // Remove compile time warnings about unused parameters, and check the
+    // write buffer is not NULL.
+    // NOTE - for simplicity, this example assumes the write buffer length
+    // is adequate, so does not check for buffer overflows
+    (void)pcCommandString;
+    (void)xWriteBufferLen;
+    configASSERT(pcWriteBuffer);
+
+    // Get frequencies, duration, and amplitude, with validation
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "start frequency",
+        1,
+        MIN_FREQ_HZ,
+        MAX_FREQ_HZ,
+        &audio_pkt.frequency
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "end frequency",
+        2,
+        MIN_FREQ_HZ,
+        MAX_FREQ_HZ,
+        &audio_pkt.frequency_end
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "duration",
+        3,
+        1,
+        AUDIO_CLI_WAIT_MS,
+        &audio_pkt.duration_ms
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "amplitude",
+        4,
+        MIN_AMP_mDB,
+        MAX_AMP_mDB,
+        &audio_pkt.amplitude
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+
+    // Send the message to the audio task
+    audio_pkt.return_queue = q_audio_cli_resp;
+    xQueueSendToBack(q_audio_cli_req, &audio_pkt, portMAX_DELAY);
+
+    // Wait for task to complete
+    xQueueReceive(q_audio_cli_resp, &audio_pkt, portMAX_DELAY);
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    xReturn = pdFALSE;
+    return xReturn;
+}
+
+
+/**
+ * @brief  FreeRTOS CLI Handler for the 'play_cue' command
+ * 
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_audio_play_cue(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    audio_packet_t audio_pkt = {0};
+    BaseType_t xReturn;
+
+    audio_pkt.cmd = AUDIO_PLAY_CUE;
+
+    // Remove compile time warnings about unused parameters, and check the
+    // write buffer is not NULL.
+    // NOTE - for simplicity, this example assumes the write buffer length
+    // is adequate, so does not check for buffer overflows
+    (void)pcCommandString;
+    (void)xWriteBufferLen;
+    configASSERT(pcWriteBuffer);
+
+    // Get cue index, with validation
+    xReturn = cli_handler_audio_get_and_check_uint_arg(
+        pcWriteBuffer,
+        xWriteBufferLen,
+        pcCommandString,
+        "cue index",
+        1,
+        0,
+        APP_AUDIO_CUE_MAX - 1,
+        &audio_pkt.cue_idx
+    );
+    if (xReturn == pdFALSE)
+    {
+        return xReturn;
+    }
+
+    // Send the message to the audio task
+    audio_pkt.return_queue = q_audio_cli_resp;
+    xQueueSendToBack(q_audio_cli_req, &audio_pkt, portMAX_DELAY);
+
+    // Wait for task to complete
+    xQueueReceive(q_audio_cli_resp, &audio_pkt, portMAX_DELAY);
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    xReturn = pdFALSE;
+    return xReturn;
+}
+
+
+/**
+ * @brief  FreeRTOS CLI Handler for the 'audio_stats' command. Prints the cost of
+ *         mixing each output block since the last time the command was run
+ * 
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_audio_stats(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    audio_packet_t audio_pkt = {0};
+
+    audio_pkt.cmd = AUDIO_PRINT_STATS;
+
+    // Remove compile time warnings about unused parameters, and check the
+    // write buffer is not NULL.
+    // NOTE - for simplicity, this example assumes the write buffer length
+    // is adequate, so does not check for buffer overflows
+    (void)pcCommandString;
+    (void)xWriteBufferLen;
+    configASSERT(pcWriteBuffer);
+
+    // Send the message to the audio task
+    audio_pkt.return_queue = q_audio_cli_resp;
+    xQueueSendToBack(q_audio_cli_req, &audio_pkt, portMAX_DELAY);
+
+    // Wait for task to complete
+    xQueueReceive(q_audio_cli_resp, &audio_pkt, portMAX_DELAY);
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+
 /******************************************************************************
  * Public Function Definitions                                                *
  ******************************************************************************/
+/**
+ * @brief  Wait for a requested sound effect to end
+ * 
+ * @param app_audio_handle_t
+ * Handle returned by app_audio_play_sound_effect
+ * @param TickType_t
+ * Most ticks to wait for
+ * @return app_audio_status_e
+ * How the sound effect ended, or APP_AUDIO_STATUS_QUEUED/PLAYING on timeout
+ */
+app_audio_status_e task_audio_wait_sound_effect(app_audio_handle_t handle, TickType_t timeout)
+{
+    const EventBits_t bit = (EventBits_t)1 << app_audio_scheduler_handle_slot(handle);
+    TimeOut_t xTimeOut;
+    app_audio_status_e status = app_audio_get_sound_effect_status(handle);
+
+    vTaskSetTimeOutState(&xTimeOut);
+    // The slot's bit may be left over from an earlier sound effect, so keep
+    // waiting until this one has actually ended
+    while (((APP_AUDIO_STATUS_QUEUED == status) || (APP_AUDIO_STATUS_PLAYING == status)) &&
+           (pdFALSE == xTaskCheckForTimeOut(&xTimeOut, &timeout)))
+    {
+        xEventGroupWaitBits(ev_audio_sound_effects, bit, pdTRUE, pdFALSE, timeout);
+        status = app_audio_get_sound_effect_status(handle);
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief  Set where the next hit came from, which sets the pitch of the hit
+ *         sound effect. Call it before requesting the sound effect
+ * 
+ * @param app_ir_hit_dir_e
+ * Direction of the hit
+ */
+void task_audio_set_hit_dir(app_ir_hit_dir_e dir)
+{
+    audio_hit_dir = (dir < APP_IR_HIT_DIR_MAX) ? dir : APP_IR_HIT_DIR_FRONT;
+}
+
+
 void task_audio_init(void)
 {
     // Create the Queues used to control the speaker/audio interface
     q_audio_cli_req  = xQueueCreate(1, sizeof(audio_packet_t));
     q_audio_cli_resp = xQueueCreate(1, sizeof(audio_packet_t));
 
+    // Report when sound effects end
+    ev_audio_sound_effects = xEventGroupCreate();
+    app_audio_set_completion_callback(task_audio_sound_effect_complete);
+
+    // Read streamed sound effects from external flash ahead of the mixer. This
+    // runs above the other audio tasks, since a late read is an audible gap
+    xTaskCreate(
+        task_audio_stream,
+        "Task_Audio_Stream",
+        configMINIMAL_STACK_SIZE,
+        NULL,
+        configMAX_PRIORITIES - 3,
+        &xTaskAudioStreamHandle
+    );
+    app_audio_set_stream_refill_callback(task_audio_stream_refill);
+
     // Register the CLI commands
     FreeRTOS_CLIRegisterCommand(&xAudioPlayTone);
     FreeRTOS_CLIRegisterCommand(&xAudioPlaySoundEffect);
+    FreeRTOS_CLIRegisterCommand(&xAudioPlaySoundEffectPitched);
+    FreeRTOS_CLIRegisterCommand(&xAudioPlayChirp);
+    FreeRTOS_CLIRegisterCommand(&xAudioPlayCue);
+    FreeRTOS_CLIRegisterCommand(&xAudioStats);
 
     // Create the task that will control audio via CLI
     xTaskCreate(
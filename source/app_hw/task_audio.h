@@ -36,13 +36,33 @@
 
 /* Include Project Specific Files */
 #include "task_console.h"
+#include "app_audio.h"
+#include "app_ir_hit.h"
 
 
+// Sound effects are requested by setting their bit in task_audio_car's notification
+// value (eSetBits), so effects requested back to back are all played
+#define AUDIO_SOUND_EFFECT_NOTIFY_BIT(E)    (1UL << (uint32_t)(E))
+// Range of pitches sound effects can be played at from the CLI (%)
+#define AUDIO_MIN_PITCH_PCT                 (25)
+#define AUDIO_MAX_PITCH_PCT                 (400)
+// The boost sound effect is raised by up to this much at full speed (%)
+#define AUDIO_BOOST_MAX_PITCH_UP_PCT        (25)
+// Pitch of the hit sound effect by where the hit came from (%). Hits from behind sound duller
+#define AUDIO_HIT_FRONT_PITCH_PCT           (100)
+#define AUDIO_HIT_SIDE_PITCH_PCT            (115)
+#define AUDIO_HIT_REAR_PITCH_PCT            (80)
+// Longest the CLI waits for a sound effect to end
+#define AUDIO_CLI_WAIT_MS                   (5000)
+
 // Audio command type
 typedef enum
 {
     AUDIO_PLAY_TONE  = 0,
-    AUDIO_PLAY_SOUND_EFFECT  = 1
+    AUDIO_PLAY_SOUND_EFFECT  = 1,
+    AUDIO_PRINT_STATS  = 2,
+    AUDIO_PLAY_CHIRP  = 3,
+    AUDIO_PLAY_CUE  = 4
 } audio_cmd_type_t;
 
 // Audio information to pass between CLI handler and audio task
@@ -50,8 +70,12 @@ typedef struct
 {
     audio_cmd_type_t cmd;
     uint32_t frequency;  // Frequency (Hz)
+    uint32_t frequency_end;  // Frequency at the end of a chirp (Hz)
+    uint32_t duration_ms;
     uint32_t amplitude;  // Amplitude (mdB)
     uint32_t sound_effect_idx;
+    uint32_t pitch_pct;  // Pitch of the sound effect (%), or 0 for its normal pitch
+    uint32_t cue_idx;
     QueueHandle_t return_queue;
 } audio_packet_t;
 
@@ -63,6 +87,8 @@ extern TaskHandle_t xTaskAudioHandle;
 
 
 void task_audio_init(void);
+void task_audio_set_hit_dir(app_ir_hit_dir_e dir);
+app_audio_status_e task_audio_wait_sound_effect(app_audio_handle_t handle, TickType_t timeout);
 
 
 #endif // __TASK_AUDIO_H__
@@ -42,6 +42,11 @@ static BaseType_t cli_handler_ble_get_item(
     size_t xWriteBufferLen,
     const char *pcCommandString
 );
+static BaseType_t cli_handler_ble_joystick_latency(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
 
 
 /******************************************************************************
@@ -96,6 +101,15 @@ static const CLI_Command_Definition_t xBleGetItem =
     0                            // The user can enter 0 parameters
 };
 
+// The CLI command definition for the joystick latency command
+static const CLI_Command_Definition_t xBleJoystickLatency =
+{
+    "joystick_latency",                  // Command text
+    "\r\njoystick_latency\r\n",          // Command help text
+    cli_handler_ble_joystick_latency,    // The function to run
+    0                                    // The user can enter 0 parameters
+};
+
 
 /******************************************************************************
  * Static Function Definitions                                                *
@@ -215,24 +229,18 @@ static void task_ble_cli(void *param)
         }
         else if (ble_packet.action == BLE_ACTION_READ_JOYSTICK)
         {
-            car_joystick_t joystick_val;
+            car_joystick_sample_t joystick = {0};
             uint32_t joystick_hex;
             car_item_t use_item_val;
             const car_item_t zero = 0;
 
             // Get the joystick x and y values from the client (hex is for demo purposes)
-            xQueueReceive(q_ble_car_joystick_y, &joystick_val, 0);
-            memcpy(&joystick_hex, &joystick_val, sizeof(car_joystick_t));
-            // TODO REMOVE
-            // memcpy(&joystick_val, &app_rc_controller_joystick_y, app_rc_controller_joystick_y_len);
-            // memcpy(&joystick_hex, &app_rc_controller_joystick_y, app_rc_controller_joystick_y_len);
-            task_print_info("Joystick Y value is %f (0x%0x)", joystick_val, joystick_hex);
-            xQueueReceive(q_ble_car_joystick_x, &joystick_val, 0);
-            memcpy(&joystick_hex, &joystick_val, sizeof(car_joystick_t));
-            // TODO REMOVE
-            // memcpy(&joystick_val, &app_rc_controller_joystick_x, app_rc_controller_joystick_x_len);
-            // memcpy(&joystick_hex, &app_rc_controller_joystick_x, app_rc_controller_joystick_x_len);
-            task_print_info("Joystick X value is %f (0x%0x)", joystick_val, joystick_hex);
+            // Peek, so the car still gets the sample
+            app_bt_car_get_joystick(&joystick);
+            memcpy(&joystick_hex, &joystick.y, sizeof(car_joystick_t));
+            task_print_info("Joystick Y value is %f (0x%0x)", joystick.y, joystick_hex);
+            memcpy(&joystick_hex, &joystick.x, sizeof(car_joystick_t));
+            task_print_info("Joystick X value is %f (0x%0x)", joystick.x, joystick_hex);
 
             // Get and reset use item value
             memcpy(&use_item_val, &app_rc_controller_use_item, app_rc_controller_use_item_len);
@@ -538,6 +546,60 @@ static BaseType_t cli_handler_ble_get_item(
     return pdFALSE;
 }
 
+/**
+ * @brief  FreeRTOS CLI Handler for the 'joystick_latency' command. Prints how
+ *         long joystick writes took to reach the motors since the command was
+ *         last run
+ * 
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_ble_joystick_latency(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    // Too big for the CLI task's stack
+    static car_joystick_latency_t latency;
+    static const char *const axis_names[CAR_JOYSTICK_AXIS_MAX] = {"Steering (X)", "Throttle (Y)"};
+
+    (void)pcCommandString;
+    configASSERT(pcWriteBuffer);
+
+    // From the GATT write to the servo or motor PWM being updated
+    for (uint32_t axis = 0; axis < CAR_JOYSTICK_AXIS_MAX; axis++)
+    {
+        app_bt_car_get_joystick_latency((car_joystick_axis_e)axis, &latency);
+        if (latency.hist.n > 0)
+        {
+            task_print_info("%s: %lu samples, %lu skipped, mean %lu us, p50 %lu us, p99 %lu us, max %lu us",
+                            axis_names[axis],
+                            latency.hist.n,
+                            latency.n_skipped,
+                            app_latency_mean(&latency.hist),
+                            app_latency_percentile(&latency.hist, 500),
+                            app_latency_percentile(&latency.hist, 990),
+                            latency.hist.max_us);
+        }
+        else
+        {
+            task_print_info("%s: no samples", axis_names[axis]);
+        }
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
 /******************************************************************************
  * Public Function Definitions                                                *
  ******************************************************************************/
@@ -553,6 +615,7 @@ void task_ble_init(void)
     FreeRTOS_CLIRegisterCommand(&xBleNotify);
     FreeRTOS_CLIRegisterCommand(&xBleReadJoystick);
     FreeRTOS_CLIRegisterCommand(&xBleGetItem);
+    FreeRTOS_CLIRegisterCommand(&xBleJoystickLatency);
 
     // Create the task that will control BLE via the CLI
     xTaskCreate(
@@ -1,6 +1,8 @@
 #include <FreeRTOS.h>
 #include <task.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "app_bt_car.h"
 #include "task_ir_led.h"
 #include "dc_motor.h"
@@ -8,28 +10,135 @@
 #include "task_console.h"
 #include "task_color_sensor.h"
 #include "task_car.h"
+#include "app_speed_ctrl.h"
+#include "wheel_speed.h"
+#include "app_clock.h"
+#include "app_bt_bonding.h"
 #include "data/audio_sample_luts.h"
 
-#define IR_RECEIVER_PIN_A P10_3
-#define IR_RECEIVER_PIN_B P10_4
-#define IR_RECEIVER_PIN_C P10_5
+// The tick timer counts microseconds, so its count when the task wakes up is the latency
+#define CAR_TICK_TIMER_HZ         (1000000)
+#define CAR_TICK_PERIOD_US        (CAR_TICK_TIMER_HZ / CAR_CONTROL_TICK_HZ)
+#define CAR_TICK_INTR_PRIORITY    (3)
+#define CAR_HIT_TICKS(ms)         ((ms) * CAR_CONTROL_TICK_HZ / 1000)
+// How long a hit stops the car, by where it came from. A side hit spins the car out, with the
+// wheels spinning down
+#define CAR_HIT_FRONT_MS          (5000)
+#define CAR_HIT_SIDE_MS           (4000)
+#define CAR_HIT_REAR_MS           (3000)
+#define CAR_SPEED_CTRL_TICKS      (CAR_CONTROL_TICK_HZ / APP_SPEED_CTRL_HZ)
+#define CAR_SPEED_CTRL_KV_KEY     "speed_ctrl"
+#define CAR_JOYSTICK_FILTER_KV_KEY    "joystick_filter"
+#define CAR_FAILSAFE_KV_KEY       "failsafe"
 
-#define RACE_INACTIVE_DELAY_MS    (50)
-#define IR_RECEIVER_THRESHOLD     (5)
+// Speed control settings, kept in kv-store so tuning survives a reset
+typedef struct {
+    app_speed_ctrl_gains_s gains;
+    bool closed_loop;
+} car_speed_ctrl_cfg_t;
+
+// Joystick conditioning for each axis, kept in kv-store so each car keeps its own feel
+typedef struct {
+    app_joystick_filter_cfg_s axis[CAR_JOYSTICK_AXIS_MAX];
+} car_joystick_filter_cfg_t;
 
 QueueHandle_t q_car;
 static TimerHandle_t speed_timer;
 static TimerHandle_t shield_timer;
 static TimerHandle_t pink_timer;
-static TimerHandle_t ir_receiver_timer;
 static TimerHandle_t i_frame_timer;
-static uint8_t ir_receiver_count[3] = {0,0,0};
 static bool speed_active = false;
 static bool shield_active = false;
 static bool can_get_new_powerup = true;
 
 static volatile bool i_am_hit = false;
+static volatile app_ir_hit_dir_e i_am_hit_dir = APP_IR_HIT_DIR_FRONT;
 static bool prev_i_am_hit = false;
+static const uint32_t car_hit_ticks[APP_IR_HIT_DIR_MAX] = {
+    [APP_IR_HIT_DIR_FRONT] = CAR_HIT_TICKS(CAR_HIT_FRONT_MS),
+    [APP_IR_HIT_DIR_SIDE]  = CAR_HIT_TICKS(CAR_HIT_SIDE_MS),
+    [APP_IR_HIT_DIR_REAR]  = CAR_HIT_TICKS(CAR_HIT_REAR_MS),
+};
+
+static TaskHandle_t car_task_handle;
+static cyhal_timer_t car_tick_timer;
+static car_loop_stats_t car_loop_stats;
+
+// Set by the CLI, and picked up by the car task on its next speed control step
+static car_speed_ctrl_cfg_t car_speed_ctrl_cfg;
+static volatile bool car_speed_ctrl_cfg_changed = false;
+// Only used by the car task
+static app_speed_ctrl_s car_speed_ctrl;
+static bool car_speed_ctrl_closed_loop = false;
+
+// Set by the CLI. Counts every change, so the car and servo tasks can each pick them up
+static car_joystick_filter_cfg_t car_joystick_filter_cfg;
+static volatile uint32_t car_joystick_filter_cfg_gen = 0;
+
+// Speed setpoint the motor is being driven at, for the servo task
+static volatile int32_t car_speed = 0;
+
+// Inputs are stamped by the BLE stack, and the rest is run by the car task
+static app_failsafe_s car_failsafe;
+// Set by the CLI, and picked up by the car task on its next tick
+static app_failsafe_cfg_s car_failsafe_cfg;
+static volatile bool car_failsafe_cfg_changed = false;
+// How long the last failsafe stop took, from tripping to a zero setpoint. Only written by the car task
+static volatile uint32_t car_failsafe_stop_ms = 0;
+static volatile app_failsafe_state_e car_failsafe_trip_reason = APP_FAILSAFE_STATE_OK;
+
+static BaseType_t cli_handler_car_loop_stats(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t cli_handler_speed_gains(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t cli_handler_speed_loop(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t cli_handler_joystick_filter(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t cli_handler_failsafe(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+// The CLI command definition for the control loop stats command
+static const CLI_Command_Definition_t xCarLoopStats =
+{
+    "car_loop_stats",                   // Command text
+    "\r\ncar_loop_stats\r\n",           // Command help text
+    cli_handler_car_loop_stats,         // The function to run
+    0                                   // The user can enter 0 parameters
+};
+
+// The CLI command definition for the speed control gains command
+static const CLI_Command_Definition_t xSpeedGains =
+{
+    "speed_gains",                                                       // Command text
+    "\r\nspeed_gains < kp > < ki > < kd >\r\n\tGains are in thousandths, and are saved\r\n",  // Command help text
+    cli_handler_speed_gains,                                             // The function to run
+    3                                                                    // The user can enter 3 parameters
+};
+
+// The CLI command definition for the speed control mode command
+static const CLI_Command_Definition_t xSpeedLoop =
+{
+    "speed_loop",                                                        // Command text
+    "\r\nspeed_loop < closed >\r\n\t1 for closed-loop speed control, 0 for open-loop (saved)\r\n",  // Command help text
+    cli_handler_speed_loop,                                              // The function to run
+    1                                                                    // The user can enter 1 parameter
+};
+
+// The CLI command definition for the joystick conditioning command
+static const CLI_Command_Definition_t xJoystickFilter =
+{
+    "joystick_filter",                                                   // Command text
+    "\r\njoystick_filter < x|y > < deadband > < expo > < alpha > < beta > < predict_ms >\r\n"
+    "\tAll but predict_ms are in thousandths, and are saved. 0 0 1000 0 0 is the raw joystick\r\n",  // Command help text
+    cli_handler_joystick_filter,                                         // The function to run
+    6                                                                    // The user can enter 6 parameters
+};
+
+// The CLI command definition for the link-loss failsafe command
+static const CLI_Command_Definition_t xFailsafe =
+{
+    "failsafe",                                                          // Command text
+    "\r\nfailsafe < deadline_ms > < decel >\r\n"
+    "\tStop once no input has come in for deadline_ms (0 only on disconnects), slowing by decel %/s (saved)\r\n",  // Command help text
+    cli_handler_failsafe,                                                // The function to run
+    2                                                                    // The user can enter 2 parameters
+};
 
 
 // disable speed boost when timer expires
@@ -44,29 +153,347 @@ void shield_timer_callback() {
 void pink_timer_callback() {
     can_get_new_powerup = true;
 }
-// count up if IR receivers are activated   
-void ir_receiver_timer_callback() {
-    // only check for hits when racing AND we have no shield AND we aren't hit
-    if ((race_state == RACE_STATE_ACTIVE) && !shield_active && !i_am_hit) {
-        // when IR receiver is activated, the pin is low
-        if (!cyhal_gpio_read(IR_RECEIVER_PIN_A)) {
-            ir_receiver_count[0]++;
-        }
-        if (!cyhal_gpio_read(IR_RECEIVER_PIN_B)) {
-            ir_receiver_count[1]++;
-        }
-        if (!cyhal_gpio_read(IR_RECEIVER_PIN_C)) {
-            ir_receiver_count[2]++;
-        }
-        // check if any pins counted a hit
-        if (ir_receiver_count[0] > IR_RECEIVER_THRESHOLD || ir_receiver_count[1] > IR_RECEIVER_THRESHOLD || ir_receiver_count[2] > IR_RECEIVER_THRESHOLD) {
-            i_am_hit = true;
-            // reset all counts
-            ir_receiver_count[0] = 0;
-            ir_receiver_count[1] = 0;
-            ir_receiver_count[2] = 0;
+// wake the car task for the next tick of the control loop
+static void car_tick_isr(void *callback_arg, cyhal_timer_event_t event) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void)callback_arg;
+    (void)event;
+
+    vTaskNotifyGiveFromISR(car_task_handle, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+// record how late the task woke up for a tick, and how long the tick took
+static void car_loop_stats_update(uint32_t n_ticks, uint32_t start_us, uint32_t end_us) {
+    const uint32_t work_us = (end_us >= start_us) ? (end_us - start_us) : (end_us + CAR_TICK_PERIOD_US - start_us);
+
+    taskENTER_CRITICAL();
+    car_loop_stats.n_ticks += n_ticks;
+    car_loop_stats.n_missed_ticks += n_ticks - 1;
+    if ((car_loop_stats.n_wakeups == 0) || (start_us < car_loop_stats.min_latency_us)) {
+        car_loop_stats.min_latency_us = start_us;
+    }
+    if (start_us > car_loop_stats.max_latency_us) {
+        car_loop_stats.max_latency_us = start_us;
+    }
+    car_loop_stats.total_latency_us += start_us;
+    car_loop_stats.n_wakeups++;
+    if (work_us > car_loop_stats.max_work_us) {
+        car_loop_stats.max_work_us = work_us;
+    }
+    taskEXIT_CRITICAL();
+}
+
+// measure the wheel speed and run the speed controller, picking up any new settings from the CLI
+static int32_t car_speed_ctrl_step(float32_t scaled_speed) {
+    const int32_t setpoint = (int32_t)scaled_speed;
+    uint32_t n_edges;
+    uint32_t last_edge_us;
+    uint32_t now_us;
+
+    if (car_speed_ctrl_cfg_changed) {
+        taskENTER_CRITICAL();
+        const car_speed_ctrl_cfg_t cfg = car_speed_ctrl_cfg;
+        car_speed_ctrl_cfg_changed = false;
+        taskEXIT_CRITICAL();
+
+        app_speed_ctrl_set_gains(&car_speed_ctrl, &cfg.gains);
+        if (cfg.closed_loop != car_speed_ctrl_closed_loop) {
+            app_speed_ctrl_reset(&car_speed_ctrl);
+            car_speed_ctrl_closed_loop = cfg.closed_loop;
         }
     }
+
+    // Measure open-loop too, so the wheel sensor can be checked over the CLI before closing the loop
+    wheel_speed_read(&n_edges, &last_edge_us, &now_us);
+    app_speed_ctrl_measure(&car_speed_ctrl, n_edges, last_edge_us, now_us);
+
+    if (!car_speed_ctrl_closed_loop || (abs(setpoint) <= DC_MOTOR_MIN_DUTY)) {
+        app_speed_ctrl_reset(&car_speed_ctrl);
+        return setpoint;
+    }
+    return app_speed_ctrl_update(&car_speed_ctrl, setpoint);
+}
+
+// get the duty cycle to drive the motor at for a setpoint. The speed controller runs every
+// CAR_SPEED_CTRL_TICKS ticks, and its output is held in between
+static float32_t car_speed_ctrl_duty(float32_t scaled_speed, uint32_t n_ticks) {
+    static uint32_t ticks = 0;
+    static int32_t ctrl_duty = 0;
+
+    ticks += n_ticks;
+    if (ticks >= CAR_SPEED_CTRL_TICKS) {
+        ticks = 0;
+        ctrl_duty = car_speed_ctrl_step(scaled_speed);
+    }
+    // Open-loop, and stopping, follow the setpoint on every tick
+    if (!car_speed_ctrl_closed_loop || (fabs(scaled_speed) <= DC_MOTOR_MIN_DUTY)) {
+        return scaled_speed;
+    }
+    return (float32_t)ctrl_duty;
+}
+
+// save new speed control settings, and hand them to the car task
+static void car_speed_ctrl_save(const car_speed_ctrl_cfg_t *cfg) {
+    taskENTER_CRITICAL();
+    car_speed_ctrl_cfg = *cfg;
+    car_speed_ctrl_cfg_changed = true;
+    taskEXIT_CRITICAL();
+
+    if (CY_RSLT_SUCCESS != mtb_kvstore_write(&kvstore_obj, CAR_SPEED_CTRL_KV_KEY, (uint8_t *)cfg, sizeof(*cfg))) {
+        task_print_error("Couldn't save the speed control settings");
+    }
+}
+
+// save new joystick conditioning settings, and hand them to the car and servo tasks
+static void car_joystick_filter_save(const car_joystick_filter_cfg_t *cfg) {
+    taskENTER_CRITICAL();
+    car_joystick_filter_cfg = *cfg;
+    car_joystick_filter_cfg_gen++;
+    taskEXIT_CRITICAL();
+
+    if (CY_RSLT_SUCCESS != mtb_kvstore_write(&kvstore_obj, CAR_JOYSTICK_FILTER_KV_KEY, (uint8_t *)cfg, sizeof(*cfg))) {
+        task_print_error("Couldn't save the joystick settings");
+    }
+}
+
+// save new failsafe settings, and hand them to the car task
+static void car_failsafe_save(const app_failsafe_cfg_s *cfg) {
+    taskENTER_CRITICAL();
+    car_failsafe_cfg = *cfg;
+    car_failsafe_cfg_changed = true;
+    taskEXIT_CRITICAL();
+
+    if (CY_RSLT_SUCCESS != mtb_kvstore_write(&kvstore_obj, CAR_FAILSAFE_KV_KEY, (uint8_t *)cfg, sizeof(*cfg))) {
+        task_print_error("Couldn't save the failsafe settings");
+    }
+}
+
+// parse the parameter at argidx as a whole number between argmin and argmax
+static BaseType_t cli_car_get_long_arg(const char *pcCommandString, UBaseType_t argidx, long argmin, long argmax, long *arg) {
+    BaseType_t xParameterStringLength;
+    char param[16] = {0};
+    char *end_ptr;
+
+    const char *pcParameter = FreeRTOS_CLIGetParameter(pcCommandString, argidx, &xParameterStringLength);
+    configASSERT(pcParameter);
+    strncat(param, pcParameter, (xParameterStringLength < (BaseType_t)sizeof(param)) ? (size_t)xParameterStringLength : sizeof(param) - 1);
+
+    *arg = strtol(param, &end_ptr, 10);
+    if ((*end_ptr != '\0') || (*arg < argmin) || (*arg > argmax)) {
+        task_print_error("Invalid parameter %lu, %s. Must be between %li and %li", argidx, param, argmin, argmax);
+        return pdFALSE;
+    }
+    return pdTRUE;
+}
+
+// print the control loop's timing since the last time the command was run
+static BaseType_t cli_handler_car_loop_stats(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    car_loop_stats_t stats;
+    (void)pcCommandString;
+    configASSERT(pcWriteBuffer);
+
+    task_car_get_loop_stats(&stats);
+    if (stats.n_wakeups > 0) {
+        task_print_info("Control loop: %lu ticks at %u Hz, %lu missed", stats.n_ticks, CAR_CONTROL_TICK_HZ, stats.n_missed_ticks);
+        task_print_info("Wake-up latency: min %lu us, avg %lu us, max %lu us (jitter %lu us)",
+                        stats.min_latency_us,
+                        (uint32_t)(stats.total_latency_us / stats.n_wakeups),
+                        stats.max_latency_us,
+                        stats.max_latency_us - stats.min_latency_us);
+        // Inputs are read at the start of a tick and the PWM is written before it ends
+        task_print_info("Longest tick: %lu us, so input to PWM takes at most %lu us",
+                        stats.max_work_us, stats.max_latency_us + stats.max_work_us);
+    } else {
+        task_print_info("Control loop hasn't run");
+    }
+    task_print_info("Speed control: %s, kp %li, ki %li, kd %li (thousandths)",
+                    car_speed_ctrl_cfg.closed_loop ? "closed-loop" : "open-loop",
+                    APP_SPEED_CTRL_GAIN_TO_MILLI(car_speed_ctrl_cfg.gains.kp),
+                    APP_SPEED_CTRL_GAIN_TO_MILLI(car_speed_ctrl_cfg.gains.ki),
+                    APP_SPEED_CTRL_GAIN_TO_MILLI(car_speed_ctrl_cfg.gains.kd));
+    task_print_info("Wheel speed: %li pulses/s (target %li pulses/s)",
+                    car_speed_ctrl.speed >> APP_SPEED_CTRL_SPEED_SHIFT,
+                    car_speed_ctrl.target >> APP_SPEED_CTRL_SPEED_SHIFT);
+    for (uint32_t axis = 0; axis < CAR_JOYSTICK_AXIS_MAX; axis++) {
+        const app_joystick_filter_cfg_s *cfg = &car_joystick_filter_cfg.axis[axis];
+        task_print_info("Joystick %c: deadband %u, expo %u, alpha %u, beta %u (thousandths), predict %u ms",
+                        (axis == CAR_JOYSTICK_AXIS_X) ? 'x' : 'y',
+                        cfg->deadband, cfg->expo, cfg->alpha, cfg->beta, cfg->predict_ms);
+    }
+    task_print_info("Failsafe: deadline %u ms, decel %u%%/s, link %s, last input %lu ms ago",
+                    car_failsafe_cfg.deadline_ms, car_failsafe_cfg.decel,
+                    car_failsafe.connected ? "up" : "down",
+                    app_failsafe_age_us(&car_failsafe, app_clock_us()) / 1000);
+    if (car_failsafe.n_trips > 0) {
+        task_print_info("Failsafe tripped %lu times, last on %s, and took %lu ms to stop",
+                        car_failsafe.n_trips,
+                        (car_failsafe_trip_reason == APP_FAILSAFE_STATE_LINK_DOWN) ? "disconnect" : "stale input",
+                        car_failsafe_stop_ms);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+// set the speed controller's gains
+static BaseType_t cli_handler_speed_gains(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    car_speed_ctrl_cfg_t cfg = car_speed_ctrl_cfg;
+    long kp;
+    long ki;
+    long kd;
+    configASSERT(pcWriteBuffer);
+
+    if ((pdTRUE == cli_car_get_long_arg(pcCommandString, 1, 0, 100000, &kp)) &&
+        (pdTRUE == cli_car_get_long_arg(pcCommandString, 2, 0, 100000, &ki)) &&
+        (pdTRUE == cli_car_get_long_arg(pcCommandString, 3, 0, 100000, &kd))) {
+        cfg.gains.kp = APP_SPEED_CTRL_GAIN_FROM_MILLI(kp);
+        cfg.gains.ki = APP_SPEED_CTRL_GAIN_FROM_MILLI(ki);
+        cfg.gains.kd = APP_SPEED_CTRL_GAIN_FROM_MILLI(kd);
+        car_speed_ctrl_save(&cfg);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+// switch between closed- and open-loop speed control
+static BaseType_t cli_handler_speed_loop(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    car_speed_ctrl_cfg_t cfg = car_speed_ctrl_cfg;
+    long closed_loop;
+    configASSERT(pcWriteBuffer);
+
+    if (pdTRUE == cli_car_get_long_arg(pcCommandString, 1, 0, 1, &closed_loop)) {
+        cfg.closed_loop = (closed_loop != 0);
+        car_speed_ctrl_save(&cfg);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+// set how one joystick axis is conditioned
+static BaseType_t cli_handler_joystick_filter(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    car_joystick_filter_cfg_t cfg = car_joystick_filter_cfg;
+    BaseType_t xParameterStringLength;
+    long deadband;
+    long expo;
+    long alpha;
+    long beta;
+    long predict_ms;
+    configASSERT(pcWriteBuffer);
+
+    const char *pcParameter = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameterStringLength);
+    configASSERT(pcParameter);
+    if ((xParameterStringLength != 1) || ((pcParameter[0] != 'x') && (pcParameter[0] != 'y'))) {
+        task_print_error("Invalid axis. Must be x or y");
+    } else if ((pdTRUE == cli_car_get_long_arg(pcCommandString, 2, 0, APP_JOYSTICK_FILTER_ONE - 1, &deadband)) &&
+               (pdTRUE == cli_car_get_long_arg(pcCommandString, 3, 0, APP_JOYSTICK_FILTER_ONE, &expo)) &&
+               (pdTRUE == cli_car_get_long_arg(pcCommandString, 4, 0, APP_JOYSTICK_FILTER_ONE, &alpha)) &&
+               (pdTRUE == cli_car_get_long_arg(pcCommandString, 5, 0, APP_JOYSTICK_FILTER_ONE, &beta)) &&
+               (pdTRUE == cli_car_get_long_arg(pcCommandString, 6, 0, 1000, &predict_ms))) {
+        app_joystick_filter_cfg_s *axis_cfg = &cfg.axis[(pcParameter[0] == 'x') ? CAR_JOYSTICK_AXIS_X : CAR_JOYSTICK_AXIS_Y];
+        axis_cfg->deadband = (uint16_t)deadband;
+        axis_cfg->expo = (uint16_t)expo;
+        axis_cfg->alpha = (uint16_t)alpha;
+        axis_cfg->beta = (uint16_t)beta;
+        axis_cfg->predict_ms = (uint16_t)predict_ms;
+        car_joystick_filter_save(&cfg);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+// set the link-loss failsafe's deadline and deceleration
+static BaseType_t cli_handler_failsafe(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    app_failsafe_cfg_s cfg;
+    long deadline_ms;
+    long decel;
+    configASSERT(pcWriteBuffer);
+
+    if ((pdTRUE == cli_car_get_long_arg(pcCommandString, 1, 0, 10000, &deadline_ms)) &&
+        (pdTRUE == cli_car_get_long_arg(pcCommandString, 2, 1, 10000, &decel))) {
+        cfg.deadline_ms = (uint16_t)deadline_ms;
+        cfg.decel = (uint16_t)decel;
+        car_failsafe_save(&cfg);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+// note that an input came in from the RC controller app. Called by the BLE stack
+void task_car_link_input(app_failsafe_input_e input) {
+    app_failsafe_input(&car_failsafe, input, app_clock_us());
+}
+
+// note that the RC controller app connected. Called by the BLE stack
+void task_car_link_up(void) {
+    app_failsafe_link_up(&car_failsafe, app_clock_us());
+}
+
+// note that the RC controller app disconnected. Called by the BLE stack, and the car starts stopping on the next tick
+void task_car_link_down(void) {
+    app_failsafe_link_down(&car_failsafe);
+}
+
+// check whether the car may be driven, or the failsafe is stopping it
+bool task_car_link_ok(void) {
+    return car_failsafe.state == APP_FAILSAFE_STATE_OK;
+}
+
+// get the joystick conditioning settings for an axis if they've changed since *gen, which
+// starts at 0. Returns true if they were copied
+bool task_car_get_joystick_filter_cfg(car_joystick_axis_e axis, uint32_t *gen, app_joystick_filter_cfg_s *cfg) {
+    bool changed = false;
+
+    taskENTER_CRITICAL();
+    if (*gen != car_joystick_filter_cfg_gen) {
+        *cfg = car_joystick_filter_cfg.axis[axis];
+        *gen = car_joystick_filter_cfg_gen;
+        changed = true;
+    }
+    taskEXIT_CRITICAL();
+    return changed;
+}
+
+// take a shot seen by the IR receivers, if the car can be hit right now. dir is where it came
+// from, which sets the penalty. Called by the IR receiver task. Returns true if the car was hit
+bool task_car_ir_hit(const app_ir_rx_hit_s *hit, app_ir_hit_dir_e dir) {
+    (void)hit;
+
+    // only take hits when racing AND we have no shield AND we aren't hit
+    if ((race_state == RACE_STATE_ACTIVE) && !shield_active && !i_am_hit) {
+        // the direction must be in place before the car task sees the hit
+        i_am_hit_dir = (dir < APP_IR_HIT_DIR_MAX) ? dir : APP_IR_HIT_DIR_FRONT;
+        i_am_hit = true;
+        return true;
+    }
+    return false;
+}
+
+// get the speed setpoint (duty cycle, %) the car is being driven at. 0 while stopped
+int32_t task_car_get_speed(void) {
+    return car_speed;
+}
+
+// get the control loop's timing, and start measuring again
+void task_car_get_loop_stats(car_loop_stats_t *stats) {
+    taskENTER_CRITICAL();
+    *stats = car_loop_stats;
+    memset(&car_loop_stats, 0, sizeof(car_loop_stats));
+    taskEXIT_CRITICAL();
 }
 
 void task_car_init() {
@@ -91,12 +518,6 @@ void task_car_init() {
                             ( void * ) 0,                /* The ID is used to store a count of the number of times the timer has expired, which is initialised to 0. */
                             pink_timer_callback         // callback function
                             );
-    ir_receiver_timer = xTimerCreate("ir_receiver_timer",            // name
-                            pdMS_TO_TICKS(10),          // check ir receivers every 10ms
-                            pdTRUE,                     // timer repeats
-                            ( void * ) 0,               /* The ID is used to store a count of the number of times the timer has expired, which is initialised to 0. */
-                            ir_receiver_timer_callback         // callback function
-                            );
     i_frame_timer = xTimerCreate("i_frame_timer",            // name
                             pdMS_TO_TICKS(1000),          // give car shield for 1 second so it can't disable itself
                             pdFALSE,                     // one shot timer
@@ -105,17 +526,68 @@ void task_car_init() {
                             );
 
 
-    // initialize the THREE (3) IR Receiver pins as GPIO input
     cy_rslt_t rslt1;
-    rslt1 = cyhal_gpio_init(IR_RECEIVER_PIN_A, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, false);
-    CY_ASSERT(CY_RSLT_SUCCESS == rslt1);
 
-    rslt1 = cyhal_gpio_init(IR_RECEIVER_PIN_B, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, false);
+    // initialize the timer that ticks the control loop
+    const cyhal_timer_cfg_t tick_cfg = {
+        .compare_value = 0,
+        .period = CAR_TICK_PERIOD_US - 1,
+        .direction = CYHAL_TIMER_DIR_UP,
+        .is_compare = false,
+        .is_continuous = true,
+        .value = 0
+    };
+    rslt1 = cyhal_timer_init(&car_tick_timer, NC, NULL);
     CY_ASSERT(CY_RSLT_SUCCESS == rslt1);
-
-    rslt1 = cyhal_gpio_init(IR_RECEIVER_PIN_C, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, false);
+    rslt1 = cyhal_timer_configure(&car_tick_timer, &tick_cfg);
     CY_ASSERT(CY_RSLT_SUCCESS == rslt1);
+    rslt1 = cyhal_timer_set_frequency(&car_tick_timer, CAR_TICK_TIMER_HZ);
+    CY_ASSERT(CY_RSLT_SUCCESS == rslt1);
+    cyhal_timer_register_callback(&car_tick_timer, car_tick_isr, NULL);
+    cyhal_timer_enable_event(&car_tick_timer, CYHAL_TIMER_IRQ_TERMINAL_COUNT, CAR_TICK_INTR_PRIORITY, true);
 
+    // load the speed control settings, which start open-loop until the wheel sensor is known to work
+    uint32_t cfg_size = sizeof(car_speed_ctrl_cfg);
+    if ((CY_RSLT_SUCCESS != mtb_kvstore_read(&kvstore_obj, CAR_SPEED_CTRL_KV_KEY, (uint8_t *)&car_speed_ctrl_cfg, &cfg_size)) ||
+        (cfg_size != sizeof(car_speed_ctrl_cfg))) {
+        car_speed_ctrl_cfg.gains.kp = APP_SPEED_CTRL_GAIN_FROM_MILLI(APP_SPEED_CTRL_DEFAULT_KP);
+        car_speed_ctrl_cfg.gains.ki = APP_SPEED_CTRL_GAIN_FROM_MILLI(APP_SPEED_CTRL_DEFAULT_KI);
+        car_speed_ctrl_cfg.gains.kd = APP_SPEED_CTRL_GAIN_FROM_MILLI(APP_SPEED_CTRL_DEFAULT_KD);
+        car_speed_ctrl_cfg.closed_loop = false;
+    }
+    app_speed_ctrl_init(&car_speed_ctrl, &car_speed_ctrl_cfg.gains, APP_SPEED_CTRL_MAX_PPS);
+    car_speed_ctrl_closed_loop = car_speed_ctrl_cfg.closed_loop;
+
+    // load this car's joystick conditioning
+    cfg_size = sizeof(car_joystick_filter_cfg);
+    if ((CY_RSLT_SUCCESS != mtb_kvstore_read(&kvstore_obj, CAR_JOYSTICK_FILTER_KV_KEY, (uint8_t *)&car_joystick_filter_cfg, &cfg_size)) ||
+        (cfg_size != sizeof(car_joystick_filter_cfg))) {
+        const car_joystick_filter_cfg_t default_cfg = {
+            .axis = {
+                [CAR_JOYSTICK_AXIS_X] = APP_JOYSTICK_FILTER_DEFAULT_STEERING,
+                [CAR_JOYSTICK_AXIS_Y] = APP_JOYSTICK_FILTER_DEFAULT_THROTTLE
+            }
+        };
+        car_joystick_filter_cfg = default_cfg;
+    }
+    taskENTER_CRITICAL();
+    car_joystick_filter_cfg_gen++;
+    taskEXIT_CRITICAL();
+
+    // load this car's failsafe settings
+    cfg_size = sizeof(car_failsafe_cfg);
+    if ((CY_RSLT_SUCCESS != mtb_kvstore_read(&kvstore_obj, CAR_FAILSAFE_KV_KEY, (uint8_t *)&car_failsafe_cfg, &cfg_size)) ||
+        (cfg_size != sizeof(car_failsafe_cfg))) {
+        car_failsafe_cfg.deadline_ms = APP_FAILSAFE_DEFAULT_DEADLINE_MS;
+        car_failsafe_cfg.decel = APP_FAILSAFE_DEFAULT_DECEL;
+    }
+    app_failsafe_init(&car_failsafe, &car_failsafe_cfg, app_clock_us());
+
+    FreeRTOS_CLIRegisterCommand(&xCarLoopStats);
+    FreeRTOS_CLIRegisterCommand(&xSpeedGains);
+    FreeRTOS_CLIRegisterCommand(&xSpeedLoop);
+    FreeRTOS_CLIRegisterCommand(&xJoystickFilter);
+    FreeRTOS_CLIRegisterCommand(&xFailsafe);
 
     // create the task
     BaseType_t rslt = xTaskCreate(task_car,
@@ -123,7 +595,7 @@ void task_car_init() {
                                   configMINIMAL_STACK_SIZE * 8,
                                   NULL,
                                   configMAX_PRIORITIES - 5,
-                                  NULL);
+                                  &car_task_handle);
     if (rslt == pdPASS) {
         task_print("CAR task created\n\r");
     }
@@ -136,21 +608,62 @@ void task_car_init() {
 
 void task_car(void *pvParameters) {
     car_joystick_t y = 0;
-    float32_t prev_scaled_speed = y;
-    uint8_t dir = STOPPED;
-    turn_dc_motor_off();
+    car_joystick_sample_t joystick;
+    uint32_t joystick_seq = 0;
+    const app_joystick_filter_cfg_s default_filter_cfg = APP_JOYSTICK_FILTER_DEFAULT_THROTTLE;
+    app_joystick_filter_cfg_s filter_cfg;
+    uint32_t filter_cfg_gen = 0;
+    app_joystick_filter_s filter;
+    float32_t curr_scaled_speed = 0;
     uint8_t speed = 0; 
     color_sensor_terrain_t terrain = BROWN_ROAD;
     color_sensor_terrain_t prev_terrain = BROWN_ROAD;
     car_item_t powerup = CAR_ITEM_MIN;
-    bool restore_after_hit = false;
-    // start the ir_receiver_timer
-    xTimerStart(ir_receiver_timer, 0);
+    uint32_t hit_ticks_left = 0;
+    app_ir_hit_dir_e hit_dir = APP_IR_HIT_DIR_FRONT;
+    bool engine_running = false;
+    bool stopping = false;
+    // start ticking the control loop
+    cy_rslt_t rslt = cyhal_timer_start(&car_tick_timer);
+    CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+    app_joystick_filter_init(&filter, &default_filter_cfg);
     
     while(1) {
+        // Run once per tick. Nothing below may block, so every input is handled on the
+        // tick it arrives and the PWM is updated on a fixed schedule
+        const uint32_t n_ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const uint32_t start_us = cyhal_timer_read(&car_tick_timer);
+        const uint32_t elapsed_ms = n_ticks * 1000 / CAR_CONTROL_TICK_HZ;
+
+        // Check the link on every tick, so a disconnect is acted on straight away
+        if (car_failsafe_cfg_changed) {
+            taskENTER_CRITICAL();
+            const app_failsafe_cfg_s cfg = car_failsafe_cfg;
+            car_failsafe_cfg_changed = false;
+            taskEXIT_CRITICAL();
+            app_failsafe_set_cfg(&car_failsafe, &cfg);
+        }
+        const uint32_t n_trips = car_failsafe.n_trips;
+        const bool link_ok = (APP_FAILSAFE_STATE_OK == app_failsafe_update(&car_failsafe, app_clock_us()));
+        if (car_failsafe.n_trips != n_trips) {
+            car_failsafe_trip_reason = car_failsafe.state;
+            stopping = true;
+        }
+
         if (race_state == RACE_STATE_ACTIVE) {
+            if (!engine_running) {
+                // Idle the engine sound until we start moving
+                app_audio_engine_set(true, 0);
+                engine_running = true;
+            }
             if (!prev_i_am_hit && i_am_hit) {
-                xTaskNotify(xTaskAudioHandle, (uint32_t)AUDIO_SOUND_EFFECT_HIT, eSetValueWithOverwrite);
+                hit_dir = i_am_hit_dir;
+                task_audio_set_hit_dir(hit_dir);
+                xTaskNotify(xTaskAudioHandle, AUDIO_SOUND_EFFECT_NOTIFY_BIT(AUDIO_SOUND_EFFECT_HIT), eSetBits);
+                // Stop dead, and start again from standstill once the hit wears off
+                hit_ticks_left = car_hit_ticks[hit_dir];
+                curr_scaled_speed = 0;
+                app_speed_ctrl_reset(&car_speed_ctrl);
             }
             prev_i_am_hit = i_am_hit;
 
@@ -174,7 +687,7 @@ void task_car(void *pvParameters) {
                 }
             }
             // keep receiving from color sensor so as to not get stale values
-            xQueueReceive(q_color_sensor, &terrain, 10);
+            xQueueReceive(q_color_sensor, &terrain, 0);
             // we still want to get power ups even if we are under influence of speed boost
             if (terrain == PINK) {
                 // give powerup
@@ -197,7 +710,7 @@ void task_car(void *pvParameters) {
                         speed_active = true;
                         // Start timer to make sure speed boost deactivates in 5 sec
                         xTimerStart(speed_timer, 0);
-                        xTaskNotify(xTaskAudioHandle, (uint32_t)AUDIO_SOUND_EFFECT_BOOST, eSetValueWithOverwrite);
+                        xTaskNotify(xTaskAudioHandle, AUDIO_SOUND_EFFECT_NOTIFY_BIT(AUDIO_SOUND_EFFECT_BOOST), eSetBits);
                         break;
                     case BROWN_ROAD:
                         speed = 50;
@@ -214,67 +727,82 @@ void task_car(void *pvParameters) {
             }
             prev_terrain = terrain;
 
-            if (i_am_hit) {
-                turn_dc_motor_off();
-                vTaskDelay(pdMS_TO_TICKS(5000)); // TODO Replacce with timer like the power ups
-                i_am_hit = false;
-                restore_after_hit = true;
+            // Take the newest joystick value, and condition it. Between samples the filter carries on
+            // from the last one, so a late packet doesn't stall the car. Only a Y write is a new
+            // sample, so an X write never feeds the filter a stale repeat
+            const bool new_sample = (pdTRUE == app_bt_car_get_joystick(&joystick)) && (joystick.seq[CAR_JOYSTICK_AXIS_Y] != joystick_seq);
+            if (task_car_get_joystick_filter_cfg(CAR_JOYSTICK_AXIS_Y, &filter_cfg_gen, &filter_cfg)) {
+                app_joystick_filter_set_cfg(&filter, &filter_cfg);
+            }
+            if (link_ok) {
+                y = app_joystick_filter_update(&filter, new_sample, joystick.y, app_clock_us());
             } else {
-                // Wait for twice the expected write period from the RC controller
-                xQueueReceive(q_ble_car_joystick_y, &y, pdMS_TO_TICKS(200));
-
-                float32_t scaled_speed = speed * y;
-
-                if (restore_after_hit || (fabs(scaled_speed - prev_scaled_speed) > DC_MOTOR_RAMP_STEP_VAL)) {
-                    int ramp_dir_scalar = 1;
-                    if (scaled_speed < prev_scaled_speed) {
-                        // Ramping in negative direction, if needed
-                        ramp_dir_scalar = -1;
-                    }
+                // Start again from the first sample once the link is back
+                app_joystick_filter_reset(&filter);
+                y = 0;
+            }
 
-                    // Ramp to setpoint
-                    float32_t curr_scaled_speed = prev_scaled_speed;
-                    bool reached_target;
-                    do {
-                        reached_target = fabs(scaled_speed - curr_scaled_speed) < DC_MOTOR_RAMP_STEP_VAL;
-
-                        if (reached_target) {
-                            curr_scaled_speed = scaled_speed;
-                        } else {
-                            curr_scaled_speed += DC_MOTOR_RAMP_STEP_VAL * ramp_dir_scalar;
-                        }
-
-                        if (fabs(curr_scaled_speed) > DC_MOTOR_MIN_DUTY) {
-                            if ((curr_scaled_speed >= 0) && (dir != FORWARD)) {
-                                dir = FORWARD;
-                                set_dc_motor_direction(dir);
-                            } else if ((curr_scaled_speed < 0) && (dir != REVERSE)) {
-                                dir = REVERSE;
-                                set_dc_motor_direction(dir);
-                            }
-
-                            set_dc_motor_duty_cycle(fabs(curr_scaled_speed));
-                        } else if (dir != STOPPED) {
-                            dir = STOPPED;
-                            turn_dc_motor_off();
-                        }
-
-                        if (!reached_target) {
-                            vTaskDelay(pdMS_TO_TICKS(DC_MOTOR_RAMP_STEP_MS));
-                        }
-                    } while (!reached_target);
-
-                    prev_scaled_speed = scaled_speed;
-                    restore_after_hit = false;
+            if (i_am_hit) {
+                // Stay stopped until the hit wears off
+                dc_motor_drive(0, DC_MOTOR_BRAKE_ON_HIT, elapsed_ms);
+                // Count off every tick that passed, so missed ticks don't stretch the penalty
+                hit_ticks_left = (hit_ticks_left > n_ticks) ? (hit_ticks_left - n_ticks) : 0;
+                if (hit_ticks_left == 0) {
+                    i_am_hit = false;
                 }
+            } else if (!link_ok) {
+                // Lost the RC controller app, so slow down on the failsafe's profile and brake to a stop
+                curr_scaled_speed = app_failsafe_decel(&car_failsafe, curr_scaled_speed, elapsed_ms);
+                dc_motor_drive((int32_t)car_speed_ctrl_duty(curr_scaled_speed, n_ticks), true, elapsed_ms);
+            } else {
+                // Slew towards the setpoint by at most one step per tick, including any missed ticks,
+                // so the ramp rate stays fixed
+                const float32_t scaled_speed = speed * y;
+                const float32_t max_step = (float32_t)(DC_MOTOR_RAMP_STEP_VAL * n_ticks);
+                if (fabs(scaled_speed - curr_scaled_speed) <= max_step) {
+                    curr_scaled_speed = scaled_speed;
+                } else if (scaled_speed > curr_scaled_speed) {
+                    curr_scaled_speed += max_step;
+                } else {
+                    curr_scaled_speed -= max_step;
+                }
+                // Brakes when the joystick returns to neutral
+                dc_motor_drive((int32_t)car_speed_ctrl_duty(curr_scaled_speed, n_ticks), DC_MOTOR_BRAKE_ON_NEUTRAL, elapsed_ms);
+            }
+            if (new_sample) {
+                // The PWM has been written, so the sample has reached the motor
+                if (link_ok) {
+                    app_bt_car_joystick_applied(CAR_JOYSTICK_AXIS_Y, &joystick, joystick_seq);
+                }
+                joystick_seq = joystick.seq[CAR_JOYSTICK_AXIS_Y];
+            }
+            // Lock-free, so the loop never waits on the audio driver. Spinning out, the wheels
+            // scream and wind down with the hit
+            if (i_am_hit && (hit_dir == APP_IR_HIT_DIR_SIDE)) {
+                app_audio_engine_set(true, (uint8_t)((APP_AUDIO_ENGINE_MAX_SPEED * hit_ticks_left) / car_hit_ticks[hit_dir]));
+            } else {
+                app_audio_engine_set(true, (uint8_t)fabs(curr_scaled_speed));
             }
         } else {
-            // Idle while we're waiting for the race to start
-            if (dir != STOPPED) {
-                dir = STOPPED;
-                turn_dc_motor_off();
+            // Idle while we're waiting for the race to start. Samples from before the race don't count as skipped
+            if (pdTRUE == app_bt_car_get_joystick(&joystick)) {
+                joystick_seq = joystick.seq[CAR_JOYSTICK_AXIS_Y];
+            }
+            app_joystick_filter_reset(&filter);
+            curr_scaled_speed = 0;
+            dc_motor_drive(0, false, elapsed_ms);
+            app_speed_ctrl_reset(&car_speed_ctrl);
+            if (engine_running) {
+                app_audio_engine_set(false, 0);
+                engine_running = false;
             }
-            vTaskDelay(pdMS_TO_TICKS(RACE_INACTIVE_DELAY_MS));
         }
+        car_speed = (int32_t)curr_scaled_speed;
+        if (stopping && (curr_scaled_speed == 0)) {
+            car_failsafe_stop_ms = (app_clock_us() - car_failsafe.trip_us) / 1000;
+            stopping = false;
+        }
+
+        car_loop_stats_update(n_ticks, start_us, cyhal_timer_read(&car_tick_timer));
     }
 }
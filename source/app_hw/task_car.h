@@ -1,12 +1,41 @@
 #ifndef __TASK_CAR__
 #define __TASK_CAR__
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "app_bt_car.h"
+#include "app_joystick_filter.h"
+#include "app_failsafe.h"
+#include "app_ir_hit.h"
+
+// Rate the control loop runs at, driven by a hardware timer
+#define CAR_CONTROL_TICK_HZ    (1000)
+
+// Timing of the control loop since the stats were last read
+typedef struct {
+    uint32_t n_ticks;
+    uint32_t n_missed_ticks;     // Ticks that fired again before the task woke up for the last one
+    uint32_t n_wakeups;
+    uint32_t min_latency_us;     // From the timer interrupt to the task running
+    uint32_t max_latency_us;
+    uint64_t total_latency_us;
+    uint32_t max_work_us;        // Longest time spent handling one tick
+} car_loop_stats_t;
+
 extern QueueHandle_t q_car;
 
 // initializes the task
 void task_car_init();
 
 void task_car(void *pvParameters);
+void task_car_get_loop_stats(car_loop_stats_t *stats);
+int32_t task_car_get_speed(void);
+void task_car_link_input(app_failsafe_input_e input);
+void task_car_link_up(void);
+void task_car_link_down(void);
+bool task_car_link_ok(void);
+bool task_car_ir_hit(const app_ir_rx_hit_s *hit, app_ir_hit_dir_e dir);
+bool task_car_get_joystick_filter_cfg(car_joystick_axis_e axis, uint32_t *gen, app_joystick_filter_cfg_s *cfg);
 
 
 #endif
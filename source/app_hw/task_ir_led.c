@@ -12,7 +12,15 @@
 #include "task_ir_led.h"
 #include "app_bt_car.h"
 #include "app_ir_led.h"
+#include "app_ir_code.h"
 #include "app_audio.h"
+#include "app_bt_bonding.h"
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define IR_LED_CAR_ID_KV_KEY    "ir_car_id"
 
 
 /******************************************************************************
@@ -26,6 +34,11 @@ static BaseType_t cli_handler_ir_led_set_state(
     size_t xWriteBufferLen,
     const char *pcCommandString
 );
+static BaseType_t cli_handler_ir_car_id(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
 
 
 /******************************************************************************
@@ -37,6 +50,9 @@ QueueHandle_t q_ir_led_cli_resp;
 
 TaskHandle_t xTaskIrLedHandle;
 
+// ID sent with this car's shots, kept in kv-store so each car keeps its own
+static volatile uint8_t ir_led_car_id;
+
 // The CLI command definition for the IR LED set state command
 static const CLI_Command_Definition_t xIrLedSetState=
 {
@@ -46,6 +62,15 @@ static const CLI_Command_Definition_t xIrLedSetState=
     1                                   // The user can enter 1 parameter
 };
 
+// The CLI command definition for the IR car ID command
+static const CLI_Command_Definition_t xIrCarId =
+{
+    "ir_car_id",                        // Command text
+    "\r\nir_car_id <id>\r\n",           // Command help text
+    cli_handler_ir_car_id,              // The function to run
+    1                                   // The user can enter 1 parameter
+};
+
 
 /******************************************************************************
  * Static Function Definitions                                                *
@@ -67,7 +92,7 @@ static void task_ir_led_car(void *param)
         // Wait to be notified, getting the item to use
         const car_item_t item = (car_item_t)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        BaseType_t used = app_ir_led_use_item(item); // TODO Won't use return value in the end
+        BaseType_t used = app_ir_led_use_item(item, ir_led_car_id); // TODO Won't use return value in the end
 
         if (used == pdTRUE)
         {
@@ -75,7 +100,7 @@ static void task_ir_led_car(void *param)
         }
         else
         {
-            task_print_info("Gave an invalid item: %u", item); // TODO REMOVE
+            task_print_info("Couldn't fire item %u: not a shot, or still sending the last one", item); // TODO REMOVE
         }
     }
 }
@@ -197,17 +222,117 @@ static BaseType_t cli_handler_ir_led_set_state(
 }
 
 
+/**
+ * @brief  FreeRTOS CLI Handler for the 'ir_car_id' command
+ * 
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_ir_car_id(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    const char *pcParameter;
+    BaseType_t xParameterStringLength;
+    char param[8] = {0};
+    char *end_ptr;
+
+    configASSERT(pcWriteBuffer);
+
+    // Obtain the parameter string
+    pcParameter = FreeRTOS_CLIGetParameter(
+        pcCommandString,        // The command string itself
+        1,                      // Return the 1st parameter
+        &xParameterStringLength // Store the parameter string length
+    );
+    // Sanity check something was returned
+    configASSERT(pcParameter);
+    strncat(param, pcParameter, (xParameterStringLength < (BaseType_t)sizeof(param)) ? (size_t)xParameterStringLength : sizeof(param) - 1);
+
+    // Clear the return string
+    memset(pcWriteBuffer, 0x00, xWriteBufferLen);
+
+    const long car_id = strtol(param, &end_ptr, 10);
+    if ((*end_ptr != '\0') || (car_id < 0) || (car_id >= (long)APP_IR_CODE_N_CAR_IDS))
+    {
+        sprintf(pcWriteBuffer, "\n\r\tInvalid ID, %s. Must be between 0 and %u", param, APP_IR_CODE_N_CAR_IDS - 1U);
+        return pdFALSE;
+    }
+
+    const uint8_t id = (uint8_t)car_id;
+    if (CY_RSLT_SUCCESS != mtb_kvstore_write(&kvstore_obj, IR_LED_CAR_ID_KV_KEY, &id, sizeof(id)))
+    {
+        task_print_warning("Failed to save the IR car ID. It will be lost on reset");
+    }
+    ir_led_car_id = id;
+    task_print_info("IR car ID set to %u", id);
+
+    return pdFALSE;
+}
+
+
+/**
+ * @brief  Load this car's ID. Until one is set, it comes from the MCU's unique
+ *         ID, so cars are unlikely to share one out of the box
+ * 
+ * @param void
+ * @return void
+ */
+static void task_ir_led_load_car_id(void)
+{
+    uint8_t id = 0;
+    uint32_t size = sizeof(id);
+
+    if ((CY_RSLT_SUCCESS != mtb_kvstore_read(&kvstore_obj, IR_LED_CAR_ID_KV_KEY, &id, &size)) ||
+        (size != sizeof(id)) || (id >= APP_IR_CODE_N_CAR_IDS))
+    {
+        uint64_t unique_id = Cy_SysLib_GetUniqueId();
+
+        id = 0;
+        while (unique_id != 0)
+        {
+            id ^= (uint8_t)(unique_id % APP_IR_CODE_N_CAR_IDS);
+            unique_id /= APP_IR_CODE_N_CAR_IDS;
+        }
+    }
+    ir_led_car_id = id;
+}
+
+
 /******************************************************************************
  * Public Function Definitions                                                *
  ******************************************************************************/
+/**
+ * @brief  Get the ID sent with this car's shots
+ * 
+ * @return uint8_t
+ * Car ID, below APP_IR_CODE_N_CAR_IDS
+ */
+uint8_t task_ir_led_get_car_id(void)
+{
+    return ir_led_car_id;
+}
+
+
 void task_ir_led_init(void)
 {
+    task_ir_led_load_car_id();
+
     // Create the Queues used to control the IR LED
     q_ir_led_cli_req  = xQueueCreate(1, sizeof(ir_led_packet_t));
     q_ir_led_cli_resp = xQueueCreate(1, sizeof(ir_led_packet_t));
 
     // Register the CLI commands
     FreeRTOS_CLIRegisterCommand(&xIrLedSetState);
+    FreeRTOS_CLIRegisterCommand(&xIrCarId);
 
     // Create the task that will control the IR LED via CLI
     xTaskCreate(
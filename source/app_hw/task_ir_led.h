@@ -60,6 +60,7 @@ extern TaskHandle_t xTaskIrLedHandle;
 
 
 void task_ir_led_init(void);
+uint8_t task_ir_led_get_car_id(void);
 
 
 #endif // __TASK_IR_LED_H__
@@ -0,0 +1,648 @@
+/**
+ * @file task_ir_receiver.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the IR receivers. Every edge of their outputs interrupts,
+ * is timestamped, and is pushed onto a lock-free ring, and the detector task
+ * is woken to decode them, work out which way any shot came from, and hand
+ * it to the car and report it to the RC controller app. Each receiver's marks are also counted by a
+ * TCPWM counter, so one that floods with noise can have its interrupt turned
+ * off without losing sight of when it calms down. How sensitive the detector
+ * is can be tuned over the CLI, and is kept in kv-store
+ *
+ * @version 0.1
+ * @date 2024-12-24
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "task_ir_receiver.h"
+#include "task_car.h"
+#include "task_ir_led.h"
+#include "app_bt_car.h"
+#include "app_bt_bonding.h"
+#include "app_clock.h"
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define IR_RECEIVER_CFG_KV_KEY  "ir_rx_cfg"
+
+
+/******************************************************************************
+ * Private Function Declarations                                              *
+ ******************************************************************************/
+static void task_ir_receiver(void *param);
+static void task_ir_receiver_isr(void *handler_arg, cyhal_gpio_event_t event);
+static void task_ir_receiver_counters_init(void);
+static void task_ir_receiver_check_counters(app_ir_rx_detector_s *det);
+static void task_ir_receiver_save_cfg(const app_ir_rx_cfg_s *cfg);
+static void task_ir_receiver_load_cfg(void);
+static BaseType_t cli_ir_receiver_get_long_arg(const char *pcCommandString, UBaseType_t argidx, long argmin, long argmax, long *arg);
+
+static BaseType_t cli_handler_ir_stats(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
+static BaseType_t cli_handler_ir_rx_sense(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
+static BaseType_t cli_handler_ir_rx_frames(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+);
+
+
+/******************************************************************************
+ * Global Variables                                                           *
+ ******************************************************************************/
+static const cyhal_gpio_t ir_receiver_pins[APP_IR_RX_N_RECEIVERS] = {
+    IR_RECEIVER_PIN_A,
+    IR_RECEIVER_PIN_B,
+    IR_RECEIVER_PIN_C
+};
+
+// The receiver's index is passed to the interrupt
+static cyhal_gpio_callback_data_t ir_receiver_cb_data[APP_IR_RX_N_RECEIVERS] = {
+    { .callback = task_ir_receiver_isr, .callback_arg = (void *)0 },
+    { .callback = task_ir_receiver_isr, .callback_arg = (void *)1 },
+    { .callback = task_ir_receiver_isr, .callback_arg = (void *)2 }
+};
+
+// Pushed by the interrupt, and popped by the detector task
+static app_ir_rx_ring_s ir_receiver_ring;
+static TaskHandle_t ir_receiver_task_handle = NULL;
+// Written by the detector task
+static ir_receiver_stats_t ir_receiver_stats;
+static volatile uint32_t ir_receiver_flooded = 0;
+
+// Count each receiver's marks in hardware. Only used by the detector task once it is running
+static cyhal_timer_t ir_receiver_counter_hw[APP_IR_RX_N_RECEIVERS];
+static app_ir_rx_counter_s ir_receiver_counters[APP_IR_RX_N_RECEIVERS];
+static bool ir_receiver_counting[APP_IR_RX_N_RECEIVERS];    // Whether the receiver has a counter
+
+// How sensitive the detector is, set over the CLI and handed to the detector task
+static app_ir_rx_cfg_s ir_receiver_cfg;
+static volatile bool ir_receiver_cfg_changed = false;
+
+// The CLI command definition for the IR receiver stats command
+static const CLI_Command_Definition_t xIrStats =
+{
+    "ir_stats",                         // Command text
+    "\r\nir_stats\r\n",                 // Command help text
+    cli_handler_ir_stats,               // The function to run
+    0                                   // The user can enter 0 parameters
+};
+
+// The CLI command definition for the IR receiver sensitivity command
+static const CLI_Command_Definition_t xIrRxSense =
+{
+    "ir_rx_sense",                                      // Command text
+    "\r\nir_rx_sense < a|b|c|all > < min_mark_us >\r\n"
+    "\tIgnore marks and dropouts shorter than min_mark_us on a receiver (saved)\r\n",  // Command help text
+    cli_handler_ir_rx_sense,                            // The function to run
+    2                                                   // The user can enter 2 parameters
+};
+
+// The CLI command definition for the IR shot confirmation command
+static const CLI_Command_Definition_t xIrRxFrames =
+{
+    "ir_rx_frames",                                     // Command text
+    "\r\nir_rx_frames < min_frames >\r\n"
+    "\tOnly take a shot once this many of its frames are decoded (saved)\r\n",  // Command help text
+    cli_handler_ir_rx_frames,                           // The function to run
+    1                                                   // The user can enter 1 parameter
+};
+
+
+/******************************************************************************
+ * Static Function Definitions                                                *
+ ******************************************************************************/
+/**
+ * @brief  Timestamp an edge of a receiver's output, and wake the detector
+ *
+ * @param handler_arg
+ * Index of the receiver
+ * @param event
+ * Unused, as the pin is read to tell which edge it was
+ */
+static void task_ir_receiver_isr(void *handler_arg, cyhal_gpio_event_t event)
+{
+    const uint32_t us = app_clock_us();
+    const uint8_t receiver = (uint8_t)(uintptr_t)handler_arg;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    (void)event;
+
+    // The output is low while the receiver sees the carrier
+    app_ir_rx_push(&ir_receiver_ring, receiver, !cyhal_gpio_read(ir_receiver_pins[receiver]), us);
+
+    if (ir_receiver_task_handle != NULL)
+    {
+        vTaskNotifyGiveFromISR(ir_receiver_task_handle, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+}
+
+
+/**
+ * @brief  Count each receiver's marks in hardware, on a TCPWM counter clocked
+ *         by the receiver's output through the trigger mux. A receiver whose
+ *         pin can't be routed to a counter just goes without
+ */
+static void task_ir_receiver_counters_init(void)
+{
+    cy_rslt_t rslt;
+    cyhal_source_t source;
+    const cyhal_timer_cfg_t counter_cfg = {
+        .compare_value = 0,
+        .period = UINT16_MAX,
+        .direction = CYHAL_TIMER_DIR_UP,
+        .is_compare = false,
+        .is_continuous = true,
+        .value = 0
+    };
+
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        ir_receiver_counting[i] = false;
+
+        rslt = cyhal_gpio_enable_output(ir_receiver_pins[i], CYHAL_SIGNAL_TYPE_EDGE, &source);
+        if (CY_RSLT_SUCCESS != rslt)
+        {
+            task_print_warning("IR receiver %lu can't be routed to a counter, so won't be muted if it floods", i);
+            continue;
+        }
+        rslt = cyhal_timer_init(&ir_receiver_counter_hw[i], NC, NULL);
+        if (CY_RSLT_SUCCESS != rslt)
+        {
+            task_print_warning("No counter free for IR receiver %lu, so it won't be muted if it floods", i);
+            continue;
+        }
+        rslt = cyhal_timer_configure(&ir_receiver_counter_hw[i], &counter_cfg);
+        CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+        // Count the start of every mark, when the output falls
+        rslt = cyhal_timer_connect_digital2(&ir_receiver_counter_hw[i], source, CYHAL_TIMER_INPUT_COUNT, CYHAL_EDGE_TYPE_FALLING_EDGE);
+        if (CY_RSLT_SUCCESS != rslt)
+        {
+            task_print_warning("IR receiver %lu can't be routed to a counter, so won't be muted if it floods", i);
+            cyhal_timer_free(&ir_receiver_counter_hw[i]);
+            continue;
+        }
+        rslt = cyhal_timer_start(&ir_receiver_counter_hw[i]);
+        CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+
+        app_ir_rx_counter_init(&ir_receiver_counters[i], (uint16_t)cyhal_timer_read(&ir_receiver_counter_hw[i]));
+        ir_receiver_counting[i] = true;
+    }
+}
+
+
+/**
+ * @brief  End a window of the receivers' hardware mark counts, turning the
+ *         edge interrupt off for any that have flooded with noise and back on
+ *         for any that have calmed down
+ *
+ * @param app_ir_rx_detector_s*
+ * Detector, whose receivers are reset when they are turned back on
+ */
+static void task_ir_receiver_check_counters(app_ir_rx_detector_s *det)
+{
+    uint32_t flooded = 0;
+    uint32_t n_marks[APP_IR_RX_N_RECEIVERS] = {0};
+    uint32_t n_floods = 0;
+
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        if (!ir_receiver_counting[i])
+        {
+            continue;
+        }
+        app_ir_rx_counter_s *counter = &ir_receiver_counters[i];
+        const bool was_flooded = counter->flooded;
+        const uint32_t n_floods_before = counter->n_floods;
+
+        if (app_ir_rx_counter_window(counter, (uint16_t)cyhal_timer_read(&ir_receiver_counter_hw[i])) != was_flooded)
+        {
+            if (counter->flooded)
+            {
+                cyhal_gpio_enable_event(ir_receiver_pins[i], CYHAL_GPIO_IRQ_BOTH, IR_RECEIVER_INTR_PRIORITY, false);
+            }
+            else
+            {
+                // Its edges were missed while it was off, so its decoder starts again
+                app_ir_rx_receiver_reset(det, (uint8_t)i);
+                cyhal_gpio_enable_event(ir_receiver_pins[i], CYHAL_GPIO_IRQ_BOTH, IR_RECEIVER_INTR_PRIORITY, true);
+            }
+        }
+        if (counter->flooded)
+        {
+            flooded |= (1UL << i);
+        }
+        n_marks[i] = counter->marks;
+        n_floods += counter->n_floods - n_floods_before;
+    }
+
+    ir_receiver_flooded = flooded;
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        ir_receiver_stats.n_marks[i] += n_marks[i];
+    }
+    ir_receiver_stats.n_floods += n_floods;
+    taskEXIT_CRITICAL();
+}
+
+
+/**
+ * @brief  Task that detects shots from the receivers' edges, and hands them to
+ *         the car
+ *
+ * @param param
+ * Unused
+ */
+static void task_ir_receiver(void *param)
+{
+    // Too big for the task's stack
+    static app_ir_rx_detector_s det;
+    app_ir_rx_edge_s edge;
+    app_ir_rx_hit_s hit;
+    app_ir_hit_s hit_dir;
+    uint32_t n_frames = 0;
+    uint32_t n_own = 0;
+    uint32_t n_errors = 0;
+    uint32_t n_glitches = 0;
+    uint32_t n_rejected = 0;
+    uint32_t window_us = app_clock_us();
+    uint32_t elapsed_us = 0;
+
+    // Suppress warning for unused parameter
+    (void)param;
+
+    app_ir_rx_detector_init(&det, task_ir_led_get_car_id());
+
+    // Repeatedly running part of the task
+    for (;;)
+    {
+        // A frame is complete as soon as its last edge comes in, so sleep until there are edges,
+        // or the counters' window is up
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(((APP_IR_RX_WINDOW_US - elapsed_us) + 999U) / 1000U));
+
+        // The car's ID and the detector's sensitivity can be changed over the CLI
+        det.own_id = task_ir_led_get_car_id();
+        if (ir_receiver_cfg_changed)
+        {
+            taskENTER_CRITICAL();
+            const app_ir_rx_cfg_s cfg = ir_receiver_cfg;
+            ir_receiver_cfg_changed = false;
+            taskEXIT_CRITICAL();
+            app_ir_rx_set_cfg(&det, &cfg);
+        }
+
+        while (app_ir_rx_pop(&ir_receiver_ring, &edge))
+        {
+            if (!app_ir_rx_edge(&det, &edge, &hit))
+            {
+                continue;
+            }
+
+            app_ir_hit_analyze(&hit, &hit_dir);
+            const bool taken = task_car_ir_hit(&hit, hit_dir.dir);
+            const uint32_t latency_us = app_clock_us() - hit.start_us;
+
+            if (taken)
+            {
+                app_bt_car_report_hit(hit.shooter_id, hit.shot_type, (uint8_t)hit_dir.dir);
+            }
+
+            taskENTER_CRITICAL();
+            ir_receiver_stats.n_shots++;
+            if (taken)
+            {
+                ir_receiver_stats.n_hits++;
+            }
+            ir_receiver_stats.n_dirs[hit_dir.dir]++;
+            ir_receiver_stats.last_bearing_deg = hit_dir.bearing_deg;
+            app_latency_record(&ir_receiver_stats.latency, latency_us);
+            taskEXIT_CRITICAL();
+        }
+
+        // Only hand over what has changed, as reading the stats clears them
+        app_ir_rx_expire(&det, app_clock_us());
+        const uint32_t n_errors_now = app_ir_rx_n_errors(&det);
+        const uint32_t n_glitches_now = app_ir_rx_n_glitches(&det);
+        taskENTER_CRITICAL();
+        ir_receiver_stats.n_frames += det.n_frames - n_frames;
+        ir_receiver_stats.n_own += det.n_own - n_own;
+        ir_receiver_stats.n_errors += n_errors_now - n_errors;
+        ir_receiver_stats.n_glitches += n_glitches_now - n_glitches;
+        ir_receiver_stats.n_rejected += det.n_rejected - n_rejected;
+        taskEXIT_CRITICAL();
+        n_frames = det.n_frames;
+        n_own = det.n_own;
+        n_errors = n_errors_now;
+        n_glitches = n_glitches_now;
+        n_rejected = det.n_rejected;
+
+        elapsed_us = app_clock_us() - window_us;
+        if (elapsed_us >= APP_IR_RX_WINDOW_US)
+        {
+            task_ir_receiver_check_counters(&det);
+            window_us += APP_IR_RX_WINDOW_US;
+            elapsed_us -= APP_IR_RX_WINDOW_US;
+            if (elapsed_us >= APP_IR_RX_WINDOW_US)
+            {
+                // Fell behind, so start again from now rather than catch up
+                window_us += elapsed_us;
+                elapsed_us = 0;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief  FreeRTOS CLI Handler for the 'ir_stats' command
+ *
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_ir_stats(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    // Too big for the CLI task's stack
+    static ir_receiver_stats_t stats;
+
+    (void)pcCommandString;
+    configASSERT(pcWriteBuffer);
+
+    task_ir_receiver_get_stats(&stats);
+    task_print_info("IR: %lu shots, %lu hits, %lu edges dropped", stats.n_shots, stats.n_hits, stats.n_dropped);
+    if (stats.n_shots > 0)
+    {
+        task_print_info("Directions: %lu front, %lu side, %lu rear. Last from %d degrees",
+                        stats.n_dirs[APP_IR_HIT_DIR_FRONT], stats.n_dirs[APP_IR_HIT_DIR_SIDE],
+                        stats.n_dirs[APP_IR_HIT_DIR_REAR], stats.last_bearing_deg);
+    }
+    task_print_info("Frames: %lu decoded, %lu from this car (ID %u), %lu abandoned",
+                    stats.n_frames, stats.n_own, task_ir_led_get_car_id(), stats.n_errors);
+    task_print_info("Filtered: %lu glitches, %lu shots short of %u frames. Min mark: A %u us, B %u us, C %u us",
+                    stats.n_glitches, stats.n_rejected, ir_receiver_cfg.min_frames,
+                    ir_receiver_cfg.min_mark_us[0], ir_receiver_cfg.min_mark_us[1], ir_receiver_cfg.min_mark_us[2]);
+    task_print_info("Marks counted in hardware: A %lu, B %lu, C %lu. %lu floods, muted now: %s%s%s",
+                    stats.n_marks[0], stats.n_marks[1], stats.n_marks[2], stats.n_floods,
+                    (stats.flooded & 1UL) ? "A " : "", (stats.flooded & 2UL) ? "B " : "", (stats.flooded & 4UL) ? "C " : "");
+    if (stats.latency.n > 0)
+    {
+        task_print_info("Hit latency: mean %lu us, p50 %lu us, p99 %lu us, max %lu us",
+                        app_latency_mean(&stats.latency),
+                        app_latency_percentile(&stats.latency, 500),
+                        app_latency_percentile(&stats.latency, 990),
+                        stats.latency.max_us);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+
+/**
+ * @brief  Hand new detector settings to the detector task, and save them
+ *
+ * @param const app_ir_rx_cfg_s*
+ * New settings, which must be valid
+ */
+static void task_ir_receiver_save_cfg(const app_ir_rx_cfg_s *cfg)
+{
+    taskENTER_CRITICAL();
+    ir_receiver_cfg = *cfg;
+    ir_receiver_cfg_changed = true;
+    taskEXIT_CRITICAL();
+
+    if (CY_RSLT_SUCCESS != mtb_kvstore_write(&kvstore_obj, IR_RECEIVER_CFG_KV_KEY, (uint8_t *)cfg, sizeof(*cfg)))
+    {
+        task_print_warning("Failed to save the IR receiver settings. They will be lost on reset");
+    }
+}
+
+
+/**
+ * @brief  Parse a CLI parameter as a whole number in a range
+ *
+ * @param const char*
+ * The list of parameters entered by the user
+ * @param UBaseType_t
+ * Which parameter to parse
+ * @param long
+ * Lowest it may be
+ * @param long
+ * Highest it may be
+ * @param long*
+ * Where to write it
+ * @return BaseType_t
+ * pdTRUE if it was a number in range, pdFALSE (and an error is printed) if not
+ */
+static BaseType_t cli_ir_receiver_get_long_arg(const char *pcCommandString, UBaseType_t argidx, long argmin, long argmax, long *arg)
+{
+    BaseType_t xParameterStringLength;
+    char param[16] = {0};
+    char *end_ptr;
+
+    const char *pcParameter = FreeRTOS_CLIGetParameter(pcCommandString, argidx, &xParameterStringLength);
+    configASSERT(pcParameter);
+    strncat(param, pcParameter, (xParameterStringLength < (BaseType_t)sizeof(param)) ? (size_t)xParameterStringLength : sizeof(param) - 1);
+
+    *arg = strtol(param, &end_ptr, 10);
+    if ((*end_ptr != '\0') || (*arg < argmin) || (*arg > argmax))
+    {
+        task_print_error("Invalid parameter %lu, %s. Must be between %li and %li", argidx, param, argmin, argmax);
+        return pdFALSE;
+    }
+    return pdTRUE;
+}
+
+
+/**
+ * @brief  FreeRTOS CLI Handler for the 'ir_rx_sense' command
+ *
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_ir_rx_sense(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    app_ir_rx_cfg_s cfg = ir_receiver_cfg;
+    BaseType_t xParameterStringLength;
+    long min_mark_us;
+
+    configASSERT(pcWriteBuffer);
+
+    const char *pcParameter = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParameterStringLength);
+    configASSERT(pcParameter);
+    const bool all = (xParameterStringLength == 3) && (strncmp(pcParameter, "all", 3) == 0);
+    const bool one = (xParameterStringLength == 1) && (pcParameter[0] >= 'a') && (pcParameter[0] <= 'c');
+
+    if (!all && !one)
+    {
+        task_print_error("Invalid receiver. Must be a, b, c, or all");
+    }
+    else if (pdTRUE == cli_ir_receiver_get_long_arg(pcCommandString, 2, 0, APP_IR_RX_MAX_MIN_MARK_US, &min_mark_us))
+    {
+        for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+        {
+            if (all || ((uint32_t)(pcParameter[0] - 'a') == i))
+            {
+                cfg.min_mark_us[i] = (uint16_t)min_mark_us;
+            }
+        }
+        task_ir_receiver_save_cfg(&cfg);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+
+/**
+ * @brief  FreeRTOS CLI Handler for the 'ir_rx_frames' command
+ *
+ * @param pcWriteBuffer
+ * Array used to return a string to the CLI parser
+ * @param xWriteBufferLen
+ * The length of the write buffer
+ * @param pcCommandString
+ * The list of parameters entered by the user
+ * @return BaseType_t
+ * pdFALSE to indicate command completion
+ */
+static BaseType_t cli_handler_ir_rx_frames(
+    char *pcWriteBuffer,
+    size_t xWriteBufferLen,
+    const char *pcCommandString
+)
+{
+    app_ir_rx_cfg_s cfg = ir_receiver_cfg;
+    long min_frames;
+
+    configASSERT(pcWriteBuffer);
+
+    if (pdTRUE == cli_ir_receiver_get_long_arg(pcCommandString, 1, 1, APP_IR_RX_MAX_MIN_FRAMES, &min_frames))
+    {
+        cfg.min_frames = (uint8_t)min_frames;
+        task_ir_receiver_save_cfg(&cfg);
+    }
+
+    // Nothing to return, so zero out the pcWriteBuffer
+    memset(pcWriteBuffer, 0, xWriteBufferLen);
+
+    return pdFALSE;
+}
+
+
+/**
+ * @brief  Load the detector's settings, or the defaults if none were saved
+ */
+static void task_ir_receiver_load_cfg(void)
+{
+    uint32_t size = sizeof(ir_receiver_cfg);
+
+    if ((CY_RSLT_SUCCESS != mtb_kvstore_read(&kvstore_obj, IR_RECEIVER_CFG_KV_KEY, (uint8_t *)&ir_receiver_cfg, &size)) ||
+        (size != sizeof(ir_receiver_cfg)) || !app_ir_rx_cfg_valid(&ir_receiver_cfg))
+    {
+        app_ir_rx_cfg_default(&ir_receiver_cfg);
+    }
+    // Picked up by the detector task when it starts
+    ir_receiver_cfg_changed = true;
+}
+
+
+/******************************************************************************
+ * Public Function Definitions                                                *
+ ******************************************************************************/
+/**
+ * @brief  Get the hits seen since the stats were last read, and start counting
+ *         again
+ *
+ * @param ir_receiver_stats_t*
+ * Where to write the stats
+ */
+void task_ir_receiver_get_stats(ir_receiver_stats_t *stats)
+{
+    const uint32_t n_dropped = ir_receiver_ring.n_dropped;
+
+    // The ring counts dropped edges, so remember where its count was at this read
+    taskENTER_CRITICAL();
+    *stats = ir_receiver_stats;
+    memset(&ir_receiver_stats, 0, sizeof(ir_receiver_stats));
+    ir_receiver_stats.n_dropped = n_dropped;
+    taskEXIT_CRITICAL();
+    stats->n_dropped = n_dropped - stats->n_dropped;
+    stats->flooded = ir_receiver_flooded;
+}
+
+
+void task_ir_receiver_init(void)
+{
+    cy_rslt_t rslt;
+
+    app_ir_rx_ring_init(&ir_receiver_ring);
+    task_ir_receiver_load_cfg();
+
+    // Register the CLI commands
+    FreeRTOS_CLIRegisterCommand(&xIrStats);
+    FreeRTOS_CLIRegisterCommand(&xIrRxSense);
+    FreeRTOS_CLIRegisterCommand(&xIrRxFrames);
+
+    // Interrupt on both edges of every receiver's output. Edges are kept on the ring until the
+    // detector is running
+    for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        rslt = cyhal_gpio_init(ir_receiver_pins[i], CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_NONE, true);
+        CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+        cyhal_gpio_register_callback(ir_receiver_pins[i], &ir_receiver_cb_data[i]);
+        cyhal_gpio_enable_event(ir_receiver_pins[i], CYHAL_GPIO_IRQ_BOTH, IR_RECEIVER_INTR_PRIORITY, true);
+    }
+
+    // The counters are the detector's, so they are set up before it starts
+    task_ir_receiver_counters_init();
+
+    // The detector only runs briefly, but must keep up with the edges of every frame, so it is
+    // above the car and the timer daemon
+    xTaskCreate(
+        task_ir_receiver,
+        "Task_IR_Receiver",
+        configMINIMAL_STACK_SIZE * 2,
+        NULL,
+        configMAX_PRIORITIES - 3,
+        &ir_receiver_task_handle
+    );
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,70 @@
+/**
+ * @file task_ir_receiver.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the IR receivers' edge interrupt and the task that decodes
+ * hits from their edges
+ *
+ * @version 0.1
+ * @date 2024-12-24
+ *
+ * @copyright Copyright (c) 2024
+ */
+#ifndef __TASK_IR_RECEIVER_H__
+#define __TASK_IR_RECEIVER_H__
+
+/* Include Infineon BSP Libraries */
+#include "cy_pdl.h"
+#include "cyhal.h"
+#include "cybsp.h"
+
+/* Include Standard C Libraries*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* FreeRTOS Includes */
+#include <FreeRTOS.h>
+#include <task.h>
+#include "source/FreeRTOSConfig.h"
+#include "source/FreeRTOS_CLI.h"
+
+/* Include Project Specific Files */
+#include "task_console.h"
+#include "app_ir_rx.h"
+#include "app_ir_hit.h"
+#include "app_latency.h"
+
+
+// The receivers' outputs are low while they see the 38 kHz carrier. They must all be on one port,
+// so their edges all come from the same interrupt
+#define IR_RECEIVER_PIN_A               P10_3
+#define IR_RECEIVER_PIN_B               P10_4
+#define IR_RECEIVER_PIN_C               P10_5
+#define IR_RECEIVER_INTR_PRIORITY       (3)
+
+// Hits seen since the stats were last read
+typedef struct
+{
+    uint32_t n_shots;               // Shots from other cars
+    uint32_t n_hits;                // Shots the car took (not racing, shielded, or already hit)
+    uint32_t n_dirs[APP_IR_HIT_DIR_MAX];    // Shots by where they came from
+    int16_t last_bearing_deg;       // Where the last shot came from
+    uint32_t n_frames;              // Valid frames, including repeats and this car's own shots
+    uint32_t n_own;                 // Frames from this car, reflected back to it
+    uint32_t n_errors;              // Frames abandoned part way, from noise or a blocked shot
+    uint32_t n_glitches;            // Marks and dropouts filtered out as too short
+    uint32_t n_rejected;            // Shots that ended without enough frames to be taken
+    uint32_t n_dropped;             // Edges lost to a full ring
+    uint32_t n_marks[APP_IR_RX_N_RECEIVERS];    // Marks counted in hardware
+    uint32_t n_floods;              // Times a receiver was muted for noise
+    uint32_t flooded;               // Mask of the receivers muted as of the read
+    app_latency_hist_s latency;     // From a shot's frame starting to the shot being handed to the car,
+                                    // which includes reading the whole frame (12.4-17.2 ms, see app_ir_code.h)
+} ir_receiver_stats_t;
+
+
+void task_ir_receiver_init(void);
+void task_ir_receiver_get_stats(ir_receiver_stats_t *stats);
+
+
+#endif // __TASK_IR_RECEIVER_H__
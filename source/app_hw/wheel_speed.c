@@ -0,0 +1,59 @@
+#include "wheel_speed.h"
+
+static volatile uint32_t wheel_speed_n_edges = 0;
+static volatile uint32_t wheel_speed_last_edge_us = 0;
+
+static void wheel_speed_isr(void *handler_arg, cyhal_gpio_event_t event);
+
+static cyhal_gpio_callback_data_t wheel_speed_cb_data =
+{
+    .callback     = wheel_speed_isr,
+    .callback_arg = NULL
+};
+
+/**
+ * @brief
+ * Counts a pulse from the wheel sensor, and records when it happened
+ */
+static void wheel_speed_isr(void *handler_arg, cyhal_gpio_event_t event) {
+    (void)handler_arg;
+    (void)event;
+
+    wheel_speed_last_edge_us = app_clock_us();
+    wheel_speed_n_edges++;
+}
+
+/**
+ * @brief
+ * Initializes the wheel speed sensor's pin and starts counting pulses. Pulses
+ * are timed with app_clock, which must already be running
+ */
+void wheel_speed_init(void) {
+    cy_rslt_t rslt;
+
+    // Count the falling edge of every pulse
+    rslt = cyhal_gpio_init(WHEEL_SPEED_PIN, CYHAL_GPIO_DIR_INPUT, CYHAL_GPIO_DRIVE_PULLUP, true);
+    CY_ASSERT(CY_RSLT_SUCCESS == rslt);
+    cyhal_gpio_register_callback(WHEEL_SPEED_PIN, &wheel_speed_cb_data);
+    cyhal_gpio_enable_event(WHEEL_SPEED_PIN, CYHAL_GPIO_IRQ_FALL, WHEEL_SPEED_INTR_PRIORITY, true);
+}
+
+/**
+ * @brief
+ * Reads how many pulses the wheel sensor has seen, when the last one was,
+ * and the current time, all consistent with each other
+ *
+ * @param n_edges
+ * Where to write the number of pulses (wraps)
+ * @param last_edge_us
+ * Where to write the time of the last pulse (us, wraps)
+ * @param now_us
+ * Where to write the current time (us, wraps)
+ */
+void wheel_speed_read(uint32_t *n_edges, uint32_t *last_edge_us, uint32_t *now_us) {
+    const uint32_t saved_intr = cyhal_system_critical_section_enter();
+    *n_edges = wheel_speed_n_edges;
+    *last_edge_us = wheel_speed_last_edge_us;
+    *now_us = app_clock_us();
+    cyhal_system_critical_section_exit(saved_intr);
+}
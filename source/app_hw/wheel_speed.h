@@ -0,0 +1,29 @@
+/**
+ * @file wheel_speed.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief Header file for the wheel speed sensor, a hall sensor (or single
+ * channel encoder) on the drive wheel that pulses as the wheel turns
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#ifndef __WHEEL_SPEED_H__
+#define __WHEEL_SPEED_H__
+
+#include <stdint.h>
+#include "cyhal_hw_types.h"
+#include "cyhal_gpio.h"
+#include "cy_result.h"
+#include "cyhal.h"
+#include "app_clock.h"
+
+// Pin the wheel sensor's output is connected to (active low, open drain)
+#define WHEEL_SPEED_PIN              P9_2
+#define WHEEL_SPEED_INTR_PRIORITY    (3)
+
+void wheel_speed_init(void);
+void wheel_speed_read(uint32_t *n_edges, uint32_t *last_edge_us, uint32_t *now_us);
+
+#endif
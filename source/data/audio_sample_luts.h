@@ -37,6 +37,12 @@
 #define AUDIO_SOUND_EFFECT_SAMPLE_SIZE_USE_SHOT      (14624U)
 #define AUDIO_SOUND_EFFECT_SAMPLE_SIZE_BOOST         (32437U)
 #define AUDIO_SOUND_EFFECT_SAMPLE_SIZE_HIT           (19726U)
+// Encoded IMA-ADPCM sizes (bytes)
+#define AUDIO_SOUND_EFFECT_ADPCM_SIZE_GET_ITEM      (10665U)
+#define AUDIO_SOUND_EFFECT_ADPCM_SIZE_USE_SHIELD    (8293U)
+#define AUDIO_SOUND_EFFECT_ADPCM_SIZE_USE_SHOT      (7414U)
+#define AUDIO_SOUND_EFFECT_ADPCM_SIZE_BOOST         (16446U)
+#define AUDIO_SOUND_EFFECT_ADPCM_SIZE_HIT           (10003U)
 
 typedef enum
 {
@@ -48,16 +54,31 @@ typedef enum
     AUDIO_SOUND_EFFECT_MAX        = 5
 } audio_sound_effect_e;
 
+// How an asset's samples are stored
+typedef enum
+{
+    AUDIO_ASSET_FORMAT_PCM   = 0, // Uncompressed 12-bit DAC samples (uint16_t each)
+    AUDIO_ASSET_FORMAT_ADPCM = 1, // IMA-ADPCM blocks (see app_audio_adpcm.h)
+    AUDIO_ASSET_FORMAT_SYNTH = 2  // Notes rendered by the synthesizer (see app_audio_synth.h)
+} audio_asset_format_e;
+
+// Everything the audio engine needs to play a clip. The DMA descriptors are built
+// from this at runtime, so adding a clip only needs a new entry in audio_assets
+typedef struct
+{
+    const void* data;            // Start of the clip's samples (or notes), or NULL if streamed
+    uint32_t ext_addr;           // Start of the clip in external flash (only if data is NULL)
+    uint32_t n_samples;          // Number of samples in the clip (notes if synthesized)
+    uint32_t sample_rate;        // Rate to play the clip at (Hz)
+    audio_asset_format_e format; // How data is encoded
+} audio_asset_s;
+
 
 /******************************************************************************/
 /* Extern Data Declarations                                                   */
 /******************************************************************************/
-// Number of samples for sound effects
-extern const uint16_t audio_sample_sizes[AUDIO_SOUND_EFFECT_MAX];
-// Sample rates for sound effects
-extern const uint32_t audio_sample_rates[AUDIO_SOUND_EFFECT_MAX];
-// VDAC sample LUTs for sound effects
-extern const uint32_t* audio_sample_luts[AUDIO_SOUND_EFFECT_MAX];
+// Asset table for sound effects
+extern const audio_asset_s audio_assets[AUDIO_SOUND_EFFECT_MAX];
 
 
 #endif // __AUDIO_SAMPLE_LUTS_H__
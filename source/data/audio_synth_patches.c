@@ -0,0 +1,117 @@
+/**
+ * @file audio_synth_patches.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file with synthesizer patches for sound effects. Built with
+ * SYNTH_SOUND_EFFECTS=1, these replace the sample LUTs in
+ * audio_sample_luts.c, taking a few hundred bytes of flash instead of tens of
+ * kilobytes, and can be played at any pitch without changing their length
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "audio_sample_luts.h"
+#include "app_hw/app_audio_mixer.h"
+
+#ifdef AUDIO_SYNTH_SOUND_EFFECTS
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define AUDIO_SYNTH_N_NOTES(NOTES)    ((uint32_t)(sizeof(NOTES) / sizeof((NOTES)[0])))
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// Rising square wave arpeggio
+static const app_audio_synth_patch_s audio_synth_get_item[] = {
+    { .wave = APP_AUDIO_SYNTH_WAVE_SQUARE, .duty = 128, .freq_start_hz = 784,  .freq_end_hz = 784,
+      .attack_ms = 2, .decay_ms = 40, .sustain_ms = 20, .release_ms = 10, .sustain = 16384, .gain = 14000 },
+    { .wave = APP_AUDIO_SYNTH_WAVE_SQUARE, .duty = 128, .freq_start_hz = 988,  .freq_end_hz = 988,
+      .attack_ms = 2, .decay_ms = 40, .sustain_ms = 20, .release_ms = 10, .sustain = 16384, .gain = 14000 },
+    { .wave = APP_AUDIO_SYNTH_WAVE_SQUARE, .duty = 128, .freq_start_hz = 1175, .freq_end_hz = 1175,
+      .attack_ms = 2, .decay_ms = 40, .sustain_ms = 20, .release_ms = 10, .sustain = 16384, .gain = 14000 },
+    { .wave = APP_AUDIO_SYNTH_WAVE_SQUARE, .duty = 64,  .freq_start_hz = 1568, .freq_end_hz = 1568,
+      .attack_ms = 2, .decay_ms = 80, .sustain_ms = 120, .release_ms = 200, .sustain = 12000, .gain = 14000 }
+};
+
+// Saw wave rising under an opening filter
+static const app_audio_synth_patch_s audio_synth_use_shield[] = {
+    { .wave = APP_AUDIO_SYNTH_WAVE_SAW, .freq_start_hz = 220, .freq_end_hz = 660, .sweep_ms = 350,
+      .attack_ms = 60, .decay_ms = 100, .sustain_ms = 150, .release_ms = 250, .sustain = 24000, .gain = 20000,
+      .cutoff_start_hz = 400, .cutoff_end_hz = 4000 },
+    { .wave = APP_AUDIO_SYNTH_WAVE_SINE, .freq_start_hz = 1320, .freq_end_hz = 1320,
+      .attack_ms = 5, .decay_ms = 50, .sustain_ms = 50, .release_ms = 200, .sustain = 16384, .gain = 16000 }
+};
+
+// Fast falling laser
+static const app_audio_synth_patch_s audio_synth_use_shot[] = {
+    { .wave = APP_AUDIO_SYNTH_WAVE_SQUARE, .duty = 96, .freq_start_hz = 1800, .freq_end_hz = 180, .sweep_ms = 220,
+      .attack_ms = 1, .decay_ms = 60, .sustain_ms = 60, .release_ms = 100, .sustain = 16384, .gain = 18000,
+      .cutoff_start_hz = 6000, .cutoff_end_hz = 1500 }
+};
+
+// Engine rev up with a burst of noise behind it
+static const app_audio_synth_patch_s audio_synth_boost[] = {
+    { .wave = APP_AUDIO_SYNTH_WAVE_NOISE, .freq_start_hz = 2000, .freq_end_hz = 8000, .sweep_ms = 150,
+      .attack_ms = 20, .decay_ms = 130, .sustain = 0, .gain = 12000,
+      .cutoff_start_hz = 1000, .cutoff_end_hz = 5000 },
+    { .wave = APP_AUDIO_SYNTH_WAVE_SAW, .freq_start_hz = 90, .freq_end_hz = 360, .sweep_ms = 900,
+      .attack_ms = 30, .decay_ms = 200, .sustain_ms = 700, .release_ms = 400, .sustain = 26000, .gain = 22000,
+      .cutoff_start_hz = 300, .cutoff_end_hz = 3000 }
+};
+
+// Noise explosion that darkens as it fades
+static const app_audio_synth_patch_s audio_synth_hit[] = {
+    { .wave = APP_AUDIO_SYNTH_WAVE_SQUARE, .duty = 128, .freq_start_hz = 160, .freq_end_hz = 40, .sweep_ms = 120,
+      .attack_ms = 1, .decay_ms = 120, .sustain = 0, .gain = 24000 },
+    { .wave = APP_AUDIO_SYNTH_WAVE_NOISE, .freq_start_hz = 6000, .freq_end_hz = 800, .sweep_ms = 450,
+      .attack_ms = 1, .decay_ms = 100, .sustain_ms = 50, .release_ms = 300, .sustain = 16384, .gain = 26000,
+      .cutoff_start_hz = 4000, .cutoff_end_hz = 300 }
+};
+
+
+/******************************************************************************/
+/* Global Data Definitions                                                    */
+/******************************************************************************/
+// Asset table for sound effects
+const audio_asset_s audio_assets[AUDIO_SOUND_EFFECT_MAX] = {
+    [AUDIO_SOUND_EFFECT_GET_ITEM] = {
+        .data        = audio_synth_get_item,
+        .n_samples   = AUDIO_SYNTH_N_NOTES(audio_synth_get_item),
+        .sample_rate = APP_AUDIO_MIXER_SAMPLE_RATE_HZ,
+        .format      = AUDIO_ASSET_FORMAT_SYNTH
+    },
+    [AUDIO_SOUND_EFFECT_USE_SHIELD] = {
+        .data        = audio_synth_use_shield,
+        .n_samples   = AUDIO_SYNTH_N_NOTES(audio_synth_use_shield),
+        .sample_rate = APP_AUDIO_MIXER_SAMPLE_RATE_HZ,
+        .format      = AUDIO_ASSET_FORMAT_SYNTH
+    },
+    [AUDIO_SOUND_EFFECT_USE_SHOT] = {
+        .data        = audio_synth_use_shot,
+        .n_samples   = AUDIO_SYNTH_N_NOTES(audio_synth_use_shot),
+        .sample_rate = APP_AUDIO_MIXER_SAMPLE_RATE_HZ,
+        .format      = AUDIO_ASSET_FORMAT_SYNTH
+    },
+    [AUDIO_SOUND_EFFECT_BOOST] = {
+        .data        = audio_synth_boost,
+        .n_samples   = AUDIO_SYNTH_N_NOTES(audio_synth_boost),
+        .sample_rate = APP_AUDIO_MIXER_SAMPLE_RATE_HZ,
+        .format      = AUDIO_ASSET_FORMAT_SYNTH
+    },
+    [AUDIO_SOUND_EFFECT_HIT] = {
+        .data        = audio_synth_hit,
+        .n_samples   = AUDIO_SYNTH_N_NOTES(audio_synth_hit),
+        .sample_rate = APP_AUDIO_MIXER_SAMPLE_RATE_HZ,
+        .format      = AUDIO_ASSET_FORMAT_SYNTH
+    }
+};
+
+#endif // AUDIO_SYNTH_SOUND_EFFECTS
+
+/* [] END OF FILE */
@@ -0,0 +1,385 @@
+/**
+ * @file adpcm_check.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host round-trip check of the IMA-ADPCM sound effects. Every ADPCM clip is
+ * decoded with the decoder the car runs (app_audio_adpcm.c), a playback
+ * buffer at a time, and compared against the uncompressed samples it was
+ * encoded from. A clip fails if its SNR falls below its floor, so a change
+ * to the encoder, the decoder, or the clips that costs quality is caught.
+ *
+ * The built-in sound effects (audio_sample_luts.c) are compared against the
+ * uncompressed LUTs they replaced, kept in ref/ as 20 kHz WAV files. Their
+ * floors are in check_lut_floors_db, about 1.5 dB under what they measured
+ * when they were encoded. The clips in the audio store can be checked too,
+ * from what compile_audio_assets.py --dump-dir writes: each clip's source
+ * PCM and encoded data, and a list of the clips with their floors.
+ *
+ * Usage:
+ *   adpcm_check [-r <ref dir>] [-d <dump dir>]
+ *
+ * Exits 0 if every clip decodes to the right length and meets its floor
+ *
+ * @version 0.1
+ * @date 2024-12-28
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio_adpcm.h"
+#include "data/audio_sample_luts.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define CHECK_DEFAULT_REF_DIR   "ref"
+#define CHECK_CHUNK_SAMPLES     (256U)      // AUDIO_PINGPONG_SAMPLES, as the mixer asks for them
+#define CHECK_MAX_PATH          (512U)
+#define CHECK_MAX_NAME          (64U)
+
+#define EXIT_PASS               (0)
+#define EXIT_FAIL               (1)
+#define EXIT_ERROR              (2)
+
+typedef struct
+{
+    const char* name;           // File name in the ref directory, without .wav
+    double min_snr_db;
+} check_lut_s;
+
+
+/******************************************************************************
+ * Global Variables                                                           *
+ ******************************************************************************/
+// Measured when the LUTs were first encoded: 29.5, 22.2, 19.6, 18.3 and 27.2 dB
+static const check_lut_s check_luts[AUDIO_SOUND_EFFECT_MAX] = {
+    [AUDIO_SOUND_EFFECT_GET_ITEM]   = { "get_item",   28.0 },
+    [AUDIO_SOUND_EFFECT_USE_SHIELD] = { "use_shield", 20.5 },
+    [AUDIO_SOUND_EFFECT_USE_SHOT]   = { "use_shot",   18.0 },
+    [AUDIO_SOUND_EFFECT_BOOST]      = { "boost",      16.5 },
+    [AUDIO_SOUND_EFFECT_HIT]        = { "hit",        25.5 },
+};
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Read a little-endian number out of a file's bytes
+ *
+ * @param const uint8_t*
+ * Where it starts
+ * @param uint32_t
+ * How many bytes it is
+ * @return uint32_t
+ * Number
+ */
+static uint32_t check_le(const uint8_t* p, uint32_t n_bytes)
+{
+    uint32_t value = 0;
+
+    for (uint32_t i = n_bytes; i > 0; i--)
+    {
+        value = (value << 8) | p[i - 1];
+    }
+    return value;
+}
+
+
+/**
+ * @brief  Read a whole file
+ *
+ * @param const char*
+ * File to read
+ * @param uint32_t*
+ * Where to write its size (bytes)
+ * @return uint8_t*
+ * Its contents, to be freed, or NULL if it couldn't be read
+ */
+static uint8_t* check_read_file(const char* path, uint32_t* n_bytes)
+{
+    FILE* file = fopen(path, "rb");
+    uint8_t* data = NULL;
+    long size;
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't open %s\n", path);
+        return NULL;
+    }
+    if ((fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) >= 0) && (fseek(file, 0, SEEK_SET) == 0))
+    {
+        data = malloc((size_t)size + 1U);
+        if ((data != NULL) && (fread(data, 1, (size_t)size, file) != (size_t)size))
+        {
+            free(data);
+            data = NULL;
+        }
+        *n_bytes = (uint32_t)size;
+    }
+    fclose(file);
+    if (data == NULL)
+    {
+        fprintf(stderr, "Can't read %s\n", path);
+    }
+    return data;
+}
+
+
+/**
+ * @brief  Read the samples out of a 16-bit mono WAV file
+ *
+ * @param const char*
+ * File to read
+ * @param uint32_t*
+ * Where to write the number of samples
+ * @return int16_t*
+ * Samples, to be freed, or NULL if it couldn't be read
+ */
+static int16_t* check_read_wav(const char* path, uint32_t* n_samples)
+{
+    uint32_t n_bytes = 0;
+    uint8_t* wav = check_read_file(path, &n_bytes);
+    int16_t* samples = NULL;
+    bool mono16 = false;
+
+    if (wav == NULL)
+    {
+        return NULL;
+    }
+    if ((n_bytes < 12U) || (memcmp(wav, "RIFF", 4) != 0) || (memcmp(&wav[8], "WAVE", 4) != 0))
+    {
+        fprintf(stderr, "%s isn't a WAV file\n", path);
+        free(wav);
+        return NULL;
+    }
+
+    for (uint32_t pos = 12U; (pos + 8U) <= n_bytes; )
+    {
+        const uint32_t chunk_bytes = check_le(&wav[pos + 4U], 4);
+        const uint8_t* chunk = &wav[pos + 8U];
+
+        if ((pos + 8U + chunk_bytes) > n_bytes)
+        {
+            break;
+        }
+        if ((memcmp(&wav[pos], "fmt ", 4) == 0) && (chunk_bytes >= 16U))
+        {
+            mono16 = (check_le(&chunk[0], 2) == 1U) && (check_le(&chunk[2], 2) == 1U) && (check_le(&chunk[14], 2) == 16U);
+        }
+        else if ((memcmp(&wav[pos], "data", 4) == 0) && mono16)
+        {
+            *n_samples = chunk_bytes / 2U;
+            samples = malloc((*n_samples + 1U) * sizeof(*samples));
+            for (uint32_t i = 0; (samples != NULL) && (i < *n_samples); i++)
+            {
+                samples[i] = (int16_t)check_le(&chunk[2U * i], 2);
+            }
+            break;
+        }
+        pos += 8U + chunk_bytes + (chunk_bytes & 1U);
+    }
+    if (samples == NULL)
+    {
+        fprintf(stderr, "%s isn't 16-bit mono PCM\n", path);
+    }
+    free(wav);
+    return samples;
+}
+
+
+/**
+ * @brief  Decode a clip and compare it against the samples it was encoded
+ *         from
+ *
+ * @param const char*
+ * Clip's name, to print
+ * @param const uint8_t*
+ * Clip's ADPCM blocks
+ * @param uint32_t
+ * Number of samples in the clip
+ * @param const int16_t*
+ * Samples it was encoded from
+ * @param uint32_t
+ * Number of samples it was encoded from
+ * @param double
+ * Lowest SNR that passes (dB)
+ * @return bool
+ * true if it passes
+ */
+static bool check_clip(const char* name, const uint8_t* data, uint32_t n_samples,
+                       const int16_t* ref, uint32_t n_ref, double min_snr_db)
+{
+    app_audio_adpcm_decoder_s dec;
+    int16_t* out = malloc((n_samples + CHECK_CHUNK_SAMPLES) * sizeof(*out));
+    uint32_t n_out = 0;
+    uint32_t n;
+    double mean = 0.0;
+    double signal = 0.0;
+    double noise = 0.0;
+
+    if (out == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_ERROR);
+    }
+
+    app_audio_adpcm_init(&dec, data, n_samples);
+    while ((n = app_audio_adpcm_decode(&dec, &out[n_out], CHECK_CHUNK_SAMPLES)) > 0)
+    {
+        n_out += n;
+    }
+
+    if ((n_out != n_samples) || (n_ref != n_samples))
+    {
+        printf("%-12s %7u samples decoded, %7u expected, %7u in the source: FAIL\n", name, n_out, n_samples, n_ref);
+        free(out);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < n_ref; i++)
+    {
+        mean += ref[i];
+    }
+    mean /= n_ref;
+    for (uint32_t i = 0; i < n_ref; i++)
+    {
+        const double err = (double)ref[i] - out[i];
+        signal += (ref[i] - mean) * (ref[i] - mean);
+        noise += err * err;
+    }
+    free(out);
+
+    const double snr_db = (noise == 0.0) ? INFINITY : (10.0 * log10(signal / noise));
+    const bool ok = snr_db >= min_snr_db;
+    printf("%-12s %7u samples, SNR %5.1f dB (min %4.1f dB): %s\n", name, n_samples, snr_db, min_snr_db, ok ? "pass" : "FAIL");
+    return ok;
+}
+
+
+/**
+ * @brief  Check the built-in sound effects against the uncompressed LUTs
+ *
+ * @param const char*
+ * Directory holding the LUTs as WAV files
+ * @return uint32_t
+ * Number of clips that failed
+ */
+static uint32_t check_luts_against(const char* ref_dir)
+{
+    uint32_t n_failed = 0;
+    char path[CHECK_MAX_PATH];
+
+    for (uint32_t i = 0; i < AUDIO_SOUND_EFFECT_MAX; i++)
+    {
+        const audio_asset_s* asset = &audio_assets[i];
+        uint32_t n_ref = 0;
+
+        if ((asset->format != AUDIO_ASSET_FORMAT_ADPCM) || (asset->data == NULL))
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s.wav", ref_dir, check_luts[i].name);
+        int16_t* ref = check_read_wav(path, &n_ref);
+        if ((ref == NULL) || !check_clip(check_luts[i].name, asset->data, asset->n_samples, ref, n_ref, check_luts[i].min_snr_db))
+        {
+            n_failed++;
+        }
+        free(ref);
+    }
+    return n_failed;
+}
+
+
+/**
+ * @brief  Check the clips compile_audio_assets.py dumped
+ *
+ * @param const char*
+ * Directory it dumped them to
+ * @return uint32_t
+ * Number of clips that failed
+ */
+static uint32_t check_dump(const char* dump_dir)
+{
+    uint32_t n_failed = 0;
+    char path[CHECK_MAX_PATH];
+    char name[CHECK_MAX_NAME];
+    double min_snr_db;
+
+    snprintf(path, sizeof(path), "%s/clips.txt", dump_dir);
+    FILE* list = fopen(path, "r");
+    if (list == NULL)
+    {
+        fprintf(stderr, "Can't open %s\n", path);
+        return 1;
+    }
+
+    while (fscanf(list, "%63s %lf", name, &min_snr_db) == 2)
+    {
+        uint32_t n_ref = 0;
+        uint32_t n_bytes = 0;
+
+        snprintf(path, sizeof(path), "%s/%s.wav", dump_dir, name);
+        int16_t* ref = check_read_wav(path, &n_ref);
+        snprintf(path, sizeof(path), "%s/%s.adpcm", dump_dir, name);
+        uint8_t* data = check_read_file(path, &n_bytes);
+
+        // Every sample of the source is encoded, and the last block is cut short after its last code
+        const uint32_t n_last = n_ref % APP_AUDIO_ADPCM_BLOCK_SAMPLES;
+        const uint32_t n_needed = ((n_ref / APP_AUDIO_ADPCM_BLOCK_SAMPLES) * APP_AUDIO_ADPCM_BLOCK_BYTES) +
+                                  ((n_last > 0) ? (APP_AUDIO_ADPCM_BLOCK_HEADER_BYTES + (n_last / 2U)) : 0U);
+        if ((ref != NULL) && (data != NULL) && (n_bytes < n_needed))
+        {
+            printf("%-12s %7u bytes, %7u needed for its source: FAIL\n", name, n_bytes, n_needed);
+            n_failed++;
+        }
+        else if ((ref == NULL) || (data == NULL) || !check_clip(name, data, n_ref, ref, n_ref, min_snr_db))
+        {
+            n_failed++;
+        }
+        free(ref);
+        free(data);
+    }
+    fclose(list);
+    return n_failed;
+}
+
+
+int main(int argc, char** argv)
+{
+    const char* ref_dir = CHECK_DEFAULT_REF_DIR;
+    const char* dump_dir = NULL;
+    uint32_t n_failed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-r") == 0) && ((i + 1) < argc))
+        {
+            ref_dir = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-d") == 0) && ((i + 1) < argc))
+        {
+            dump_dir = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-r <ref dir>] [-d <dump dir>]\n", argv[0]);
+            return EXIT_ERROR;
+        }
+    }
+
+    printf("Built-in sound effects, against the uncompressed LUTs in %s:\n", ref_dir);
+    n_failed += check_luts_against(ref_dir);
+    if (dump_dir != NULL)
+    {
+        printf("Audio store clips, against their sources in %s:\n", dump_dir);
+        n_failed += check_dump(dump_dir);
+    }
+
+    printf("%s\n", (n_failed == 0) ? "PASS" : "FAIL");
+    return (n_failed == 0) ? EXIT_PASS : EXIT_FAIL;
+}
@@ -0,0 +1,774 @@
+/**
+ * @file audio_render.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host render harness for the audio driver. app_audio.c and everything under
+ * it is built for the host against fake DMA/CTDAC hardware (fake_hw.c), a
+ * list of timed requests is played through it, and whatever the DMA writes to
+ * CTDAC_VAL_NXT is saved as a WAV file. Renders can then be compared against
+ * reference renders, so codec, mixer, and resampler changes can be measured
+ * without a car.
+ *
+ * Usage:
+ *   audio_render render -o <out.wav> [-t <ms>] [-s <store.bin>] <event>...
+ *   audio_render compare <ref.wav> <test.wav> [--min-snr <dB>] [--max-lsd <dB>]
+ *
+ * Events are <ms>:effect:<idx>[:<pitch_pct>], <ms>:tone:<amp_mdB>:<hz>, <ms>:stop_tone,
+ * <ms>:chirp:<start_hz>:<end_hz>:<duration_ms>:<amp_mdB>, <ms>:cue:<idx>,
+ * <ms>:engine:<speed>, and <ms>:engine_off.
+ * Without -t, rendering stops once everything has finished playing
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_audio.h"
+#include "fake_hw.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define RENDER_MAX_EVENTS        (64U)
+#define RENDER_MAX_MS            (60000U)
+// Silence kept after everything stops, so tails and fades are captured
+#define RENDER_TAIL_SAMPLES      (4U * APP_AUDIO_MIXER_BLOCK_SAMPLES)
+
+#define COMPARE_FRAME            (1024U)
+#define COMPARE_HOP              (COMPARE_FRAME / 2U)
+// Frames quieter than this (in both renders) are left out of the spectral distance
+#define COMPARE_SILENT_DBFS      (-60.0)
+#define COMPARE_POWER_FLOOR      (1e-12)
+
+#define EXIT_PASS                (0)
+#define EXIT_FAIL                (1)
+#define EXIT_ERROR               (2)
+
+typedef enum
+{
+    RENDER_EVENT_EFFECT    = 0,
+    RENDER_EVENT_TONE      = 1,
+    RENDER_EVENT_STOP_TONE = 2,
+    RENDER_EVENT_CHIRP     = 3,
+    RENDER_EVENT_CUE       = 4,
+    RENDER_EVENT_ENGINE    = 5,
+    RENDER_EVENT_ENGINE_OFF = 6
+} render_event_type_e;
+
+typedef struct
+{
+    uint32_t time_ms;
+    render_event_type_e type;
+    uint32_t args[4];
+} render_event_s;
+
+typedef struct
+{
+    int16_t* samples;
+    uint32_t n_samples;
+    uint32_t sample_rate;
+} wav_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static render_event_s render_events[RENDER_MAX_EVENTS];
+static uint32_t render_n_events = 0;
+static volatile bool render_refill_pending = false;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Stream refill callback. The harness stands in for the refill task
+ *
+ * @return void
+ */
+static void render_stream_refill(void)
+{
+    render_refill_pending = true;
+}
+
+
+/**
+ * @brief  Parse an event from the command line
+ *
+ * @param const char*
+ * Event, as <ms>:<type>[:<arg>...]
+ * @param render_event_s*
+ * Where to write the parsed event
+ * @return bool
+ * true if the event is valid
+ */
+static bool render_parse_event(const char* arg, render_event_s* event)
+{
+    char type[16];
+    int n_chars = 0;
+
+    memset(event, 0, sizeof(*event));
+    if (sscanf(arg, "%u:%15[a-z_]%n", &event->time_ms, type, &n_chars) != 2)
+    {
+        return false;
+    }
+    arg += n_chars;
+
+    if (strcmp(type, "effect") == 0)
+    {
+        event->type = RENDER_EVENT_EFFECT;
+        event->args[1] = 100;
+        return (sscanf(arg, ":%u:%u", &event->args[0], &event->args[1]) >= 1) &&
+               (event->args[0] < AUDIO_SOUND_EFFECT_MAX) && (event->args[1] > 0);
+    }
+    if (strcmp(type, "tone") == 0)
+    {
+        event->type = RENDER_EVENT_TONE;
+        return sscanf(arg, ":%u:%u", &event->args[0], &event->args[1]) == 2;
+    }
+    if (strcmp(type, "stop_tone") == 0)
+    {
+        event->type = RENDER_EVENT_STOP_TONE;
+        return *arg == '\0';
+    }
+    if (strcmp(type, "chirp") == 0)
+    {
+        event->type = RENDER_EVENT_CHIRP;
+        return sscanf(arg, ":%u:%u:%u:%u", &event->args[0], &event->args[1], &event->args[2], &event->args[3]) == 4;
+    }
+    if (strcmp(type, "cue") == 0)
+    {
+        event->type = RENDER_EVENT_CUE;
+        return (sscanf(arg, ":%u", &event->args[0]) == 1) && (event->args[0] < APP_AUDIO_CUE_MAX);
+    }
+    if (strcmp(type, "engine") == 0)
+    {
+        event->type = RENDER_EVENT_ENGINE;
+        return (sscanf(arg, ":%u", &event->args[0]) == 1) && (event->args[0] <= APP_AUDIO_ENGINE_MAX_SPEED);
+    }
+    if (strcmp(type, "engine_off") == 0)
+    {
+        event->type = RENDER_EVENT_ENGINE_OFF;
+        return *arg == '\0';
+    }
+    return false;
+}
+
+
+/**
+ * @brief  Make the request an event describes, the same way task_audio does
+ *
+ * @param const render_event_s*
+ * Event to play
+ */
+static void render_play_event(const render_event_s* event)
+{
+    switch (event->type)
+    {
+        case RENDER_EVENT_EFFECT:
+            (void)app_audio_play_sound_effect_pitched((audio_sound_effect_e)event->args[0],
+                                                      (uint16_t)((event->args[1] * APP_AUDIO_MIXER_PITCH_UNITY) / 100));
+            break;
+
+        case RENDER_EVENT_TONE:
+            app_audio_play_tone(event->args[0], event->args[1]);
+            break;
+
+        case RENDER_EVENT_STOP_TONE:
+            app_audio_stop_tone();
+            break;
+
+        case RENDER_EVENT_CHIRP:
+        {
+            const app_audio_dds_segment_s chirp =
+            {
+                .freq_start_hz = (uint16_t)event->args[0],
+                .freq_end_hz   = (uint16_t)event->args[1],
+                .gain          = (int16_t)((event->args[3] * APP_AUDIO_MIXER_GAIN_UNITY) / (MAX_AMP_mDB - MIN_AMP_mDB)),
+                .duration_ms   = (uint16_t)event->args[2]
+            };
+            app_audio_play_tone_sequence(&chirp, 1);
+            break;
+        }
+
+        case RENDER_EVENT_CUE:
+            app_audio_play_cue((app_audio_cue_e)event->args[0]);
+            break;
+
+        case RENDER_EVENT_ENGINE:
+            app_audio_engine_set(true, (uint8_t)event->args[0]);
+            break;
+
+        case RENDER_EVENT_ENGINE_OFF:
+            app_audio_engine_set(false, 0);
+            break;
+    }
+}
+
+
+/**
+ * @brief  Read a whole file into memory
+ *
+ * @param const char*
+ * Path of the file
+ * @param uint32_t*
+ * Where to write the size of the file
+ * @return uint8_t*
+ * Contents of the file (to be freed), or NULL if it couldn't be read
+ */
+static uint8_t* render_read_file(const char* path, uint32_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    uint8_t* data = NULL;
+
+    if (f == NULL)
+    {
+        return NULL;
+    }
+    if ((fseek(f, 0, SEEK_END) == 0) && (ftell(f) > 0))
+    {
+        *size = (uint32_t)ftell(f);
+        data = malloc(*size);
+        rewind(f);
+        if ((data != NULL) && (fread(data, 1, *size, f) != *size))
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+
+/**
+ * @brief  Write little endian values to a file
+ *
+ * @param FILE*
+ * File to write to
+ * @param uint32_t
+ * Value to write
+ * @param uint8_t
+ * Number of bytes to write
+ */
+static void wav_put(FILE* f, uint32_t value, uint8_t n_bytes)
+{
+    for (uint8_t i = 0; i < n_bytes; i++)
+    {
+        fputc((int)((value >> (8U * i)) & 0xFFU), f);
+    }
+}
+
+
+/**
+ * @brief  Save samples as a 16-bit mono WAV file
+ *
+ * @param const char*
+ * Path to write to
+ * @param const wav_s*
+ * Samples to write
+ * @return bool
+ * true if the file was written
+ */
+static bool wav_write(const char* path, const wav_s* wav)
+{
+    FILE* f = fopen(path, "wb");
+    const uint32_t data_bytes = wav->n_samples * sizeof(int16_t);
+
+    if (f == NULL)
+    {
+        return false;
+    }
+    fwrite("RIFF", 1, 4, f);
+    wav_put(f, 36U + data_bytes, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    wav_put(f, 16, 4);                          // fmt chunk size
+    wav_put(f, 1, 2);                           // PCM
+    wav_put(f, 1, 2);                           // Mono
+    wav_put(f, wav->sample_rate, 4);
+    wav_put(f, wav->sample_rate * 2U, 4);       // Byte rate
+    wav_put(f, 2, 2);                           // Block align
+    wav_put(f, 16, 2);                          // Bits per sample
+    fwrite("data", 1, 4, f);
+    wav_put(f, data_bytes, 4);
+    for (uint32_t i = 0; i < wav->n_samples; i++)
+    {
+        wav_put(f, (uint16_t)wav->samples[i], 2);
+    }
+    return fclose(f) == 0;
+}
+
+
+/**
+ * @brief  Load a 16-bit mono WAV file
+ *
+ * @param const char*
+ * Path to read from
+ * @param wav_s*
+ * Where to write the samples (to be freed)
+ * @return bool
+ * true if the file is a 16-bit mono WAV file
+ */
+static bool wav_read(const char* path, wav_s* wav)
+{
+    uint32_t size = 0;
+    uint8_t* data = render_read_file(path, &size);
+    bool ok = false;
+
+    memset(wav, 0, sizeof(*wav));
+    if ((data == NULL) || (size < 12) || (memcmp(data, "RIFF", 4) != 0) || (memcmp(&data[8], "WAVE", 4) != 0))
+    {
+        free(data);
+        return false;
+    }
+
+    // Walk the chunks for the format and the samples
+    bool have_fmt = false;
+    for (uint32_t pos = 12; (pos + 8) <= size;)
+    {
+        const uint32_t chunk_size = data[pos + 4] | (data[pos + 5] << 8) | (data[pos + 6] << 16) | ((uint32_t)data[pos + 7] << 24);
+        const uint8_t* chunk = &data[pos + 8];
+
+        if ((pos + 8 + chunk_size) > size)
+        {
+            break;
+        }
+        if ((memcmp(&data[pos], "fmt ", 4) == 0) && (chunk_size >= 16))
+        {
+            const uint16_t format = chunk[0] | (chunk[1] << 8);
+            const uint16_t n_channels = chunk[2] | (chunk[3] << 8);
+            const uint16_t bits = chunk[14] | (chunk[15] << 8);
+            wav->sample_rate = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+            have_fmt = (format == 1) && (n_channels == 1) && (bits == 16);
+        }
+        else if ((memcmp(&data[pos], "data", 4) == 0) && have_fmt)
+        {
+            wav->n_samples = chunk_size / 2U;
+            wav->samples = malloc((wav->n_samples + 1U) * sizeof(int16_t));
+            for (uint32_t i = 0; (wav->samples != NULL) && (i < wav->n_samples); i++)
+            {
+                wav->samples[i] = (int16_t)(chunk[2U * i] | (chunk[(2U * i) + 1U] << 8));
+            }
+            ok = (wav->samples != NULL);
+            break;
+        }
+        pos += 8U + chunk_size + (chunk_size & 1U);
+    }
+
+    free(data);
+    return ok;
+}
+
+
+/**
+ * @brief  Play the events through the audio driver and capture the CTDAC
+ *
+ * @param uint32_t
+ * Length to render in ms, or 0 to stop once everything has finished playing
+ * @param wav_s*
+ * Where to write the capture (to be freed)
+ * @return bool
+ * true if the output ran the whole time
+ */
+static bool render_run(uint32_t duration_ms, wav_s* wav)
+{
+    app_audio_set_stream_refill_callback(render_stream_refill);
+    app_audio_init();
+    // The host counts nanoseconds rather than CM4 cycles, so the per-block budget means
+    // nothing here. Lift it, or a slow block on a busy host would change the render
+    app_audio_mixer_init(UINT32_MAX);
+
+    const double sample_rate = fake_hw_sample_rate_hz();
+    const uint32_t max_samples = (uint32_t)((sample_rate * ((duration_ms > 0) ? duration_ms : RENDER_MAX_MS)) / 1000.0);
+    uint32_t next_event = 0;
+    uint32_t n_idle = 0;
+
+    wav->sample_rate = (uint32_t)lround(sample_rate);
+    wav->samples = malloc(max_samples * sizeof(int16_t));
+    wav->n_samples = 0;
+    if (wav->samples == NULL)
+    {
+        return false;
+    }
+
+    while (wav->n_samples < max_samples)
+    {
+        const double now_ms = (wav->n_samples * 1000.0) / sample_rate;
+        for (; (next_event < render_n_events) && (render_events[next_event].time_ms <= now_ms); next_event++)
+        {
+            render_play_event(&render_events[next_event]);
+        }
+
+        uint16_t sample;
+        if (!fake_hw_dac_tick(&sample))
+        {
+            return false;
+        }
+        // Same scaling the mixer uses for DAC samples, so the WAV is lossless
+        wav->samples[wav->n_samples++] = (int16_t)(((int32_t)sample - 2048) * 16);
+
+        // The refill task would run as soon as the interrupt returns
+        if (render_refill_pending)
+        {
+            render_refill_pending = false;
+            app_audio_stream_refill();
+        }
+
+        if ((duration_ms == 0) && (next_event >= render_n_events))
+        {
+            const bool idle = (app_audio_mixer_n_active() == 0) && !app_audio_dds_active() && !app_audio_engine_active();
+            n_idle = idle ? (n_idle + 1) : 0;
+            if (n_idle >= RENDER_TAIL_SAMPLES)
+            {
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief  In-place radix-2 FFT
+ *
+ * @param double*
+ * Real parts
+ * @param double*
+ * Imaginary parts
+ * @param uint32_t
+ * Number of points (power of 2)
+ */
+static void compare_fft(double* re, double* im, uint32_t n)
+{
+    for (uint32_t i = 1, j = 0; i < n; i++)
+    {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (uint32_t len = 2; len <= n; len <<= 1)
+    {
+        const double angle = -2.0 * M_PI / len;
+        for (uint32_t i = 0; i < n; i += len)
+        {
+            for (uint32_t k = 0; k < (len / 2U); k++)
+            {
+                const double wr = cos(angle * k);
+                const double wi = sin(angle * k);
+                const uint32_t a = i + k;
+                const uint32_t b = a + (len / 2U);
+                const double xr = (re[b] * wr) - (im[b] * wi);
+                const double xi = (re[b] * wi) + (im[b] * wr);
+                re[b] = re[a] - xr;
+                im[b] = im[a] - xi;
+                re[a] += xr;
+                im[a] += xi;
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief  Power spectrum of one Hann-windowed frame
+ *
+ * @param const int16_t*
+ * Start of the frame (COMPARE_FRAME samples)
+ * @param double*
+ * Where to write COMPARE_FRAME / 2 + 1 bins
+ * @return double
+ * Mean square level of the frame (full scale = 1)
+ */
+static double compare_spectrum(const int16_t* samples, double* power)
+{
+    static double re[COMPARE_FRAME];
+    static double im[COMPARE_FRAME];
+    double energy = 0.0;
+
+    for (uint32_t i = 0; i < COMPARE_FRAME; i++)
+    {
+        const double x = samples[i] / 32768.0;
+        energy += x * x;
+        re[i] = x * (0.5 - (0.5 * cos((2.0 * M_PI * i) / COMPARE_FRAME)));
+        im[i] = 0.0;
+    }
+    compare_fft(re, im, COMPARE_FRAME);
+    for (uint32_t i = 0; i <= (COMPARE_FRAME / 2U); i++)
+    {
+        power[i] = (re[i] * re[i]) + (im[i] * im[i]) + COMPARE_POWER_FLOOR;
+    }
+    return energy / COMPARE_FRAME;
+}
+
+
+/**
+ * @brief  Compare a render against a reference. Reports the SNR (treating any
+ *         difference as noise) and the log-spectral distance, which is what
+ *         still shows when the difference is only a shift in phase
+ *
+ * @param const char*
+ * Reference render
+ * @param const char*
+ * Render to check
+ * @param double
+ * Lowest SNR to pass (dB)
+ * @param double
+ * Highest log-spectral distance to pass (dB)
+ * @return int
+ * EXIT_PASS, EXIT_FAIL, or EXIT_ERROR
+ */
+static int compare_run(const char* ref_path, const char* test_path, double min_snr_db, double max_lsd_db)
+{
+    wav_s ref;
+    wav_s test;
+
+    if (!wav_read(ref_path, &ref) || !wav_read(test_path, &test))
+    {
+        fprintf(stderr, "Can't read %s and %s as 16-bit mono WAV files\n", ref_path, test_path);
+        return EXIT_ERROR;
+    }
+    if (ref.sample_rate != test.sample_rate)
+    {
+        printf("%s: sample rate %u Hz, reference is %u Hz\n", test_path, test.sample_rate, ref.sample_rate);
+        return EXIT_FAIL;
+    }
+
+    // Anything past the shorter render counts as difference
+    const uint32_t n_samples = (ref.n_samples > test.n_samples) ? ref.n_samples : test.n_samples;
+    double signal = 0.0;
+    double noise = 0.0;
+    for (uint32_t i = 0; i < n_samples; i++)
+    {
+        const double r = (i < ref.n_samples) ? ref.samples[i] : 0.0;
+        const double t = (i < test.n_samples) ? test.samples[i] : 0.0;
+        signal += r * r;
+        noise += (r - t) * (r - t);
+    }
+    const double snr_db = (noise == 0.0) ? INFINITY : 10.0 * log10(signal / noise);
+
+    // Mean over frames of the RMS difference between the log power spectra
+    static double ref_power[(COMPARE_FRAME / 2U) + 1U];
+    static double test_power[(COMPARE_FRAME / 2U) + 1U];
+    const double silent = pow(10.0, COMPARE_SILENT_DBFS / 10.0);
+    const uint32_t n_common = (ref.n_samples < test.n_samples) ? ref.n_samples : test.n_samples;
+    double lsd_total = 0.0;
+    uint32_t n_frames = 0;
+    for (uint32_t pos = 0; (pos + COMPARE_FRAME) <= n_common; pos += COMPARE_HOP)
+    {
+        const double ref_level = compare_spectrum(&ref.samples[pos], ref_power);
+        const double test_level = compare_spectrum(&test.samples[pos], test_power);
+        if ((ref_level < silent) && (test_level < silent))
+        {
+            continue;
+        }
+
+        double sum = 0.0;
+        for (uint32_t i = 0; i <= (COMPARE_FRAME / 2U); i++)
+        {
+            const double d = 10.0 * log10(ref_power[i] / test_power[i]);
+            sum += d * d;
+        }
+        lsd_total += sqrt(sum / ((COMPARE_FRAME / 2U) + 1U));
+        n_frames++;
+    }
+    const double lsd_db = (n_frames > 0) ? (lsd_total / n_frames) : 0.0;
+
+    const bool pass = (snr_db >= min_snr_db) && (lsd_db <= max_lsd_db);
+    printf("%s: %u samples (reference %u), SNR %.1f dB (min %.1f), LSD %.2f dB over %u frames (max %.2f): %s\n",
+           test_path, test.n_samples, ref.n_samples, snr_db, min_snr_db, lsd_db, n_frames, max_lsd_db,
+           pass ? "pass" : "FAIL");
+
+    free(ref.samples);
+    free(test.samples);
+    return pass ? EXIT_PASS : EXIT_FAIL;
+}
+
+
+/**
+ * @brief  Print how to use the harness
+ *
+ * @return int
+ * EXIT_ERROR
+ */
+static int usage(void)
+{
+    fprintf(stderr,
+            "usage: audio_render render -o <out.wav> [-t <ms>] [-s <store.bin>] <event>...\n"
+            "       audio_render compare <ref.wav> <test.wav> [--min-snr <dB>] [--max-lsd <dB>]\n"
+            "events: <ms>:effect:<idx>[:<pitch_pct>]  <ms>:tone:<amp_mdB>:<hz>  <ms>:stop_tone\n"
+            "        <ms>:chirp:<start_hz>:<end_hz>:<duration_ms>:<amp_mdB>  <ms>:cue:<idx>\n"
+            "        <ms>:engine:<speed>  <ms>:engine_off\n");
+    return EXIT_ERROR;
+}
+
+
+/**
+ * @brief  Render a list of events to a WAV file
+ *
+ * @param int
+ * Number of arguments after "render"
+ * @param char**
+ * Arguments after "render"
+ * @return int
+ * EXIT_PASS or EXIT_ERROR
+ */
+static int render_main(int argc, char** argv)
+{
+    const char* out_path = NULL;
+    const char* store_path = NULL;
+    uint32_t duration_ms = 0;
+    uint8_t* store = NULL;
+    uint32_t store_size = 0;
+    wav_s wav;
+
+    for (int i = 0; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-o") == 0) && ((i + 1) < argc))
+        {
+            out_path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-t") == 0) && ((i + 1) < argc))
+        {
+            duration_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((strcmp(argv[i], "-s") == 0) && ((i + 1) < argc))
+        {
+            store_path = argv[++i];
+        }
+        else if ((render_n_events < RENDER_MAX_EVENTS) && render_parse_event(argv[i], &render_events[render_n_events]))
+        {
+            render_n_events++;
+        }
+        else
+        {
+            fprintf(stderr, "Bad argument: %s\n", argv[i]);
+            return usage();
+        }
+    }
+    if ((out_path == NULL) || (duration_ms > RENDER_MAX_MS))
+    {
+        return usage();
+    }
+
+    // Events are played in time order, and ties in the order given
+    for (uint32_t i = 1; i < render_n_events; i++)
+    {
+        const render_event_s event = render_events[i];
+        uint32_t j = i;
+        for (; (j > 0) && (render_events[j - 1].time_ms > event.time_ms); j--)
+        {
+            render_events[j] = render_events[j - 1];
+        }
+        render_events[j] = event;
+    }
+
+    if (store_path != NULL)
+    {
+        store = render_read_file(store_path, &store_size);
+        if (store == NULL)
+        {
+            fprintf(stderr, "Can't read %s\n", store_path);
+            return EXIT_ERROR;
+        }
+        fake_hw_set_flash(store, APP_AUDIO_STORE_FLASH_ADDR, store_size);
+    }
+
+    if (!render_run(duration_ms, &wav))
+    {
+        fprintf(stderr, "Audio output stopped\n");
+        return EXIT_ERROR;
+    }
+    if (!wav_write(out_path, &wav))
+    {
+        fprintf(stderr, "Can't write %s\n", out_path);
+        return EXIT_ERROR;
+    }
+
+    app_audio_mixer_stats_s mixer_stats;
+    app_audio_stream_stats_s stream_stats;
+    app_audio_load_stats_s load_stats;
+    app_audio_get_mixer_stats(&mixer_stats);
+    app_audio_get_stream_stats(&stream_stats);
+    app_audio_get_load_stats(&load_stats);
+    printf("%s: %u samples at %.2f Hz (%.0f ms), %u DMA interrupts, %u voices max, %u sound effects streamed, %u underruns\n",
+           out_path, wav.n_samples, fake_hw_sample_rate_hz(), (wav.n_samples * 1000.0) / fake_hw_sample_rate_hz(),
+           fake_hw_n_interrupts(), mixer_stats.max_active_voices, app_audio_store_n_streamed(), stream_stats.n_underruns);
+    // Host time, so only useful for comparing changes on the same machine
+    printf("%s: DMA interrupt took %.2f us per block on average, %.2f us max\n",
+           out_path, (load_stats.n_blocks > 0) ? (load_stats.total_cycles / 1000.0) / load_stats.n_blocks : 0.0,
+           load_stats.max_cycles / 1000.0);
+
+    free(wav.samples);
+    free(store);
+    return EXIT_PASS;
+}
+
+
+/**
+ * @brief  Compare a render against a reference
+ *
+ * @param int
+ * Number of arguments after "compare"
+ * @param char**
+ * Arguments after "compare"
+ * @return int
+ * EXIT_PASS, EXIT_FAIL, or EXIT_ERROR
+ */
+static int compare_main(int argc, char** argv)
+{
+    // By default only an identical render passes
+    double min_snr_db = INFINITY;
+    double max_lsd_db = 0.0;
+
+    if (argc < 2)
+    {
+        return usage();
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "--min-snr") == 0) && ((i + 1) < argc))
+        {
+            min_snr_db = strtod(argv[++i], NULL);
+        }
+        else if ((strcmp(argv[i], "--max-lsd") == 0) && ((i + 1) < argc))
+        {
+            max_lsd_db = strtod(argv[++i], NULL);
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    return compare_run(argv[0], argv[1], min_snr_db, max_lsd_db);
+}
+
+
+int main(int argc, char** argv)
+{
+    if ((argc >= 2) && (strcmp(argv[1], "render") == 0))
+    {
+        return render_main(argc - 2, &argv[2]);
+    }
+    if ((argc >= 2) && (strcmp(argv[1], "compare") == 0))
+    {
+        return compare_main(argc - 2, &argv[2]);
+    }
+    return usage();
+}
+
+/* [] END OF FILE */
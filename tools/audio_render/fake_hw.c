@@ -0,0 +1,350 @@
+/**
+ * @file fake_hw.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Source file for the fake audio hardware. The DW channel is stepped one
+ * element per CTDAC clock, following the descriptors the driver built, and
+ * raises the channel's interrupt when a descriptor completes, just like the
+ * real one. Each tick returns the value written to CTDAC_VAL_NXT, which is
+ * exactly what the speaker would have played
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "fake_hw.h"
+#include "cy_pdl.h"
+#include "cybsp.h"
+#include "cy_serial_flash_qspi.h"
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define FAKE_PCLK_FREQ_HZ       (100000000.0)
+#define FAKE_FRAC_STEPS         (32U)
+#define FAKE_CPU_FREQ_HZ        (100000000UL)
+
+typedef struct
+{
+    bool initialized;
+    bool enabled;
+    bool intr_enabled;
+    bool nvic_enabled;
+    const cy_stc_dma_descriptor_t* descriptor;
+    uint32_t x_idx;               // Next element of the current descriptor
+    cy_israddress isr;
+    uint32_t n_interrupts;
+} fake_dma_channel_s;
+
+
+/******************************************************************************/
+/* Global Data Definitions                                                    */
+/******************************************************************************/
+uint32_t SystemCoreClock = FAKE_CPU_FREQ_HZ;
+DW_Type fake_dw1;
+CTDAC_Type fake_ctdac0;
+const cy_stc_ctdac_fast_config_t Cy_CTDAC_Fast_VddaRef_BufferedOut;
+const cy_stc_sysanalog_config_t Cy_SysAnalog_Fast_Local;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static fake_dma_channel_s fake_dma;
+static uint32_t fake_div_int = 0;
+static uint32_t fake_div_frac = 0;
+static uint32_t fake_div_assigned = 0;
+static const uint8_t* fake_flash_image = NULL;
+static uint32_t fake_flash_addr = 0;
+static uint32_t fake_flash_size = 0;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    return 0;
+}
+
+
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+cy_en_sysint_status_t Cy_SysInt_Init(const cy_stc_sysint_t* config, cy_israddress userIsr)
+{
+    CY_ASSERT(config->intrSrc == cpuss_0_dw1_0_chan_0_IRQ);
+    fake_dma.isr = userIsr;
+    return CY_SYSINT_SUCCESS;
+}
+
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    CY_ASSERT(IRQn == cpuss_0_dw1_0_chan_0_IRQ);
+    fake_dma.nvic_enabled = true;
+}
+
+
+cy_en_sysclk_status_t Cy_SysClk_PeriphDisableDivider(cy_en_divider_types_t dividerType, uint32_t dividerNum)
+{
+    (void)dividerType;
+    (void)dividerNum;
+    return CY_SYSCLK_SUCCESS;
+}
+
+
+cy_en_sysclk_status_t Cy_SysClk_PeriphEnableDivider(cy_en_divider_types_t dividerType, uint32_t dividerNum)
+{
+    (void)dividerType;
+    (void)dividerNum;
+    return CY_SYSCLK_SUCCESS;
+}
+
+
+cy_en_sysclk_status_t Cy_SysClk_PeriphSetFracDivider(cy_en_divider_types_t dividerType, uint32_t dividerNum,
+                                                     uint32_t dividerIntValue, uint32_t dividerFracValue)
+{
+    CY_ASSERT((dividerType == peri_0_div_24_5_0_HW) && (dividerNum == peri_0_div_24_5_0_NUM));
+    CY_ASSERT(dividerFracValue < FAKE_FRAC_STEPS);
+    fake_div_int = dividerIntValue;
+    fake_div_frac = dividerFracValue;
+    return CY_SYSCLK_SUCCESS;
+}
+
+
+cy_en_sysclk_status_t Cy_SysClk_PeriphAssignDivider(en_clk_dst_t ipBlock, cy_en_divider_types_t dividerType,
+                                                    uint32_t dividerNum)
+{
+    (void)ipBlock;
+    fake_div_assigned = _VAL2FLD(PERI_DIV_CMD_TYPE_SEL, dividerType) | _VAL2FLD(PERI_DIV_CMD_DIV_SEL, dividerNum);
+    return CY_SYSCLK_SUCCESS;
+}
+
+
+uint32_t Cy_SysClk_PeriphGetAssignedDivider(en_clk_dst_t ipBlock)
+{
+    (void)ipBlock;
+    return fake_div_assigned;
+}
+
+
+cy_en_sysanalog_status_t Cy_SysAnalog_Init(const cy_stc_sysanalog_config_t* config)
+{
+    (void)config;
+    return CY_SYSANALOG_SUCCESS;
+}
+
+
+void Cy_SysAnalog_Enable(void)
+{
+}
+
+
+cy_en_ctdac_status_t Cy_CTDAC_FastInit(CTDAC_Type* base, const cy_stc_ctdac_fast_config_t* config)
+{
+    (void)config;
+    memset((void*)base, 0, sizeof(*base));
+    return CY_CTDAC_SUCCESS;
+}
+
+
+void Cy_CTDAC_Enable(CTDAC_Type* base)
+{
+    (void)base;
+}
+
+
+cy_en_dma_status_t Cy_DMA_Descriptor_Init(cy_stc_dma_descriptor_t* descriptor, const cy_stc_dma_descriptor_config_t* config)
+{
+    // Only what the audio driver uses is modelled
+    if ((config->descriptorType != CY_DMA_1D_TRANSFER) || (config->xCount == 0) || (config->xCount > 256))
+    {
+        return CY_DMA_BAD_PARAM;
+    }
+
+    descriptor->interruptType = config->interruptType;
+    descriptor->dataSize = config->dataSize;
+    descriptor->srcTransferSize = config->srcTransferSize;
+    descriptor->dstTransferSize = config->dstTransferSize;
+    descriptor->srcAddress = config->srcAddress;
+    descriptor->dstAddress = config->dstAddress;
+    descriptor->srcXincrement = config->srcXincrement;
+    descriptor->dstXincrement = config->dstXincrement;
+    descriptor->xCount = config->xCount;
+    descriptor->nextDescriptor = config->nextDescriptor;
+    return CY_DMA_SUCCESS;
+}
+
+
+cy_en_dma_status_t Cy_DMA_Channel_Init(DW_Type* base, uint32_t channel, const cy_stc_dma_channel_config_t* config)
+{
+    (void)base;
+    (void)channel;
+    fake_dma.initialized = true;
+    fake_dma.descriptor = config->descriptor;
+    fake_dma.enabled = config->enable;
+    fake_dma.x_idx = 0;
+    return CY_DMA_SUCCESS;
+}
+
+
+void Cy_DMA_Channel_SetDescriptor(DW_Type* base, uint32_t channel, const cy_stc_dma_descriptor_t* descriptor)
+{
+    (void)base;
+    (void)channel;
+    fake_dma.descriptor = descriptor;
+    fake_dma.x_idx = 0;
+}
+
+
+void Cy_DMA_Channel_SetInterruptMask(DW_Type* base, uint32_t channel, uint32_t interrupt)
+{
+    (void)base;
+    (void)channel;
+    fake_dma.intr_enabled = (interrupt & CY_DMA_INTR_MASK) != 0;
+}
+
+
+void Cy_DMA_Channel_ClearInterrupt(DW_Type* base, uint32_t channel)
+{
+    (void)base;
+    (void)channel;
+}
+
+
+void Cy_DMA_Channel_Enable(DW_Type* base, uint32_t channel)
+{
+    (void)base;
+    (void)channel;
+    fake_dma.enabled = true;
+}
+
+
+void Cy_DMA_Enable(DW_Type* base)
+{
+    (void)base;
+}
+
+
+cy_rslt_t cy_serial_flash_qspi_read(uint32_t addr, size_t length, uint8_t* buf)
+{
+    if ((fake_flash_image == NULL) || (addr < fake_flash_addr) ||
+        ((addr - fake_flash_addr + length) > fake_flash_size))
+    {
+        // Like erased flash
+        memset(buf, 0xFF, length);
+        return CY_RSLT_SUCCESS;
+    }
+
+    memcpy(buf, &fake_flash_image[addr - fake_flash_addr], length);
+    return CY_RSLT_SUCCESS;
+}
+
+
+/**
+ * @brief  Advance the CTDAC by one clock. The DMA channel writes the next
+ *         element of its descriptor to CTDAC_VAL_NXT, and the interrupt runs
+ *         if that was the descriptor's last element
+ *
+ * @param uint16_t*
+ * Where to write the value written to CTDAC_VAL_NXT
+ * @return bool
+ * false if the channel isn't running, so nothing was written
+ */
+bool fake_hw_dac_tick(uint16_t* sample)
+{
+    const cy_stc_dma_descriptor_t* descriptor = fake_dma.descriptor;
+
+    if (!fake_dma.initialized || !fake_dma.enabled || (descriptor == NULL))
+    {
+        return false;
+    }
+
+    // Read one element from the source and widen it to the destination
+    uint32_t value;
+    if (descriptor->dataSize == CY_DMA_HALFWORD)
+    {
+        value = ((const uint16_t*)descriptor->srcAddress)[fake_dma.x_idx * descriptor->srcXincrement];
+    }
+    else if (descriptor->dataSize == CY_DMA_WORD)
+    {
+        value = ((const uint32_t*)descriptor->srcAddress)[fake_dma.x_idx * descriptor->srcXincrement];
+    }
+    else
+    {
+        value = ((const uint8_t*)descriptor->srcAddress)[fake_dma.x_idx * descriptor->srcXincrement];
+    }
+    CY_ASSERT(descriptor->dstAddress == (void*)&fake_ctdac0.CTDAC_VAL_NXT);
+    fake_ctdac0.CTDAC_VAL_NXT = value;
+    *sample = (uint16_t)(value & 0xFFFU);
+
+    if (++fake_dma.x_idx >= descriptor->xCount)
+    {
+        // Chain to the next descriptor before the interrupt, as the hardware does
+        fake_dma.descriptor = descriptor->nextDescriptor;
+        fake_dma.x_idx = 0;
+        if (fake_dma.descriptor == NULL)
+        {
+            fake_dma.enabled = false;
+        }
+        if ((descriptor->interruptType == CY_DMA_DESCR) && fake_dma.intr_enabled &&
+            fake_dma.nvic_enabled && (fake_dma.isr != NULL))
+        {
+            fake_dma.n_interrupts++;
+            fake_dma.isr();
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief  Get the CTDAC sample rate set by the driver
+ *
+ * @return double
+ * Sample rate from the 24.5 divider, including its fraction
+ */
+double fake_hw_sample_rate_hz(void)
+{
+    return FAKE_PCLK_FREQ_HZ / ((double)(fake_div_int + 1) + ((double)fake_div_frac / FAKE_FRAC_STEPS));
+}
+
+
+/**
+ * @brief  Get how many times the DMA interrupt has run
+ *
+ * @return uint32_t
+ * Number of DMA interrupts
+ */
+uint32_t fake_hw_n_interrupts(void)
+{
+    return fake_dma.n_interrupts;
+}
+
+
+/**
+ * @brief  Set the contents of the external flash
+ *
+ * @param const uint8_t*
+ * Image to read from (not copied)
+ * @param uint32_t
+ * Flash address of the start of the image
+ * @param uint32_t
+ * Size of the image in bytes
+ */
+void fake_hw_set_flash(const uint8_t* image, uint32_t addr, uint32_t size)
+{
+    fake_flash_image = image;
+    fake_flash_addr = addr;
+    fake_flash_size = size;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,29 @@
+/**
+ * @file fake_hw.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Header file for the fake audio hardware the render harness runs the audio
+ * driver against
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __FAKE_HW_H__
+#define __FAKE_HW_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+// Function declarations
+bool fake_hw_dac_tick(uint16_t* sample);
+double fake_hw_sample_rate_hz(void);
+uint32_t fake_hw_n_interrupts(void);
+void fake_hw_set_flash(const uint8_t* image, uint32_t addr, uint32_t size);
+
+
+#endif // __FAKE_HW_H__
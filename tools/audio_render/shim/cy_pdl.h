@@ -0,0 +1,164 @@
+/**
+ * @file cy_pdl.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host stand-in for the parts of the PDL the audio driver uses. The DMA,
+ * CTDAC, clock divider, and interrupt calls are backed by the fake hardware
+ * in fake_hw.c, which plays the DMA descriptors out one sample at a time
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __CY_PDL_H__
+#define __CY_PDL_H__
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/******************************************************************************/
+/* System                                                                     */
+/******************************************************************************/
+#define CY_ASSERT(X)    assert(X)
+#define _VAL2FLD(FIELD, VALUE)    ((uint32_t)(VALUE) << FIELD ## _Pos)
+#define PERI_DIV_CMD_DIV_SEL_Pos     (0U)
+#define PERI_DIV_CMD_TYPE_SEL_Pos    (6U)
+
+typedef uint32_t cy_rslt_t;
+#define CY_RSLT_SUCCESS    ((cy_rslt_t)0)
+
+extern uint32_t SystemCoreClock;
+
+// There is only ever one thread, so critical sections have nothing to do
+uint32_t Cy_SysLib_EnterCriticalSection(void);
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus);
+
+
+/******************************************************************************/
+/* Interrupts                                                                 */
+/******************************************************************************/
+typedef int32_t IRQn_Type;
+typedef void (*cy_israddress)(void);
+typedef struct
+{
+    IRQn_Type intrSrc;
+    uint32_t intrPriority;
+} cy_stc_sysint_t;
+typedef enum { CY_SYSINT_SUCCESS = 0 } cy_en_sysint_status_t;
+
+cy_en_sysint_status_t Cy_SysInt_Init(const cy_stc_sysint_t* config, cy_israddress userIsr);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+
+
+/******************************************************************************/
+/* Clocks                                                                     */
+/******************************************************************************/
+typedef enum { CY_SYSCLK_DIV_8_BIT = 0, CY_SYSCLK_DIV_16_BIT = 1, CY_SYSCLK_DIV_16_5_BIT = 2, CY_SYSCLK_DIV_24_5_BIT = 3 } cy_en_divider_types_t;
+typedef enum { PCLK_PASS_CLOCK_CTDAC = 0 } en_clk_dst_t;
+typedef enum { CY_SYSCLK_SUCCESS = 0 } cy_en_sysclk_status_t;
+
+cy_en_sysclk_status_t Cy_SysClk_PeriphDisableDivider(cy_en_divider_types_t dividerType, uint32_t dividerNum);
+cy_en_sysclk_status_t Cy_SysClk_PeriphEnableDivider(cy_en_divider_types_t dividerType, uint32_t dividerNum);
+cy_en_sysclk_status_t Cy_SysClk_PeriphSetFracDivider(cy_en_divider_types_t dividerType, uint32_t dividerNum,
+                                                     uint32_t dividerIntValue, uint32_t dividerFracValue);
+cy_en_sysclk_status_t Cy_SysClk_PeriphAssignDivider(en_clk_dst_t ipBlock, cy_en_divider_types_t dividerType,
+                                                    uint32_t dividerNum);
+uint32_t Cy_SysClk_PeriphGetAssignedDivider(en_clk_dst_t ipBlock);
+
+
+/******************************************************************************/
+/* CTDAC and analog reference                                                 */
+/******************************************************************************/
+typedef struct
+{
+    volatile uint32_t CTDAC_VAL;
+    volatile uint32_t CTDAC_VAL_NXT;
+} CTDAC_Type;
+typedef struct { uint32_t unused; } cy_stc_ctdac_fast_config_t;
+typedef struct { uint32_t unused; } cy_stc_sysanalog_config_t;
+typedef enum { CY_CTDAC_SUCCESS = 0 } cy_en_ctdac_status_t;
+typedef enum { CY_SYSANALOG_SUCCESS = 0 } cy_en_sysanalog_status_t;
+
+extern const cy_stc_ctdac_fast_config_t Cy_CTDAC_Fast_VddaRef_BufferedOut;
+extern const cy_stc_sysanalog_config_t Cy_SysAnalog_Fast_Local;
+
+cy_en_sysanalog_status_t Cy_SysAnalog_Init(const cy_stc_sysanalog_config_t* config);
+void Cy_SysAnalog_Enable(void);
+cy_en_ctdac_status_t Cy_CTDAC_FastInit(CTDAC_Type* base, const cy_stc_ctdac_fast_config_t* config);
+void Cy_CTDAC_Enable(CTDAC_Type* base);
+
+
+/******************************************************************************/
+/* DMA (DataWire)                                                             */
+/******************************************************************************/
+typedef enum { CY_DMA_SUCCESS = 0, CY_DMA_BAD_PARAM = 1 } cy_en_dma_status_t;
+typedef enum { CY_DMA_RETRIG_IM = 0, CY_DMA_RETRIG_4CYC = 1, CY_DMA_RETRIG_16CYC = 2, CY_DMA_WAIT_FOR_REACT = 3 } cy_en_dma_retrigger_t;
+typedef enum { CY_DMA_1ELEMENT = 0, CY_DMA_X_LOOP = 1, CY_DMA_DESCR = 2, CY_DMA_DESCR_CHAIN = 3 } cy_en_dma_trigger_type_t;
+typedef enum { CY_DMA_CHANNEL_ENABLED = 0, CY_DMA_CHANNEL_DISABLED = 1 } cy_en_dma_channel_state_t;
+typedef enum { CY_DMA_BYTE = 0, CY_DMA_HALFWORD = 1, CY_DMA_WORD = 2 } cy_en_dma_data_size_t;
+typedef enum { CY_DMA_TRANSFER_SIZE_DATA = 0, CY_DMA_TRANSFER_SIZE_WORD = 1 } cy_en_dma_transfer_size_t;
+typedef enum { CY_DMA_SINGLE_TRANSFER = 0, CY_DMA_1D_TRANSFER = 1, CY_DMA_2D_TRANSFER = 2 } cy_en_dma_descriptor_type_t;
+
+typedef struct cy_stc_dma_descriptor
+{
+    cy_en_dma_trigger_type_t interruptType;
+    cy_en_dma_data_size_t dataSize;
+    cy_en_dma_transfer_size_t srcTransferSize;
+    cy_en_dma_transfer_size_t dstTransferSize;
+    const void* srcAddress;
+    void* dstAddress;
+    int32_t srcXincrement;
+    int32_t dstXincrement;
+    uint32_t xCount;
+    struct cy_stc_dma_descriptor* nextDescriptor;
+} cy_stc_dma_descriptor_t;
+
+typedef struct
+{
+    cy_en_dma_retrigger_t retrigger;
+    cy_en_dma_trigger_type_t interruptType;
+    cy_en_dma_trigger_type_t triggerOutType;
+    cy_en_dma_channel_state_t channelState;
+    cy_en_dma_trigger_type_t triggerInType;
+    cy_en_dma_data_size_t dataSize;
+    cy_en_dma_transfer_size_t srcTransferSize;
+    cy_en_dma_transfer_size_t dstTransferSize;
+    cy_en_dma_descriptor_type_t descriptorType;
+    void* srcAddress;
+    void* dstAddress;
+    int32_t srcXincrement;
+    int32_t dstXincrement;
+    uint32_t xCount;
+    int32_t srcYincrement;
+    int32_t dstYincrement;
+    uint32_t yCount;
+    cy_stc_dma_descriptor_t* nextDescriptor;
+} cy_stc_dma_descriptor_config_t;
+
+typedef struct
+{
+    cy_stc_dma_descriptor_t* descriptor;
+    bool preemptable;
+    uint32_t priority;
+    bool enable;
+    bool bufferable;
+} cy_stc_dma_channel_config_t;
+
+typedef struct { uint32_t unused; } DW_Type;
+#define CY_DMA_INTR_MASK    (0x01UL)
+
+cy_en_dma_status_t Cy_DMA_Descriptor_Init(cy_stc_dma_descriptor_t* descriptor, const cy_stc_dma_descriptor_config_t* config);
+cy_en_dma_status_t Cy_DMA_Channel_Init(DW_Type* base, uint32_t channel, const cy_stc_dma_channel_config_t* config);
+void Cy_DMA_Channel_SetDescriptor(DW_Type* base, uint32_t channel, const cy_stc_dma_descriptor_t* descriptor);
+void Cy_DMA_Channel_SetInterruptMask(DW_Type* base, uint32_t channel, uint32_t interrupt);
+void Cy_DMA_Channel_ClearInterrupt(DW_Type* base, uint32_t channel);
+void Cy_DMA_Channel_Enable(DW_Type* base, uint32_t channel);
+void Cy_DMA_Enable(DW_Type* base);
+
+
+#endif // __CY_PDL_H__
@@ -0,0 +1,23 @@
+/**
+ * @file cy_serial_flash_qspi.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host stand-in for the serial flash library. Reads come from a store image
+ * loaded into memory by the render harness
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __CY_SERIAL_FLASH_QSPI_H__
+#define __CY_SERIAL_FLASH_QSPI_H__
+
+#include "cy_pdl.h"
+
+
+cy_rslt_t cy_serial_flash_qspi_read(uint32_t addr, size_t length, uint8_t* buf);
+
+
+#endif // __CY_SERIAL_FLASH_QSPI_H__
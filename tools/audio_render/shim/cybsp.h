@@ -0,0 +1,31 @@
+/**
+ * @file cybsp.h
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host stand-in for the generated device configuration the audio driver uses
+ *
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ */
+
+#ifndef __CYBSP_H__
+#define __CYBSP_H__
+
+#include "cy_pdl.h"
+
+
+extern DW_Type fake_dw1;
+extern CTDAC_Type fake_ctdac0;
+
+#define cpuss_0_dw1_0_chan_0_HW         (&fake_dw1)
+#define cpuss_0_dw1_0_chan_0_CHANNEL    (0U)
+#define cpuss_0_dw1_0_chan_0_IRQ        (67)
+#define pass_0_ctdac_0_HW               (&fake_ctdac0)
+#define CTDAC0                          (&fake_ctdac0)
+#define peri_0_div_24_5_0_HW            (CY_SYSCLK_DIV_24_5_BIT)
+#define peri_0_div_24_5_0_NUM           (0U)
+
+
+#endif // __CYBSP_H__
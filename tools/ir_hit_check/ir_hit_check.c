@@ -0,0 +1,360 @@
+/**
+ * @file ir_hit_check.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host check of hit analysis (app_ir_hit.c). A shot from another car is
+ * built with the real encoder (app_ir_code.c), and turned into each
+ * receiver's pulse train from where the shooter is. A receiver facing the
+ * shot sees a stronger signal, so it locks on to each mark sooner and holds
+ * it longer, and one facing away may not see it at all. The receivers'
+ * edges are merged in time order and fed through the real detector
+ * (app_ir_rx.c), as on the car, and the direction it reports is checked
+ * against where the shooter was.
+ *
+ * Shooters are placed all the way round the car, every 5 degrees, at
+ * point blank, mid and long range. Bearings within BAND degrees of a
+ * front/side or side/rear boundary could fairly go either way, so they are
+ * reported but not checked. At point blank, every receiver that faces
+ * anywhere near the shooter is swamped and they all look the same, so its
+ * directions are reported but only missed shots fail.
+ *
+ * Usage:
+ *   ir_hit_check [-b <band>] [-v]
+ *
+ * -v prints every shot. Exits 0 if every shot is detected once, from the
+ * right shooter, and every checked shot's direction is right
+ *
+ * @version 0.1
+ * @date 2024-12-27
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_ir_hit.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define CHECK_DEFAULT_BAND_DEG  (15)
+#define CHECK_STEP_DEG          (5)
+#define CHECK_OWN_ID            (5U)
+#define CHECK_SHOOTER_ID        (42U)
+#define CHECK_SHOT_FRAMES       (3U)
+#define CHECK_START_US          (10000U)
+#define CHECK_MAX_EDGES         (1024U)
+#define CHECK_SEED              (12345U)
+
+// Receiver model. Strength is how much of the shot a receiver sees, from 0 to 1 (and more when
+// the shooter is close). Below CHECK_SEEN it doesn't see it at all. Marks start later and end
+// sooner the weaker the signal, and every edge has some jitter
+#define CHECK_SEEN              (0.25)
+#define CHECK_START_DELAY_US    (60.0)      // At full strength
+#define CHECK_START_WEAK_US     (200.0)     // Added at the weakest
+#define CHECK_END_DELAY_US      (150.0)
+#define CHECK_END_WEAK_US       (100.0)     // Taken off at the weakest
+#define CHECK_JITTER_US         (20U)
+
+#define EXIT_PASS               (0)
+#define EXIT_FAIL               (1)
+#define EXIT_ERROR              (2)
+
+typedef struct
+{
+    const char* name;
+    double power;               // Strength of a receiver facing the shooter
+    bool checked;               // Whether wrong directions fail the check
+} check_range_s;
+
+
+/******************************************************************************
+ * Global Variables                                                           *
+ ******************************************************************************/
+static const double check_bearings_deg[APP_IR_RX_N_RECEIVERS] = {
+    APP_IR_HIT_BEARING_A_DEG,
+    APP_IR_HIT_BEARING_B_DEG,
+    APP_IR_HIT_BEARING_C_DEG
+};
+
+static const check_range_s check_ranges[] = {
+    { "point blank", 2.0, false },
+    { "mid",         1.0, true },
+    { "long",        0.6, true },
+};
+
+static const char* check_dir_names[APP_IR_HIT_DIR_MAX] = {
+    [APP_IR_HIT_DIR_FRONT] = "front",
+    [APP_IR_HIT_DIR_SIDE]  = "side",
+    [APP_IR_HIT_DIR_REAR]  = "rear",
+};
+
+static app_ir_rx_edge_s check_edges[CHECK_MAX_EDGES];
+static uint32_t check_n_edges;
+static uint32_t check_rand_state = CHECK_SEED;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Small, repeatable random number generator, so runs can be compared
+ *
+ * @return uint32_t
+ * Next random number
+ */
+static uint32_t check_rand(void)
+{
+    check_rand_state = (check_rand_state * 1103515245U) + 12345U;
+    return check_rand_state >> 8;
+}
+
+
+/**
+ * @brief  Get how far apart two bearings are
+ *
+ * @param double
+ * First bearing (degrees)
+ * @param double
+ * Second bearing (degrees)
+ * @return double
+ * Difference, from -180 to 180 (degrees)
+ */
+static double check_bearing_diff(double a_deg, double b_deg)
+{
+    double diff = fmod(a_deg - b_deg, 360.0);
+
+    if (diff > 180.0)
+    {
+        diff -= 360.0;
+    }
+    else if (diff < -180.0)
+    {
+        diff += 360.0;
+    }
+    return diff;
+}
+
+
+/**
+ * @brief  Add the pulse train one receiver sees of a shot to the edges
+ *
+ * @param uint8_t
+ * Receiver
+ * @param double
+ * Its strength, at least CHECK_SEEN
+ * @param const uint8_t*
+ * Frames being sent, 1 per unit of carrier and 0 per unit of space
+ * @param uint32_t
+ * Units sent
+ */
+static void check_receiver_edges(uint8_t receiver, double strength, const uint8_t* units, uint32_t n_units)
+{
+    const double weak = 1.0 - ((fmin(strength, 1.0) - CHECK_SEEN) / (1.0 - CHECK_SEEN));
+    const double start_delay_us = CHECK_START_DELAY_US + (CHECK_START_WEAK_US * weak);
+    const double end_delay_us = CHECK_END_DELAY_US - (CHECK_END_WEAK_US * weak);
+    uint8_t level = 0;
+
+    for (uint32_t i = 0; i < n_units; i++)
+    {
+        if (units[i] == level)
+        {
+            continue;
+        }
+        level = units[i];
+
+        const double delay_us = level ? start_delay_us : end_delay_us;
+        app_ir_rx_edge_s* edge = &check_edges[check_n_edges++];
+        edge->us = CHECK_START_US + (i * APP_IR_CODE_UNIT_US) + (uint32_t)delay_us + (check_rand() % CHECK_JITTER_US);
+        edge->receiver = receiver;
+        edge->mark = (level != 0);
+    }
+}
+
+
+/**
+ * @brief  Put the edges in the order they happened, as the interrupt would
+ *         push them
+ */
+static void check_sort_edges(void)
+{
+    for (uint32_t i = 1; i < check_n_edges; i++)
+    {
+        const app_ir_rx_edge_s edge = check_edges[i];
+        uint32_t j = i;
+
+        while ((j > 0) && ((int32_t)(check_edges[j - 1].us - edge.us) > 0))
+        {
+            check_edges[j] = check_edges[j - 1];
+            j--;
+        }
+        check_edges[j] = edge;
+    }
+}
+
+
+/**
+ * @brief  Fire one shot at the car and analyze it
+ *
+ * @param double
+ * Bearing of the shooter (degrees)
+ * @param double
+ * Strength of a receiver facing the shooter
+ * @param app_ir_hit_s*
+ * Where to write the direction
+ * @return uint32_t
+ * Shots detected from the shooter, which should be 1
+ */
+static uint32_t check_shot(double bearing_deg, double power, app_ir_hit_s* result)
+{
+    static app_ir_rx_detector_s det;
+    uint8_t units[CHECK_SHOT_FRAMES * APP_IR_CODE_MAX_FRAME_UNITS];
+    const app_ir_code_frame_s frame = { .car_id = CHECK_SHOOTER_ID, .shot_type = 1 };
+    uint32_t n_units = 0;
+    uint32_t n_shots = 0;
+    app_ir_rx_hit_s hit;
+
+    for (uint32_t i = 0; i < CHECK_SHOT_FRAMES; i++)
+    {
+        n_units += app_ir_code_encode(&frame, &units[n_units], sizeof(units) - n_units);
+    }
+
+    check_n_edges = 0;
+    for (uint8_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        const double off_rad = check_bearing_diff(bearing_deg, check_bearings_deg[i]) * M_PI / 180.0;
+        const double strength = power * (1.0 + cos(off_rad)) / 2.0;
+        if (strength >= CHECK_SEEN)
+        {
+            check_receiver_edges(i, strength, units, n_units);
+        }
+    }
+    check_sort_edges();
+
+    app_ir_rx_detector_init(&det, CHECK_OWN_ID);
+    for (uint32_t i = 0; i < check_n_edges; i++)
+    {
+        if (app_ir_rx_edge(&det, &check_edges[i], &hit))
+        {
+            if (hit.shooter_id != CHECK_SHOOTER_ID)
+            {
+                return 0;
+            }
+            if (n_shots++ == 0)
+            {
+                app_ir_hit_analyze(&hit, result);
+            }
+        }
+    }
+    return n_shots;
+}
+
+
+int main(int argc, char** argv)
+{
+    int32_t band_deg = CHECK_DEFAULT_BAND_DEG;
+    bool verbose = false;
+    uint32_t n_failed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-b") == 0) && ((i + 1) < argc))
+        {
+            band_deg = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-b <band>] [-v]\n", argv[0]);
+            return EXIT_ERROR;
+        }
+    }
+
+    printf("Receivers at %d, %d and %d degrees. Front up to %d, rear from %d, boundary band %d degrees\n",
+           APP_IR_HIT_BEARING_A_DEG, APP_IR_HIT_BEARING_B_DEG, APP_IR_HIT_BEARING_C_DEG,
+           APP_IR_HIT_FRONT_DEG, APP_IR_HIT_REAR_DEG, band_deg);
+    printf("%-12s %8s %8s %8s %8s %10s %10s\n", "range", "front", "side", "rear", "band", "missed", "rms err");
+
+    for (size_t r = 0; r < (sizeof(check_ranges) / sizeof(check_ranges[0])); r++)
+    {
+        uint32_t n_right[APP_IR_HIT_DIR_MAX] = {0};
+        uint32_t n_checked[APP_IR_HIT_DIR_MAX] = {0};
+        uint32_t n_band = 0;
+        uint32_t n_missed = 0;
+        double sq_err = 0.0;
+        uint32_t n_err = 0;
+
+        for (int32_t bearing_deg = -180; bearing_deg < 180; bearing_deg += CHECK_STEP_DEG)
+        {
+            app_ir_hit_s result;
+            const uint32_t n_shots = check_shot(bearing_deg, check_ranges[r].power, &result);
+            const app_ir_hit_dir_e expected = app_ir_hit_dir(bearing_deg);
+            const int32_t off_deg = abs(bearing_deg);
+            const bool in_band = (abs(off_deg - APP_IR_HIT_FRONT_DEG) <= band_deg) ||
+                                 (abs(off_deg - APP_IR_HIT_REAR_DEG) <= band_deg);
+            bool ok = true;
+
+            if (n_shots != 1)
+            {
+                n_missed++;
+                ok = false;
+            }
+            else
+            {
+                const double err = check_bearing_diff(result.bearing_deg, bearing_deg);
+                sq_err += err * err;
+                n_err++;
+                if (in_band)
+                {
+                    n_band++;
+                }
+                else
+                {
+                    n_checked[expected]++;
+                    if (result.dir == expected)
+                    {
+                        n_right[expected]++;
+                    }
+                    else if (check_ranges[r].checked)
+                    {
+                        ok = false;
+                    }
+                }
+            }
+            if (!ok)
+            {
+                n_failed++;
+            }
+
+            if (verbose || !ok)
+            {
+                printf("  %-11s %4d deg: %s", check_ranges[r].name, bearing_deg, ok ? "" : "FAIL ");
+                if (n_shots == 1)
+                {
+                    printf("%s at %d deg, receivers %c%c%c%s\n",
+                           check_dir_names[result.dir], result.bearing_deg,
+                           (result.receivers & 1U) ? 'A' : '-', (result.receivers & 2U) ? 'B' : '-',
+                           (result.receivers & 4U) ? 'C' : '-', in_band ? " (band)" : "");
+                }
+                else
+                {
+                    printf("%u shots detected\n", n_shots);
+                }
+            }
+        }
+
+        printf("%-12s %4u/%-3u %4u/%-3u %4u/%-3u %8u %10u %7.1f deg%s\n", check_ranges[r].name,
+               n_right[APP_IR_HIT_DIR_FRONT], n_checked[APP_IR_HIT_DIR_FRONT],
+               n_right[APP_IR_HIT_DIR_SIDE], n_checked[APP_IR_HIT_DIR_SIDE],
+               n_right[APP_IR_HIT_DIR_REAR], n_checked[APP_IR_HIT_DIR_REAR],
+               n_band, n_missed, (n_err > 0) ? sqrt(sq_err / n_err) : 0.0,
+               check_ranges[r].checked ? "" : "  (not checked)");
+    }
+
+    printf("%s\n", (n_failed == 0) ? "PASS" : "FAIL");
+    return (n_failed == 0) ? EXIT_PASS : EXIT_FAIL;
+}
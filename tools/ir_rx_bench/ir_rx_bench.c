@@ -0,0 +1,845 @@
+/**
+ * @file ir_rx_bench.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host benchmark of IR hit detection (app_ir_rx.c) against noise. Traces of
+ * the receivers' outputs are replayed through the real detector, as on the
+ * car, and its hits are matched against the shots that were really sent, to
+ * get how many shots it detects and how many false hits it takes.
+ *
+ * Traces can be recorded ones, given with -n (noise, no shots) and -s
+ * (shots, maybe with noise), or else synthetic ones are made up:
+ *   - shots from all round the car, at ranges from close to the edge of
+ *     reach, where marks start to drop out or break up
+ *   - glitches: short spikes, as from a receiver's AGC or EMI from the motors
+ *   - lamp: bursts at 100 Hz, as from fluorescent and LED lighting
+ *   - sun: random marks of all lengths, some in runs that look like frames
+ * The shots are also replayed with each kind of noise on top, and a receiver
+ * is marked whenever either is.
+ *
+ * A trace is text, one edge per line, with # for comments:
+ *   <us> <receiver 0-2> <1 for a mark, 0 for a space>
+ *   shot <us> <car ID>       A shot sent from car ID, starting at us
+ *
+ * Usage:
+ *   ir_rx_bench [-n <noise trace>] [-s <shot trace>] [-m <min_mark_us>] [-f <min_frames>] [-c]
+ *
+ * With -m or -f, just that setting is run, otherwise a sweep of settings is.
+ * -c checks the detector's default settings instead, and exits 0 if they
+ * detect enough shots and take no false hits from the noise
+ *
+ * @version 0.1
+ * @date 2024-12-28
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_ir_rx.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define BENCH_OWN_ID            (5U)
+#define BENCH_SEED              (2024U)
+#define BENCH_NOISE_US          (60000000U)     // Each kind of synthetic noise
+#define BENCH_N_SHOTS           (400U)
+#define BENCH_SHOT_PERIOD_US    (250000U)       // Shooters take turns, so shots don't overlap
+#define BENCH_SHOT_FRAMES       (3U)
+#define BENCH_MATCH_US          (150000U)       // A hit this long after a shot started is from it
+#define BENCH_MAX_LINE          (128U)
+
+// Receiver model, as in tools/ir_hit_check. Strength is how much of a shot a receiver sees, and
+// below BENCH_SEEN it doesn't see it. Weaker marks start later and end sooner, and at the edge of
+// reach they break up or go missing
+#define BENCH_SEEN              (0.25)
+#define BENCH_START_DELAY_US    (60.0)
+#define BENCH_START_WEAK_US     (200.0)
+#define BENCH_END_DELAY_US      (150.0)
+#define BENCH_END_WEAK_US       (100.0)
+#define BENCH_JITTER_US         (20U)
+#define BENCH_BREAK_UP          (0.15)          // Chance a mark breaks up, at the weakest
+#define BENCH_MISS              (0.01)          // Chance a mark is missed, at the weakest
+
+// Check thresholds, for -c
+#define BENCH_CHECK_CLEAN_PCT   (98.0)
+#define BENCH_CHECK_NOISY_PCT   (90.0)
+
+#define EXIT_PASS               (0)
+#define EXIT_FAIL               (1)
+#define EXIT_ERROR              (2)
+
+// A receiver's mark, from start_us up to end_us
+typedef struct
+{
+    uint32_t start_us;
+    uint32_t end_us;
+    uint8_t receiver;
+} bench_mark_s;
+
+// A shot that was really sent
+typedef struct
+{
+    uint32_t us;
+    uint8_t car_id;
+} bench_shot_s;
+
+typedef struct
+{
+    bench_mark_s* marks;
+    uint32_t n_marks;
+    uint32_t max_marks;
+    bench_shot_s* shots;
+    uint32_t n_shots;
+    uint32_t max_shots;
+    uint32_t end_us;
+} bench_trace_s;
+
+// How a trace went
+typedef struct
+{
+    uint32_t n_shots;
+    uint32_t n_detected;
+    uint32_t n_false;
+    uint32_t n_glitches;
+    uint32_t n_rejected;
+    double latency_us;          // Mean, from the shot starting
+} bench_result_s;
+
+typedef struct
+{
+    const char* name;
+    const bench_trace_s* trace;
+} bench_case_s;
+
+
+/******************************************************************************
+ * Global Variables                                                           *
+ ******************************************************************************/
+static const double bench_bearings_deg[APP_IR_RX_N_RECEIVERS] = { 0.0, 120.0, -120.0 };
+static const uint16_t bench_min_marks_us[] = { 0, 60, 120, 180, 240 };
+static uint32_t bench_rand_state = BENCH_SEED;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Small, repeatable random number generator, so runs can be compared
+ *
+ * @return uint32_t
+ * Next random number
+ */
+static uint32_t bench_rand(void)
+{
+    bench_rand_state = (bench_rand_state * 1103515245U) + 12345U;
+    return bench_rand_state >> 8;
+}
+
+
+/**
+ * @brief  Get a random number in a range
+ *
+ * @param double
+ * Lowest
+ * @param double
+ * Highest
+ * @return double
+ * Random number between them
+ */
+static double bench_uniform(double lo, double hi)
+{
+    return lo + ((hi - lo) * (double)(bench_rand() & 0xFFFFFFU) / (double)0x1000000U);
+}
+
+
+/**
+ * @brief  Get how long until the next of some randomly timed events
+ *
+ * @param double
+ * How often they happen (per second)
+ * @return uint32_t
+ * Time to the next one (us)
+ */
+static uint32_t bench_interval_us(double per_s)
+{
+    return (uint32_t)(-log(1.0 - bench_uniform(0.0, 1.0)) * 1e6 / per_s) + 1U;
+}
+
+
+/**
+ * @brief  Add a mark to a trace
+ *
+ * @param bench_trace_s*
+ * Trace to add to
+ * @param uint8_t
+ * Receiver
+ * @param uint32_t
+ * When it starts (us)
+ * @param uint32_t
+ * How long it is (us)
+ */
+static void bench_add_mark(bench_trace_s* trace, uint8_t receiver, uint32_t start_us, uint32_t len_us)
+{
+    if (trace->n_marks == trace->max_marks)
+    {
+        trace->max_marks = (trace->max_marks == 0) ? 1024U : (trace->max_marks * 2U);
+        trace->marks = realloc(trace->marks, trace->max_marks * sizeof(*trace->marks));
+        if (trace->marks == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_ERROR);
+        }
+    }
+    bench_mark_s* mark = &trace->marks[trace->n_marks++];
+    mark->start_us = start_us;
+    mark->end_us = start_us + ((len_us > 0) ? len_us : 1U);
+    mark->receiver = receiver;
+    if (mark->end_us > trace->end_us)
+    {
+        trace->end_us = mark->end_us;
+    }
+}
+
+
+/**
+ * @brief  Add a shot that was sent to a trace
+ *
+ * @param bench_trace_s*
+ * Trace to add to
+ * @param uint32_t
+ * When it started (us)
+ * @param uint8_t
+ * Shooter
+ */
+static void bench_add_shot(bench_trace_s* trace, uint32_t us, uint8_t car_id)
+{
+    if (trace->n_shots == trace->max_shots)
+    {
+        trace->max_shots = (trace->max_shots == 0) ? 64U : (trace->max_shots * 2U);
+        trace->shots = realloc(trace->shots, trace->max_shots * sizeof(*trace->shots));
+        if (trace->shots == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_ERROR);
+        }
+    }
+    trace->shots[trace->n_shots].us = us;
+    trace->shots[trace->n_shots].car_id = car_id;
+    trace->n_shots++;
+}
+
+
+/**
+ * @brief  Make a trace that is one on top of another
+ *
+ * @param const bench_trace_s*
+ * First trace
+ * @param const bench_trace_s*
+ * Second trace, which is looped if it is shorter than the first
+ * @param bench_trace_s*
+ * Where to write the trace
+ */
+static void bench_overlay(const bench_trace_s* a, const bench_trace_s* b, bench_trace_s* out)
+{
+    memset(out, 0, sizeof(*out));
+    for (uint32_t i = 0; i < a->n_marks; i++)
+    {
+        bench_add_mark(out, a->marks[i].receiver, a->marks[i].start_us, a->marks[i].end_us - a->marks[i].start_us);
+    }
+    for (uint32_t i = 0; i < a->n_shots; i++)
+    {
+        bench_add_shot(out, a->shots[i].us, a->shots[i].car_id);
+    }
+    for (uint32_t loop_us = 0; (b->end_us > 0) && (loop_us < a->end_us); loop_us += b->end_us)
+    {
+        for (uint32_t i = 0; (i < b->n_marks) && ((loop_us + b->marks[i].start_us) < a->end_us); i++)
+        {
+            bench_add_mark(out, b->marks[i].receiver, loop_us + b->marks[i].start_us, b->marks[i].end_us - b->marks[i].start_us);
+        }
+    }
+}
+
+
+/**
+ * @brief  Add the marks one receiver sees of a shot
+ *
+ * @param bench_trace_s*
+ * Trace to add to
+ * @param uint8_t
+ * Receiver
+ * @param double
+ * Its strength, at least BENCH_SEEN
+ * @param uint32_t
+ * When the shot starts (us)
+ * @param const uint8_t*
+ * Frames being sent, 1 per unit of carrier and 0 per unit of space
+ * @param uint32_t
+ * Units sent
+ */
+static void bench_receiver_marks(bench_trace_s* trace, uint8_t receiver, double strength, uint32_t start_us,
+                                 const uint8_t* units, uint32_t n_units)
+{
+    const double weak = 1.0 - ((fmin(strength, 1.0) - BENCH_SEEN) / (1.0 - BENCH_SEEN));
+    const double start_delay_us = BENCH_START_DELAY_US + (BENCH_START_WEAK_US * weak);
+    const double end_delay_us = BENCH_END_DELAY_US - (BENCH_END_WEAK_US * weak);
+
+    for (uint32_t i = 0; i < n_units; )
+    {
+        uint32_t n = 0;
+
+        if (units[i] == 0)
+        {
+            i++;
+            continue;
+        }
+        while (((i + n) < n_units) && (units[i + n] != 0))
+        {
+            n++;
+        }
+
+        const uint32_t mark_start_us = start_us + (i * APP_IR_CODE_UNIT_US) + (uint32_t)start_delay_us + (bench_rand() % BENCH_JITTER_US);
+        const uint32_t mark_end_us = start_us + ((i + n) * APP_IR_CODE_UNIT_US) + (uint32_t)end_delay_us + (bench_rand() % BENCH_JITTER_US);
+        i += n;
+
+        if (bench_uniform(0.0, 1.0) < (BENCH_MISS * weak))
+        {
+            continue;
+        }
+        if (bench_uniform(0.0, 1.0) < (BENCH_BREAK_UP * weak))
+        {
+            // The receiver loses lock part way through, for a few carrier cycles
+            const uint32_t break_us = mark_start_us + (uint32_t)bench_uniform(50.0, (double)(mark_end_us - mark_start_us) - 50.0);
+            const uint32_t gap_us = (uint32_t)bench_uniform(20.0, 80.0);
+            bench_add_mark(trace, receiver, mark_start_us, break_us - mark_start_us);
+            bench_add_mark(trace, receiver, break_us + gap_us, mark_end_us - (break_us + gap_us));
+            continue;
+        }
+        bench_add_mark(trace, receiver, mark_start_us, mark_end_us - mark_start_us);
+    }
+}
+
+
+/**
+ * @brief  Make up shots from all round the car, at all ranges
+ *
+ * @param bench_trace_s*
+ * Where to write the trace
+ */
+static void bench_make_shots(bench_trace_s* trace)
+{
+    uint8_t units[BENCH_SHOT_FRAMES * APP_IR_CODE_MAX_FRAME_UNITS];
+
+    memset(trace, 0, sizeof(*trace));
+    for (uint32_t s = 0; s < BENCH_N_SHOTS; s++)
+    {
+        const uint32_t start_us = (s * BENCH_SHOT_PERIOD_US) + (bench_rand() % (BENCH_SHOT_PERIOD_US / 4U));
+        app_ir_code_frame_s frame = { .car_id = (uint8_t)(bench_rand() % APP_IR_CODE_N_CAR_IDS), .shot_type = 1 };
+        const double bearing_deg = bench_uniform(-180.0, 180.0);
+        const double power = bench_uniform(0.45, 2.0);
+        uint32_t n_units = 0;
+
+        if (frame.car_id == BENCH_OWN_ID)
+        {
+            frame.car_id++;
+        }
+        for (uint32_t i = 0; i < BENCH_SHOT_FRAMES; i++)
+        {
+            n_units += app_ir_code_encode(&frame, &units[n_units], sizeof(units) - n_units);
+        }
+
+        bench_add_shot(trace, start_us, frame.car_id);
+        for (uint8_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+        {
+            const double off_rad = (bearing_deg - bench_bearings_deg[i]) * M_PI / 180.0;
+            const double strength = power * (1.0 + cos(off_rad)) / 2.0;
+            if (strength >= BENCH_SEEN)
+            {
+                bench_receiver_marks(trace, i, strength, start_us, units, n_units);
+            }
+        }
+    }
+    trace->end_us += BENCH_SHOT_PERIOD_US;
+}
+
+
+/**
+ * @brief  Make up short spikes on every receiver
+ *
+ * @param bench_trace_s*
+ * Where to write the trace
+ */
+static void bench_make_glitches(bench_trace_s* trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    for (uint8_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        for (uint32_t us = bench_interval_us(300.0); us < BENCH_NOISE_US; us += bench_interval_us(300.0))
+        {
+            bench_add_mark(trace, i, us, (uint32_t)bench_uniform(5.0, 100.0));
+        }
+    }
+    trace->end_us = BENCH_NOISE_US;
+}
+
+
+/**
+ * @brief  Make up lighting that flickers at 100 Hz. Every receiver sees the
+ *         same lamp, but not always
+ *
+ * @param bench_trace_s*
+ * Where to write the trace
+ */
+static void bench_make_lamp(bench_trace_s* trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    for (uint32_t us = 1000U; us < BENCH_NOISE_US; us += 10000U)
+    {
+        const uint32_t n_pulses = 1U + (bench_rand() % 3U);
+
+        for (uint8_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+        {
+            if (bench_uniform(0.0, 1.0) < 0.4)
+            {
+                continue;
+            }
+            uint32_t pulse_us = us + (bench_rand() % 100U);
+            for (uint32_t p = 0; p < n_pulses; p++)
+            {
+                const uint32_t len_us = (uint32_t)bench_uniform(30.0, 250.0);
+                bench_add_mark(trace, i, pulse_us, len_us);
+                pulse_us += len_us + (uint32_t)bench_uniform(100.0, 400.0);
+            }
+        }
+    }
+    trace->end_us = BENCH_NOISE_US;
+}
+
+
+/**
+ * @brief  Make up sunlight glinting off the track and other cars. Marks are
+ *         every length, and some come in runs spaced like a frame's
+ *
+ * @param bench_trace_s*
+ * Where to write the trace
+ */
+static void bench_make_sun(bench_trace_s* trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    for (uint8_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+    {
+        for (uint32_t us = bench_interval_us(60.0); us < BENCH_NOISE_US; us += bench_interval_us(60.0))
+        {
+            if (bench_uniform(0.0, 1.0) < 0.2)
+            {
+                // A run of marks, a unit or two apart
+                const uint32_t n_marks = 5U + (bench_rand() % 16U);
+                for (uint32_t m = 0; m < n_marks; m++)
+                {
+                    const uint32_t len_us = (uint32_t)bench_uniform(150.0, 1800.0);
+                    bench_add_mark(trace, i, us, len_us);
+                    us += len_us + (uint32_t)bench_uniform(250.0, 900.0);
+                }
+            }
+            else
+            {
+                bench_add_mark(trace, i, us, (uint32_t)bench_uniform(20.0, 600.0));
+            }
+        }
+    }
+    trace->end_us = BENCH_NOISE_US + 100000U;
+}
+
+
+/**
+ * @brief  Read a recorded trace
+ *
+ * @param const char*
+ * File to read
+ * @param bench_trace_s*
+ * Where to write the trace
+ * @return bool
+ * true if it was read
+ */
+static bool bench_read_trace(const char* path, bench_trace_s* trace)
+{
+    FILE* file = fopen(path, "r");
+    char line[BENCH_MAX_LINE];
+    bool in_mark[APP_IR_RX_N_RECEIVERS] = {0};
+    uint32_t mark_us[APP_IR_RX_N_RECEIVERS] = {0};
+    uint32_t line_no = 0;
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+
+    memset(trace, 0, sizeof(*trace));
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned long us;
+        unsigned int a;
+        unsigned int b;
+
+        line_no++;
+        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r'))
+        {
+            continue;
+        }
+        if (sscanf(line, "shot %lu %u", &us, &a) == 2)
+        {
+            bench_add_shot(trace, (uint32_t)us, (uint8_t)a);
+        }
+        else if ((sscanf(line, "%lu %u %u", &us, &a, &b) == 3) && (a < APP_IR_RX_N_RECEIVERS))
+        {
+            // Only changes count, as on the car
+            if ((b != 0) && !in_mark[a])
+            {
+                in_mark[a] = true;
+                mark_us[a] = (uint32_t)us;
+            }
+            else if ((b == 0) && in_mark[a])
+            {
+                in_mark[a] = false;
+                bench_add_mark(trace, (uint8_t)a, mark_us[a], (uint32_t)us - mark_us[a]);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s:%u: can't read '%s'\n", path, line_no, strtok(line, "\r\n"));
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+
+/**
+ * @brief  Order marks by when they start
+ */
+static int bench_mark_cmp(const void* a, const void* b)
+{
+    const bench_mark_s* mark_a = a;
+    const bench_mark_s* mark_b = b;
+
+    return (mark_a->start_us > mark_b->start_us) - (mark_a->start_us < mark_b->start_us);
+}
+
+
+/**
+ * @brief  Order edges by when they happened
+ */
+static int bench_edge_cmp(const void* a, const void* b)
+{
+    const app_ir_rx_edge_s* edge_a = a;
+    const app_ir_rx_edge_s* edge_b = b;
+
+    return (edge_a->us > edge_b->us) - (edge_a->us < edge_b->us);
+}
+
+
+/**
+ * @brief  Replay a trace through the detector, and match its hits against
+ *         the shots that were sent
+ *
+ * @param const bench_trace_s*
+ * Trace to replay
+ * @param const app_ir_rx_cfg_s*
+ * Detector settings
+ * @param bench_result_s*
+ * Where to write how it went
+ */
+static void bench_run(const bench_trace_s* trace, const app_ir_rx_cfg_s* cfg, bench_result_s* result)
+{
+    static app_ir_rx_detector_s det;
+    bench_mark_s* marks = malloc((trace->n_marks + 1U) * sizeof(*marks));
+    app_ir_rx_edge_s* edges = malloc(((2U * trace->n_marks) + 1U) * sizeof(*edges));
+    bool* matched = calloc(trace->n_shots + 1U, sizeof(*matched));
+    uint32_t n_edges = 0;
+    double latency_us = 0.0;
+    app_ir_rx_hit_s hit;
+
+    if ((marks == NULL) || (edges == NULL) || (matched == NULL))
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_ERROR);
+    }
+
+    // A receiver is marked while any of its marks are going, as when noise and a shot overlap
+    memcpy(marks, trace->marks, trace->n_marks * sizeof(*marks));
+    qsort(marks, trace->n_marks, sizeof(*marks), bench_mark_cmp);
+    for (uint8_t r = 0; r < APP_IR_RX_N_RECEIVERS; r++)
+    {
+        bool in_mark = false;
+        uint32_t end_us = 0;
+
+        for (uint32_t i = 0; i < trace->n_marks; i++)
+        {
+            if (marks[i].receiver != r)
+            {
+                continue;
+            }
+            if (in_mark && (marks[i].start_us <= end_us))
+            {
+                end_us = (marks[i].end_us > end_us) ? marks[i].end_us : end_us;
+                continue;
+            }
+            if (in_mark)
+            {
+                edges[n_edges++] = (app_ir_rx_edge_s){ .us = end_us, .receiver = r, .mark = false };
+            }
+            edges[n_edges++] = (app_ir_rx_edge_s){ .us = marks[i].start_us, .receiver = r, .mark = true };
+            in_mark = true;
+            end_us = marks[i].end_us;
+        }
+        if (in_mark)
+        {
+            edges[n_edges++] = (app_ir_rx_edge_s){ .us = end_us, .receiver = r, .mark = false };
+        }
+    }
+    qsort(edges, n_edges, sizeof(*edges), bench_edge_cmp);
+
+    memset(result, 0, sizeof(*result));
+    result->n_shots = trace->n_shots;
+    app_ir_rx_detector_init(&det, BENCH_OWN_ID);
+    app_ir_rx_set_cfg(&det, cfg);
+    for (uint32_t i = 0; i < n_edges; i++)
+    {
+        if (!app_ir_rx_edge(&det, &edges[i], &hit))
+        {
+            continue;
+        }
+
+        bool found = false;
+        for (uint32_t s = 0; s < trace->n_shots; s++)
+        {
+            const bench_shot_s* shot = &trace->shots[s];
+            if (!matched[s] && (shot->car_id == hit.shooter_id) &&
+                (hit.detect_us >= shot->us) && ((hit.detect_us - shot->us) <= BENCH_MATCH_US))
+            {
+                matched[s] = true;
+                found = true;
+                latency_us += hit.detect_us - shot->us;
+                break;
+            }
+        }
+        if (found)
+        {
+            result->n_detected++;
+        }
+        else
+        {
+            result->n_false++;
+        }
+    }
+    app_ir_rx_expire(&det, trace->end_us + APP_IR_RX_SHOT_GAP_US + 1U);
+
+    result->n_glitches = app_ir_rx_n_glitches(&det);
+    result->n_rejected = det.n_rejected;
+    result->latency_us = (result->n_detected > 0) ? (latency_us / result->n_detected) : 0.0;
+
+    free(marks);
+    free(edges);
+    free(matched);
+}
+
+
+/**
+ * @brief  Get the share of a trace's shots that were detected
+ *
+ * @param const bench_result_s*
+ * How the trace went
+ * @return double
+ * Detection rate (%), 100 if it had no shots
+ */
+static double bench_detected_pct(const bench_result_s* result)
+{
+    return (result->n_shots > 0) ? (100.0 * result->n_detected / result->n_shots) : 100.0;
+}
+
+
+/**
+ * @brief  Run every trace with one setting, and print how it went
+ *
+ * @param const bench_case_s*
+ * Traces to run
+ * @param size_t
+ * Number of traces
+ * @param const app_ir_rx_cfg_s*
+ * Detector settings
+ * @param bool
+ * true to check the results against the thresholds
+ * @return uint32_t
+ * Number of checks failed
+ */
+static uint32_t bench_setting(const bench_case_s* cases, size_t n_cases, const app_ir_rx_cfg_s* cfg, bool check)
+{
+    uint32_t n_failed = 0;
+
+    printf("min_mark %3u us, min_frames %u:\n", cfg->min_mark_us[0], cfg->min_frames);
+    for (size_t c = 0; c < n_cases; c++)
+    {
+        bench_result_s result;
+        const double minutes = cases[c].trace->end_us / 60e6;
+        bool ok = true;
+
+        bench_run(cases[c].trace, cfg, &result);
+        if (check)
+        {
+            const double min_pct = (c == 0) ? BENCH_CHECK_CLEAN_PCT : BENCH_CHECK_NOISY_PCT;
+            ok = (result.n_false == 0) && (bench_detected_pct(&result) >= min_pct);
+        }
+        if (!ok)
+        {
+            n_failed++;
+        }
+
+        printf("  %-14s", cases[c].name);
+        if (result.n_shots > 0)
+        {
+            printf(" detected %5.1f%% (%u/%u), latency %5.1f ms,", bench_detected_pct(&result),
+                   result.n_detected, result.n_shots, result.latency_us / 1000.0);
+        }
+        printf(" false hits %u (%.2f/min), rejected %u, glitches %u%s\n", result.n_false,
+               (minutes > 0.0) ? (result.n_false / minutes) : 0.0, result.n_rejected, result.n_glitches,
+               ok ? "" : "  FAIL");
+    }
+    return n_failed;
+}
+
+
+int main(int argc, char** argv)
+{
+    static bench_trace_s shots;
+    static bench_trace_s noise[3];
+    static bench_trace_s noisy[3];
+    static const char* noise_names[3] = { "glitches", "lamp", "sun" };
+    static const char* noisy_names[3] = { "shots+glitches", "shots+lamp", "shots+sun" };
+    bench_case_s cases[1U + (2U * 3U)];
+    size_t n_cases = 0;
+    size_t n_noise = 3;
+    const char* noise_path = NULL;
+    const char* shot_path = NULL;
+    app_ir_rx_cfg_s cfg;
+    int min_mark_us = -1;
+    int min_frames = -1;
+    bool check = false;
+    uint32_t n_failed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-n") == 0) && ((i + 1) < argc))
+        {
+            noise_path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-s") == 0) && ((i + 1) < argc))
+        {
+            shot_path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-m") == 0) && ((i + 1) < argc))
+        {
+            min_mark_us = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "-f") == 0) && ((i + 1) < argc))
+        {
+            min_frames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            check = true;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-n <noise trace>] [-s <shot trace>] [-m <min_mark_us>] [-f <min_frames>] [-c]\n", argv[0]);
+            return EXIT_ERROR;
+        }
+    }
+
+    if (shot_path != NULL)
+    {
+        if (!bench_read_trace(shot_path, &shots))
+        {
+            return EXIT_ERROR;
+        }
+    }
+    else
+    {
+        bench_make_shots(&shots);
+    }
+    if (noise_path != NULL)
+    {
+        n_noise = 1;
+        noise_names[0] = "noise";
+        noisy_names[0] = "shots+noise";
+        if (!bench_read_trace(noise_path, &noise[0]))
+        {
+            return EXIT_ERROR;
+        }
+    }
+    else
+    {
+        bench_make_glitches(&noise[0]);
+        bench_make_lamp(&noise[1]);
+        bench_make_sun(&noise[2]);
+    }
+
+    cases[n_cases++] = (bench_case_s){ "shots", &shots };
+    for (size_t i = 0; i < n_noise; i++)
+    {
+        cases[n_cases++] = (bench_case_s){ noise_names[i], &noise[i] };
+    }
+    for (size_t i = 0; i < n_noise; i++)
+    {
+        bench_overlay(&shots, &noise[i], &noisy[i]);
+        cases[n_cases++] = (bench_case_s){ noisy_names[i], &noisy[i] };
+    }
+
+    printf("%u shots over %.1f s%s, noise over %.1f s%s\n", shots.n_shots, shots.end_us / 1e6,
+           (shot_path != NULL) ? " (recorded)" : "", noise[0].end_us / 1e6, (noise_path != NULL) ? " (recorded)" : "");
+
+    app_ir_rx_cfg_default(&cfg);
+    if (check || (min_mark_us >= 0) || (min_frames >= 0))
+    {
+        for (uint32_t i = 0; (min_mark_us >= 0) && (i < APP_IR_RX_N_RECEIVERS); i++)
+        {
+            cfg.min_mark_us[i] = (uint16_t)min_mark_us;
+        }
+        if (min_frames >= 0)
+        {
+            cfg.min_frames = (uint8_t)min_frames;
+        }
+        if (!app_ir_rx_cfg_valid(&cfg))
+        {
+            fprintf(stderr, "min_mark_us must be up to %u, and min_frames from 1 to %u\n",
+                    APP_IR_RX_MAX_MIN_MARK_US, APP_IR_RX_MAX_MIN_FRAMES);
+            return EXIT_ERROR;
+        }
+        n_failed = bench_setting(cases, n_cases, &cfg, check);
+    }
+    else
+    {
+        for (uint8_t frames = 1; frames <= APP_IR_RX_MAX_MIN_FRAMES; frames++)
+        {
+            for (size_t m = 0; m < (sizeof(bench_min_marks_us) / sizeof(bench_min_marks_us[0])); m++)
+            {
+                for (uint32_t i = 0; i < APP_IR_RX_N_RECEIVERS; i++)
+                {
+                    cfg.min_mark_us[i] = bench_min_marks_us[m];
+                }
+                cfg.min_frames = frames;
+                bench_setting(cases, n_cases, &cfg, false);
+            }
+        }
+    }
+
+    if (check)
+    {
+        printf("%s\n", (n_failed == 0) ? "PASS" : "FAIL");
+    }
+    return (n_failed == 0) ? EXIT_PASS : EXIT_FAIL;
+}
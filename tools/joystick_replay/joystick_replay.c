@@ -0,0 +1,771 @@
+/**
+ * @file joystick_replay.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host replay of joystick input through app_joystick_filter.c. A trace of
+ * the RC controller app's GATT writes is handed to the filters the way the
+ * car sees it: one control loop tick at a time, through the latest-value
+ * mailbox, so only the newest position is visible on each tick. Each axis is
+ * replayed raw, with only the deadband and expo, and with the full filter,
+ * and the setpoint jitter and tracking of each are compared.
+ *
+ * With no trace given, a 20 s drive is made up: the stick is sampled at the
+ * app's 60 Hz frame rate with touch noise, and written on 30 ms connection
+ * events, some of which are missed and some of which are lost to a burst of
+ * interference, with the writes queued up meanwhile delivered together. X and
+ * Y are separate writes, -p us apart on the event (400 by default). From
+ * 1000 up they land on different ticks, so each filter sees ticks where only
+ * the other axis was written.
+ *
+ * Usage:
+ *   joystick_replay [-i <trace.csv>] [-w <trace.csv>] [-p <us>] [-x <cfg>] [-y <cfg>] [-o <out.csv>] [-c]
+ *
+ * Traces have a row per write, "ms,axis,value" with axis x or y. -w saves the
+ * made up trace in the same format. A cfg is "deadband,expo,alpha,beta,ms"
+ * in thousandths, as entered with the joystick_filter CLI command. The output
+ * has a row per control loop tick.
+ *
+ * -c checks the filtered run of each axis against its raw run, and exits 0
+ * if it cuts the jitter enough without tracking the stick much worse or
+ * being slower back to neutral
+ *
+ * @version 0.1
+ * @date 2024-12-21
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_joystick_filter.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define REPLAY_TICK_US           (1000U)     // Control loop tick (CAR_CONTROL_TICK_HZ)
+#define REPLAY_N_AXES            (2U)
+#define REPLAY_AXIS_X            (0U)
+#define REPLAY_AXIS_Y            (1U)
+
+// Made up trace
+#define REPLAY_SYNTH_MS          (20000U)
+#define REPLAY_FRAME_US          (16667U)    // The app samples the stick once per frame
+#define REPLAY_CONN_US           (30000U)    // Connection interval
+#define REPLAY_PACKET_US         (400U)      // Between writes delivered on the same event, by default
+#define REPLAY_MAX_PACKET_US     (1875U)     // So a full queue still fits in a connection interval
+#define REPLAY_NOISE             (0.01)      // Touch noise, full scale
+#define REPLAY_MISS_PERMILLE     (100U)      // Connection events missed
+#define REPLAY_BURST_PERMILLE    (10U)       // Connection events that start a burst of interference
+#define REPLAY_BURST_US          (150000U)
+#define REPLAY_MAX_QUEUED        (16U)       // Writes the app's BLE stack holds while it can't send
+
+// The stick counts as released once its position is at neutral after being this far out
+#define REPLAY_RELEASE_FROM      (0.2)
+#define REPLAY_RELEASE_MAX_US    (1000000U)
+// The output counts as back at neutral this close to it, as task_servo rounds it
+#define REPLAY_NEUTRAL           (0.01)
+
+// Check thresholds, for -c. Filtering must cut the jitter by at least REPLAY_CHECK_JITTER_CUT,
+// and can't add more than REPLAY_CHECK_MAX_ERROR to the max error: when the writes stop, the
+// prediction carries the stick on where holding the last value would stop short, so it can
+// overshoot a little. Release to neutral must be no slower than raw, and within
+// REPLAY_CHECK_RELEASE_MS
+#define REPLAY_CHECK_JITTER_CUT  (0.25)
+#define REPLAY_CHECK_MAX_ERROR   (0.15)
+#define REPLAY_CHECK_RELEASE_MS  (20.0)
+
+#define EXIT_PASS                (0)
+#define EXIT_FAIL                (1)
+#define EXIT_ERROR               (2)
+
+// A write to one of the joystick characteristics
+typedef struct
+{
+    uint32_t us;
+    uint32_t axis;
+    float value;
+} replay_write_s;
+
+typedef struct
+{
+    replay_write_s* writes;
+    uint32_t n_writes;
+    uint32_t n_alloc;
+    uint32_t n_ticks;
+    double* truth[REPLAY_N_AXES];            // Stick position at every tick
+} replay_trace_s;
+
+typedef struct
+{
+    double jitter;                           // Setpoint change per tick the stick didn't make (RMS)
+    double max_step;                         // Largest setpoint change in a tick
+    double rms_error;                        // Against the stick, after the same deadband and expo
+    double max_error;
+    double mean_release_ms;                  // From the stick reaching neutral to the output, < 0 if it never did
+} replay_result_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static const char* const replay_axis_names[REPLAY_N_AXES] = { "steering (x)", "throttle (y)" };
+static uint32_t replay_rng = 0x2545F491U;
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Uniform random number, so made up traces are the same every run
+ *
+ * @return double
+ * From 0 to 1
+ */
+static double replay_random(void)
+{
+    replay_rng ^= replay_rng << 13;
+    replay_rng ^= replay_rng >> 17;
+    replay_rng ^= replay_rng << 5;
+    return (double)replay_rng / 4294967296.0;
+}
+
+
+/**
+ * @brief  Move linearly from one value to another over a span of time
+ *
+ * @param double
+ * Time (s)
+ * @param double
+ * Start of the span (s)
+ * @param double
+ * End of the span (s)
+ * @param double
+ * Value at its start
+ * @param double
+ * Value at its end
+ * @return double
+ * Value at the time
+ */
+static double replay_ramp(double t, double t0, double t1, double v0, double v1)
+{
+    return v0 + ((v1 - v0) * (t - t0) / (t1 - t0));
+}
+
+
+/**
+ * @brief  Made up stick position: full throttle with thumb tremor, snapping
+ *         back to neutral, reversing, sweeps and pumps on the throttle, and
+ *         slow sweeps and fast flicks on the steering
+ *
+ * @param uint32_t
+ * Axis
+ * @param double
+ * Time (s)
+ * @return double
+ * Stick position, from -1 to 1
+ */
+static double replay_synth_stick(uint32_t axis, double t)
+{
+    const double two_pi = 2.0 * M_PI;
+
+    if (axis == REPLAY_AXIS_Y)
+    {
+        if (t < 0.5)   return 0.0;
+        if (t < 0.8)   return replay_ramp(t, 0.5, 0.8, 0.0, 1.0);
+        if (t < 3.0)   return 0.97 + (0.03 * sin(two_pi * 7.0 * t));
+        if (t < 3.05)  return replay_ramp(t, 3.0, 3.05, 0.97, 0.0);
+        if (t < 4.0)   return 0.0;
+        if (t < 4.3)   return replay_ramp(t, 4.0, 4.3, 0.0, -0.6);
+        if (t < 5.0)   return -0.6;
+        if (t < 5.05)  return replay_ramp(t, 5.0, 5.05, -0.6, 0.0);
+        if (t < 5.5)   return 0.0;
+        if (t < 5.8)   return replay_ramp(t, 5.5, 5.8, 0.0, 0.6);
+        if (t < 9.0)   return 0.6 + (0.3 * sin(two_pi * 0.5 * (t - 5.8)));
+        if (t < 9.05)  return replay_ramp(t, 9.0, 9.05, 0.6 + (0.3 * sin(two_pi * 0.5 * 3.2)), 0.0);
+        if (t < 10.0)  return 0.0;
+        if (t < 14.0)  return 0.5 + (0.4 * sin(two_pi * 2.0 * (t - 10.0)));
+        if (t < 14.05) return replay_ramp(t, 14.0, 14.05, 0.5, 0.0);
+        if (t < 15.0)  return 0.0;
+        if (t < 15.2)  return replay_ramp(t, 15.0, 15.2, 0.0, 1.0);
+        if (t < 19.0)  return 1.0;
+        if (t < 19.05) return replay_ramp(t, 19.0, 19.05, 1.0, 0.0);
+        return 0.0;
+    }
+
+    if (t < 8.0)
+    {
+        return 0.8 * sin(two_pi * 0.4 * t);
+    }
+    if (t < 12.0)
+    {
+        // Flick from side to side every half second
+        const double phase = fmod(t - 8.0, 1.0);
+        if (phase < 0.04)  return replay_ramp(phase, 0.0, 0.04, -0.9, 0.9);
+        if (phase < 0.5)   return 0.9;
+        if (phase < 0.54)  return replay_ramp(phase, 0.5, 0.54, 0.9, -0.9);
+        return -0.9;
+    }
+    return (0.5 * sin(two_pi * 1.2 * t)) + (0.3 * sin(two_pi * 0.3 * t));
+}
+
+
+/**
+ * @brief  Add a write to a trace
+ *
+ * @param replay_trace_s*
+ * Trace to add to
+ * @param uint32_t
+ * When it was written (us)
+ * @param uint32_t
+ * Axis written
+ * @param double
+ * Value written
+ */
+static void replay_add_write(replay_trace_s* trace, uint32_t us, uint32_t axis, double value)
+{
+    if (trace->n_writes == trace->n_alloc)
+    {
+        trace->n_alloc = (trace->n_alloc > 0) ? (trace->n_alloc * 2) : 1024;
+        trace->writes = realloc(trace->writes, trace->n_alloc * sizeof(*trace->writes));
+        if (trace->writes == NULL)
+        {
+            perror("realloc");
+            exit(EXIT_ERROR);
+        }
+    }
+    trace->writes[trace->n_writes].us = us;
+    trace->writes[trace->n_writes].axis = axis;
+    trace->writes[trace->n_writes].value = (float)value;
+    trace->n_writes++;
+}
+
+
+/**
+ * @brief  Make up a drive, as the car would receive it over BLE
+ *
+ * @param replay_trace_s*
+ * Where to put the writes and the stick's actual position
+ * @param uint32_t
+ * Time between writes delivered on the same connection event (us)
+ */
+static void replay_synth(replay_trace_s* trace, uint32_t packet_us)
+{
+    // Writes the app has made but not been able to send yet
+    uint32_t queued_axis[REPLAY_MAX_QUEUED];
+    double queued_value[REPLAY_MAX_QUEUED];
+    uint32_t n_queued = 0;
+    uint32_t next_frame_us = 0;
+    uint32_t burst_end_us = 0;
+
+    trace->n_ticks = (REPLAY_SYNTH_MS * 1000U) / REPLAY_TICK_US;
+    for (uint32_t axis = 0; axis < REPLAY_N_AXES; axis++)
+    {
+        trace->truth[axis] = malloc(trace->n_ticks * sizeof(double));
+        for (uint32_t tick = 0; tick < trace->n_ticks; tick++)
+        {
+            trace->truth[axis][tick] = replay_synth_stick(axis, (tick * REPLAY_TICK_US) * 1e-6);
+        }
+    }
+
+    for (uint32_t conn_us = REPLAY_CONN_US; conn_us < REPLAY_SYNTH_MS * 1000U; conn_us += REPLAY_CONN_US)
+    {
+        // The app writes both axes every frame, dropping the oldest writes if it can't keep up
+        for (; next_frame_us <= conn_us; next_frame_us += REPLAY_FRAME_US)
+        {
+            for (uint32_t axis = 0; axis < REPLAY_N_AXES; axis++)
+            {
+                double value = replay_synth_stick(axis, next_frame_us * 1e-6) + (REPLAY_NOISE * ((2.0 * replay_random()) - 1.0));
+                value = (value > 1.0) ? 1.0 : ((value < -1.0) ? -1.0 : value);
+                if (n_queued == REPLAY_MAX_QUEUED)
+                {
+                    memmove(&queued_axis[0], &queued_axis[1], (REPLAY_MAX_QUEUED - 1) * sizeof(queued_axis[0]));
+                    memmove(&queued_value[0], &queued_value[1], (REPLAY_MAX_QUEUED - 1) * sizeof(queued_value[0]));
+                    n_queued--;
+                }
+                queued_axis[n_queued] = axis;
+                queued_value[n_queued] = value;
+                n_queued++;
+            }
+        }
+
+        // Deliver everything queued, unless this event is missed
+        if (conn_us < burst_end_us)
+        {
+            continue;
+        }
+        if (replay_random() * 1000.0 < REPLAY_BURST_PERMILLE)
+        {
+            burst_end_us = conn_us + REPLAY_BURST_US;
+            continue;
+        }
+        if (replay_random() * 1000.0 < REPLAY_MISS_PERMILLE)
+        {
+            continue;
+        }
+        for (uint32_t i = 0; i < n_queued; i++)
+        {
+            replay_add_write(trace, conn_us + (i * packet_us), queued_axis[i], queued_value[i]);
+        }
+        n_queued = 0;
+    }
+}
+
+
+/**
+ * @brief  Read a recorded trace. With no record of the stick itself, it is
+ *         taken to move in straight lines between the writes
+ *
+ * @param replay_trace_s*
+ * Where to put the writes and the stick's position
+ * @param const char*
+ * CSV file to read
+ * @return bool
+ * true on success
+ */
+static bool replay_load(replay_trace_s* trace, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    char line[128];
+    uint32_t prev_us = 0;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        double ms;
+        char axis;
+        double value;
+
+        if (sscanf(line, "%lf,%c,%lf", &ms, &axis, &value) != 3)
+        {
+            // Header or blank line
+            continue;
+        }
+        if (((axis != 'x') && (axis != 'y')) || (ms < 0.0) || ((uint32_t)(ms * 1000.0) < prev_us))
+        {
+            fprintf(stderr, "%s: bad row: %s", path, line);
+            fclose(file);
+            return false;
+        }
+        prev_us = (uint32_t)(ms * 1000.0);
+        replay_add_write(trace, prev_us, (axis == 'x') ? REPLAY_AXIS_X : REPLAY_AXIS_Y, value);
+    }
+    fclose(file);
+    if (trace->n_writes == 0)
+    {
+        fprintf(stderr, "%s: no writes\n", path);
+        return false;
+    }
+
+    trace->n_ticks = (prev_us / REPLAY_TICK_US) + 1;
+    for (uint32_t axis = 0; axis < REPLAY_N_AXES; axis++)
+    {
+        const replay_write_s* prev = NULL;
+        const replay_write_s* next = NULL;
+        uint32_t i = 0;
+
+        trace->truth[axis] = malloc(trace->n_ticks * sizeof(double));
+        for (uint32_t tick = 0; tick < trace->n_ticks; tick++)
+        {
+            const uint32_t now_us = tick * REPLAY_TICK_US;
+
+            // Find the writes either side of this tick
+            while ((next == NULL) || (next->us < now_us))
+            {
+                if (next != NULL)
+                {
+                    prev = next;
+                }
+                next = NULL;
+                for (; i < trace->n_writes; i++)
+                {
+                    if (trace->writes[i].axis == axis)
+                    {
+                        next = &trace->writes[i++];
+                        break;
+                    }
+                }
+                if (next == NULL)
+                {
+                    break;
+                }
+            }
+            if (prev == NULL)
+            {
+                trace->truth[axis][tick] = (next != NULL) ? next->value : 0.0;
+            }
+            else if ((next == NULL) || (next->us == prev->us))
+            {
+                trace->truth[axis][tick] = prev->value;
+            }
+            else
+            {
+                trace->truth[axis][tick] = replay_ramp(now_us, prev->us, next->us, prev->value, next->value);
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief  Replay a trace through one axis's filter, as task_car and
+ *         task_servo run it, and measure the result
+ *
+ * @param const replay_trace_s*
+ * Trace to replay
+ * @param uint32_t
+ * Axis to replay
+ * @param const app_joystick_filter_cfg_s*
+ * Conditioning settings
+ * @param const char*
+ * Name of the settings, for the output
+ * @param replay_result_s*
+ * Where to write the measurements
+ * @param FILE*
+ * Where to write every tick, or NULL
+ */
+static void replay_run(const replay_trace_s* trace, uint32_t axis, const app_joystick_filter_cfg_s* cfg,
+                       const char* label, replay_result_s* result, FILE* out)
+{
+    app_joystick_filter_s filter;
+    float latest[REPLAY_N_AXES] = { 0.0f, 0.0f };
+    uint32_t next_write = 0;
+    double prev_output = 0.0;
+    double prev_truth = 0.0;
+    double sum_jitter2 = 0.0;
+    double sum_error2 = 0.0;
+    uint32_t n_releases = 0;
+    double sum_release_ms = 0.0;
+    uint32_t release_tick = 0;
+    bool releasing = false;
+    bool was_out = false;
+
+    memset(result, 0, sizeof(*result));
+    app_joystick_filter_init(&filter, cfg);
+
+    for (uint32_t tick = 0; tick < trace->n_ticks; tick++)
+    {
+        const uint32_t now_us = tick * REPLAY_TICK_US;
+        bool new_sample = false;
+
+        // Only the newest write is left in the mailbox by the time the tick runs
+        while ((next_write < trace->n_writes) && (trace->writes[next_write].us <= now_us))
+        {
+            // The app writes each axis separately, and each has its own count, so only a
+            // write to this axis is a new sample for its filter
+            latest[trace->writes[next_write].axis] = trace->writes[next_write].value;
+            new_sample = new_sample || (trace->writes[next_write].axis == axis);
+            next_write++;
+        }
+
+        const double output = app_joystick_filter_update(&filter, new_sample, latest[axis], now_us);
+        const double truth = app_joystick_filter_shape(cfg, (float)trace->truth[axis][tick]);
+        const double step = output - prev_output;
+
+        if (tick > 0)
+        {
+            sum_jitter2 += (step - (truth - prev_truth)) * (step - (truth - prev_truth));
+            result->max_step = fmax(result->max_step, fabs(step));
+        }
+        sum_error2 += (output - truth) * (output - truth);
+        result->max_error = fmax(result->max_error, fabs(output - truth));
+
+        // Time from the stick reaching neutral to the output
+        if (fabs(trace->truth[axis][tick]) >= REPLAY_RELEASE_FROM)
+        {
+            was_out = true;
+            releasing = false;
+        }
+        else if (was_out && (trace->truth[axis][tick] == 0.0))
+        {
+            was_out = false;
+            releasing = true;
+            release_tick = tick;
+        }
+        if (releasing && ((fabs(output) < REPLAY_NEUTRAL) || ((tick - release_tick) * REPLAY_TICK_US >= REPLAY_RELEASE_MAX_US)))
+        {
+            sum_release_ms += (tick - release_tick) * (REPLAY_TICK_US / 1000.0);
+            n_releases++;
+            releasing = false;
+        }
+
+        if (out != NULL)
+        {
+            fprintf(out, "%s,%s,%.3f,%.4f,%.4f\n", replay_axis_names[axis], label, now_us / 1000.0, truth, output);
+        }
+        prev_output = output;
+        prev_truth = truth;
+    }
+
+    result->jitter = sqrt(sum_jitter2 / (trace->n_ticks - 1));
+    result->rms_error = sqrt(sum_error2 / trace->n_ticks);
+    result->mean_release_ms = (n_releases > 0) ? (sum_release_ms / n_releases) : -1.0;
+}
+
+
+/**
+ * @brief  Check a filtered run against the raw run of the same axis
+ *
+ * @param const replay_result_s*
+ * Raw run
+ * @param const replay_result_s*
+ * Filtered run
+ * @return bool
+ * true if it passes
+ */
+static bool replay_check(const replay_result_s* raw, const replay_result_s* filtered)
+{
+    bool ok = (filtered->jitter <= ((1.0 - REPLAY_CHECK_JITTER_CUT) * raw->jitter)) &&
+              (filtered->max_error <= (raw->max_error + REPLAY_CHECK_MAX_ERROR));
+
+    // Only if the stick was released at all
+    if (raw->mean_release_ms >= 0.0)
+    {
+        ok = ok && (filtered->mean_release_ms >= 0.0) && (filtered->mean_release_ms <= raw->mean_release_ms) &&
+             (filtered->mean_release_ms <= REPLAY_CHECK_RELEASE_MS);
+    }
+    return ok;
+}
+
+
+/**
+ * @brief  Replay one axis raw, shaped and filtered, and print the comparison
+ *
+ * @param const replay_trace_s*
+ * Trace to replay
+ * @param uint32_t
+ * Axis to replay
+ * @param const app_joystick_filter_cfg_s*
+ * Full conditioning settings
+ * @param FILE*
+ * Where to write every tick, or NULL
+ * @param bool
+ * true to check the filtered run against the raw run
+ * @return bool
+ * true unless the check failed
+ */
+static bool replay_axis(const replay_trace_s* trace, uint32_t axis, const app_joystick_filter_cfg_s* cfg, FILE* out, bool check)
+{
+    const app_joystick_filter_cfg_s raw_cfg = { .alpha = APP_JOYSTICK_FILTER_ONE };
+    const app_joystick_filter_cfg_s shaped_cfg = { .deadband = cfg->deadband, .expo = cfg->expo, .alpha = APP_JOYSTICK_FILTER_ONE };
+    const struct
+    {
+        const char* label;
+        const app_joystick_filter_cfg_s* cfg;
+    } runs[] = {
+        { "raw", &raw_cfg },
+        { "shaped", &shaped_cfg },
+        { "filtered", cfg }
+    };
+    replay_result_s raw_result;
+    bool ok = true;
+
+    printf("%s: deadband %u, expo %u, alpha %u, beta %u, predict %u ms\n", replay_axis_names[axis],
+           cfg->deadband, cfg->expo, cfg->alpha, cfg->beta, cfg->predict_ms);
+    printf("  %-10s %10s %9s %10s %10s %11s\n", "", "jitter (%)", "max step", "rms error", "max error", "release ms");
+    for (uint32_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+    {
+        replay_result_s result;
+
+        replay_run(trace, axis, runs[i].cfg, runs[i].label, &result, out);
+        if (i == 0)
+        {
+            raw_result = result;
+        }
+        printf("  %-10s %10.3f %8.1f%% %9.2f%% %9.1f%%", runs[i].label, 100.0 * result.jitter,
+               100.0 * result.max_step, 100.0 * result.rms_error, 100.0 * result.max_error);
+        if (result.mean_release_ms >= 0.0)
+        {
+            printf(" %11.1f", result.mean_release_ms);
+        }
+        else
+        {
+            printf(" %11s", "-");
+        }
+        if (i > 0)
+        {
+            printf("   (jitter %+.0f%%)", 100.0 * ((result.jitter / raw_result.jitter) - 1.0));
+        }
+        if (check && (runs[i].cfg == cfg))
+        {
+            ok = replay_check(&raw_result, &result);
+            printf("%s", ok ? "" : "  FAIL");
+        }
+        printf("\n");
+    }
+    return ok;
+}
+
+
+/**
+ * @brief  Parse conditioning settings from the command line
+ *
+ * @param const char*
+ * "deadband,expo,alpha,beta,ms"
+ * @param app_joystick_filter_cfg_s*
+ * Where to write them
+ * @return bool
+ * true if they're valid
+ */
+static bool replay_parse_cfg(const char* arg, app_joystick_filter_cfg_s* cfg)
+{
+    unsigned int deadband;
+    unsigned int expo;
+    unsigned int alpha;
+    unsigned int beta;
+    unsigned int predict_ms;
+
+    if ((sscanf(arg, "%u,%u,%u,%u,%u", &deadband, &expo, &alpha, &beta, &predict_ms) != 5) ||
+        (deadband >= APP_JOYSTICK_FILTER_ONE) || (expo > APP_JOYSTICK_FILTER_ONE) ||
+        (alpha > APP_JOYSTICK_FILTER_ONE) || (beta > APP_JOYSTICK_FILTER_ONE) || (predict_ms > UINT16_MAX))
+    {
+        return false;
+    }
+    cfg->deadband = (uint16_t)deadband;
+    cfg->expo = (uint16_t)expo;
+    cfg->alpha = (uint16_t)alpha;
+    cfg->beta = (uint16_t)beta;
+    cfg->predict_ms = (uint16_t)predict_ms;
+    return true;
+}
+
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: joystick_replay [-i <trace.csv>] [-w <trace.csv>] [-p <us>] [-x <cfg>] [-y <cfg>] [-o <out.csv>] [-c]\n"
+                    "  us is the time between writes on a connection event in the made up drive, up to %u\n"
+                    "  cfg is deadband,expo,alpha,beta,predict_ms in thousandths (predict in ms)\n", REPLAY_MAX_PACKET_US);
+    return EXIT_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    app_joystick_filter_cfg_s cfgs[REPLAY_N_AXES] = {
+        APP_JOYSTICK_FILTER_DEFAULT_STEERING,
+        APP_JOYSTICK_FILTER_DEFAULT_THROTTLE
+    };
+    replay_trace_s trace = { 0 };
+    const char* in_path = NULL;
+    const char* save_path = NULL;
+    FILE* out = NULL;
+    uint32_t packet_us = REPLAY_PACKET_US;
+    bool check = false;
+    uint32_t n_failed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-i") == 0) && (i + 1 < argc))
+        {
+            in_path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-w") == 0) && (i + 1 < argc))
+        {
+            save_path = argv[++i];
+        }
+        else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc))
+        {
+            char* end;
+            const unsigned long us = strtoul(argv[++i], &end, 10);
+            if ((*end != '\0') || (us > REPLAY_MAX_PACKET_US))
+            {
+                return usage();
+            }
+            packet_us = (uint32_t)us;
+        }
+        else if ((strcmp(argv[i], "-x") == 0) && (i + 1 < argc))
+        {
+            if (!replay_parse_cfg(argv[++i], &cfgs[REPLAY_AXIS_X]))
+            {
+                return usage();
+            }
+        }
+        else if ((strcmp(argv[i], "-y") == 0) && (i + 1 < argc))
+        {
+            if (!replay_parse_cfg(argv[++i], &cfgs[REPLAY_AXIS_Y]))
+            {
+                return usage();
+            }
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+        {
+            out = fopen(argv[++i], "w");
+            if (out == NULL)
+            {
+                perror(argv[i]);
+                return EXIT_ERROR;
+            }
+            fprintf(out, "axis,run,ms,stick,output\n");
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            check = true;
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if (in_path != NULL)
+    {
+        if (!replay_load(&trace, in_path))
+        {
+            return EXIT_ERROR;
+        }
+        printf("%s: %u writes over %.1f s\n", in_path, trace.n_writes, trace.n_ticks * (REPLAY_TICK_US * 1e-6));
+    }
+    else
+    {
+        replay_synth(&trace, packet_us);
+        printf("made up drive: %u writes over %.1f s, %u us apart on an event\n", trace.n_writes,
+               trace.n_ticks * (REPLAY_TICK_US * 1e-6), packet_us);
+    }
+    if (save_path != NULL)
+    {
+        FILE* save = fopen(save_path, "w");
+        if (save == NULL)
+        {
+            perror(save_path);
+            return EXIT_ERROR;
+        }
+        fprintf(save, "ms,axis,value\n");
+        for (uint32_t i = 0; i < trace.n_writes; i++)
+        {
+            fprintf(save, "%.1f,%c,%.4f\n", trace.writes[i].us / 1000.0, (trace.writes[i].axis == REPLAY_AXIS_X) ? 'x' : 'y',
+                    trace.writes[i].value);
+        }
+        fclose(save);
+    }
+
+    for (uint32_t axis = 0; axis < REPLAY_N_AXES; axis++)
+    {
+        if (!replay_axis(&trace, axis, &cfgs[axis], out, check))
+        {
+            n_failed++;
+        }
+    }
+    if (check)
+    {
+        printf("%s\n", (n_failed == 0) ? "PASS" : "FAIL");
+    }
+
+    if (out != NULL)
+    {
+        fclose(out);
+    }
+    for (uint32_t axis = 0; axis < REPLAY_N_AXES; axis++)
+    {
+        free(trace.truth[axis]);
+    }
+    free(trace.writes);
+
+    return (n_failed == 0) ? EXIT_PASS : EXIT_FAIL;
+}
+
+/* [] END OF FILE */
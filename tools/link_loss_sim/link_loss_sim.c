@@ -0,0 +1,494 @@
+/**
+ * @file link_loss_sim.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host simulation of the link-loss failsafe (app_failsafe.c). A fake BLE
+ * stack stands in for the RC controller app: it connects, starts the race,
+ * and writes the joystick on every connection event, calling into the
+ * failsafe the way the GATT handler does. The car runs the way task_car runs
+ * it (failsafe, throttle filter, setpoint slew, and the motor drive state
+ * machine every control loop tick) against the motor model from speed_sim.
+ *
+ * Midway through a drive at full throttle the link is lost, in each of the
+ * ways it can be: the app disconnects, the radio goes quiet and the stack
+ * only reports the disconnect at the supervision timeout, a burst of
+ * interference that the failsafe should ride out, and a disconnect followed
+ * by a reconnect. For each, the time from the link being lost to the
+ * failsafe tripping, the setpoint reaching 0, and the wheel stopping is
+ * reported, with and without the failsafe.
+ *
+ * Usage:
+ *   link_loss_sim [-c <deadline_ms>,<decel>] [-o <trace.csv>] [-k]
+ *
+ * The settings are as entered with the failsafe CLI command. -k checks the
+ * times against the settings, and exits non-zero if the car doesn't stop in
+ * time, or stops when it shouldn't. The trace has a row per control loop tick
+ *
+ * @version 0.1
+ * @date 2024-12-23
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_failsafe.h"
+#include "app_joystick_filter.h"
+#include "app_motor_drive.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define SIM_STEP_US              (10U)
+#define SIM_TICK_US              (1000U)     // Control loop tick (CAR_CONTROL_TICK_HZ)
+#define SIM_RAMP_STEP            (5)         // DC_MOTOR_RAMP_STEP_VAL
+#define SIM_SPEED                (100)       // Boost, the fastest the car goes
+
+// Motor model, as in speed_sim
+#define SIM_MOTOR_PPS_PER_DUTY   (4.8)
+#define SIM_MOTOR_FRICTION       (8.0)       // Duty cycle (%) it takes to get the wheel moving
+#define SIM_MOTOR_TAU_S          (0.15)
+
+// Fake BLE stack
+#define SIM_CONN_US              (30000U)    // Connection interval, with a joystick write on each
+#define SIM_SUPERVISION_MS       (2000U)     // Quiet time before the stack reports a disconnect
+#define SIM_BURST_MS             (150U)      // Longest burst of interference the car should ride out
+#define SIM_RECONNECT_MS         (1000U)     // Time from a disconnect to the app reconnecting
+
+#define SIM_LOSS_MS              (2000U)     // When the link is lost
+#define SIM_END_MS               (6000U)
+// Allowed for the motor to spin down once the setpoint is 0, when checking
+#define SIM_SPIN_DOWN_MS         (300U)
+
+#define EXIT_PASS                (0)
+#define EXIT_FAIL                (1)
+#define EXIT_ERROR               (2)
+
+// Ways the link can be lost
+typedef enum
+{
+    SIM_LOSS_DISCONNECT   = 0,               // The app disconnects
+    SIM_LOSS_SILENT       = 1,               // The radio goes quiet until the supervision timeout
+    SIM_LOSS_INTERFERENCE = 2,               // The radio goes quiet for a moment
+    SIM_LOSS_RECONNECT    = 3,               // The app disconnects, and comes back
+    SIM_LOSS_MAX
+} sim_loss_e;
+
+// Fake BLE stack, as seen by the GATT handler
+typedef struct
+{
+    bool connected;
+    bool writing;                            // Whether joystick writes are getting through
+    uint32_t next_write_us;
+    float y;
+    uint32_t n_writes;
+} sim_ble_s;
+
+// The car, as task_car runs it
+typedef struct
+{
+    app_failsafe_s failsafe;
+    app_joystick_filter_s filter;
+    app_motor_drive_s drive;
+    uint32_t n_writes_seen;
+    float setpoint;                          // curr_scaled_speed
+    double speed;                            // Wheel speed (pulses/s)
+    double position;                         // Pulses
+} sim_car_s;
+
+// Times from the link being lost, -1 if it didn't happen
+typedef struct
+{
+    double trip_ms;
+    double zero_ms;                          // Setpoint reached 0
+    double stop_ms;                          // Wheel stopped
+    double resume_ms;                        // Moving again after the link came back
+    double travel;                           // Pulses travelled after the link was lost
+} sim_result_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+static const char* const sim_loss_names[SIM_LOSS_MAX] = { "disconnect", "silent", "interference", "reconnect" };
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Advance the motor model by one simulation step
+ *
+ * @param sim_car_s*
+ * Car whose motor to advance
+ * @param int32_t
+ * Signed duty cycle it is driven at
+ */
+static void sim_motor_step(sim_car_s* car, int32_t duty)
+{
+    const double dt = SIM_STEP_US * 1e-6;
+    const double drive = SIM_MOTOR_PPS_PER_DUTY * duty;
+    const double friction = SIM_MOTOR_PPS_PER_DUTY * SIM_MOTOR_FRICTION;
+    const double prev_speed = car->speed;
+
+    if ((prev_speed == 0.0) && (fabs(drive) <= friction))
+    {
+        // Not enough to get the wheel moving
+    }
+    else
+    {
+        const double direction = (prev_speed != 0.0) ? ((prev_speed > 0.0) ? 1.0 : -1.0) : ((drive > 0.0) ? 1.0 : -1.0);
+        car->speed += (drive - (direction * friction) - prev_speed) * dt / SIM_MOTOR_TAU_S;
+        if ((car->speed * direction < 0.0) && (fabs(drive) <= friction))
+        {
+            // Friction stops the wheel rather than turning it backwards
+            car->speed = 0.0;
+        }
+    }
+    car->position += car->speed * dt;
+}
+
+
+/**
+ * @brief  Run the fake BLE stack up to the given time, making the GATT
+ *         handler's calls into the failsafe
+ *
+ * @param sim_ble_s*
+ * Fake BLE stack
+ * @param sim_car_s*
+ * Car the app is connected to
+ * @param sim_loss_e
+ * How the link is lost
+ * @param uint32_t
+ * Current time (us)
+ */
+static void sim_ble_run(sim_ble_s* ble, sim_car_s* car, sim_loss_e loss, uint32_t now_us)
+{
+    const uint32_t loss_us = SIM_LOSS_MS * 1000U;
+
+    switch (loss)
+    {
+        case SIM_LOSS_DISCONNECT:
+        case SIM_LOSS_RECONNECT:
+            if (ble->connected && (now_us >= loss_us) && (now_us < loss_us + SIM_RECONNECT_MS * 1000U))
+            {
+                // app_bt_gatt_connection_down
+                ble->connected = false;
+                ble->writing = false;
+                app_failsafe_link_down(&car->failsafe);
+            }
+            else if (!ble->connected && (loss == SIM_LOSS_RECONNECT) && (now_us >= loss_us + SIM_RECONNECT_MS * 1000U))
+            {
+                // app_bt_gatt_connection_up, and the app carries on writing
+                ble->connected = true;
+                ble->writing = true;
+                ble->next_write_us = now_us + SIM_CONN_US;
+                app_failsafe_link_up(&car->failsafe, now_us);
+            }
+            break;
+        case SIM_LOSS_SILENT:
+            ble->writing = (now_us < loss_us);
+            if (ble->connected && (now_us >= loss_us + SIM_SUPERVISION_MS * 1000U))
+            {
+                ble->connected = false;
+                app_failsafe_link_down(&car->failsafe);
+            }
+            break;
+        case SIM_LOSS_INTERFERENCE:
+            ble->writing = (now_us < loss_us) || (now_us >= loss_us + SIM_BURST_MS * 1000U);
+            break;
+        default:
+            break;
+    }
+
+    while (now_us >= ble->next_write_us)
+    {
+        if (ble->connected && ble->writing)
+        {
+            // app_bt_car_set_joystick
+            ble->n_writes++;
+            app_failsafe_input(&car->failsafe, APP_FAILSAFE_INPUT_JOYSTICK, ble->next_write_us);
+        }
+        ble->next_write_us += SIM_CONN_US;
+    }
+}
+
+
+/**
+ * @brief  Run one control loop tick, as task_car does, then run the motor
+ *         until the next one
+ *
+ * @param sim_car_s*
+ * Car to run
+ * @param const sim_ble_s*
+ * Fake BLE stack, for the joystick mailbox
+ * @param bool
+ * false to drive the way the car used to, on the last joystick position
+ * @param uint32_t
+ * Current time (us)
+ */
+static void sim_car_tick(sim_car_s* car, const sim_ble_s* ble, bool use_failsafe, uint32_t now_us)
+{
+    const bool new_sample = (ble->n_writes != car->n_writes_seen);
+    const bool link_ok = !use_failsafe || (APP_FAILSAFE_STATE_OK == app_failsafe_update(&car->failsafe, now_us));
+
+    car->n_writes_seen = ble->n_writes;
+    if (link_ok)
+    {
+        const float y = app_joystick_filter_update(&car->filter, new_sample, ble->y, now_us);
+        const float scaled_speed = SIM_SPEED * y;
+        if (fabsf(scaled_speed - car->setpoint) <= SIM_RAMP_STEP)
+        {
+            car->setpoint = scaled_speed;
+        }
+        else
+        {
+            car->setpoint += (scaled_speed > car->setpoint) ? SIM_RAMP_STEP : -SIM_RAMP_STEP;
+        }
+    }
+    else
+    {
+        app_joystick_filter_reset(&car->filter);
+        car->setpoint = app_failsafe_decel(&car->failsafe, car->setpoint, SIM_TICK_US / 1000U);
+    }
+
+    // Open-loop, as the car starts out
+    const int32_t duty = (fabsf(car->setpoint) > APP_MOTOR_DRIVE_MIN_DUTY) ? (int32_t)car->setpoint : 0;
+    const int32_t output = app_motor_drive_update(&car->drive, duty, true, SIM_TICK_US / 1000U);
+    for (uint32_t t = 0; t < SIM_TICK_US; t += SIM_STEP_US)
+    {
+        sim_motor_step(car, output);
+    }
+}
+
+
+/**
+ * @brief  Drive at full throttle, lose the link, and measure how the car stops
+ *
+ * @param const app_failsafe_cfg_s*
+ * Failsafe settings
+ * @param sim_loss_e
+ * How the link is lost
+ * @param bool
+ * false to drive the way the car used to, on the last joystick position
+ * @param sim_result_s*
+ * Where to write the times
+ * @param FILE*
+ * Where to write a trace of every tick, or NULL
+ */
+static void sim_run(const app_failsafe_cfg_s* cfg, sim_loss_e loss, bool use_failsafe, sim_result_s* result, FILE* trace)
+{
+    const app_joystick_filter_cfg_s filter_cfg = APP_JOYSTICK_FILTER_DEFAULT_THROTTLE;
+    const app_motor_drive_cfg_s drive_cfg = { .brake_duty = APP_MOTOR_DRIVE_DEFAULT_BRAKE_DUTY,
+                                              .brake_release = APP_MOTOR_DRIVE_DEFAULT_BRAKE_RELEASE,
+                                              .dead_time_ms = APP_MOTOR_DRIVE_DEFAULT_DEAD_TIME_MS,
+                                              .tau_ms = APP_MOTOR_DRIVE_DEFAULT_TAU_MS };
+    sim_ble_s ble = { .connected = true, .writing = true, .next_write_us = 0, .y = 1.0f, .n_writes = 0 };
+    sim_car_s car;
+    double loss_position = 0.0;
+
+    memset(&car, 0, sizeof(car));
+    memset(result, 0, sizeof(*result));
+    result->trip_ms = -1.0;
+    result->zero_ms = -1.0;
+    result->stop_ms = -1.0;
+    result->resume_ms = -1.0;
+
+    // The app connects and starts the race
+    app_failsafe_link_up(&car.failsafe, 0);
+    app_failsafe_input(&car.failsafe, APP_FAILSAFE_INPUT_GAME_EVENT, 0);
+    app_failsafe_init(&car.failsafe, cfg, 0);
+    app_joystick_filter_init(&car.filter, &filter_cfg);
+    app_motor_drive_init(&car.drive, &drive_cfg);
+
+    for (uint32_t now_us = 0; now_us < SIM_END_MS * 1000U; now_us += SIM_TICK_US)
+    {
+        const uint32_t n_trips = car.failsafe.n_trips;
+
+        sim_ble_run(&ble, &car, loss, now_us);
+        sim_car_tick(&car, &ble, use_failsafe, now_us);
+
+        if (now_us < SIM_LOSS_MS * 1000U)
+        {
+            loss_position = car.position;
+            continue;
+        }
+        const double ms = (now_us + SIM_TICK_US) / 1000.0 - SIM_LOSS_MS;
+        if ((result->trip_ms < 0.0) && (car.failsafe.n_trips != n_trips))
+        {
+            result->trip_ms = (now_us / 1000.0) - SIM_LOSS_MS;
+        }
+        if ((result->zero_ms < 0.0) && (car.setpoint == 0.0f))
+        {
+            result->zero_ms = ms;
+        }
+        if ((result->stop_ms < 0.0) && (car.speed == 0.0))
+        {
+            result->stop_ms = ms;
+            result->travel = car.position - loss_position;
+        }
+        if ((result->stop_ms >= 0.0) && (result->resume_ms < 0.0) && (car.speed > 0.0))
+        {
+            result->resume_ms = ms;
+        }
+        if (trace != NULL)
+        {
+            fprintf(trace, "%s%s,%u,%d,%d,%.1f,%.2f\n", sim_loss_names[loss], use_failsafe ? "" : " without",
+                    now_us / 1000U, ble.connected, car.failsafe.state, car.setpoint, car.speed);
+        }
+    }
+    if (result->stop_ms < 0.0)
+    {
+        result->travel = car.position - loss_position;
+    }
+}
+
+
+/**
+ * @brief  Format a time from the link being lost
+ *
+ * @param char*
+ * Where to write it
+ * @param size_t
+ * Size of str
+ * @param double
+ * Time (ms), -1 if it never happened
+ */
+static void sim_format_ms(char* str, size_t size, double ms)
+{
+    if (ms >= 0.0)
+    {
+        snprintf(str, size, "%.0f", ms);
+    }
+    else
+    {
+        snprintf(str, size, "-");
+    }
+}
+
+
+/**
+ * @brief  Print how to use the simulation
+ *
+ * @return int
+ * Exit code
+ */
+static int usage(void)
+{
+    fprintf(stderr, "usage: link_loss_sim [-c <deadline_ms>,<decel>] [-o <trace.csv>] [-k]\n");
+    return EXIT_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    app_failsafe_cfg_s cfg = { .deadline_ms = APP_FAILSAFE_DEFAULT_DEADLINE_MS, .decel = APP_FAILSAFE_DEFAULT_DECEL };
+    FILE* trace = NULL;
+    bool check = false;
+    int ret = EXIT_PASS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        unsigned int deadline_ms;
+        unsigned int decel;
+
+        if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc))
+        {
+            if ((sscanf(argv[++i], "%u,%u", &deadline_ms, &decel) != 2) || (deadline_ms > UINT16_MAX) ||
+                (decel == 0) || (decel > UINT16_MAX))
+            {
+                return usage();
+            }
+            cfg.deadline_ms = (uint16_t)deadline_ms;
+            cfg.decel = (uint16_t)decel;
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+        {
+            trace = fopen(argv[++i], "w");
+            if (trace == NULL)
+            {
+                perror(argv[i]);
+                return EXIT_ERROR;
+            }
+            fprintf(trace, "run,ms,connected,failsafe,setpoint,actual_pps\n");
+        }
+        else if (strcmp(argv[i], "-k") == 0)
+        {
+            check = true;
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    // From full speed, the setpoint should reach 0 this long after the failsafe trips
+    const double decel_ms = SIM_SPEED * 1000.0 / cfg.decel;
+
+    printf("link loss at %u%% (deadline %u ms, decel %u%%/s, supervision timeout %u ms):\n", SIM_SPEED,
+           cfg.deadline_ms, cfg.decel, SIM_SUPERVISION_MS);
+    printf("  %-22s %9s %10s %10s %10s %12s\n", "loss", "trip ms", "zero ms", "stop ms", "resume ms", "travel (p)");
+    for (uint32_t with = 0; with < 2; with++)
+    {
+        const bool use_failsafe = (with == 0);
+        for (uint32_t loss = 0; loss < SIM_LOSS_MAX; loss++)
+        {
+            sim_result_s result;
+            char name[32];
+            char trip[16];
+            char zero[16];
+            char stop[16];
+            char resume[16];
+
+            sim_run(&cfg, (sim_loss_e)loss, use_failsafe, &result, trace);
+            snprintf(name, sizeof(name), "%s%s", sim_loss_names[loss], use_failsafe ? "" : " (without)");
+            sim_format_ms(trip, sizeof(trip), use_failsafe ? result.trip_ms : -1.0);
+            sim_format_ms(zero, sizeof(zero), result.zero_ms);
+            sim_format_ms(stop, sizeof(stop), result.stop_ms);
+            sim_format_ms(resume, sizeof(resume), result.resume_ms);
+            printf("  %-22s %9s %10s %10s %10s %12.0f\n", name, trip, zero, stop, resume, result.travel);
+
+            if (!check || !use_failsafe)
+            {
+                continue;
+            }
+            // The deadline is checked to the tick, and the stop to the spin down allowance
+            const double trip_limit = (loss == SIM_LOSS_SILENT) ? (cfg.deadline_ms + SIM_CONN_US / 1000.0) : 1.0;
+            if (loss == SIM_LOSS_INTERFERENCE)
+            {
+                if ((cfg.deadline_ms > SIM_BURST_MS + SIM_CONN_US / 1000U) && (result.trip_ms >= 0.0))
+                {
+                    printf("    FAIL: tripped on a %u ms burst of interference\n", SIM_BURST_MS);
+                    ret = EXIT_FAIL;
+                }
+            }
+            else if ((result.trip_ms < 0.0) || (result.trip_ms > trip_limit))
+            {
+                printf("    FAIL: tripped after %s ms, should be at most %.0f ms\n", trip, trip_limit);
+                ret = EXIT_FAIL;
+            }
+            else if ((result.stop_ms < 0.0) || (result.stop_ms > result.trip_ms + decel_ms + SIM_SPIN_DOWN_MS))
+            {
+                printf("    FAIL: stopped after %s ms, should be at most %.0f ms\n", stop,
+                       result.trip_ms + decel_ms + SIM_SPIN_DOWN_MS);
+                ret = EXIT_FAIL;
+            }
+            else if ((loss == SIM_LOSS_RECONNECT) && (result.resume_ms < 0.0))
+            {
+                printf("    FAIL: didn't drive again after reconnecting\n");
+                ret = EXIT_FAIL;
+            }
+        }
+    }
+
+    if (trace != NULL)
+    {
+        fclose(trace);
+    }
+    if (check)
+    {
+        printf("%s\n", (ret == EXIT_PASS) ? "pass" : "FAIL");
+    }
+    return ret;
+}
@@ -0,0 +1,640 @@
+/**
+ * @file speed_sim.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host simulation of the car's closed-loop speed control. app_speed_ctrl.c is
+ * built for the host and run the way task_car runs it (setpoint slew every
+ * control loop tick, PID every APP_SPEED_CTRL_HZ) against a model of the
+ * motor and wheel sensor: a first-order motor with friction, and a sensor
+ * that reports the time of every pulse to the microsecond. It drives the car
+ * through the speed changes of a race (road, boost, grass, road) and reports
+ * the step response of each, closed-loop and open-loop, so gains can be tuned
+ * without a car.
+ *
+ * The stops mode instead stops and reverses the car from steady speed through
+ * the motor drive state machine, and reports how long it takes, how far it
+ * carries on, and the peak current.
+ *
+ * Usage:
+ *   speed_sim [steps|stops] [-g <kp>,<ki>,<kd>] [-b <brake duty>,<release>,<dead time ms>]
+ *             [-o <trace.csv>] [-c]
+ *
+ * Gains are in thousandths, as entered with the speed_gains CLI command. The
+ * trace has a row per control loop tick. -c checks the closed-loop steps or
+ * the braked stops against the limits in sim_phases and sim_stops_list, and
+ * exits 0 if they are all within them
+ *
+ * @version 0.1
+ * @date 2024-12-18
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_speed_ctrl.h"
+#include "app_motor_drive.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define SIM_STEP_US              (10U)
+#define SIM_TICK_US              (1000U)     // Control loop tick (CAR_CONTROL_TICK_HZ)
+#define SIM_PID_TICKS            (1000000U / SIM_TICK_US / APP_SPEED_CTRL_HZ)
+#define SIM_RAMP_STEP            (5)         // DC_MOTOR_RAMP_STEP_VAL
+#define SIM_MIN_DUTY             (5)         // DC_MOTOR_MIN_DUTY
+
+// Motor model. Unloaded, the wheel reaches SIM_MOTOR_PPS_PER_DUTY * (duty - friction)
+#define SIM_MOTOR_PPS_PER_DUTY   (4.8)
+#define SIM_MOTOR_FRICTION       (8.0)       // Duty cycle (%) it takes to get the wheel moving
+#define SIM_MOTOR_TAU_S          (0.15)
+
+// A step counts as settled once it stays within this fraction of the target
+#define SIM_SETTLE_BAND          (0.05)
+// The steady-state error is averaged over the end of each phase
+#define SIM_STEADY_MS            (200U)
+
+#define SIM_DRIVE_CFG_DEFAULT    { .brake_duty = APP_MOTOR_DRIVE_DEFAULT_BRAKE_DUTY,       \
+                                   .brake_release = APP_MOTOR_DRIVE_DEFAULT_BRAKE_RELEASE, \
+                                   .dead_time_ms = APP_MOTOR_DRIVE_DEFAULT_DEAD_TIME_MS,   \
+                                   .tau_ms = APP_MOTOR_DRIVE_DEFAULT_TAU_MS }
+
+// The steady-state error a closed-loop step can have, for -c
+#define SIM_CHECK_STEADY_PCT     (1.0)
+
+#define EXIT_PASS                (0)
+#define EXIT_FAIL                (1)
+#define EXIT_ERROR               (2)
+
+// A phase of the race, from its start to the next one's
+typedef struct
+{
+    const char* name;
+    uint32_t start_ms;
+    int32_t setpoint;                        // speed * y, as task_car computes it
+    double load;                             // Extra friction, as a duty cycle (%)
+    double max_settle_ms;                    // Closed-loop limits, for -c
+    double max_overshoot_pct;
+} sim_phase_s;
+
+typedef struct
+{
+    double speed;                            // pulses/s
+    double position;                         // pulses
+    double current;                          // Duty cycle (%) that draws the same current stalled
+    uint32_t n_edges;
+    uint32_t last_edge_us;
+} sim_motor_s;
+
+// The car's control loop, as task_car runs it
+typedef struct
+{
+    app_speed_ctrl_s ctrl;
+    app_motor_drive_s drive;
+    sim_motor_s motor;
+    int32_t slewed;                          // Setpoint after the slew limit
+    int32_t duty;                            // Speed controller output
+    int32_t output;                          // Duty cycle the motor is driven at
+} sim_car_s;
+
+// A stop or reversal
+typedef struct
+{
+    int32_t from;                            // Setpoint before
+    int32_t to;                              // Setpoint after
+    bool brake;                              // Whether to brake when stopping
+    double max_ms;                           // Limits with the default drive settings, for -c. 0 isn't checked
+    double max_travel;
+    double max_current_pct;
+} sim_stop_s;
+
+typedef struct
+{
+    double rise_ms;
+    double overshoot_pct;
+    double settle_ms;
+    double steady_error_pct;
+} sim_step_s;
+
+
+/******************************************************************************/
+/* Private Data Definitions                                                   */
+/******************************************************************************/
+// Settling is within about 0.4 s. Grass also adds load as the setpoint drops, so the speed dips
+// well under its target before the integral catches up
+static const sim_phase_s sim_phases[] = {
+    { "road",  0,    50,  0.0,  450.0, 20.0 },
+    { "boost", 1500, 100, 0.0,  450.0, 20.0 },
+    { "grass", 3000, 25,  12.0, 650.0, 40.0 },
+    { "road",  4500, 50,  0.0,  450.0, 20.0 }
+};
+#define SIM_N_PHASES             (sizeof(sim_phases) / sizeof(sim_phases[0]))
+#define SIM_END_MS               (6000U)
+
+// Stops and reversals, from steady speed. Braking roughly halves the time and distance of a
+// coasting stop, and the dead time takes the edge off a reversal's current
+static const sim_stop_s sim_stops_list[] = {
+    { 100, 0,   false, 0.0,   0.0,  0.0   },
+    { 100, 0,   true,  215.0, 38.5, 0.0   },
+    { 50,  0,   false, 0.0,   0.0,  0.0   },
+    { 50,  0,   true,  140.0, 11.5, 0.0   },
+    { 100, -50, false, 0.0,   0.0,  125.0 },
+    { 50,  -50, false, 0.0,   0.0,  80.0  }
+};
+#define SIM_N_STOPS              (sizeof(sim_stops_list) / sizeof(sim_stops_list[0]))
+#define SIM_STOP_AT_MS           (1500U)
+#define SIM_STOP_MS              (1500U)
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Advance the motor model by one simulation step, and record the
+ *         wheel sensor's edges
+ *
+ * @param sim_motor_s*
+ * Motor to advance
+ * @param int32_t
+ * Signed duty cycle it is driven at
+ * @param double
+ * Extra friction from the terrain, as a duty cycle (%)
+ * @param uint32_t
+ * Time at the start of the step (us)
+ */
+static void sim_motor_step(sim_motor_s* motor, int32_t duty, double load, uint32_t now_us)
+{
+    const double dt = SIM_STEP_US * 1e-6;
+    const double drive = SIM_MOTOR_PPS_PER_DUTY * duty;
+    const double friction = SIM_MOTOR_PPS_PER_DUTY * (SIM_MOTOR_FRICTION + load);
+    const double prev_position = motor->position;
+    const double prev_speed = motor->speed;
+
+    if ((prev_speed == 0.0) && (fabs(drive) <= friction))
+    {
+        // Not enough to get the wheel moving
+    }
+    else
+    {
+        const double direction = (prev_speed != 0.0) ? ((prev_speed > 0.0) ? 1.0 : -1.0) : ((drive > 0.0) ? 1.0 : -1.0);
+        motor->speed += (drive - (direction * friction) - prev_speed) * dt / SIM_MOTOR_TAU_S;
+        if ((motor->speed * direction < 0.0) && (fabs(drive) <= friction))
+        {
+            // Friction stops the wheel rather than turning it backwards
+            motor->speed = 0.0;
+        }
+    }
+    motor->position += motor->speed * dt;
+    // Current, as the duty cycle that would draw it at standstill. None flows while it's off
+    motor->current = (duty != 0) ? (duty - (motor->speed / SIM_MOTOR_PPS_PER_DUTY)) : 0.0;
+
+    // The sensor only sees how far the wheel turned, not which way
+    const double n_crossed = fabs(floor(motor->position) - floor(prev_position));
+    if (n_crossed > 0.0)
+    {
+        const double edge = (motor->position > prev_position) ? floor(motor->position) : ceil(motor->position);
+        const double frac = (edge - prev_position) / (motor->position - prev_position);
+        motor->n_edges += (uint32_t)n_crossed;
+        motor->last_edge_us = now_us + (uint32_t)(frac * SIM_STEP_US);
+    }
+}
+
+
+/**
+ * @brief  Set up a simulated car, stopped
+ *
+ * @param sim_car_s*
+ * Car to set up
+ * @param const app_speed_ctrl_gains_s*
+ * Speed controller gains
+ * @param const app_motor_drive_cfg_s*
+ * Braking and dead time settings
+ */
+static void sim_car_init(sim_car_s* car, const app_speed_ctrl_gains_s* gains, const app_motor_drive_cfg_s* drive_cfg)
+{
+    memset(car, 0, sizeof(*car));
+    app_speed_ctrl_init(&car->ctrl, gains, APP_SPEED_CTRL_MAX_PPS);
+    app_motor_drive_init(&car->drive, drive_cfg);
+}
+
+
+/**
+ * @brief  Run one control loop tick, as task_car does, then run the motor
+ *         until the next one
+ *
+ * @param sim_car_s*
+ * Car to run
+ * @param uint32_t
+ * Index of the tick
+ * @param int32_t
+ * Setpoint (speed * y, as task_car computes it)
+ * @param bool
+ * true to brake if the setpoint is to stop
+ * @param double
+ * Extra friction from the terrain, as a duty cycle (%)
+ */
+static void sim_car_tick(sim_car_s* car, uint32_t tick, int32_t setpoint, bool brake, double load)
+{
+    const uint32_t now_us = tick * SIM_TICK_US;
+
+    if (abs(setpoint - car->slewed) <= SIM_RAMP_STEP)
+    {
+        car->slewed = setpoint;
+    }
+    else
+    {
+        car->slewed += (setpoint > car->slewed) ? SIM_RAMP_STEP : -SIM_RAMP_STEP;
+    }
+    if ((tick % SIM_PID_TICKS) == 0)
+    {
+        app_speed_ctrl_measure(&car->ctrl, car->motor.n_edges, car->motor.last_edge_us, now_us);
+        if (abs(car->slewed) > APP_MOTOR_DRIVE_MIN_DUTY)
+        {
+            car->duty = app_speed_ctrl_update(&car->ctrl, car->slewed);
+        }
+        else
+        {
+            app_speed_ctrl_reset(&car->ctrl);
+            car->duty = 0;
+        }
+    }
+    const int32_t duty = (abs(car->slewed) > APP_MOTOR_DRIVE_MIN_DUTY) ? car->duty : 0;
+    car->output = app_motor_drive_update(&car->drive, duty, brake, SIM_TICK_US / 1000U);
+
+    for (uint32_t t = 0; t < SIM_TICK_US; t += SIM_STEP_US)
+    {
+        sim_motor_step(&car->motor, car->output, load, now_us + t);
+    }
+}
+
+
+/**
+ * @brief  Measure the step response of one phase of the race
+ *
+ * @param const double*
+ * Wheel speed (pulses/s) at each control loop tick of the phase
+ * @param uint32_t
+ * Number of ticks in the phase
+ * @param double
+ * Wheel speed at the start of the phase
+ * @param double
+ * Target wheel speed of the phase
+ * @param sim_step_s*
+ * Where to write the step response
+ */
+static void sim_measure_step(const double* speed, uint32_t n_ticks, double start, double target, sim_step_s* step)
+{
+    const double span = target - start;
+    const double band = fabs(target) * SIM_SETTLE_BAND;
+    const uint32_t n_steady = SIM_STEADY_MS * 1000U / SIM_TICK_US;
+    double t10 = -1.0;
+    double t90 = -1.0;
+    double peak = 0.0;
+    double steady = 0.0;
+
+    step->settle_ms = 0.0;
+    for (uint32_t i = 0; i < n_ticks; i++)
+    {
+        const double progress = (speed[i] - start) / span;
+        if ((t10 < 0.0) && (progress >= 0.1))
+        {
+            t10 = i;
+        }
+        if ((t90 < 0.0) && (progress >= 0.9))
+        {
+            t90 = i;
+        }
+        if (progress - 1.0 > peak)
+        {
+            peak = progress - 1.0;
+        }
+        if (fabs(speed[i] - target) > band)
+        {
+            step->settle_ms = (i + 1) * SIM_TICK_US / 1000.0;
+        }
+        if (i >= n_ticks - n_steady)
+        {
+            steady += speed[i];
+        }
+    }
+
+    step->rise_ms = ((t10 >= 0.0) && (t90 >= 0.0)) ? ((t90 - t10) * SIM_TICK_US / 1000.0) : -1.0;
+    step->overshoot_pct = peak * 100.0 * fabs(span) / fabs(target);
+    if (step->settle_ms >= (n_ticks - n_steady) * SIM_TICK_US / 1000.0)
+    {
+        // Never settled
+        step->settle_ms = -1.0;
+    }
+    step->steady_error_pct = ((steady / n_steady) - target) * 100.0 / target;
+}
+
+
+/**
+ * @brief  Drive the simulated car through the race and print the response to
+ *         each phase
+ *
+ * @param const app_speed_ctrl_gains_s*
+ * PID gains
+ * @param const char*
+ * Label for the results
+ * @param FILE*
+ * Where to write a trace of every tick, or NULL
+ * @param bool
+ * true to check each phase against its limits
+ * @return uint32_t
+ * Number of phases that failed the check
+ */
+static uint32_t sim_steps(const app_speed_ctrl_gains_s* gains, const char* label, FILE* trace, bool check)
+{
+    static double speed[SIM_END_MS * 1000U / SIM_TICK_US];
+    const app_motor_drive_cfg_s drive_cfg = SIM_DRIVE_CFG_DEFAULT;
+    sim_car_s car;
+    uint32_t phase = 0;
+    uint32_t n_failed = 0;
+
+    sim_car_init(&car, gains, &drive_cfg);
+
+    for (uint32_t tick = 0; tick < SIM_END_MS * 1000U / SIM_TICK_US; tick++)
+    {
+        if ((phase + 1 < SIM_N_PHASES) && (tick * SIM_TICK_US >= sim_phases[phase + 1].start_ms * 1000U))
+        {
+            phase++;
+        }
+
+        sim_car_tick(&car, tick, sim_phases[phase].setpoint, false, sim_phases[phase].load);
+        speed[tick] = car.motor.speed;
+
+        if (trace != NULL)
+        {
+            fprintf(trace, "%s,%u,%d,%d,%.2f,%.2f,%.1f\n", label, tick * SIM_TICK_US / 1000U, car.slewed, car.output,
+                    (double)car.ctrl.speed / (1 << APP_SPEED_CTRL_SPEED_SHIFT), car.motor.speed, car.motor.current);
+        }
+    }
+
+    printf("%s (kp %d, ki %d, kd %d):\n", label, APP_SPEED_CTRL_GAIN_TO_MILLI(gains->kp),
+           APP_SPEED_CTRL_GAIN_TO_MILLI(gains->ki), APP_SPEED_CTRL_GAIN_TO_MILLI(gains->kd));
+    printf("  %-6s %7s %7s %10s %10s %10s\n", "phase", "target", "speed", "rise (ms)", "overshoot", "settle (ms)");
+    for (uint32_t i = 0; i < SIM_N_PHASES; i++)
+    {
+        const uint32_t start = sim_phases[i].start_ms * 1000U / SIM_TICK_US;
+        const uint32_t end = ((i + 1 < SIM_N_PHASES) ? sim_phases[i + 1].start_ms : SIM_END_MS) * 1000U / SIM_TICK_US;
+        const double target = (double)sim_phases[i].setpoint * APP_SPEED_CTRL_MAX_PPS / APP_SPEED_CTRL_MAX_OUTPUT;
+        sim_step_s step;
+        char settle[16];
+        bool ok = true;
+
+        sim_measure_step(&speed[start], end - start, (start > 0) ? speed[start - 1] : 0.0, target, &step);
+        if (step.settle_ms >= 0.0)
+        {
+            snprintf(settle, sizeof(settle), "%.1f", step.settle_ms);
+        }
+        else
+        {
+            snprintf(settle, sizeof(settle), "never");
+        }
+        if (check)
+        {
+            ok = (step.settle_ms >= 0.0) && (step.settle_ms <= sim_phases[i].max_settle_ms) &&
+                 (step.overshoot_pct <= sim_phases[i].max_overshoot_pct) &&
+                 (fabs(step.steady_error_pct) <= SIM_CHECK_STEADY_PCT);
+            if (!ok)
+            {
+                n_failed++;
+            }
+        }
+        printf("  %-6s %7.1f %7.1f %10.1f %9.1f%% %10s   (%+.1f%% steady-state)%s\n",
+               sim_phases[i].name, target, speed[end - 1], step.rise_ms, step.overshoot_pct, settle,
+               step.steady_error_pct, ok ? "" : "  FAIL");
+    }
+    return n_failed;
+}
+
+
+/**
+ * @brief  Drive the simulated car up to speed, then stop or reverse it, and
+ *         print how it decelerates
+ *
+ * @param const app_speed_ctrl_gains_s*
+ * PID gains
+ * @param const app_motor_drive_cfg_s*
+ * Braking and dead time settings
+ * @param const char*
+ * Label for the results
+ * @param FILE*
+ * Where to write a trace of every tick, or NULL
+ * @param bool
+ * true to check each stop against its limits
+ * @return uint32_t
+ * Number of stops that failed the check
+ */
+static uint32_t sim_stops(const app_speed_ctrl_gains_s* gains, const app_motor_drive_cfg_s* drive_cfg, const char* label,
+                          FILE* trace, bool check)
+{
+    uint32_t n_failed = 0;
+
+    printf("%s (brake %u%% until %u%%, dead time %u ms):\n", label, drive_cfg->brake_duty, drive_cfg->brake_release,
+           drive_cfg->dead_time_ms);
+    printf("  %-12s %9s %10s %12s %9s %12s\n", "from -> to", "speed", "time (ms)", "travel (p)", "reversed",
+           "peak current");
+
+    for (uint32_t i = 0; i < SIM_N_STOPS; i++)
+    {
+        const sim_stop_s* stop = &sim_stops_list[i];
+        const uint32_t n_ticks = (SIM_STOP_AT_MS + SIM_STOP_MS) * 1000U / SIM_TICK_US;
+        sim_car_s car;
+        double start_speed = 0.0;
+        double start_position = 0.0;
+        double stop_ms = -1.0;
+        double travel = 0.0;
+        double reversed = 0.0;
+        double peak_current = 0.0;
+        bool ok = true;
+
+        sim_car_init(&car, gains, drive_cfg);
+        for (uint32_t tick = 0; tick < n_ticks; tick++)
+        {
+            const bool stopping = (tick * SIM_TICK_US >= SIM_STOP_AT_MS * 1000U);
+            if (stopping && (start_speed == 0.0))
+            {
+                start_speed = car.motor.speed;
+                start_position = car.motor.position;
+            }
+
+            sim_car_tick(&car, tick, stopping ? stop->to : stop->from, stop->brake, 0.0);
+
+            if (stopping)
+            {
+                const double ms = (tick + 1) * SIM_TICK_US / 1000.0 - SIM_STOP_AT_MS;
+                if (fabs(car.motor.current) > fabs(peak_current))
+                {
+                    peak_current = car.motor.current;
+                }
+                // How far the car carries on the way it was going
+                travel = fmax(travel, (car.motor.position - start_position) * ((start_speed > 0.0) ? 1.0 : -1.0));
+                if (stop->to == 0)
+                {
+                    // Stopping, so measure until the wheel stops, and whether it turned backwards
+                    if ((stop_ms < 0.0) && (car.motor.speed * start_speed <= 0.0))
+                    {
+                        stop_ms = ms;
+                    }
+                    if (car.motor.speed * start_speed < 0.0)
+                    {
+                        reversed = fmax(reversed, fabs(car.motor.speed));
+                    }
+                }
+                else if ((stop_ms < 0.0) && (car.motor.speed * start_speed < 0.0) &&
+                         (fabs(car.motor.speed) >= 0.9 * abs(stop->to) * APP_SPEED_CTRL_MAX_PPS / APP_SPEED_CTRL_MAX_OUTPUT))
+                {
+                    // Reversing, so measure until the wheel is at 90% of its new speed
+                    stop_ms = ms;
+                }
+            }
+            if (trace != NULL)
+            {
+                fprintf(trace, "%s %d->%d%s,%u,%d,%d,%.2f,%.2f,%.1f\n", label, stop->from, stop->to,
+                        stop->brake ? " brake" : "", tick * SIM_TICK_US / 1000U, car.slewed, car.output,
+                        (double)car.ctrl.speed / (1 << APP_SPEED_CTRL_SPEED_SHIFT), car.motor.speed,
+                        car.motor.current);
+            }
+        }
+
+        char transition[16];
+        char stop_str[16];
+        snprintf(transition, sizeof(transition), "%d -> %d%s", stop->from, stop->to, stop->brake ? " B" : "");
+        if (stop_ms >= 0.0)
+        {
+            snprintf(stop_str, sizeof(stop_str), "%.0f", stop_ms);
+        }
+        else
+        {
+            snprintf(stop_str, sizeof(stop_str), "never");
+        }
+        if (check)
+        {
+            // A stop must never turn the wheel backwards
+            ok = (stop_ms >= 0.0) && (reversed == 0.0) &&
+                 ((stop->max_ms == 0.0) || (stop_ms <= stop->max_ms)) &&
+                 ((stop->max_travel == 0.0) || (travel <= stop->max_travel)) &&
+                 ((stop->max_current_pct == 0.0) || (fabs(peak_current) <= stop->max_current_pct));
+            if (!ok)
+            {
+                n_failed++;
+            }
+        }
+        printf("  %-12s %9.1f %10s %12.1f %9.1f %11.0f%%%s\n", transition, start_speed, stop_str, travel, reversed,
+               peak_current, ok ? "" : "  FAIL");
+    }
+    return n_failed;
+}
+
+
+/**
+ * @brief  Print how to use the simulation
+ *
+ * @return int
+ * Exit code
+ */
+static int usage(void)
+{
+    fprintf(stderr, "usage: speed_sim [steps|stops] [-g <kp>,<ki>,<kd>] [-b <brake duty>,<release>,<dead time ms>]\n"
+                    "                 [-o <trace.csv>] [-c]\n");
+    return EXIT_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    int32_t kp = APP_SPEED_CTRL_DEFAULT_KP;
+    int32_t ki = APP_SPEED_CTRL_DEFAULT_KI;
+    int32_t kd = APP_SPEED_CTRL_DEFAULT_KD;
+    app_motor_drive_cfg_s drive_cfg = SIM_DRIVE_CFG_DEFAULT;
+    bool stops = false;
+    bool check = false;
+    uint32_t n_failed = 0;
+    FILE* trace = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        unsigned int brake_duty;
+        unsigned int brake_release;
+        unsigned int dead_time_ms;
+
+        if ((i == 1) && ((strcmp(argv[i], "steps") == 0) || (strcmp(argv[i], "stops") == 0)))
+        {
+            stops = (strcmp(argv[i], "stops") == 0);
+        }
+        else if ((strcmp(argv[i], "-g") == 0) && (i + 1 < argc))
+        {
+            if (sscanf(argv[++i], "%d,%d,%d", &kp, &ki, &kd) != 3)
+            {
+                return usage();
+            }
+        }
+        else if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+        {
+            if ((sscanf(argv[++i], "%u,%u,%u", &brake_duty, &brake_release, &dead_time_ms) != 3) ||
+                (brake_duty > APP_MOTOR_DRIVE_MAX_DUTY) || (brake_release > APP_MOTOR_DRIVE_MAX_DUTY) ||
+                (dead_time_ms > UINT16_MAX))
+            {
+                return usage();
+            }
+            drive_cfg.brake_duty = (uint8_t)brake_duty;
+            drive_cfg.brake_release = (uint8_t)brake_release;
+            drive_cfg.dead_time_ms = (uint16_t)dead_time_ms;
+        }
+        else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+        {
+            trace = fopen(argv[++i], "w");
+            if (trace == NULL)
+            {
+                perror(argv[i]);
+                return EXIT_ERROR;
+            }
+            fprintf(trace, "run,ms,setpoint,duty,measured_pps,actual_pps,current_pct\n");
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            check = true;
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    const app_speed_ctrl_gains_s closed_loop = {
+        .kp = APP_SPEED_CTRL_GAIN_FROM_MILLI(kp),
+        .ki = APP_SPEED_CTRL_GAIN_FROM_MILLI(ki),
+        .kd = APP_SPEED_CTRL_GAIN_FROM_MILLI(kd)
+    };
+    const app_speed_ctrl_gains_s open_loop = { 0 };
+
+    if (stops)
+    {
+        // Compare against stopping the way the car used to: coast, and reverse straight away
+        const app_motor_drive_cfg_s no_drive_cfg = { .tau_ms = APP_MOTOR_DRIVE_DEFAULT_TAU_MS };
+
+        n_failed += sim_stops(&open_loop, &drive_cfg, "drive state machine", trace, check);
+        sim_stops(&open_loop, &no_drive_cfg, "without", trace, false);
+    }
+    else
+    {
+        n_failed += sim_steps(&closed_loop, "closed-loop", trace, check);
+        sim_steps(&open_loop, "open-loop", trace, false);
+    }
+    if (check)
+    {
+        printf("%s\n", (n_failed == 0) ? "PASS" : "FAIL");
+    }
+
+    if (trace != NULL)
+    {
+        fclose(trace);
+    }
+
+    return (n_failed == 0) ? EXIT_PASS : EXIT_FAIL;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,248 @@
+/**
+ * @file steering_check.c
+ * @author James Vollmer (jrvollmer@wisc.edu) - Team 01
+ * @brief
+ * Host check of app_steering.c. Its tables are built by the preprocessor in
+ * integer math, so they are checked here against the response worked out in
+ * double precision, for every stick position and speed. Then the table's
+ * shape (symmetric, monotonic, exact at the ends) and the slew rate limit
+ * are checked.
+ *
+ * Usage:
+ *   steering_check [-t <tolerance>]
+ *
+ * The tolerance is the largest error allowed against the reference, in
+ * thousandths of full lock (default 2.5). Exits 0 if every check passes
+ *
+ * @version 0.1
+ * @date 2024-12-22
+ *
+ * @copyright Copyright (c) 2024
+ */
+#include "app_steering.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/******************************************************************************/
+/* Defines and Typedefs                                                       */
+/******************************************************************************/
+#define CHECK_DEFAULT_TOLERANCE  (2.5)       // Thousandths of full lock
+
+#define EXIT_PASS                (0)
+#define EXIT_FAIL                (1)
+#define EXIT_ERROR               (2)
+
+
+/*******************************************************************************
+ * Function Definitions
+ *******************************************************************************/
+/**
+ * @brief  Reference steering response, in double precision
+ *
+ * @param double
+ * Stick position, from -1 to 1
+ * @param double
+ * Speed, from 0 to 1 of full
+ * @return double
+ * Steering angle, from -1 to 1
+ */
+static double check_reference(double stick, double speed)
+{
+    const double expo = APP_STEERING_EXPO / 1000.0;
+    const double high_speed = APP_STEERING_HIGH_SPEED / 1000.0;
+    const double curve = ((1.0 - expo) * stick) + (expo * stick * stick * stick);
+
+    return curve * (1.0 - (high_speed * speed * speed));
+}
+
+
+/**
+ * @brief  Compare the table against the reference for every stick position
+ *         and speed
+ *
+ * @param double
+ * Largest error allowed (fraction of full lock)
+ * @return bool
+ * true if every point is within it
+ */
+static bool check_table(double tolerance)
+{
+    double max_error = 0.0;
+    int32_t worst_stick = 0;
+    int32_t worst_speed = 0;
+
+    for (int32_t speed = 0; speed <= APP_STEERING_MAX_SPEED; speed++)
+    {
+        for (int32_t stick = -APP_STEERING_ONE; stick <= APP_STEERING_ONE; stick++)
+        {
+            const double angle = (double)app_steering_target(stick, speed) / APP_STEERING_ONE;
+            const double reference = check_reference((double)stick / APP_STEERING_ONE, (double)speed / APP_STEERING_MAX_SPEED);
+            const double error = fabs(angle - reference);
+            if (error > max_error)
+            {
+                max_error = error;
+                worst_stick = stick;
+                worst_speed = speed;
+            }
+        }
+    }
+
+    printf("table vs reference: max error %.3f thousandths of full lock (stick %ld, speed %ld%%), tolerance %.3f: %s\n",
+           1000.0 * max_error, (long)worst_stick, (long)worst_speed, 1000.0 * tolerance,
+           (max_error <= tolerance) ? "pass" : "FAIL");
+    return (max_error <= tolerance);
+}
+
+
+/**
+ * @brief  Check the table is symmetric, monotonic, and exact at the ends
+ *
+ * @return bool
+ * true if it is
+ */
+static bool check_shape(void)
+{
+    uint32_t n_fail = 0;
+
+    for (int32_t speed = 0; speed <= APP_STEERING_MAX_SPEED; speed++)
+    {
+        int32_t prev = -1;
+        if (app_steering_target(0, speed) != 0)
+        {
+            printf("  speed %ld%%: not straight with the stick centred\n", (long)speed);
+            n_fail++;
+        }
+        for (int32_t stick = 0; stick <= APP_STEERING_ONE; stick++)
+        {
+            const int32_t angle = app_steering_target(stick, speed);
+            if (app_steering_target(-stick, speed) != -angle)
+            {
+                printf("  speed %ld%%, stick %ld: left and right differ\n", (long)speed, (long)stick);
+                n_fail++;
+            }
+            if (angle < prev)
+            {
+                printf("  speed %ld%%, stick %ld: turns less than at the last stick position\n", (long)speed, (long)stick);
+                n_fail++;
+            }
+            if ((speed > 0) && (angle > app_steering_target(stick, speed - 1)))
+            {
+                printf("  speed %ld%%, stick %ld: turns more than when slower\n", (long)speed, (long)stick);
+                n_fail++;
+            }
+            prev = angle;
+        }
+        // Speeds beyond full (e.g. in reverse) are treated as full
+        if (app_steering_target(APP_STEERING_ONE, -speed) != app_steering_target(APP_STEERING_ONE, speed))
+        {
+            printf("  speed %ld%%: steers differently in reverse\n", (long)speed);
+            n_fail++;
+        }
+    }
+    if (app_steering_target(APP_STEERING_ONE, 0) != APP_STEERING_ONE)
+    {
+        printf("  full stick at standstill isn't full lock\n");
+        n_fail++;
+    }
+    if (app_steering_target(2 * APP_STEERING_ONE, 0) != APP_STEERING_ONE)
+    {
+        printf("  stick beyond full travel isn't clamped\n");
+        n_fail++;
+    }
+
+    printf("table shape (centred, symmetric, monotonic, full lock at full stick): %s\n", (n_fail == 0) ? "pass" : "FAIL");
+    return (n_fail == 0);
+}
+
+
+/**
+ * @brief  Swing the steering from lock to lock and back to centre, and check
+ *         it never moves faster than its slew rate limit, and gets there
+ *
+ * @param uint32_t
+ * Slew rate limit (thousandths of full lock per second)
+ * @return bool
+ * true if it behaves
+ */
+static bool check_slew(uint32_t max_rate)
+{
+    const app_steering_cfg_s cfg = { .max_rate = max_rate };
+    const int32_t targets[] = { APP_STEERING_ONE, -APP_STEERING_ONE, 0 };
+    // The limit is a whole number of Q15 steps per tick, rounded down so it's never exceeded
+    const double max_step = (max_rate > 0) ? floor(((double)max_rate / 1000.0) * APP_STEERING_ONE / APP_STEERING_TICK_HZ) : INFINITY;
+    app_steering_s steering;
+    uint32_t n_fail = 0;
+
+    app_steering_init(&steering, &cfg);
+    for (uint32_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+    {
+        const int32_t start = steering.angle;
+        const double expected_ticks = fmax(1.0, ceil(fabs((double)(targets[i] - start)) / max_step));
+        uint32_t ticks = 0;
+        int32_t prev = start;
+
+        while ((steering.angle != targets[i]) && (ticks < 10 * APP_STEERING_TICK_HZ))
+        {
+            const int32_t angle = app_steering_update(&steering, targets[i], 0);
+            if (fabs((double)(angle - prev)) > max_step)
+            {
+                printf("  rate %lu: moved %ld in a tick, limit %.0f\n", (unsigned long)max_rate, (long)(angle - prev), max_step);
+                n_fail++;
+            }
+            prev = angle;
+            ticks++;
+        }
+        if ((steering.angle != targets[i]) || (ticks != (uint32_t)expected_ticks))
+        {
+            printf("  rate %lu: %ld -> %ld took %lu ticks, expected %.0f\n", (unsigned long)max_rate, (long)start,
+                   (long)targets[i], (unsigned long)ticks, expected_ticks);
+            n_fail++;
+        }
+    }
+
+    printf("slew rate limit %lu/1000 per s: %s\n", (unsigned long)max_rate, (n_fail == 0) ? "pass" : "FAIL");
+    return (n_fail == 0);
+}
+
+
+static int usage(void)
+{
+    fprintf(stderr, "usage: steering_check [-t <tolerance in thousandths of full lock>]\n");
+    return EXIT_ERROR;
+}
+
+
+int main(int argc, char** argv)
+{
+    double tolerance = CHECK_DEFAULT_TOLERANCE;
+    bool pass = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+        {
+            if (sscanf(argv[++i], "%lf", &tolerance) != 1)
+            {
+                return usage();
+            }
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    printf("expo %d, high speed reduction %d (thousandths), %u curve segments, %u speed segments\n",
+           APP_STEERING_EXPO, APP_STEERING_HIGH_SPEED, APP_STEERING_CURVE_SEGMENTS, APP_STEERING_SPEED_SEGMENTS);
+    pass &= check_table(tolerance / 1000.0);
+    pass &= check_shape();
+    pass &= check_slew(APP_STEERING_DEFAULT_MAX_RATE);
+    pass &= check_slew(1000);
+    pass &= check_slew(0);
+
+    return pass ? EXIT_PASS : EXIT_FAIL;
+}
+
+/* [] END OF FILE */